@@ -0,0 +1,648 @@
+#include "json_parser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace layer_tree {
+namespace {
+
+// Simple JSON tokenizer
+class JsonTokenizer {
+ public:
+  explicit JsonTokenizer(const std::string& json) : json_(json), pos_(0) {}
+
+  void SkipWhitespace() {
+    while (pos_ < json_.size() &&
+           (json_[pos_] == ' ' || json_[pos_] == '\n' ||
+            json_[pos_] == '\r' || json_[pos_] == '\t')) {
+      ++pos_;
+    }
+  }
+
+  char Peek() {
+    SkipWhitespace();
+    return pos_ < json_.size() ? json_[pos_] : '\0';
+  }
+
+  char Consume() {
+    SkipWhitespace();
+    return pos_ < json_.size() ? json_[pos_++] : '\0';
+  }
+
+  void Expect(char c) {
+    SkipWhitespace();
+    if (pos_ >= json_.size() || json_[pos_] != c) {
+      throw std::runtime_error(std::string("Expected '") + c + "' at offset " +
+                               std::to_string(pos_));
+    }
+    ++pos_;
+  }
+
+  // Decodes escapes, including \uXXXX (and surrogate pairs) to UTF-8, so
+  // the serializer can escape the string again the way JSON.stringify does
+  std::string ReadString() {
+    Expect('"');
+    std::string result;
+    while (pos_ < json_.size() && json_[pos_] != '"') {
+      if (json_[pos_] != '\\') {
+        result += json_[pos_++];
+        continue;
+      }
+      ++pos_;
+      if (pos_ >= json_.size()) {
+        break;
+      }
+      switch (json_[pos_++]) {
+        case 'n': result += '\n'; break;
+        case 't': result += '\t'; break;
+        case 'r': result += '\r'; break;
+        case 'b': result += '\b'; break;
+        case 'f': result += '\f'; break;
+        case 'u': AppendUtf8(ReadCodePoint(), result); break;
+        default: result += json_[pos_ - 1]; break;
+      }
+    }
+    Expect('"');
+    return result;
+  }
+
+  double ReadNumber() {
+    SkipWhitespace();
+    const char* start = json_.c_str() + pos_;
+    char* end = nullptr;
+    const double value = std::strtod(start, &end);
+    if (end == start) {
+      throw std::runtime_error("Expected number at offset " +
+                               std::to_string(pos_));
+    }
+    pos_ += end - start;
+    return value;
+  }
+
+  bool ReadBool() {
+    SkipWhitespace();
+    if (json_.compare(pos_, 4, "true") == 0) {
+      pos_ += 4;
+      return true;
+    }
+    if (json_.compare(pos_, 5, "false") == 0) {
+      pos_ += 5;
+      return false;
+    }
+    throw std::runtime_error("Expected boolean at offset " +
+                             std::to_string(pos_));
+  }
+
+  // Consumes "null" and returns true, or returns false for any other value
+  bool ReadNull() {
+    SkipWhitespace();
+    if (json_.compare(pos_, 4, "null") == 0) {
+      pos_ += 4;
+      return true;
+    }
+    return false;
+  }
+
+  // Skips any value without building strings or numbers; most of a layout
+  // tree (styles, geometry, glyph runs) is skipped
+  void SkipValue() {
+    const char c = Peek();
+    if (c == '"') {
+      SkipString();
+    } else if (c == '{' || c == '[') {
+      SkipContainer();
+    } else if (c == 't' || c == 'f') {
+      ReadBool();
+    } else if (c == 'n') {
+      if (!ReadNull()) {
+        throw std::runtime_error("Expected null at offset " +
+                                 std::to_string(pos_));
+      }
+    } else {
+      ReadNumber();
+    }
+  }
+
+ private:
+  void SkipString() {
+    ++pos_;  // Opening quote
+    while (pos_ < json_.size() && json_[pos_] != '"') {
+      pos_ += json_[pos_] == '\\' ? 2 : 1;
+    }
+    Expect('"');
+  }
+
+  // Skips a whole object or array by bracket depth
+  void SkipContainer() {
+    int depth = 0;
+    do {
+      const char c = json_[pos_];
+      if (c == '"') {
+        SkipString();
+        continue;
+      }
+      if (c == '{' || c == '[') {
+        ++depth;
+      } else if (c == '}' || c == ']') {
+        --depth;
+      }
+      ++pos_;
+    } while (depth > 0 && pos_ < json_.size());
+    if (depth > 0) {
+      throw std::runtime_error("Unterminated object or array");
+    }
+  }
+
+  uint32_t ReadHex4() {
+    if (pos_ + 4 > json_.size()) {
+      throw std::runtime_error("Truncated \\u escape");
+    }
+    const std::string hex = json_.substr(pos_, 4);
+    pos_ += 4;
+    return static_cast<uint32_t>(std::strtoul(hex.c_str(), nullptr, 16));
+  }
+
+  uint32_t ReadCodePoint() {
+    const uint32_t unit = ReadHex4();
+    if (unit >= 0xD800 && unit < 0xDC00 &&
+        json_.compare(pos_, 2, "\\u") == 0) {
+      const size_t saved = pos_;
+      pos_ += 2;
+      const uint32_t low = ReadHex4();
+      if (low >= 0xDC00 && low < 0xE000) {
+        return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+      }
+      pos_ = saved;
+    }
+    return unit;
+  }
+
+  static void AppendUtf8(uint32_t code_point, std::string& out) {
+    if (code_point < 0x80) {
+      out += static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+      out += static_cast<char>(0xC0 | (code_point >> 6));
+      out += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+      out += static_cast<char>(0xE0 | (code_point >> 12));
+      out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else {
+      out += static_cast<char>(0xF0 | (code_point >> 18));
+      out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+  }
+
+  const std::string& json_;
+  size_t pos_;
+};
+
+// Calls |member(key)| for every key of an object; |member| consumes the value
+template <typename Fn>
+void ParseObject(JsonTokenizer& tok, Fn member) {
+  tok.Expect('{');
+  while (tok.Peek() != '}') {
+    std::string key = tok.ReadString();
+    tok.Expect(':');
+    member(key);
+    if (tok.Peek() == ',') tok.Consume();
+  }
+  tok.Expect('}');
+}
+
+// Calls |element()| for every element of an array
+template <typename Fn>
+void ParseArray(JsonTokenizer& tok, Fn element) {
+  tok.Expect('[');
+  while (tok.Peek() != ']') {
+    element();
+    if (tok.Peek() == ',') tok.Consume();
+  }
+  tok.Expect(']');
+}
+
+std::optional<bool> ReadOptionalBool(JsonTokenizer& tok) {
+  if (tok.ReadNull()) {
+    return std::nullopt;
+  }
+  return tok.ReadBool();
+}
+
+LayoutObject ParseLayoutObject(JsonTokenizer& tok) {
+  LayoutObject object;
+  ParseObject(tok, [&](const std::string& key) {
+    if (key == "id") {
+      object.id = static_cast<int64_t>(tok.ReadNumber());
+    } else if (key == "name") {
+      if (!tok.ReadNull()) {
+        object.name = tok.ReadString();
+      }
+    } else if (key == "z_index") {
+      if (!tok.ReadNull()) {
+        object.z_index = tok.ReadNumber();
+      }
+    } else if (key == "is_stacking_context") {
+      object.is_stacking_context = ReadOptionalBool(tok);
+    } else if (key == "is_stacked") {
+      object.is_stacked = ReadOptionalBool(tok);
+    } else if (key == "is_self_painting") {
+      object.is_self_painting = ReadOptionalBool(tok);
+    } else if (key == "has_layer") {
+      object.has_layer = ReadOptionalBool(tok).value_or(false);
+    } else if (key == "children") {
+      ParseArray(tok, [&]() {
+        object.children.push_back(static_cast<int64_t>(tok.ReadNumber()));
+      });
+    } else {
+      tok.SkipValue();
+    }
+  });
+  return object;
+}
+
+struct LayerEntry {
+  StackingLayer layer;
+  std::vector<int64_t> children;  // Layer ids
+};
+
+LayerEntry ParseLayerEntry(JsonTokenizer& tok) {
+  LayerEntry entry;
+  ParseObject(tok, [&](const std::string& key) {
+    if (key == "id") {
+      entry.layer.id = static_cast<int64_t>(tok.ReadNumber());
+    } else if (key == "name") {
+      if (!tok.ReadNull()) {
+        entry.layer.name = tok.ReadString();
+      }
+    } else if (key == "z_index") {
+      if (!tok.ReadNull()) {
+        entry.layer.z_index = tok.ReadNumber();
+      }
+    } else if (key == "is_stacking_context") {
+      entry.layer.is_stacking_context = ReadOptionalBool(tok).value_or(false);
+    } else if (key == "is_stacked") {
+      entry.layer.is_stacked = ReadOptionalBool(tok).value_or(false);
+    } else if (key == "children") {
+      ParseArray(tok, [&]() {
+        entry.children.push_back(static_cast<int64_t>(tok.ReadNumber()));
+      });
+    } else {
+      tok.SkipValue();
+    }
+  });
+  return entry;
+}
+
+std::unordered_map<int64_t, uint32_t> IndexById(
+    const std::vector<StackingLayer>& layers) {
+  std::unordered_map<int64_t, uint32_t> index_of;
+  index_of.reserve(layers.size());
+  for (uint32_t i = 0; i < layers.size(); ++i) {
+    index_of[layers[i].id] = i;
+  }
+  return index_of;
+}
+
+// JSON.stringify's string escaping: quotes, backslashes and control
+// characters; everything else, including non-ASCII, is written as is
+void AppendString(const std::string& value, std::string& out) {
+  out += '"';
+  for (const char c : value) {
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\b': out += "\\b"; break;
+      case '\f': out += "\\f"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x",
+                        static_cast<unsigned char>(c));
+          out += escaped;
+        } else {
+          out += c;
+        }
+        break;
+    }
+  }
+  out += '"';
+}
+
+// JavaScript's Number to String: the fewest digits that round-trip, in
+// fixed notation for exponents in [-7, 21), else as d.ddde+n
+void AppendNumber(double value, std::string& out) {
+  if (!std::isfinite(value)) {
+    out += "null";
+    return;
+  }
+  if (value == 0.0) {
+    out += "0";
+    return;
+  }
+  char buffer[32];
+  for (int precision = 1; precision <= 17; ++precision) {
+    std::snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, value);
+    if (std::strtod(buffer, nullptr) == value) {
+      break;
+    }
+  }
+  // buffer is [-]d[.ddd]e[+-]xx
+  std::string text = buffer;
+  if (text[0] == '-') {
+    out += '-';
+    text.erase(0, 1);
+  }
+  const size_t e = text.find('e');
+  std::string digits = text.substr(0, e);
+  digits.erase(std::remove(digits.begin(), digits.end(), '.'), digits.end());
+  const int k = static_cast<int>(digits.size());
+  const int n = std::atoi(text.c_str() + e + 1) + 1;
+  if (k <= n && n <= 21) {
+    out += digits;
+    out.append(n - k, '0');
+  } else if (0 < n && n <= 21) {
+    out += digits.substr(0, n);
+    out += '.';
+    out += digits.substr(n);
+  } else if (-6 < n && n <= 0) {
+    out += "0.";
+    out.append(-n, '0');
+    out += digits;
+  } else {
+    out += digits[0];
+    if (k > 1) {
+      out += '.';
+      out += digits.substr(1);
+    }
+    out += n - 1 < 0 ? "e-" : "e+";
+    out += std::to_string(std::abs(n - 1));
+  }
+}
+
+void AppendBool(bool value, std::string& out) {
+  out += value ? "true" : "false";
+}
+
+void AppendIndex(int64_t value, std::string& out) {
+  out += std::to_string(value);
+}
+
+}  // namespace
+
+std::vector<StackingLayer> ParseLayerTree(const std::string& json_str) {
+  JsonTokenizer tok(json_str);
+  std::vector<LayerEntry> entries;
+  ParseObject(tok, [&](const std::string& key) {
+    if (key == "layer_tree") {
+      ParseArray(tok, [&]() { entries.push_back(ParseLayerEntry(tok)); });
+    } else {
+      tok.SkipValue();
+    }
+  });
+
+  std::vector<StackingLayer> layers;
+  layers.reserve(entries.size());
+  for (LayerEntry& entry : entries) {
+    layers.push_back(std::move(entry.layer));
+  }
+  // Children ids to indices; the last layer listing a child is its parent
+  const std::unordered_map<int64_t, uint32_t> index_of = IndexById(layers);
+  for (uint32_t i = 0; i < layers.size(); ++i) {
+    for (int64_t child_id : entries[i].children) {
+      auto it = index_of.find(child_id);
+      if (it == index_of.end()) {
+        continue;
+      }
+      layers[i].children.push_back(it->second);
+      layers[it->second].parent = i;
+    }
+  }
+  return layers;
+}
+
+std::vector<StackingChange> ParseStackingChanges(
+    const std::string& json_str, const std::vector<StackingLayer>& layers) {
+  const std::unordered_map<int64_t, uint32_t> index_of = IndexById(layers);
+  JsonTokenizer tok(json_str);
+  std::vector<StackingChange> changes;
+  ParseObject(tok, [&](const std::string& key) {
+    if (key != "changes") {
+      tok.SkipValue();
+      return;
+    }
+    ParseArray(tok, [&]() {
+      StackingChange change;
+      std::optional<int64_t> id;
+      ParseObject(tok, [&](const std::string& field) {
+        if (field == "id") {
+          id = static_cast<int64_t>(tok.ReadNumber());
+        } else if (field == "z_index") {
+          if (!tok.ReadNull()) {
+            change.z_index = tok.ReadNumber();
+          }
+        } else if (field == "is_stacked") {
+          change.is_stacked = ReadOptionalBool(tok);
+        } else if (field == "is_stacking_context") {
+          change.is_stacking_context = ReadOptionalBool(tok);
+        } else {
+          tok.SkipValue();
+        }
+      });
+      auto it = id ? index_of.find(*id) : index_of.end();
+      if (it == index_of.end()) {
+        throw std::runtime_error("Change for an unknown layer id");
+      }
+      change.layer = it->second;
+      changes.push_back(change);
+    });
+  });
+  return changes;
+}
+
+std::string SerializeStackingNodes(const StackingNodeTree& tree) {
+  // JSON.stringify(output, null, 3)
+  const char* kNode = "\n      ";
+  const char* kField = "\n         ";
+  const char* kItem = "\n            ";
+  const char* kItemField = "\n               ";
+
+  const std::vector<StackingLayer>& layers = tree.layers();
+  auto append_list = [&](const char* name, const std::vector<uint32_t>& list,
+                         std::string& out) {
+    out += kField;
+    out += name;
+    out += ": [";
+    for (size_t i = 0; i < list.size(); ++i) {
+      const StackingLayer& layer = layers[list[i]];
+      out += i == 0 ? "" : ",";
+      out += kItem;
+      out += "{";
+      out += kItemField;
+      out += "\"id\": ";
+      AppendIndex(layer.id, out);
+      if (layer.name) {
+        out += ",";
+        out += kItemField;
+        out += "\"name\": ";
+        AppendString(*layer.name, out);
+      }
+      // Listed layers always have a z-index
+      out += ",";
+      out += kItemField;
+      out += "\"z_index\": ";
+      AppendNumber(*layer.z_index, out);
+      out += kItem;
+      out += "}";
+    }
+    if (!list.empty()) {
+      out += kField;
+    }
+    out += "]";
+  };
+
+  std::string out = "{\n   \"stacking_nodes\": [";
+  bool first = true;
+  for (uint32_t i = 0; i < layers.size(); ++i) {
+    if (!tree.HasStackingNode(i)) {
+      continue;
+    }
+    const StackingLayer& layer = layers[i];
+    const ZOrderLists& lists = tree.Lists(i);
+    out += first ? "" : ",";
+    first = false;
+    out += kNode;
+    out += "{";
+    out += kField;
+    out += "\"layer_id\": ";
+    AppendIndex(layer.id, out);
+    if (layer.name) {
+      out += ",";
+      out += kField;
+      out += "\"layer\": ";
+      AppendString(*layer.name, out);
+    }
+    out += ",";
+    out += kField;
+    out += "\"has_stacking_node\": true,";
+    append_list("\"neg_z_order_list\"", lists.neg, out);
+    out += ",";
+    append_list("\"pos_z_order_list\"", lists.pos, out);
+    out += kNode;
+    out += "}";
+  }
+  if (!first) {
+    out += "\n   ";
+  }
+  out += "]\n}";
+  return out;
+}
+
+std::string NumberToString(double value) {
+  std::string out;
+  AppendNumber(value, out);
+  return out;
+}
+
+std::vector<LayoutObject> ParseLayoutTree(const std::string& json_str) {
+  JsonTokenizer tok(json_str);
+  std::vector<LayoutObject> objects;
+  ParseObject(tok, [&](const std::string& key) {
+    if (key == "layout_tree") {
+      ParseArray(tok, [&]() { objects.push_back(ParseLayoutObject(tok)); });
+    } else {
+      tok.SkipValue();
+    }
+  });
+  return objects;
+}
+
+std::string SerializeLayerTree(const LayerTree& tree,
+                               const std::vector<LayoutObject>& objects) {
+  // JSON.stringify(output, null, 3): nested levels indent by 3 spaces
+  const char* kLayer = "\n      ";
+  const char* kField = "\n         ";
+  const char* kChild = "\n            ";
+
+  std::string out;
+  out.reserve(tree.layers.size() * 256 + 32);
+  out += "{\n   \"layer_tree\": [";
+  for (size_t i = 0; i < tree.layers.size(); ++i) {
+    const PaintLayer& layer = tree.layers[i];
+    const LayoutObject& object = objects[layer.layout_object];
+    out += i == 0 ? "" : ",";
+    out += kLayer;
+    out += "{";
+    out += kField;
+    out += "\"id\": ";
+    AppendIndex(layer.id, out);
+    // Fields missing from the input are left out, like undefined in JS
+    if (object.name) {
+      out += ",";
+      out += kField;
+      out += "\"name\": ";
+      AppendString(*object.name, out);
+    }
+    if (object.z_index) {
+      out += ",";
+      out += kField;
+      out += "\"z_index\": ";
+      AppendNumber(*object.z_index, out);
+    }
+    if (object.is_stacking_context) {
+      out += ",";
+      out += kField;
+      out += "\"is_stacking_context\": ";
+      AppendBool(*object.is_stacking_context, out);
+    }
+    if (object.is_stacked) {
+      out += ",";
+      out += kField;
+      out += "\"is_stacked\": ";
+      AppendBool(*object.is_stacked, out);
+    }
+    out += ",";
+    out += kField;
+    out += "\"is_self_painting\": ";
+    AppendBool(object.is_self_painting.value_or(true), out);
+    if (layer.parent != kNoIndex) {
+      out += ",";
+      out += kField;
+      out += "\"parent_id\": ";
+      AppendIndex(tree.layers[layer.parent].id, out);
+    }
+    out += ",";
+    out += kField;
+    out += "\"children\": [";
+    for (size_t c = 0; c < layer.children.size(); ++c) {
+      out += c == 0 ? "" : ",";
+      out += kChild;
+      AppendIndex(tree.layers[layer.children[c]].id, out);
+    }
+    if (!layer.children.empty()) {
+      out += kField;
+    }
+    out += "],";
+    out += kField;
+    out += "\"depth\": ";
+    AppendIndex(layer.depth, out);
+    out += kLayer;
+    out += "}";
+  }
+  if (!tree.layers.empty()) {
+    out += "\n   ";
+  }
+  out += "]\n}";
+  return out;
+}
+
+}  // namespace layer_tree
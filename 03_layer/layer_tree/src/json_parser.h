@@ -0,0 +1,43 @@
+#ifndef LAYER_TREE_JSON_PARSER_H_
+#define LAYER_TREE_JSON_PARSER_H_
+
+#include <string>
+#include <vector>
+
+#include "layer_tree.h"
+#include "stacking_node.h"
+
+namespace layer_tree {
+
+// Parse the layout_tree JSON ({"layout_tree": [node, ...]}, as written by
+// 02_shape) into its LayoutObjects, skipping the fields the layer tree does
+// not use. Throws std::runtime_error on malformed JSON.
+std::vector<LayoutObject> ParseLayoutTree(const std::string& json_str);
+
+// Serialize to {"layer_tree": [...]}, byte for byte as compute_layer_tree.js
+// writes computed_layer_tree.json (JSON.stringify with a 3-space indent)
+std::string SerializeLayerTree(const LayerTree& tree,
+                               const std::vector<LayoutObject>& objects);
+
+// Parse a layer tree ({"layer_tree": [...]}, as SerializeLayerTree and
+// compute_layer_tree.js write it) into the layers the stacking computation
+// reads. Throws std::runtime_error on malformed JSON.
+std::vector<StackingLayer> ParseLayerTree(const std::string& json_str);
+
+// Parse {"changes": [{"id", "z_index"?, "is_stacked"?,
+// "is_stacking_context"?}, ...]}, where id is a layer id of |layers|.
+// Throws std::runtime_error on malformed JSON or an unknown id.
+std::vector<StackingChange> ParseStackingChanges(
+    const std::string& json_str, const std::vector<StackingLayer>& layers);
+
+// Serialize to {"stacking_nodes": [...]}, byte for byte as
+// compute_stacking_nodes.js writes computed_stacking_nodes.json: the
+// stacking contexts with a stacking node, in layer order
+std::string SerializeStackingNodes(const StackingNodeTree& tree);
+
+// JavaScript's String(number), as the output uses for z_index
+std::string NumberToString(double value);
+
+}  // namespace layer_tree
+
+#endif  // LAYER_TREE_JSON_PARSER_H_
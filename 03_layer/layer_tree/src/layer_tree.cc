@@ -0,0 +1,127 @@
+#include "layer_tree.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+namespace layer_tree {
+
+LayerTree BuildLayerTree(const std::vector<LayoutObject>& objects,
+                         BuildStats* stats) {
+  const uint32_t count = static_cast<uint32_t>(objects.size());
+  LayerTree tree;
+
+  // Resolve child ids once, into one flat array (CSR)
+  std::unordered_map<int64_t, uint32_t> index_of;
+  index_of.reserve(count);
+  size_t child_count = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    index_of[objects[i].id] = i;
+    child_count += objects[i].children.size();
+  }
+  std::vector<uint32_t> child_begin(count + 1, 0);
+  std::vector<uint32_t> child_index;
+  child_index.reserve(child_count);
+  std::vector<uint32_t> parent(count, kNoIndex);
+  for (uint32_t i = 0; i < count; ++i) {
+    child_begin[i] = static_cast<uint32_t>(child_index.size());
+    for (int64_t child_id : objects[i].children) {
+      auto it = index_of.find(child_id);
+      if (it == index_of.end()) {
+        continue;
+      }
+      child_index.push_back(it->second);
+      parent[it->second] = i;  // The last node listing a child is its parent
+    }
+  }
+  child_begin[count] = static_cast<uint32_t>(child_index.size());
+
+  // One layer per has_layer object, in object order
+  std::vector<uint32_t> layer_of(count, kNoIndex);
+  for (uint32_t i = 0; i < count; ++i) {
+    if (objects[i].has_layer) {
+      layer_of[i] = static_cast<uint32_t>(tree.layers.size());
+      PaintLayer layer;
+      layer.layout_object = i;
+      tree.layers.push_back(std::move(layer));
+    }
+  }
+
+  // Depth-first walk from every root; each entry carries its enclosing
+  // layer, so the layer stack is implicit in the walk's stack
+  struct Entry {
+    uint32_t object;
+    uint32_t enclosing_layer;
+    uint32_t depth;
+  };
+  std::vector<Entry> stack;
+  std::vector<bool> visited(count, false);
+  uint32_t max_object_depth = 0;
+  for (uint32_t root = 0; root < count; ++root) {
+    if (parent[root] != kNoIndex) {
+      continue;
+    }
+    stack.push_back({root, kNoIndex, 0});
+    while (!stack.empty()) {
+      const Entry entry = stack.back();
+      stack.pop_back();
+      if (visited[entry.object]) {
+        continue;  // Listed twice by its parent
+      }
+      visited[entry.object] = true;
+      max_object_depth = std::max(max_object_depth, entry.depth);
+
+      uint32_t enclosing_layer = entry.enclosing_layer;
+      const uint32_t layer = layer_of[entry.object];
+      if (layer != kNoIndex) {
+        tree.layers[layer].parent = enclosing_layer;
+        enclosing_layer = layer;
+      }
+      for (uint32_t c = child_begin[entry.object];
+           c < child_begin[entry.object + 1]; ++c) {
+        const uint32_t child = child_index[c];
+        if (parent[child] == entry.object) {
+          stack.push_back({child, enclosing_layer, entry.depth + 1});
+        }
+      }
+    }
+  }
+
+  // Layer children in object order
+  for (uint32_t i = 0; i < tree.layers.size(); ++i) {
+    const uint32_t layer_parent = tree.layers[i].parent;
+    if (layer_parent == kNoIndex) {
+      tree.roots.push_back(i);
+    } else {
+      tree.layers[layer_parent].children.push_back(i);
+    }
+  }
+
+  // Number the layers in depth-first pre-order and set their depths
+  std::vector<uint32_t> layer_stack;
+  int64_t next_id = 0;
+  uint32_t max_layer_depth = 0;
+  for (uint32_t root : tree.roots) {
+    tree.layers[root].depth = 0;
+    layer_stack.push_back(root);
+    while (!layer_stack.empty()) {
+      PaintLayer& layer = tree.layers[layer_stack.back()];
+      layer_stack.pop_back();
+      layer.id = next_id++;
+      max_layer_depth = std::max(max_layer_depth, layer.depth);
+      for (auto it = layer.children.rbegin(); it != layer.children.rend();
+           ++it) {
+        tree.layers[*it].depth = layer.depth + 1;
+        layer_stack.push_back(*it);
+      }
+    }
+  }
+
+  if (stats) {
+    stats->max_object_depth = max_object_depth;
+    stats->max_layer_depth = max_layer_depth;
+  }
+  return tree;
+}
+
+}  // namespace layer_tree
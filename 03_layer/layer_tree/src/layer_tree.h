@@ -0,0 +1,69 @@
+// Layer Tree
+// Builds the PaintLayer tree from the LayoutObject tree, like
+// compute_layer_tree.js but in one pass
+//
+// A PaintLayer is created for every LayoutObject with has_layer
+// (LayerTypeRequired() != kNoPaintLayer). The PaintLayer tree is a sparse
+// subset of the LayoutObject tree: a layer's parent is its enclosing layer,
+// the nearest ancestor LayoutObject that has one.
+//
+// See: layout_box.cc:498-513 (LayerTypeRequired)
+//      paint_layer.cc:829-852 (InsertOnlyThisLayerAfterStyleChange)
+
+#ifndef LAYER_TREE_LAYER_TREE_H_
+#define LAYER_TREE_LAYER_TREE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace layer_tree {
+
+constexpr uint32_t kNoIndex = UINT32_MAX;
+
+// The fields of a layout_tree node the layer tree needs. Optional fields are
+// copied to the layers only when present in the input.
+struct LayoutObject {
+  int64_t id = 0;
+  std::optional<std::string> name;
+  std::optional<double> z_index;
+  std::optional<bool> is_stacking_context;
+  std::optional<bool> is_stacked;
+  std::optional<bool> is_self_painting;
+  bool has_layer = false;
+  std::vector<int64_t> children;  // LayoutObject ids
+};
+
+struct PaintLayer {
+  uint32_t layout_object = kNoIndex;  // Into the LayoutObject list
+  uint32_t parent = kNoIndex;         // Into LayerTree::layers
+  std::vector<uint32_t> children;     // Into LayerTree::layers
+  int64_t id = 0;  // Depth-first pre-order, as Chromium numbers PaintLayers
+  uint32_t depth = 0;
+};
+
+// Layers in LayoutObject order (not tree order), as compute_layer_tree.js
+// lists them; each layer's children are in LayoutObject order too
+struct LayerTree {
+  std::vector<PaintLayer> layers;
+  std::vector<uint32_t> roots;  // Layers without an enclosing layer
+};
+
+struct BuildStats {
+  uint32_t max_object_depth = 0;  // Of the deepest LayoutObject
+  uint32_t max_layer_depth = 0;
+};
+
+// Builds the layer tree of |objects|. The LayoutObject parent of a node is
+// the last node listing it as a child; ids are expected to be unique (a
+// repeated id refers to its last node). The enclosing layer of every node
+// is found by one iterative depth-first walk whose stack carries the
+// current layer, so the cost is O(n) whatever the depth.
+LayerTree BuildLayerTree(const std::vector<LayoutObject>& objects,
+                         BuildStats* stats = nullptr);
+
+}  // namespace layer_tree
+
+#endif  // LAYER_TREE_LAYER_TREE_H_
@@ -0,0 +1,163 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "json_parser.h"
+#include "layer_tree.h"
+
+void PrintUsage(const char* program) {
+  std::cerr << "Usage: " << program << " -i <layout_tree.json> [-o <output.json>]\n";
+  std::cerr << "\n";
+  std::cerr << "Options:\n";
+  std::cerr << "  -i <file>  Layout tree JSON (required)\n";
+  std::cerr << "  -o <file>  Output JSON file (default: stdout)\n";
+  std::cerr << "  --report   Print compute_layer_tree.js's summary and layer tree\n";
+  std::cerr << "             to stderr\n";
+  std::cerr << "  --stats    Print tree depths and parse/build/serialize times to\n";
+  std::cerr << "             stderr\n";
+}
+
+namespace {
+
+// compute_layer_tree.js's console output
+void PrintReport(const layer_tree::LayerTree& tree,
+                 const std::vector<layer_tree::LayoutObject>& objects,
+                 std::ostream& os) {
+  const std::string rule(80, '=');
+  size_t stacking_contexts = 0;
+  size_t stacked = 0;
+  for (const layer_tree::PaintLayer& layer : tree.layers) {
+    const layer_tree::LayoutObject& object = objects[layer.layout_object];
+    stacking_contexts += object.is_stacking_context.value_or(false);
+    stacked += object.is_stacked.value_or(false);
+  }
+  os << rule << "\nPAINT LAYER TREE COMPUTED FROM LAYOUT TREE\n" << rule
+     << "\n\n";
+  os << "Total LayoutObjects: " << objects.size() << "\n";
+  os << "Total PaintLayers: " << tree.layers.size() << "\n";
+  os << "Layers that are stacking contexts: " << stacking_contexts << "\n";
+  os << "Layers that are stacked: " << stacked << "\n\n";
+  os << rule << "\nLAYER TREE STRUCTURE\n" << rule << "\n\n";
+
+  std::vector<uint32_t> stack(tree.roots.rbegin(), tree.roots.rend());
+  while (!stack.empty()) {
+    const layer_tree::PaintLayer& layer = tree.layers[stack.back()];
+    stack.pop_back();
+    const layer_tree::LayoutObject& object = objects[layer.layout_object];
+    os << std::string(2 * layer.depth, ' ') << "[" << layer.id << "] "
+       << object.name.value_or("undefined") << " (z: ";
+    if (object.z_index) {
+      os << layer_tree::NumberToString(*object.z_index);
+    } else {
+      os << "undefined";
+    }
+    os << ")";
+    const bool sc = object.is_stacking_context.value_or(false);
+    const bool stk = object.is_stacked.value_or(false);
+    if (sc || stk) {
+      os << " [" << (sc ? "SC" : "") << (sc && stk ? ", " : "")
+         << (stk ? "STK" : "") << "]";
+    }
+    os << "\n";
+    stack.insert(stack.end(), layer.children.rbegin(), layer.children.rend());
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string input_file;
+  std::string output_file;
+  bool print_report = false;
+  bool print_stats = false;
+
+  // Parse command line arguments
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-i" && i + 1 < argc) {
+      input_file = argv[++i];
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_file = argv[++i];
+    } else if (arg == "--report") {
+      print_report = true;
+    } else if (arg == "--stats") {
+      print_stats = true;
+    } else if (arg == "-h" || arg == "--help") {
+      PrintUsage(argv[0]);
+      return 0;
+    }
+  }
+
+  if (input_file.empty()) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  // Read input file
+  std::ifstream ifs(input_file);
+  if (!ifs) {
+    std::cerr << "Error: Cannot open input file: " << input_file << "\n";
+    return 1;
+  }
+
+  std::stringstream buffer;
+  buffer << ifs.rdbuf();
+  std::string json_input = buffer.str();
+
+  // Parse input
+  using Clock = std::chrono::steady_clock;
+  auto parse_start = Clock::now();
+  std::vector<layer_tree::LayoutObject> objects;
+  try {
+    objects = layer_tree::ParseLayoutTree(json_input);
+  } catch (const std::exception& e) {
+    std::cerr << "Error parsing input: " << e.what() << "\n";
+    return 1;
+  }
+
+  // Build the layer tree
+  auto build_start = Clock::now();
+  layer_tree::BuildStats stats;
+  layer_tree::LayerTree tree = layer_tree::BuildLayerTree(objects, &stats);
+
+  // Serialize output
+  auto serialize_start = Clock::now();
+  std::string json_output = layer_tree::SerializeLayerTree(tree, objects);
+  auto serialize_end = Clock::now();
+
+  if (print_report) {
+    PrintReport(tree, objects, std::cerr);
+  }
+  if (print_stats) {
+    using Ms = std::chrono::duration<double, std::milli>;
+    std::cerr << "layout objects: " << objects.size() << " (max depth "
+              << stats.max_object_depth << ")\n";
+    std::cerr << "paint layers: " << tree.layers.size() << " (max depth "
+              << stats.max_layer_depth << ")\n";
+    std::cerr << std::fixed << std::setprecision(3)
+              << "parse time: " << Ms(build_start - parse_start).count()
+              << " ms\n"
+              << "build time: " << Ms(serialize_start - build_start).count()
+              << " ms\n"
+              << "serialize time: "
+              << Ms(serialize_end - serialize_start).count() << " ms\n";
+  }
+
+  // Write output
+  if (output_file.empty()) {
+    std::cout << json_output;
+  } else {
+    std::ofstream ofs(output_file);
+    if (!ofs) {
+      std::cerr << "Error: Cannot open output file: " << output_file << "\n";
+      return 1;
+    }
+    ofs << json_output;
+  }
+
+  return 0;
+}
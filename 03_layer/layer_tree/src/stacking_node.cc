@@ -0,0 +1,179 @@
+#include "stacking_node.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace layer_tree {
+
+std::vector<StackingLayer> StackingLayersFromLayerTree(
+    const LayerTree& tree, const std::vector<LayoutObject>& objects) {
+  std::vector<StackingLayer> layers;
+  layers.reserve(tree.layers.size());
+  for (const PaintLayer& layer : tree.layers) {
+    const LayoutObject& object = objects[layer.layout_object];
+    StackingLayer stacking_layer;
+    stacking_layer.id = layer.id;
+    stacking_layer.name = object.name;
+    stacking_layer.z_index = object.z_index;
+    stacking_layer.is_stacked = object.is_stacked.value_or(false);
+    stacking_layer.is_stacking_context =
+        object.is_stacking_context.value_or(false);
+    stacking_layer.parent = layer.parent;
+    stacking_layer.children = layer.children;
+    layers.push_back(std::move(stacking_layer));
+  }
+  return layers;
+}
+
+StackingNodeTree::StackingNodeTree(std::vector<StackingLayer> layers)
+    : layers_(std::move(layers)) {
+  BuildAll();
+}
+
+bool StackingNodeTree::HasStackingNode(uint32_t layer) const {
+  return layers_[layer].is_stacking_context &&
+         lists_[layer].stacked_descendants > 0;
+}
+
+uint32_t StackingNodeTree::EnclosingStackingContext(uint32_t layer) const {
+  for (uint32_t ancestor = layers_[layer].parent; ancestor != kNoIndex;
+       ancestor = layers_[ancestor].parent) {
+    if (layers_[ancestor].is_stacking_context) {
+      return ancestor;
+    }
+  }
+  return kNoIndex;
+}
+
+void StackingNodeTree::Append(uint32_t context, uint32_t layer) {
+  ZOrderLists& lists = lists_[context];
+  ++lists.stacked_descendants;
+  const std::optional<double>& z_index = layers_[layer].z_index;
+  if (z_index) {
+    (*z_index < 0 ? lists.neg : lists.pos).push_back(layer);
+  }
+}
+
+void StackingNodeTree::SortLists(uint32_t context) {
+  // Layers were appended in tree order, which breaks z-index ties
+  auto by_z_index = [this](uint32_t a, uint32_t b) {
+    return *layers_[a].z_index < *layers_[b].z_index;
+  };
+  ZOrderLists& lists = lists_[context];
+  std::stable_sort(lists.neg.begin(), lists.neg.end(), by_z_index);
+  std::stable_sort(lists.pos.begin(), lists.pos.end(), by_z_index);
+}
+
+void StackingNodeTree::BuildAll() {
+  lists_.assign(layers_.size(), ZOrderLists());
+  stats_ = StackingStats();
+
+  // One pre-order walk; each entry carries its enclosing stacking context
+  struct Entry {
+    uint32_t layer;
+    uint32_t context;
+  };
+  std::vector<Entry> stack;
+  for (uint32_t root = 0; root < layers_.size(); ++root) {
+    if (layers_[root].parent != kNoIndex) {
+      continue;
+    }
+    stack.push_back({root, kNoIndex});
+    while (!stack.empty()) {
+      const Entry entry = stack.back();
+      stack.pop_back();
+      ++stats_.layers_visited;
+      const StackingLayer& layer = layers_[entry.layer];
+      if (entry.context != kNoIndex && layer.is_stacked) {
+        Append(entry.context, entry.layer);
+      }
+      const uint32_t context =
+          layer.is_stacking_context ? entry.layer : entry.context;
+      for (auto it = layer.children.rbegin(); it != layer.children.rend();
+           ++it) {
+        stack.push_back({*it, context});
+      }
+    }
+  }
+
+  for (uint32_t i = 0; i < layers_.size(); ++i) {
+    if (layers_[i].is_stacking_context) {
+      SortLists(i);
+      ++stats_.contexts_rebuilt;
+    }
+  }
+}
+
+void StackingNodeTree::Rebuild(uint32_t context) {
+  lists_[context] = ZOrderLists();
+  ++stats_.contexts_rebuilt;
+  if (!layers_[context].is_stacking_context) {
+    return;
+  }
+
+  // CollectLayers: stacked descendants in tree order, stopping at nested
+  // stacking contexts
+  const std::vector<uint32_t>& children = layers_[context].children;
+  std::vector<uint32_t> stack(children.rbegin(), children.rend());
+  while (!stack.empty()) {
+    const uint32_t index = stack.back();
+    stack.pop_back();
+    ++stats_.layers_visited;
+    const StackingLayer& layer = layers_[index];
+    if (layer.is_stacked) {
+      Append(context, index);
+    }
+    if (!layer.is_stacking_context) {
+      stack.insert(stack.end(), layer.children.rbegin(),
+                   layer.children.rend());
+    }
+  }
+  SortLists(context);
+}
+
+void StackingNodeTree::Update(const std::vector<StackingChange>& changes) {
+  stats_ = StackingStats();
+
+  // Apply every change first, so enclosing stacking contexts are looked up
+  // with the new flags
+  std::vector<uint32_t> dirty;
+  std::vector<uint32_t> dirty_enclosing;
+  for (const StackingChange& change : changes) {
+    StackingLayer& layer = layers_[change.layer];
+    const bool was_stacked = layer.is_stacked;
+    bool affects_enclosing = false;
+    if (change.z_index && change.z_index != layer.z_index) {
+      layer.z_index = change.z_index;
+      affects_enclosing |= was_stacked || layer.is_stacked;
+    }
+    if (change.is_stacked && *change.is_stacked != layer.is_stacked) {
+      layer.is_stacked = *change.is_stacked;
+      affects_enclosing = true;
+    }
+    if (change.is_stacking_context &&
+        *change.is_stacking_context != layer.is_stacking_context) {
+      // Its own lists appear or go, and its descendants move between it
+      // and its enclosing stacking context
+      layer.is_stacking_context = *change.is_stacking_context;
+      dirty.push_back(change.layer);
+      affects_enclosing = true;
+    }
+    if (affects_enclosing) {
+      dirty_enclosing.push_back(change.layer);
+    }
+  }
+  for (uint32_t layer : dirty_enclosing) {
+    const uint32_t context = EnclosingStackingContext(layer);
+    if (context != kNoIndex) {
+      dirty.push_back(context);
+    }
+  }
+
+  std::sort(dirty.begin(), dirty.end());
+  dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+  for (uint32_t context : dirty) {
+    Rebuild(context);
+  }
+}
+
+}  // namespace layer_tree
@@ -0,0 +1,100 @@
+// Stacking Node
+// PaintLayerStackingNode: the z-order lists of every stacking context, like
+// compute_stacking_nodes.js, built in one pass and rebuilt incrementally
+//
+// A stacking context gets a stacking node when it has stacked descendants
+// in its stacking context (UpdateStackingNode() in paint_layer.cc:858-877).
+// Its z-order lists hold those descendants, collected in tree order without
+// entering nested stacking contexts (CollectLayers() in
+// paint_layer_stacking_node.cc:315-338), split by the sign of z-index and
+// stable-sorted by it (RebuildZOrderLists).
+
+#ifndef LAYER_TREE_STACKING_NODE_H_
+#define LAYER_TREE_STACKING_NODE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "layer_tree.h"
+
+namespace layer_tree {
+
+// A PaintLayer as the stacking computation sees it
+struct StackingLayer {
+  int64_t id = 0;
+  std::optional<std::string> name;
+  std::optional<double> z_index;  // Layers without one are in neither list
+  bool is_stacked = false;
+  bool is_stacking_context = false;
+  uint32_t parent = kNoIndex;      // Into the layer list
+  std::vector<uint32_t> children;  // Into the layer list, in paint order
+};
+
+// The stacking layers of a built layer tree, in the same order
+std::vector<StackingLayer> StackingLayersFromLayerTree(
+    const LayerTree& tree, const std::vector<LayoutObject>& objects);
+
+struct ZOrderLists {
+  std::vector<uint32_t> neg;  // z-index < 0, by increasing z-index
+  std::vector<uint32_t> pos;  // z-index >= 0, by increasing z-index
+  uint32_t stacked_descendants = 0;
+};
+
+// A property change on one layer; unset fields keep their value
+struct StackingChange {
+  uint32_t layer = kNoIndex;
+  std::optional<double> z_index;
+  std::optional<bool> is_stacked;
+  std::optional<bool> is_stacking_context;
+};
+
+struct StackingStats {
+  size_t contexts_rebuilt = 0;
+  size_t layers_visited = 0;
+};
+
+class StackingNodeTree {
+ public:
+  // Builds the z-order lists of every stacking context with one walk of the
+  // layer tree
+  explicit StackingNodeTree(std::vector<StackingLayer> layers);
+
+  const std::vector<StackingLayer>& layers() const { return layers_; }
+
+  // Whether |layer| is a stacking context with stacked descendants
+  bool HasStackingNode(uint32_t layer) const;
+
+  // Empty for layers that are not stacking contexts
+  const ZOrderLists& Lists(uint32_t layer) const { return lists_[layer]; }
+
+  // Applies |changes| and rebuilds the lists of the stacking contexts they
+  // affect, and only those: the enclosing stacking context of a layer whose
+  // z-index or is_stacked changed, and both the layer and its enclosing
+  // stacking context when is_stacking_context changed. Cost is the size of
+  // the rebuilt contexts (each up to its nested stacking contexts), not of
+  // the tree.
+  void Update(const std::vector<StackingChange>& changes);
+
+  // Work done by the constructor or the last Update()
+  const StackingStats& stats() const { return stats_; }
+
+ private:
+  // The nearest ancestor that is a stacking context
+  uint32_t EnclosingStackingContext(uint32_t layer) const;
+
+  void BuildAll();
+  void Rebuild(uint32_t context);
+  void Append(uint32_t context, uint32_t layer);
+  void SortLists(uint32_t context);
+
+  std::vector<StackingLayer> layers_;
+  std::vector<ZOrderLists> lists_;  // Per layer
+  StackingStats stats_;
+};
+
+}  // namespace layer_tree
+
+#endif  // LAYER_TREE_STACKING_NODE_H_
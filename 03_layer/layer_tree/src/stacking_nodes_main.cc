@@ -0,0 +1,149 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "json_parser.h"
+#include "layer_tree.h"
+#include "stacking_node.h"
+
+void PrintUsage(const char* program) {
+  std::cerr << "Usage: " << program << " -i <layer_tree.json> [-o <output.json>]\n";
+  std::cerr << "\n";
+  std::cerr << "Options:\n";
+  std::cerr << "  -i <file>        Layer tree JSON (required)\n";
+  std::cerr << "  -o <file>        Output JSON file (default: stdout)\n";
+  std::cerr << "  --layout-tree    The input is a layout tree; build its layer tree first\n";
+  std::cerr << "  --changes <file> Apply {\"changes\": [...]} after building, rebuilding\n";
+  std::cerr << "                   only the affected stacking contexts\n";
+  std::cerr << "  --stats          Print stacking contexts rebuilt, layers visited and\n";
+  std::cerr << "                   times to stderr\n";
+}
+
+namespace {
+
+bool ReadFile(const std::string& path, std::string& contents) {
+  std::ifstream ifs(path);
+  if (!ifs) {
+    std::cerr << "Error: Cannot open input file: " << path << "\n";
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << ifs.rdbuf();
+  contents = buffer.str();
+  return true;
+}
+
+void PrintStats(const char* pass, const layer_tree::StackingStats& stats,
+                double ms) {
+  std::cerr << pass << ": " << stats.contexts_rebuilt
+            << " stacking contexts rebuilt, " << stats.layers_visited
+            << " layers visited, " << std::fixed << std::setprecision(3) << ms
+            << " ms\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string input_file;
+  std::string output_file;
+  std::string changes_file;
+  bool layout_tree_input = false;
+  bool print_stats = false;
+
+  // Parse command line arguments
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-i" && i + 1 < argc) {
+      input_file = argv[++i];
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_file = argv[++i];
+    } else if (arg == "--layout-tree") {
+      layout_tree_input = true;
+    } else if (arg == "--changes" && i + 1 < argc) {
+      changes_file = argv[++i];
+    } else if (arg == "--stats") {
+      print_stats = true;
+    } else if (arg == "-h" || arg == "--help") {
+      PrintUsage(argv[0]);
+      return 0;
+    }
+  }
+
+  if (input_file.empty()) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  std::string json_input;
+  if (!ReadFile(input_file, json_input)) {
+    return 1;
+  }
+
+  // Parse input
+  std::vector<layer_tree::StackingLayer> layers;
+  try {
+    if (layout_tree_input) {
+      std::vector<layer_tree::LayoutObject> objects =
+          layer_tree::ParseLayoutTree(json_input);
+      layers = layer_tree::StackingLayersFromLayerTree(
+          layer_tree::BuildLayerTree(objects), objects);
+    } else {
+      layers = layer_tree::ParseLayerTree(json_input);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Error parsing input: " << e.what() << "\n";
+    return 1;
+  }
+
+  // Build every z-order list
+  using Clock = std::chrono::steady_clock;
+  using Ms = std::chrono::duration<double, std::milli>;
+  auto build_start = Clock::now();
+  layer_tree::StackingNodeTree tree(std::move(layers));
+  Ms build_time = Clock::now() - build_start;
+  if (print_stats) {
+    PrintStats("build", tree.stats(), build_time.count());
+  }
+
+  // Then rebuild what the changes affect
+  if (!changes_file.empty()) {
+    std::string json_changes;
+    if (!ReadFile(changes_file, json_changes)) {
+      return 1;
+    }
+    std::vector<layer_tree::StackingChange> changes;
+    try {
+      changes = layer_tree::ParseStackingChanges(json_changes, tree.layers());
+    } catch (const std::exception& e) {
+      std::cerr << "Error parsing changes: " << e.what() << "\n";
+      return 1;
+    }
+    auto update_start = Clock::now();
+    tree.Update(changes);
+    Ms update_time = Clock::now() - update_start;
+    if (print_stats) {
+      PrintStats("update", tree.stats(), update_time.count());
+    }
+  }
+
+  // Serialize output
+  std::string json_output = layer_tree::SerializeStackingNodes(tree);
+
+  // Write output
+  if (output_file.empty()) {
+    std::cout << json_output;
+  } else {
+    std::ofstream ofs(output_file);
+    if (!ofs) {
+      std::cerr << "Error: Cannot open output file: " << output_file << "\n";
+      return 1;
+    }
+    ofs << json_output;
+  }
+
+  return 0;
+}
@@ -1,4 +1,101 @@
 #include "block_painter.h"
+#include "dark_mode_filter.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <variant>
+
+namespace block_painter {
+
+namespace {
+
+// Shared across Paint calls so the inverted-color cache spans the document
+DarkModeFilter& GetDarkModeFilter() {
+  static DarkModeFilter filter;
+  return filter;
+}
+
+Color ApplyDarkMode(const BlockPaintInput& input, const Color& color) {
+  if (!input.dark_mode.enabled) return color;
+  return GetDarkModeFilter().InvertColorIfNeeded(
+      color, DarkModeFilter::ElementRole::kBackground);
+}
+
+// Shrink a rect by per-side amounts (negative amounts grow it)
+RectF InsetRect(const RectF& rect, float top, float right, float bottom,
+                float left) {
+  return {rect.x + left, rect.y + top,
+          std::max(0.0f, rect.width - left - right),
+          std::max(0.0f, rect.height - top - bottom)};
+}
+
+RectF OutsetRect(const RectF& rect, float outset) {
+  return InsetRect(rect, -outset, -outset, -outset, -outset);
+}
+
+bool Intersects(const RectF& a, const RectF& b) {
+  return a.Left() < b.Right() && b.Left() < a.Right() &&
+         a.Top() < b.Bottom() && b.Top() < a.Bottom();
+}
+
+// Radii of the padding box edge: each corner loses the adjacent border widths
+BorderRadii InnerRadii(const BorderRadii& radii, const BorderWidths& widths) {
+  const float top = widths[0];
+  const float right = widths[1];
+  const float bottom = widths[2];
+  const float left = widths[3];
+  return {std::max(0.0f, radii[0] - left),  std::max(0.0f, radii[1] - top),
+          std::max(0.0f, radii[2] - right), std::max(0.0f, radii[3] - top),
+          std::max(0.0f, radii[4] - right), std::max(0.0f, radii[5] - bottom),
+          std::max(0.0f, radii[6] - left),  std::max(0.0f, radii[7] - bottom)};
+}
+
+// Tags every draw op with the box it paints, so the op can be matched to
+// the same box's op in another paint
+void SetNodeId(PaintOpList& ops, DOMNodeId node_id) {
+  for (PaintOp& op : ops.ops) {
+    std::visit(
+        [node_id](auto& o) {
+          using T = std::decay_t<decltype(o)>;
+          if constexpr (std::is_same_v<T, DrawRectOp> ||
+                        std::is_same_v<T, DrawRRectOp> ||
+                        std::is_same_v<T, DrawDRRectOp>) {
+            o.node_id = node_id;
+          }
+        },
+        op);
+  }
+}
+
+// FloatRoundedRect::ShrinkRadii / ExpandRadii for the shadow spread; square
+// corners stay square
+BorderRadii AdjustRadiiForSpread(const BorderRadii& radii, float spread) {
+  BorderRadii adjusted = radii;
+  for (float& r : adjusted) {
+    if (r > 0.0f) {
+      r = std::max(0.0f, r - spread);
+    }
+  }
+  return adjusted;
+}
+
+// Chromium's AreaCastingShadowInHole: the part of the plane whose shadow can
+// reach into the hole
+RectF AreaCastingShadowInHole(const RectF& hole_rect, float shadow_blur,
+                              float shadow_spread, float offset_x,
+                              float offset_y) {
+  RectF bounds = OutsetRect(hole_rect, shadow_blur);
+  if (shadow_spread < 0.0f) {
+    bounds = OutsetRect(bounds, -shadow_spread);
+  }
+  const float left = std::min(bounds.Left(), bounds.Left() - offset_x);
+  const float top = std::min(bounds.Top(), bounds.Top() - offset_y);
+  const float right = std::max(bounds.Right(), bounds.Right() - offset_x);
+  const float bottom = std::max(bounds.Bottom(), bounds.Bottom() - offset_y);
+  return {left, top, right - left, bottom - top};
+}
+
+}  // namespace
 
 PaintOpList BlockPainter::Paint(const BlockPaintInput& input) {
   PaintOpList ops;
@@ -8,33 +105,76 @@ PaintOpList BlockPainter::Paint(const BlockPaintInput& input) {
     return ops;
   }
 
-  // 2. If no background color, nothing to paint
-  if (!input.background_color.has_value()) {
+  // 2. Skip boxes outside the cull rect
+  if (!input.cull_rect.Intersects(VisualRect(input))) {
+    return ops;
+  }
+
+  // 3. If no background color and no inset shadow, nothing to paint
+  const bool has_inset_shadow =
+      std::any_of(input.box_shadow.begin(), input.box_shadow.end(),
+                  [](const BoxShadowData& shadow) { return shadow.inset; });
+  if (!input.background_color.has_value() && !has_inset_shadow) {
     return ops;
   }
 
-  // 3. Build paint flags with color and shadows
-  DrawFlags flags = BuildFlags(input);
-
-  // 4. Convert geometry to LTRB rect format
-  std::array<float, 4> rect = input.geometry.ToLTRB();
-
-  // 5. Output DrawRectOp or DrawRRectOp based on border radius
-  if (HasBorderRadius(input)) {
-    ops.DrawRRect(rect, *input.border_radii, flags,
-                  input.state_ids.transform_id,
-                  input.state_ids.clip_id,
-                  input.state_ids.effect_id);
-  } else {
-    ops.DrawRect(rect, flags,
-                 input.state_ids.transform_id,
-                 input.state_ids.clip_id,
-                 input.state_ids.effect_id);
+  if (input.background_color.has_value()) {
+    // 4. Build paint flags with color and shadows
+    DrawFlags flags = BuildFlags(input);
+
+    // 5. Convert geometry to LTRB rect format
+    std::array<float, 4> rect = input.geometry.ToLTRB();
+
+    // 6. Output DrawRectOp or DrawRRectOp based on border radius
+    if (HasBorderRadius(input)) {
+      ops.DrawRRect(rect, *input.border_radii, flags,
+                    input.state_ids.transform_id,
+                    input.state_ids.clip_id,
+                    input.state_ids.effect_id);
+    } else {
+      ops.DrawRect(rect, flags,
+                   input.state_ids.transform_id,
+                   input.state_ids.clip_id,
+                   input.state_ids.effect_id);
+    }
+  }
+
+  // 7. Inset shadows over the background, inside the padding box
+  // (PaintInsetBoxShadowWithBorderRect)
+  if (has_inset_shadow) {
+    const BorderWidths& widths = input.border_widths;
+    const RectF inner_rect = InsetRect(input.geometry, widths[0], widths[1],
+                                       widths[2], widths[3]);
+    const BorderRadii inner_radii =
+        HasBorderRadius(input) ? InnerRadii(*input.border_radii, widths)
+                               : BorderRadii{};
+    PaintInsetBoxShadowWithInnerRect(input, inner_rect, inner_radii, ops);
   }
 
+  SetNodeId(ops, input.node_id);
   return ops;
 }
 
+RectF BlockPainter::VisualRect(const BlockPaintInput& input) {
+  float left = input.geometry.Left();
+  float top = input.geometry.Top();
+  float right = input.geometry.Right();
+  float bottom = input.geometry.Bottom();
+  for (const auto& shadow : input.box_shadow) {
+    if (shadow.inset) {
+      continue;
+    }
+    // The blur reaches 3 sigma past the spread shape
+    const float outset = shadow.spread + 3.0f * shadow.BlurAsSigma();
+    const RectF rect = OutsetRect(input.geometry, outset);
+    left = std::min(left, rect.Left() + shadow.offset_x);
+    top = std::min(top, rect.Top() + shadow.offset_y);
+    right = std::max(right, rect.Right() + shadow.offset_x);
+    bottom = std::max(bottom, rect.Bottom() + shadow.offset_y);
+  }
+  return {left, top, right - left, bottom - top};
+}
+
 bool BlockPainter::HasBorderRadius(const BlockPaintInput& input) {
   if (!input.border_radii.has_value()) {
     return false;
@@ -47,7 +187,7 @@ DrawFlags BlockPainter::BuildFlags(const BlockPaintInput& input) {
 
   // Set color
   if (input.background_color.has_value()) {
-    flags.SetColor(*input.background_color);
+    flags.SetColor(ApplyDarkMode(input, *input.background_color));
   }
 
   // Set style to Fill
@@ -56,7 +196,7 @@ DrawFlags BlockPainter::BuildFlags(const BlockPaintInput& input) {
 
   // Add shadows
   for (const auto& shadow : input.box_shadow) {
-    // Skip inset shadows for now (they're painted differently)
+    // Inset shadows are painted after the background
     if (shadow.inset) {
       continue;
     }
@@ -65,10 +205,104 @@ DrawFlags BlockPainter::BuildFlags(const BlockPaintInput& input) {
     sf.offset_x = shadow.offset_x;
     sf.offset_y = shadow.offset_y;
     sf.blur_sigma = shadow.BlurAsSigma();
-    sf.color = shadow.color;
+    sf.color = ApplyDarkMode(input, shadow.color);
     sf.flags = 2;  // Standard shadow flags
     flags.shadows.push_back(sf);
   }
 
   return flags;
 }
+
+void BlockPainter::PaintInsetBoxShadowWithInnerRect(
+    const BlockPaintInput& input, const RectF& inner_rect,
+    const BorderRadii& inner_radii, PaintOpList& ops) {
+  const int transform_id = input.state_ids.transform_id;
+  const int clip_id = input.state_ids.clip_id;
+  const int effect_id = input.state_ids.effect_id;
+  const bool is_rounded = !IsZeroRadii(inner_radii);
+  const std::array<float, 4> inner_ltrb = inner_rect.ToLTRB();
+
+  auto fill_inner_rect = [&](const Color& color) {
+    DrawFlags flags;
+    flags.SetColor(color);
+    if (is_rounded) {
+      ops.DrawRRect(inner_ltrb, inner_radii, flags, transform_id, clip_id,
+                    effect_id);
+    } else {
+      ops.DrawRect(inner_ltrb, flags, transform_id, clip_id, effect_id);
+    }
+  };
+
+  // Shadows paint back to front: the first shadow ends up on top
+  for (auto it = input.box_shadow.rbegin(); it != input.box_shadow.rend();
+       ++it) {
+    const BoxShadowData& shadow = *it;
+    if (!shadow.inset) {
+      continue;
+    }
+    if (!shadow.offset_x && !shadow.offset_y && !shadow.blur &&
+        !shadow.spread) {
+      continue;
+    }
+    if (shadow.color.a == 0) {
+      continue;
+    }
+    const Color shadow_color = ApplyDarkMode(input, shadow.color);
+
+    // The hole is the padding box shrunk by the spread; once it is gone the
+    // shadow covers the whole box
+    const RectF hole_rect = InsetRect(inner_rect, shadow.spread, shadow.spread,
+                                      shadow.spread, shadow.spread);
+    if (hole_rect.width <= 0.0f || hole_rect.height <= 0.0f) {
+      fill_inner_rect(shadow_color);
+      continue;
+    }
+
+    // Blurred edges reach 3 sigma past the hole. When the offset hole does
+    // not come within that extent of the box, the box is fully shadowed, so
+    // the caster never grows with the offset beyond the box and its blur
+    const float blur_extent = 3.0f * shadow.BlurAsSigma();
+    const RectF cast_hole = {hole_rect.x + shadow.offset_x,
+                             hole_rect.y + shadow.offset_y, hole_rect.width,
+                             hole_rect.height};
+    if (!Intersects(cast_hole, OutsetRect(inner_rect, blur_extent))) {
+      fill_inner_rect(shadow_color);
+      continue;
+    }
+
+    // GraphicsContext::DrawInnerShadow: clip to the box, then fill the
+    // area around the hole with a shadow-only looper
+    const RectF outer_rect =
+        AreaCastingShadowInHole(inner_rect, shadow.blur, shadow.spread,
+                                shadow.offset_x, shadow.offset_y);
+    const BorderRadii hole_radii =
+        is_rounded ? AdjustRadiiForSpread(inner_radii, shadow.spread)
+                   : BorderRadii{};
+
+    ops.Save(transform_id, clip_id, effect_id);
+    if (is_rounded) {
+      ops.ClipRRect(inner_ltrb, inner_radii, true, transform_id, clip_id,
+                    effect_id);
+    } else {
+      ops.ClipRect(inner_ltrb, true, transform_id, clip_id, effect_id);
+    }
+
+    DrawFlags flags;
+    Color fill_color = shadow_color;
+    fill_color.a = 255;
+    flags.SetColor(fill_color);
+    ShadowFlag sf;
+    sf.offset_x = shadow.offset_x;
+    sf.offset_y = shadow.offset_y;
+    sf.blur_sigma = shadow.BlurAsSigma();
+    sf.color = shadow_color;
+    sf.flags = 2;  // kOverrideAlphaFlag (kShadowIgnoresAlpha)
+    flags.shadows.push_back(sf);
+    ops.DrawDRRect(outer_rect.ToLTRB(), BorderRadii{}, hole_rect.ToLTRB(),
+                   hole_radii, flags, transform_id, clip_id, effect_id);
+
+    ops.Restore(transform_id, clip_id, effect_id);
+  }
+}
+
+}  // namespace block_painter
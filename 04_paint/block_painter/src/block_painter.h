@@ -2,11 +2,14 @@
 #define BLOCK_PAINTER_BLOCK_PAINTER_H_
 
 #include "types.h"
+#include "cull_rect.h"
 #include "draw_commands.h"
 
 #include <optional>
 #include <vector>
 
+namespace block_painter {
+
 // Input context for block painting
 struct BlockPaintInput {
   // Geometry (x, y, width, height)
@@ -21,6 +24,9 @@ struct BlockPaintInput {
   // Box shadows
   std::vector<BoxShadowData> box_shadow;
 
+  // Border widths; inset shadows are painted inside the padding box
+  BorderWidths border_widths = {0.0f, 0.0f, 0.0f, 0.0f};
+
   // Visibility
   Visibility visibility = Visibility::kVisible;
 
@@ -29,6 +35,12 @@ struct BlockPaintInput {
 
   // Property tree state IDs
   GraphicsStateIds state_ids;
+
+  // Dark mode (background and box-shadow colors use the background role)
+  AutoDarkMode dark_mode;
+
+  // Boxes whose visual rect (outer shadows included) misses it paint nothing
+  CullRect cull_rect;
 };
 
 // Pure functional block painter
@@ -39,11 +51,23 @@ class BlockPainter {
   static PaintOpList Paint(const BlockPaintInput& input);
 
  private:
+  // Border box united with the outer shadows' blurred, spread rects
+  static RectF VisualRect(const BlockPaintInput& input);
+
   // Check if input has non-zero border radius
   static bool HasBorderRadius(const BlockPaintInput& input);
 
   // Build DrawFlags from input
   static DrawFlags BuildFlags(const BlockPaintInput& input);
+
+  // Inset shadows, cast by a DRRect around a hole and clipped to the
+  // padding box (inner_rect / inner_radii)
+  static void PaintInsetBoxShadowWithInnerRect(const BlockPaintInput& input,
+                                               const RectF& inner_rect,
+                                               const BorderRadii& inner_radii,
+                                               PaintOpList& ops);
 };
 
+}  // namespace block_painter
+
 #endif  // BLOCK_PAINTER_BLOCK_PAINTER_H_
@@ -0,0 +1,94 @@
+// Copyright 2017 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's CullRect
+// Original: third_party/blink/renderer/platform/graphics/paint/cull_rect.h
+//
+// Changes from Chromium:
+// - The rect stays in the root coordinate space and carries the 2D
+//   local-to-root transform of the painter's transform node; visual rects
+//   are mapped to the root instead of the cull rect to each local space
+// - No expansion for scrolling or composited transforms
+//   (CanExpandForScroll, ApplyPaintProperties): the caller passes the final
+//   rect
+// - Default constructed is infinite
+//
+// Module copies: text_painter/src/cull_rect.h is the canonical copy.
+// block_painter and border_painter build standalone, and each copy wraps its
+// own module's RectF, so they carry their own copies. Keep all three
+// identical apart from the namespace and the include guard, and change the
+// canonical copy first.
+
+#ifndef BLOCK_PAINTER_CULL_RECT_H_
+#define BLOCK_PAINTER_CULL_RECT_H_
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
+
+#include "types.h"
+
+namespace block_painter {
+
+class CullRect {
+ public:
+  // Local-to-root affine transform [a, b, c, d, e, f]:
+  // (x, y) -> (a * x + c * y + e, b * x + d * y + f)
+  using Transform = std::array<float, 6>;
+  static constexpr Transform kIdentity = {1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f};
+
+  CullRect() = default;
+  explicit CullRect(const RectF& root_rect,
+                    const Transform& local_to_root = kIdentity)
+      : rect_(root_rect), local_to_root_(local_to_root) {}
+
+  static CullRect Infinite() { return CullRect(); }
+
+  bool IsInfinite() const { return !rect_.has_value(); }
+  const RectF& Rect() const { return *rect_; }
+  const Transform& LocalToRoot() const { return local_to_root_; }
+
+  // Whether |local_rect|, the visual rect of what is about to be painted in
+  // the painter's local space, can touch the cull rect
+  bool Intersects(const RectF& local_rect) const {
+    if (!rect_) {
+      return true;
+    }
+    const Transform& m = local_to_root_;
+    float left, top, right, bottom;
+    if (m[0] == 1.0f && m[1] == 0.0f && m[2] == 0.0f && m[3] == 1.0f) {
+      left = local_rect.x + m[4];
+      top = local_rect.y + m[5];
+      right = left + local_rect.width;
+      bottom = top + local_rect.height;
+    } else {
+      // Bounds of the mapped corners
+      const float xs[2] = {local_rect.x, local_rect.x + local_rect.width};
+      const float ys[2] = {local_rect.y, local_rect.y + local_rect.height};
+      left = top = std::numeric_limits<float>::infinity();
+      right = bottom = -std::numeric_limits<float>::infinity();
+      for (float x : xs) {
+        for (float y : ys) {
+          const float root_x = m[0] * x + m[2] * y + m[4];
+          const float root_y = m[1] * x + m[3] * y + m[5];
+          left = std::min(left, root_x);
+          top = std::min(top, root_y);
+          right = std::max(right, root_x);
+          bottom = std::max(bottom, root_y);
+        }
+      }
+    }
+    return left < rect_->x + rect_->width && rect_->x < right &&
+           top < rect_->y + rect_->height && rect_->y < bottom;
+  }
+
+ private:
+  std::optional<RectF> rect_;
+  Transform local_to_root_ = kIdentity;
+};
+
+}  // namespace block_painter
+
+#endif  // BLOCK_PAINTER_CULL_RECT_H_
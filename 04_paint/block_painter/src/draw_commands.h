@@ -8,6 +8,8 @@
 #include <variant>
 #include <vector>
 
+namespace block_painter {
+
 // Shadow data for paint flags (matches Chromium's SkDrawLooper format)
 struct ShadowFlag {
   float offset_x = 0.0f;
@@ -41,6 +43,7 @@ struct DrawFlags {
 struct DrawRectOp {
   std::string type = "DrawRectOp";
   std::array<float, 4> rect;  // [left, top, right, bottom]
+  DOMNodeId node_id = kInvalidDOMNodeId;  // Set by BlockPainter::Paint
   DrawFlags flags;
   int transform_id = 0;
   int clip_id = 0;
@@ -52,19 +55,45 @@ struct DrawRRectOp {
   std::string type = "DrawRRectOp";
   std::array<float, 4> rect;  // [left, top, right, bottom]
   BorderRadii radii;          // [tl_x, tl_y, tr_x, tr_y, br_x, br_y, bl_x, bl_y]
+  DOMNodeId node_id = kInvalidDOMNodeId;  // Set by BlockPainter::Paint
+  DrawFlags flags;
+  int transform_id = 0;
+  int clip_id = 0;
+  int effect_id = 0;
+};
+
+// DrawDRRectOp - fill between two rounded rects (inset shadow casters)
+struct DrawDRRectOp {
+  std::string type = "DrawDRRectOp";
+  std::array<float, 4> outer_rect;  // [left, top, right, bottom]
+  BorderRadii outer_radii;
+  std::array<float, 4> inner_rect;  // [left, top, right, bottom]
+  BorderRadii inner_radii;
+  DOMNodeId node_id = kInvalidDOMNodeId;  // Set by BlockPainter::Paint
   DrawFlags flags;
   int transform_id = 0;
   int clip_id = 0;
   int effect_id = 0;
 };
 
+// ClipRectOp - rect clipping
+struct ClipRectOp {
+  std::string type = "ClipRectOp";
+  std::array<float, 4> rect;
+  bool anti_alias = true;
+  int clip_op = 1;  // SkClipOp: 0 = difference, 1 = intersect
+  int transform_id = 0;
+  int clip_id = 0;
+  int effect_id = 0;
+};
+
 // ClipRRectOp - rounded rect clipping
 struct ClipRRectOp {
   std::string type = "ClipRRectOp";
   std::array<float, 4> rect;
   BorderRadii radii;
   bool anti_alias = true;
-  int clip_op = 0;  // 0 = intersect
+  int clip_op = 1;  // SkClipOp: 0 = difference, 1 = intersect
   int transform_id = 0;
   int clip_id = 0;
   int effect_id = 0;
@@ -90,6 +119,8 @@ struct RestoreOp {
 using PaintOp = std::variant<
     DrawRectOp,
     DrawRRectOp,
+    DrawDRRectOp,
+    ClipRectOp,
     ClipRRectOp,
     SaveOp,
     RestoreOp>;
@@ -121,6 +152,34 @@ struct PaintOpList {
     ops.emplace_back(op);
   }
 
+  void DrawDRRect(const std::array<float, 4>& outer_rect,
+                  const BorderRadii& outer_radii,
+                  const std::array<float, 4>& inner_rect,
+                  const BorderRadii& inner_radii, const DrawFlags& flags,
+                  int transform_id, int clip_id, int effect_id) {
+    DrawDRRectOp op;
+    op.outer_rect = outer_rect;
+    op.outer_radii = outer_radii;
+    op.inner_rect = inner_rect;
+    op.inner_radii = inner_radii;
+    op.flags = flags;
+    op.transform_id = transform_id;
+    op.clip_id = clip_id;
+    op.effect_id = effect_id;
+    ops.emplace_back(op);
+  }
+
+  void ClipRect(const std::array<float, 4>& rect, bool anti_alias,
+                int transform_id, int clip_id, int effect_id) {
+    ClipRectOp op;
+    op.rect = rect;
+    op.anti_alias = anti_alias;
+    op.transform_id = transform_id;
+    op.clip_id = clip_id;
+    op.effect_id = effect_id;
+    ops.emplace_back(op);
+  }
+
   void ClipRRect(const std::array<float, 4>& rect, const BorderRadii& radii,
                  bool anti_alias, int transform_id, int clip_id, int effect_id) {
     ClipRRectOp op;
@@ -153,4 +212,6 @@ struct PaintOpList {
   size_t size() const { return ops.size(); }
 };
 
+}  // namespace block_painter
+
 #endif  // BLOCK_PAINTER_DRAW_COMMANDS_H_
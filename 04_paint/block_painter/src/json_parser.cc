@@ -1,9 +1,12 @@
 #include "json_parser.h"
 
+#include <algorithm>
 #include <cctype>
 #include <cstdlib>
 #include <sstream>
 
+namespace block_painter {
+
 namespace {
 
 // Skip whitespace
@@ -75,6 +78,38 @@ std::vector<std::string> SplitArrayElements(const std::string& array_content) {
   return elements;
 }
 
+// Serialize DrawFlags as a JSON object (no trailing newline)
+void SerializeFlags(const DrawFlags& flags, std::ostringstream& oss) {
+  oss << "{\n"
+      << "      \"r\": " << flags.r << ",\n"
+      << "      \"g\": " << flags.g << ",\n"
+      << "      \"b\": " << flags.b << ",\n"
+      << "      \"a\": " << flags.a << ",\n"
+      << "      \"style\": " << flags.style << ",\n"
+      << "      \"strokeWidth\": " << flags.stroke_width << ",\n"
+      << "      \"strokeCap\": " << flags.stroke_cap << ",\n"
+      << "      \"strokeJoin\": " << flags.stroke_join;
+  if (!flags.shadows.empty()) {
+    oss << ",\n      \"shadows\": [\n";
+    for (size_t j = 0; j < flags.shadows.size(); ++j) {
+      if (j > 0) oss << ",\n";
+      const auto& s = flags.shadows[j];
+      oss << "        {\n"
+          << "          \"offsetX\": " << s.offset_x << ",\n"
+          << "          \"offsetY\": " << s.offset_y << ",\n"
+          << "          \"blurSigma\": " << s.blur_sigma << ",\n"
+          << "          \"r\": " << s.color.R() << ",\n"
+          << "          \"g\": " << s.color.G() << ",\n"
+          << "          \"b\": " << s.color.B() << ",\n"
+          << "          \"a\": " << s.color.A() << ",\n"
+          << "          \"flags\": " << s.flags << "\n"
+          << "        }";
+    }
+    oss << "\n      ]";
+  }
+  oss << "\n    }";
+}
+
 }  // namespace
 
 std::string JsonParser::ExtractString(const std::string& json,
@@ -252,6 +287,15 @@ bool JsonParser::ParseInput(const std::string& json, BlockPaintInput& output) {
     }
   }
 
+  // Parse border_widths (inset shadows are cast inside the padding box)
+  std::string widths = ExtractObject(json, "border_widths");
+  if (!widths.empty()) {
+    output.border_widths = {ExtractFloat(widths, "top", 0.0f),
+                            ExtractFloat(widths, "right", 0.0f),
+                            ExtractFloat(widths, "bottom", 0.0f),
+                            ExtractFloat(widths, "left", 0.0f)};
+  }
+
   // Parse background_color
   std::string bg_color = ExtractObject(json, "background_color");
   if (!bg_color.empty()) {
@@ -292,6 +336,29 @@ bool JsonParser::ParseInput(const std::string& json, BlockPaintInput& output) {
     output.state_ids.effect_id = ExtractInt(state_ids, "effect_id", 0);
   }
 
+  // Parse dark_mode
+  std::string dark_mode = ExtractObject(json, "dark_mode");
+  if (!dark_mode.empty()) {
+    output.dark_mode.enabled = ExtractBool(dark_mode, "enabled", false);
+  }
+
+  // Parse cull_rect (root space, with the local-to-root transform)
+  std::string cull_rect = ExtractObject(json, "cull_rect");
+  if (!cull_rect.empty()) {
+    RectF rect;
+    rect.x = ExtractFloat(cull_rect, "x", 0.0f);
+    rect.y = ExtractFloat(cull_rect, "y", 0.0f);
+    rect.width = ExtractFloat(cull_rect, "width", 0.0f);
+    rect.height = ExtractFloat(cull_rect, "height", 0.0f);
+    CullRect::Transform local_to_root = CullRect::kIdentity;
+    std::vector<float> transform =
+        ParseFloatArray(ExtractArray(cull_rect, "local_to_root"));
+    if (transform.size() == 6) {
+      std::copy(transform.begin(), transform.end(), local_to_root.begin());
+    }
+    output.cull_rect = CullRect(rect, local_to_root);
+  }
+
   return true;
 }
 
@@ -313,34 +380,10 @@ std::string JsonParser::SerializeOps(const PaintOpList& ops) {
                 << "    \"type\": \"DrawRectOp\",\n"
                 << "    \"rect\": [" << arg.rect[0] << ", " << arg.rect[1]
                 << ", " << arg.rect[2] << ", " << arg.rect[3] << "],\n"
-                << "    \"flags\": {\n"
-                << "      \"r\": " << arg.flags.r << ",\n"
-                << "      \"g\": " << arg.flags.g << ",\n"
-                << "      \"b\": " << arg.flags.b << ",\n"
-                << "      \"a\": " << arg.flags.a << ",\n"
-                << "      \"style\": " << arg.flags.style << ",\n"
-                << "      \"strokeWidth\": " << arg.flags.stroke_width << ",\n"
-                << "      \"strokeCap\": " << arg.flags.stroke_cap << ",\n"
-                << "      \"strokeJoin\": " << arg.flags.stroke_join;
-            if (!arg.flags.shadows.empty()) {
-              oss << ",\n      \"shadows\": [\n";
-              for (size_t j = 0; j < arg.flags.shadows.size(); ++j) {
-                if (j > 0) oss << ",\n";
-                const auto& s = arg.flags.shadows[j];
-                oss << "        {\n"
-                    << "          \"offsetX\": " << s.offset_x << ",\n"
-                    << "          \"offsetY\": " << s.offset_y << ",\n"
-                    << "          \"blurSigma\": " << s.blur_sigma << ",\n"
-                    << "          \"r\": " << s.color.R() << ",\n"
-                    << "          \"g\": " << s.color.G() << ",\n"
-                    << "          \"b\": " << s.color.B() << ",\n"
-                    << "          \"a\": " << s.color.A() << ",\n"
-                    << "          \"flags\": " << s.flags << "\n"
-                    << "        }";
-              }
-              oss << "\n      ]";
-            }
-            oss << "\n    },\n"
+                << "    \"nodeId\": " << arg.node_id << ",\n"
+                << "    \"flags\": ";
+            SerializeFlags(arg.flags, oss);
+            oss << ",\n"
                 << "    \"transform_id\": " << arg.transform_id << ",\n"
                 << "    \"clip_id\": " << arg.clip_id << ",\n"
                 << "    \"effect_id\": " << arg.effect_id << "\n"
@@ -354,34 +397,48 @@ std::string JsonParser::SerializeOps(const PaintOpList& ops) {
                 << ", " << arg.radii[2] << ", " << arg.radii[3]
                 << ", " << arg.radii[4] << ", " << arg.radii[5]
                 << ", " << arg.radii[6] << ", " << arg.radii[7] << "],\n"
-                << "    \"flags\": {\n"
-                << "      \"r\": " << arg.flags.r << ",\n"
-                << "      \"g\": " << arg.flags.g << ",\n"
-                << "      \"b\": " << arg.flags.b << ",\n"
-                << "      \"a\": " << arg.flags.a << ",\n"
-                << "      \"style\": " << arg.flags.style << ",\n"
-                << "      \"strokeWidth\": " << arg.flags.stroke_width << ",\n"
-                << "      \"strokeCap\": " << arg.flags.stroke_cap << ",\n"
-                << "      \"strokeJoin\": " << arg.flags.stroke_join;
-            if (!arg.flags.shadows.empty()) {
-              oss << ",\n      \"shadows\": [\n";
-              for (size_t j = 0; j < arg.flags.shadows.size(); ++j) {
-                if (j > 0) oss << ",\n";
-                const auto& s = arg.flags.shadows[j];
-                oss << "        {\n"
-                    << "          \"offsetX\": " << s.offset_x << ",\n"
-                    << "          \"offsetY\": " << s.offset_y << ",\n"
-                    << "          \"blurSigma\": " << s.blur_sigma << ",\n"
-                    << "          \"r\": " << s.color.R() << ",\n"
-                    << "          \"g\": " << s.color.G() << ",\n"
-                    << "          \"b\": " << s.color.B() << ",\n"
-                    << "          \"a\": " << s.color.A() << ",\n"
-                    << "          \"flags\": " << s.flags << "\n"
-                    << "        }";
-              }
-              oss << "\n      ]";
-            }
-            oss << "\n    },\n"
+                << "    \"nodeId\": " << arg.node_id << ",\n"
+                << "    \"flags\": ";
+            SerializeFlags(arg.flags, oss);
+            oss << ",\n"
+                << "    \"transform_id\": " << arg.transform_id << ",\n"
+                << "    \"clip_id\": " << arg.clip_id << ",\n"
+                << "    \"effect_id\": " << arg.effect_id << "\n"
+                << "  }";
+          } else if constexpr (std::is_same_v<T, DrawDRRectOp>) {
+            oss << "  {\n"
+                << "    \"type\": \"DrawDRRectOp\",\n"
+                << "    \"outer_rect\": [" << arg.outer_rect[0] << ", "
+                << arg.outer_rect[1] << ", " << arg.outer_rect[2] << ", "
+                << arg.outer_rect[3] << "],\n"
+                << "    \"outer_radii\": [" << arg.outer_radii[0] << ", "
+                << arg.outer_radii[1] << ", " << arg.outer_radii[2] << ", "
+                << arg.outer_radii[3] << ", " << arg.outer_radii[4] << ", "
+                << arg.outer_radii[5] << ", " << arg.outer_radii[6] << ", "
+                << arg.outer_radii[7] << "],\n"
+                << "    \"inner_rect\": [" << arg.inner_rect[0] << ", "
+                << arg.inner_rect[1] << ", " << arg.inner_rect[2] << ", "
+                << arg.inner_rect[3] << "],\n"
+                << "    \"inner_radii\": [" << arg.inner_radii[0] << ", "
+                << arg.inner_radii[1] << ", " << arg.inner_radii[2] << ", "
+                << arg.inner_radii[3] << ", " << arg.inner_radii[4] << ", "
+                << arg.inner_radii[5] << ", " << arg.inner_radii[6] << ", "
+                << arg.inner_radii[7] << "],\n"
+                << "    \"nodeId\": " << arg.node_id << ",\n"
+                << "    \"flags\": ";
+            SerializeFlags(arg.flags, oss);
+            oss << ",\n"
+                << "    \"transform_id\": " << arg.transform_id << ",\n"
+                << "    \"clip_id\": " << arg.clip_id << ",\n"
+                << "    \"effect_id\": " << arg.effect_id << "\n"
+                << "  }";
+          } else if constexpr (std::is_same_v<T, ClipRectOp>) {
+            oss << "  {\n"
+                << "    \"type\": \"ClipRectOp\",\n"
+                << "    \"rect\": [" << arg.rect[0] << ", " << arg.rect[1]
+                << ", " << arg.rect[2] << ", " << arg.rect[3] << "],\n"
+                << "    \"antiAlias\": " << (arg.anti_alias ? "true" : "false") << ",\n"
+                << "    \"clipOp\": " << arg.clip_op << ",\n"
                 << "    \"transform_id\": " << arg.transform_id << ",\n"
                 << "    \"clip_id\": " << arg.clip_id << ",\n"
                 << "    \"effect_id\": " << arg.effect_id << "\n"
@@ -423,3 +480,5 @@ std::string JsonParser::SerializeOps(const PaintOpList& ops) {
   oss << "\n]";
   return oss.str();
 }
+
+}  // namespace block_painter
@@ -8,6 +8,8 @@
 #include <string>
 #include <vector>
 
+namespace block_painter {
+
 // Simple JSON parsing and serialization for block painter
 // Uses a minimal approach without external dependencies
 
@@ -54,4 +56,6 @@ class JsonParser {
   static BoxShadowData ParseBoxShadow(const std::string& json);
 };
 
+}  // namespace block_painter
+
 #endif  // BLOCK_PAINTER_JSON_PARSER_H_
@@ -64,17 +64,17 @@ int main(int argc, char* argv[]) {
   }
 
   // Parse input
-  BlockPaintInput input;
-  if (!JsonParser::ParseInput(json_input, input)) {
+  block_painter::BlockPaintInput input;
+  if (!block_painter::JsonParser::ParseInput(json_input, input)) {
     std::cerr << "Error: Failed to parse input JSON" << std::endl;
     return 1;
   }
 
   // Run block painter
-  PaintOpList ops = BlockPainter::Paint(input);
+  block_painter::PaintOpList ops = block_painter::BlockPainter::Paint(input);
 
   // Serialize output
-  std::string json_output = JsonParser::SerializeOps(ops);
+  std::string json_output = block_painter::JsonParser::SerializeOps(ops);
 
   // Write output
   if (output_file.empty()) {
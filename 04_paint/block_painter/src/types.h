@@ -8,6 +8,8 @@
 #include <string>
 #include <vector>
 
+namespace block_painter {
+
 // Basic types for block painting - mirrors Chromium's blink types
 
 struct Color {
@@ -119,12 +121,20 @@ struct GraphicsStateIds {
   int effect_id = 0;
 };
 
+// Dark mode settings
+struct AutoDarkMode {
+  bool enabled = false;
+};
+
 using DOMNodeId = int64_t;
 constexpr DOMNodeId kInvalidDOMNodeId = 0;
 
 // Border radii: 8 values for [tl_x, tl_y, tr_x, tr_y, br_x, br_y, bl_x, bl_y]
 using BorderRadii = std::array<float, 8>;
 
+// Border widths: [top, right, bottom, left]
+using BorderWidths = std::array<float, 4>;
+
 // Check if radii are all zero
 inline bool IsZeroRadii(const BorderRadii& radii) {
   for (float r : radii) {
@@ -133,4 +143,6 @@ inline bool IsZeroRadii(const BorderRadii& radii) {
   return true;
 }
 
+}  // namespace block_painter
+
 #endif  // BLOCK_PAINTER_TYPES_H_
@@ -0,0 +1,324 @@
+// Border Painter Batch Analysis Implementation
+
+#include "border_batch.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace border_painter {
+
+namespace {
+
+constexpr int32_t kNone = static_cast<int32_t>(EBorderStyle::kNone);
+constexpr int32_t kHidden = static_cast<int32_t>(EBorderStyle::kHidden);
+constexpr int32_t kDotted = static_cast<int32_t>(EBorderStyle::kDotted);
+constexpr int32_t kDashed = static_cast<int32_t>(EBorderStyle::kDashed);
+
+// Scalar AnalyzeBorder over lane |i|; handles the tail of the SIMD loop
+void AnalyzeLane(const BorderBatch& batch, size_t i,
+                 BorderBatchAnalysis& analysis) {
+  using Flag = BorderBatchAnalysis::Flag;
+  uint8_t flags = Flag::kUniformWidth | Flag::kUniformColor |
+                  Flag::kUniformStyle;
+  uint8_t count = 0;
+  uint8_t first = 0;
+
+  for (unsigned s = 0; s < 4; ++s) {
+    const float w = batch.widths[s][i];
+    const float a = batch.alpha[s][i];
+    const int32_t style = batch.styles[s][i];
+
+    const bool should_render =
+        w > 0 && style != kNone && style != kHidden && a != 0.0f;
+    if (!should_render) {
+      if (w > 0 && (style == kHidden || a == 0.0f)) {
+        flags &= ~(Flag::kUniformWidth | Flag::kUniformColor);
+      }
+      continue;
+    }
+
+    if (a != 1.0f) {
+      flags |= Flag::kTransparency;
+    }
+    if (style == kDashed || style == kDotted) {
+      flags |= Flag::kDashedOrDotted;
+    }
+
+    if (++count == 1) {
+      first = s;
+      continue;
+    }
+
+    if (style != batch.styles[first][i]) {
+      flags &= ~Flag::kUniformStyle;
+    }
+    if (w != batch.widths[first][i]) {
+      flags &= ~Flag::kUniformWidth;
+    }
+    if (batch.red[s][i] != batch.red[first][i] ||
+        batch.green[s][i] != batch.green[first][i] ||
+        batch.blue[s][i] != batch.blue[first][i] ||
+        a != batch.alpha[first][i]) {
+      flags &= ~Flag::kUniformColor;
+    }
+  }
+
+  for (const auto& r : batch.radii) {
+    if (r[i] > 0.0f) {
+      flags |= Flag::kRounded;
+      break;
+    }
+  }
+
+  analysis.flags[i] = flags;
+  analysis.visible_edge_count[i] = count;
+  analysis.first_visible_edge[i] = first;
+}
+
+#if defined(__SSE2__)
+// mask ? a : b
+__m128 Select(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+__m128i Select(__m128i mask, __m128i a, __m128i b) {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Sets |bit| in the flags of the 4 lanes whose |mask| is set
+void StoreFlag(__m128 mask, uint8_t bit, uint8_t* flags) {
+  const int bits = _mm_movemask_ps(mask);
+  for (int lane = 0; lane < 4; ++lane) {
+    if (bits & (1 << lane)) {
+      flags[lane] |= bit;
+    }
+  }
+}
+#endif
+
+}  // namespace
+
+BorderBatch::BorderBatch(const std::vector<BorderPaintInput>& inputs) {
+  const size_t n = inputs.size();
+  for (auto* v : {&x, &y, &width, &height}) {
+    v->resize(n);
+  }
+  for (unsigned s = 0; s < 4; ++s) {
+    for (auto* v : {&widths[s], &red[s], &green[s], &blue[s], &alpha[s]}) {
+      v->resize(n);
+    }
+    styles[s].resize(n);
+  }
+  for (auto& r : radii) {
+    r.resize(n);
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    const BorderPaintInput& input = inputs[i];
+    x[i] = input.geometry.x;
+    y[i] = input.geometry.y;
+    width[i] = input.geometry.width;
+    height[i] = input.geometry.height;
+
+    const BorderWidths& w = input.border_widths;
+    const BorderColors& c = input.border_colors;
+    const BorderStyles st = input.border_styles.value_or(BorderStyles{});
+    const float side_widths[4] = {w.top, w.right, w.bottom, w.left};
+    const Color* side_colors[4] = {&c.top, &c.right, &c.bottom, &c.left};
+    const EBorderStyle side_styles[4] = {st.top, st.right, st.bottom, st.left};
+    for (unsigned s = 0; s < 4; ++s) {
+      widths[s][i] = side_widths[s];
+      red[s][i] = side_colors[s]->r;
+      green[s][i] = side_colors[s]->g;
+      blue[s][i] = side_colors[s]->b;
+      alpha[s][i] = side_colors[s]->a;
+      styles[s][i] = static_cast<int32_t>(side_styles[s]);
+    }
+
+    const BorderRadii r = input.border_radii.value_or(BorderRadii{});
+    for (size_t k = 0; k < r.size(); ++k) {
+      radii[k][i] = r[k];
+    }
+  }
+}
+
+void AnalyzeBorders(const BorderBatch& batch, BorderBatchAnalysis& analysis) {
+  const size_t n = batch.size();
+  analysis.flags.assign(n, 0);
+  analysis.visible_edge_count.assign(n, 0);
+  analysis.first_visible_edge.assign(n, 0);
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  using Flag = BorderBatchAnalysis::Flag;
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128i none = _mm_set1_epi32(kNone);
+  const __m128i hidden = _mm_set1_epi32(kHidden);
+  const __m128i dotted = _mm_set1_epi32(kDotted);
+  const __m128i dashed = _mm_set1_epi32(kDashed);
+
+  for (; i + 4 <= n; i += 4) {
+    __m128 w[4], r[4], g[4], b[4], a[4];
+    __m128i style[4];
+    __m128 render[4];
+    __m128 invisible = zero;     // Any side PresentButInvisible
+    __m128 transparency = zero;  // Any rendered side translucent
+    __m128 dashes = zero;        // Any rendered side dashed / dotted
+    __m128i count = _mm_setzero_si128();
+
+    for (unsigned s = 0; s < 4; ++s) {
+      w[s] = _mm_loadu_ps(&batch.widths[s][i]);
+      r[s] = _mm_loadu_ps(&batch.red[s][i]);
+      g[s] = _mm_loadu_ps(&batch.green[s][i]);
+      b[s] = _mm_loadu_ps(&batch.blue[s][i]);
+      a[s] = _mm_loadu_ps(&batch.alpha[s][i]);
+      style[s] = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(&batch.styles[s][i]));
+
+      const __m128 has_width = _mm_cmpgt_ps(w[s], zero);
+      const __m128 is_hidden =
+          _mm_castsi128_ps(_mm_cmpeq_epi32(style[s], hidden));
+      const __m128 is_none =
+          _mm_castsi128_ps(_mm_cmpeq_epi32(style[s], none));
+      const __m128 is_clear = _mm_cmpeq_ps(a[s], zero);
+
+      // ShouldRender / PresentButInvisible
+      render[s] = _mm_andnot_ps(
+          _mm_or_ps(_mm_or_ps(is_none, is_hidden), is_clear), has_width);
+      invisible = _mm_or_ps(
+          invisible, _mm_and_ps(has_width, _mm_or_ps(is_hidden, is_clear)));
+
+      transparency = _mm_or_ps(
+          transparency, _mm_and_ps(render[s], _mm_cmpneq_ps(a[s], one)));
+      const __m128 is_dashed = _mm_castsi128_ps(
+          _mm_or_si128(_mm_cmpeq_epi32(style[s], dotted),
+                       _mm_cmpeq_epi32(style[s], dashed)));
+      dashes = _mm_or_ps(dashes, _mm_and_ps(render[s], is_dashed));
+      count = _mm_sub_epi32(count, _mm_castps_si128(render[s]));  // mask = -1
+    }
+
+    // Values of the first rendered side; later sides are compared to it
+    __m128 first_w = zero, first_r = zero, first_g = zero, first_b = zero,
+           first_a = zero;
+    __m128i first_style = _mm_setzero_si128();
+    __m128i first_index = _mm_setzero_si128();
+    for (int s = 3; s >= 0; --s) {
+      first_w = Select(render[s], w[s], first_w);
+      first_r = Select(render[s], r[s], first_r);
+      first_g = Select(render[s], g[s], first_g);
+      first_b = Select(render[s], b[s], first_b);
+      first_a = Select(render[s], a[s], first_a);
+      const __m128i mask = _mm_castps_si128(render[s]);
+      first_style = Select(mask, style[s], first_style);
+      first_index = Select(mask, _mm_set1_epi32(s), first_index);
+    }
+
+    __m128 uniform_width = _mm_cmpeq_ps(zero, zero);
+    __m128 uniform_color = uniform_width;
+    __m128 uniform_style = uniform_width;
+    for (unsigned s = 0; s < 4; ++s) {
+      // Sides that do not render match trivially
+      const __m128 skip = _mm_xor_ps(render[s], _mm_cmpeq_ps(zero, zero));
+      uniform_width = _mm_and_ps(
+          uniform_width, _mm_or_ps(skip, _mm_cmpeq_ps(w[s], first_w)));
+      const __m128 same_color = _mm_and_ps(
+          _mm_and_ps(_mm_cmpeq_ps(r[s], first_r), _mm_cmpeq_ps(g[s], first_g)),
+          _mm_and_ps(_mm_cmpeq_ps(b[s], first_b), _mm_cmpeq_ps(a[s], first_a)));
+      uniform_color = _mm_and_ps(uniform_color, _mm_or_ps(skip, same_color));
+      uniform_style = _mm_and_ps(
+          uniform_style,
+          _mm_or_ps(skip, _mm_castsi128_ps(
+                              _mm_cmpeq_epi32(style[s], first_style))));
+    }
+    uniform_width = _mm_andnot_ps(invisible, uniform_width);
+    uniform_color = _mm_andnot_ps(invisible, uniform_color);
+
+    __m128 rounded = zero;
+    for (const auto& radius : batch.radii) {
+      rounded = _mm_or_ps(rounded,
+                          _mm_cmpgt_ps(_mm_loadu_ps(&radius[i]), zero));
+    }
+
+    uint8_t* flags = &analysis.flags[i];
+    StoreFlag(uniform_width, Flag::kUniformWidth, flags);
+    StoreFlag(uniform_color, Flag::kUniformColor, flags);
+    StoreFlag(uniform_style, Flag::kUniformStyle, flags);
+    StoreFlag(rounded, Flag::kRounded, flags);
+    StoreFlag(transparency, Flag::kTransparency, flags);
+    StoreFlag(dashes, Flag::kDashedOrDotted, flags);
+
+    alignas(16) int32_t counts[4];
+    alignas(16) int32_t firsts[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(counts), count);
+    _mm_store_si128(reinterpret_cast<__m128i*>(firsts), first_index);
+    for (int lane = 0; lane < 4; ++lane) {
+      analysis.visible_edge_count[i + lane] =
+          static_cast<uint8_t>(counts[lane]);
+      analysis.first_visible_edge[i + lane] =
+          static_cast<uint8_t>(firsts[lane]);
+    }
+  }
+#endif
+
+  for (; i < n; ++i) {
+    AnalyzeLane(batch, i, analysis);
+  }
+}
+
+void ComputeStrokeGeometry(const BorderBatch& batch,
+                           BorderStrokeGeometry& geometry) {
+  const size_t n = batch.size();
+  for (auto* v : {&geometry.left, &geometry.top, &geometry.right,
+                  &geometry.bottom}) {
+    v->resize(n);
+  }
+  for (auto& r : geometry.radii) {
+    r.resize(n);
+  }
+  const std::vector<float>& stroke_width =
+      batch.widths[static_cast<unsigned>(BoxSide::kTop)];
+  size_t i = 0;
+
+  // Same operation order as CalculateStrokeRect / AdjustRadiiForStroke, so
+  // the results are bit-identical to the per-box fast path
+#if defined(__SSE2__)
+  const __m128 two = _mm_set1_ps(2.0f);
+  const __m128 zero = _mm_setzero_ps();
+  for (; i + 4 <= n; i += 4) {
+    const __m128 inset = _mm_div_ps(_mm_loadu_ps(&stroke_width[i]), two);
+    const __m128 x = _mm_loadu_ps(&batch.x[i]);
+    const __m128 y = _mm_loadu_ps(&batch.y[i]);
+    _mm_storeu_ps(&geometry.left[i], _mm_add_ps(x, inset));
+    _mm_storeu_ps(&geometry.top[i], _mm_add_ps(y, inset));
+    _mm_storeu_ps(&geometry.right[i],
+                  _mm_sub_ps(_mm_add_ps(x, _mm_loadu_ps(&batch.width[i])),
+                             inset));
+    _mm_storeu_ps(&geometry.bottom[i],
+                  _mm_sub_ps(_mm_add_ps(y, _mm_loadu_ps(&batch.height[i])),
+                             inset));
+    for (size_t k = 0; k < batch.radii.size(); ++k) {
+      // std::max(0, v) is (0 < v) ? v : 0
+      const __m128 v = _mm_sub_ps(_mm_loadu_ps(&batch.radii[k][i]), inset);
+      _mm_storeu_ps(&geometry.radii[k][i],
+                    Select(_mm_cmplt_ps(zero, v), v, zero));
+    }
+  }
+#endif
+
+  for (; i < n; ++i) {
+    const float inset = stroke_width[i] / 2.0f;
+    geometry.left[i] = batch.x[i] + inset;
+    geometry.top[i] = batch.y[i] + inset;
+    geometry.right[i] = batch.x[i] + batch.width[i] - inset;
+    geometry.bottom[i] = batch.y[i] + batch.height[i] - inset;
+    for (size_t k = 0; k < batch.radii.size(); ++k) {
+      geometry.radii[k][i] = std::max(0.0f, batch.radii[k][i] - inset);
+    }
+  }
+}
+
+}  // namespace border_painter
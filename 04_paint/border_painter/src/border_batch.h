@@ -0,0 +1,73 @@
+// Border Painter Batch Analysis
+// Classifies the borders of a whole document at once
+
+#ifndef BORDER_PAINTER_BORDER_BATCH_H_
+#define BORDER_PAINTER_BORDER_BATCH_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "border_painter.h"
+#include "types.h"
+
+namespace border_painter {
+
+// The border definitions of N boxes as structure of arrays, one lane per
+// box, so the analysis compares the same side of 4 boxes per SIMD op
+// instead of building a BorderEdge[4] per box. Per-side arrays are indexed
+// by BoxSide.
+struct BorderBatch {
+  explicit BorderBatch(const std::vector<BorderPaintInput>& inputs);
+
+  size_t size() const { return x.size(); }
+
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> width;
+  std::vector<float> height;
+  std::array<std::vector<float>, 4> widths;
+  std::array<std::vector<float>, 4> red;
+  std::array<std::vector<float>, 4> green;
+  std::array<std::vector<float>, 4> blue;
+  std::array<std::vector<float>, 4> alpha;
+  std::array<std::vector<int32_t>, 4> styles;  // EBorderStyle; missing = solid
+  std::array<std::vector<float>, 8> radii;     // Missing radii are zero
+};
+
+// BorderPainter::AnalyzeBorder of every box in a batch
+struct BorderBatchAnalysis {
+  enum Flag : uint8_t {
+    kUniformWidth = 1 << 0,
+    kUniformColor = 1 << 1,
+    kUniformStyle = 1 << 2,
+    kRounded = 1 << 3,
+    kTransparency = 1 << 4,
+    kDashedOrDotted = 1 << 5,
+  };
+
+  std::vector<uint8_t> flags;
+  std::vector<uint8_t> visible_edge_count;
+  std::vector<uint8_t> first_visible_edge;
+};
+
+void AnalyzeBorders(const BorderBatch& batch, BorderBatchAnalysis& analysis);
+
+// Centerline rect and radii of the uniform-width stroke of every box in a
+// batch (CalculateStrokeRect / AdjustRadiiForStroke with the top width).
+// Lanes whose border is not uniform hold unused values.
+struct BorderStrokeGeometry {
+  std::vector<float> left;
+  std::vector<float> top;
+  std::vector<float> right;
+  std::vector<float> bottom;
+  std::array<std::vector<float>, 8> radii;
+};
+
+void ComputeStrokeGeometry(const BorderBatch& batch,
+                           BorderStrokeGeometry& geometry);
+
+}  // namespace border_painter
+
+#endif  // BORDER_PAINTER_BORDER_BATCH_H_
@@ -0,0 +1,104 @@
+// Border Painter Op Template Cache Implementation
+
+#include "border_op_cache.h"
+
+#include <cstring>
+#include <utility>
+
+namespace border_painter {
+
+namespace {
+
+// FNV-1a over 32-bit words
+constexpr uint64_t kFnvOffset = 0xcbf29ce484222325ull;
+constexpr uint64_t kFnvPrime = 0x100000001b3ull;
+
+void HashWord(uint64_t& hash, uint32_t word) {
+  hash ^= word;
+  hash *= kFnvPrime;
+}
+
+void HashFloat(uint64_t& hash, float value) {
+  // Fold -0 into +0 so equal keys hash equally
+  if (value == 0.0f) value = 0.0f;
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  HashWord(hash, bits);
+}
+
+void HashColor(uint64_t& hash, const Color& color) {
+  HashFloat(hash, color.r);
+  HashFloat(hash, color.g);
+  HashFloat(hash, color.b);
+  HashFloat(hash, color.a);
+}
+
+}  // namespace
+
+BorderOpCache::Key::Key(const BorderPaintInput& input)
+    : widths(input.border_widths),
+      colors(input.border_colors),
+      styles(input.border_styles.value_or(BorderStyles{})),
+      radii(input.border_radii.value_or(BorderRadii{})),
+      visibility(input.visibility),
+      render_hint(input.render_hint),
+      dark_mode(input.dark_mode.enabled),
+      corner_shapes(input.corner_shapes.value_or(CornerShapes{})),
+      device_scale_factor(input.device_scale_factor),
+      bleed_avoidance(input.bleed_avoidance) {}
+
+bool BorderOpCache::Key::operator==(const Key& other) const {
+  return widths == other.widths && colors == other.colors &&
+         styles == other.styles && radii == other.radii &&
+         visibility == other.visibility && render_hint == other.render_hint &&
+         dark_mode == other.dark_mode &&
+         corner_shapes == other.corner_shapes &&
+         device_scale_factor == other.device_scale_factor &&
+         bleed_avoidance == other.bleed_avoidance;
+}
+
+size_t BorderOpCache::KeyHash::operator()(const Key& key) const {
+  uint64_t hash = kFnvOffset;
+  for (float w : {key.widths.top, key.widths.right, key.widths.bottom,
+                  key.widths.left}) {
+    HashFloat(hash, w);
+  }
+  for (const Color* c : {&key.colors.top, &key.colors.right,
+                         &key.colors.bottom, &key.colors.left}) {
+    HashColor(hash, *c);
+  }
+  for (EBorderStyle s : {key.styles.top, key.styles.right, key.styles.bottom,
+                         key.styles.left}) {
+    HashWord(hash, static_cast<uint32_t>(s));
+  }
+  for (float r : key.radii) {
+    HashFloat(hash, r);
+  }
+  HashWord(hash, static_cast<uint32_t>(key.visibility));
+  HashWord(hash, static_cast<uint32_t>(key.render_hint) << 1 | key.dark_mode);
+  for (float k : {key.corner_shapes.top_left, key.corner_shapes.top_right,
+                  key.corner_shapes.bottom_right,
+                  key.corner_shapes.bottom_left}) {
+    HashFloat(hash, k);
+  }
+  HashFloat(hash, key.device_scale_factor);
+  HashWord(hash, static_cast<uint32_t>(key.bleed_avoidance));
+  return static_cast<size_t>(hash);
+}
+
+const BorderOpTemplate* BorderOpCache::Lookup(const BorderPaintInput& input) {
+  auto it = entries_.find(Key(input));
+  if (it == entries_.end()) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  return &it->second;
+}
+
+void BorderOpCache::Insert(const BorderPaintInput& input,
+                           BorderOpTemplate op_template) {
+  entries_.insert_or_assign(Key(input), std::move(op_template));
+}
+
+}  // namespace border_painter
@@ -0,0 +1,84 @@
+// Border Painter Op Template Cache
+// Reuses painted ops across boxes that share a border definition
+
+#ifndef BORDER_PAINTER_BORDER_OP_CACHE_H_
+#define BORDER_PAINTER_BORDER_OP_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "border_painter.h"
+#include "draw_commands.h"
+#include "types.h"
+
+namespace border_painter {
+
+// Ops for one border style signature, painted for an empty box at the
+// origin. Every op coordinate is either anchored to the box origin or moves
+// with the box size: stretch holds one flag per coordinate of the ops (in
+// op order, x, y, x, y within an op), set when the coordinate is relative
+// to the right / bottom edge.
+struct BorderOpTemplate {
+  PaintOpList ops;
+  std::vector<uint8_t> stretch;
+  // False when the painter output is not affine in the box size; such
+  // signatures are painted directly on every hit
+  bool stretchable = false;
+};
+
+// Memo from the box-size independent part of BorderPaintInput (widths,
+// colors, styles, radii, visibility, render hint, dark mode, corner shapes,
+// device scale factor and bleed avoidance) to an op
+// template.
+//
+// Pages reuse a handful of border definitions (cards, table cells, form
+// controls) across many boxes, so a document-level paint loop keeps one
+// cache alive and passes it to every BorderPainter::Paint call. Entries are
+// never evicted.
+class BorderOpCache {
+ public:
+  // Returns the cached template or nullptr (counted as a hit / miss)
+  const BorderOpTemplate* Lookup(const BorderPaintInput& input);
+
+  // Stores |op_template| for the signature of |input|
+  void Insert(const BorderPaintInput& input, BorderOpTemplate op_template);
+
+  size_t hits() const { return hits_; }
+  size_t misses() const { return misses_; }
+  size_t size() const { return entries_.size(); }
+  double HitRate() const {
+    size_t total = hits_ + misses_;
+    return total ? static_cast<double>(hits_) / total : 0.0;
+  }
+
+ private:
+  struct Key {
+    BorderWidths widths;
+    BorderColors colors;
+    BorderStyles styles;  // Missing styles are solid
+    BorderRadii radii;    // Missing radii are zero
+    Visibility visibility;
+    BorderRenderHint render_hint;
+    bool dark_mode;
+    CornerShapes corner_shapes;  // Missing shapes are round
+    float device_scale_factor;
+    BackgroundBleedAvoidance bleed_avoidance;
+
+    explicit Key(const BorderPaintInput& input);
+    bool operator==(const Key& other) const;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  std::unordered_map<Key, BorderOpTemplate, KeyHash> entries_;
+  size_t hits_ = 0;
+  size_t misses_ = 0;
+};
+
+}  // namespace border_painter
+
+#endif  // BORDER_PAINTER_BORDER_OP_CACHE_H_
@@ -5,6 +5,18 @@
 
 #include <algorithm>
 #include <cmath>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "border_batch.h"
+#include "border_op_cache.h"
+#include "box_decoration_painter.h"
+#include "complex_border_painter.h"
+#include "contoured_border_geometry.h"
+#include "dark_mode_filter.h"
+#include "dash_layout.h"
 
 namespace border_painter {
 
@@ -18,6 +30,109 @@ bool DarkenBoxSide(BoxSide side, EBorderStyle style) {
          (style == EBorderStyle::kInset);
 }
 
+// Ops that carry paint flags (Save / Restore / clips do not)
+template <typename T, typename = void>
+struct HasDrawFlags : std::false_type {};
+template <typename T>
+struct HasDrawFlags<T, std::void_t<decltype(std::declval<T&>().flags)>>
+    : std::true_type {};
+
+// Calls fn(coordinate, index) for every geometry coordinate of |op|, in
+// x, y, x, y order. Radii and flags do not depend on the box.
+template <typename Op, typename Fn>
+void ForEachCoordinate(Op& op, Fn fn) {
+  std::visit(
+      [&fn](auto& o) {
+        using T = std::decay_t<decltype(o)>;
+        if constexpr (std::is_same_v<T, DrawLineOp>) {
+          fn(o.x0, 0);
+          fn(o.y0, 1);
+          fn(o.x1, 2);
+          fn(o.y1, 3);
+        } else if constexpr (std::is_same_v<T, DrawDRRectOp>) {
+          for (int i = 0; i < 4; ++i) fn(o.outer_rect[i], i);
+          for (int i = 0; i < 4; ++i) fn(o.inner_rect[i], 4 + i);
+        } else if constexpr (std::is_same_v<T, ClipPathOp>) {
+          int i = 0;
+          for (auto& p : o.points) {
+            fn(p.x, i++);
+            fn(p.y, i++);
+          }
+        } else if constexpr (std::is_same_v<T, DrawPathOp>) {
+          int i = 0;
+          for (auto& contour : o.contours) {
+            for (auto& p : contour) {
+              fn(p.x, i++);
+              fn(p.y, i++);
+            }
+          }
+        } else if constexpr (std::is_same_v<T, SaveOp> ||
+                             std::is_same_v<T, RestoreOp> ||
+                             std::is_same_v<T, SaveLayerAlphaOp>) {
+          // No geometry
+        } else {
+          for (int i = 0; i < 4; ++i) fn(o.rect[i], i);
+        }
+      },
+      op);
+}
+
+const BorderRadii* OpRadii(const PaintOp& op, int index) {
+  if (const auto* rrect = std::get_if<DrawRRectOp>(&op)) {
+    return index == 0 ? &rrect->radii : nullptr;
+  }
+  if (const auto* drrect = std::get_if<DrawDRRectOp>(&op)) {
+    return index == 0 ? &drrect->outer_radii : &drrect->inner_radii;
+  }
+  if (const auto* clip = std::get_if<ClipRRectOp>(&op)) {
+    return index == 0 ? &clip->radii : nullptr;
+  }
+  return nullptr;
+}
+
+// Dash and dot layouts are fitted to the stroked length, so they change
+// with the box size: a side too short to dash is even stroked solid, which
+// the emitted ops cannot tell apart from a solid border
+bool HasDashedOrDottedSide(const BorderPaintInput& input) {
+  if (!input.border_styles.has_value()) {
+    return false;
+  }
+  const BorderStyles& styles = *input.border_styles;
+  for (EBorderStyle style :
+       {styles.top, styles.right, styles.bottom, styles.left}) {
+    if (style == EBorderStyle::kDashed || style == EBorderStyle::kDotted) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Tags every draw op with the box it paints, so the op can be matched to
+// the same box's op in another paint. Op cache templates are shared by
+// boxes, so ops are tagged once instantiated.
+void SetNodeId(PaintOpList& ops, DOMNodeId node_id) {
+  for (auto& op : ops.mutable_ops()) {
+    std::visit(
+        [node_id](auto& o) {
+          if constexpr (HasDrawFlags<std::decay_t<decltype(o)>>::value) {
+            o.node_id = node_id;
+          }
+        },
+        op);
+  }
+}
+
+void AppendOps(PaintOpList& ops, PaintOpList box_ops) {
+  auto& box_list = box_ops.mutable_ops();
+  ops.mutable_ops().insert(ops.mutable_ops().end(),
+                           std::make_move_iterator(box_list.begin()),
+                           std::make_move_iterator(box_list.end()));
+}
+
+bool NearlyEqual(float a, float b) {
+  return std::fabs(a - b) <= 1e-4f * std::max(1.0f, std::fabs(a));
+}
+
 }  // namespace
 
 // Analyze the border properties to determine rendering strategy
@@ -48,6 +163,11 @@ BorderPainter::BorderProperties BorderPainter::AnalyzeBorder(
       props.has_transparency = true;
     }
 
+    if (edge.style == EBorderStyle::kDashed ||
+        edge.style == EBorderStyle::kDotted) {
+      props.has_dashed_or_dotted = true;
+    }
+
     props.visible_edge_count++;
 
     if (props.visible_edge_count == 1) {
@@ -101,7 +221,260 @@ BorderEdge BorderPainter::GetEdge(const BorderPaintInput& input, BoxSide side) {
   return edge;
 }
 
-PaintOpList BorderPainter::Paint(const BorderPaintInput& input) {
+PaintOpList BorderPainter::Paint(const BorderPaintInput& input,
+                                 BorderOpCache* op_cache) {
+  if (!input.cull_rect.Intersects(input.geometry)) {
+    return PaintOpList();
+  }
+  // Background + border: painted together for bleed avoidance, as in
+  // PaintBatch
+  if (input.background_color.has_value()) {
+    return BoxDecorationPainter::Paint(input, op_cache);
+  }
+  PaintOpList ops = PaintAnalyzed(input, nullptr, op_cache);
+  SetNodeId(ops, input.node_id);
+  return ops;
+}
+
+PaintOpList BorderPainter::PaintBatch(
+    const std::vector<BorderPaintInput>& inputs, BorderOpCache* op_cache) {
+  const BorderBatch batch(inputs);
+  BorderBatchAnalysis analysis;
+  AnalyzeBorders(batch, analysis);
+  BorderStrokeGeometry stroke;
+  ComputeStrokeGeometry(batch, stroke);
+
+  using Flag = BorderBatchAnalysis::Flag;
+  constexpr uint8_t kUniform =
+      Flag::kUniformWidth | Flag::kUniformColor | Flag::kUniformStyle;
+
+  PaintOpList ops;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const BorderPaintInput& input = inputs[i];
+    if (!input.cull_rect.Intersects(input.geometry)) {
+      continue;
+    }
+    const uint8_t flags = analysis.flags[i];
+    const bool rounded = flags & Flag::kRounded;
+
+    // The uniform-width solid case of PaintFastPath: one stroked rect or
+    // rrect along the batched centerline
+    const bool fast_path =
+        input.visibility == Visibility::kVisible &&
+        (input.render_hint == BorderRenderHint::kAuto ||
+         input.render_hint == BorderRenderHint::kStrokedRect) &&
+        !input.dark_mode.enabled && !input.background_color.has_value() &&
+        analysis.visible_edge_count[i] == 4 &&
+        (flags & kUniform) == kUniform &&
+        batch.styles[0][i] == static_cast<int32_t>(EBorderStyle::kSolid) &&
+        !(rounded && input.corner_shapes.has_value() &&
+          !input.corner_shapes->IsRound());
+    if (fast_path) {
+      const float stroke_width = input.border_widths.top;
+      const DrawFlags draw_flags =
+          BuildStrokeFlags(input.border_colors.top, stroke_width);
+      const std::array<float, 4> rect = {stroke.left[i], stroke.top[i],
+                                         stroke.right[i], stroke.bottom[i]};
+      if (rounded) {
+        DrawRRectOp op;
+        op.rect = rect;
+        for (size_t k = 0; k < op.radii.size(); ++k) {
+          op.radii[k] = stroke.radii[k][i];
+        }
+        op.flags = draw_flags;
+        op.node_id = input.node_id;
+        op.transform_id = input.state_ids.transform_id;
+        op.clip_id = input.state_ids.clip_id;
+        op.effect_id = input.state_ids.effect_id;
+        ops.AddDrawRRect(std::move(op));
+      } else {
+        DrawRectOp op;
+        op.rect = rect;
+        op.flags = draw_flags;
+        op.node_id = input.node_id;
+        op.transform_id = input.state_ids.transform_id;
+        op.clip_id = input.state_ids.clip_id;
+        op.effect_id = input.state_ids.effect_id;
+        ops.AddDrawRect(std::move(op));
+      }
+      continue;
+    }
+
+    // Background + border: painted together for bleed avoidance
+    if (input.background_color.has_value()) {
+      AppendOps(ops, BoxDecorationPainter::Paint(input, op_cache));
+      continue;
+    }
+
+    BorderProperties props;
+    props.is_uniform_width = flags & Flag::kUniformWidth;
+    props.is_uniform_color = flags & Flag::kUniformColor;
+    props.is_uniform_style = flags & Flag::kUniformStyle;
+    props.is_rounded = rounded;
+    props.has_transparency = flags & Flag::kTransparency;
+    props.has_dashed_or_dotted = flags & Flag::kDashedOrDotted;
+    props.visible_edge_count = analysis.visible_edge_count[i];
+    props.first_visible_edge = analysis.first_visible_edge[i];
+
+    PaintOpList box_ops = PaintAnalyzed(input, &props, op_cache);
+    SetNodeId(box_ops, input.node_id);
+    AppendOps(ops, std::move(box_ops));
+  }
+  return ops;
+}
+
+PaintOpList BorderPainter::PaintAnalyzed(const BorderPaintInput& input,
+                                         const BorderProperties* props,
+                                         BorderOpCache* op_cache) {
+  if (!op_cache) {
+    return PaintUncached(input, props);
+  }
+
+  if (const BorderOpTemplate* op_template = op_cache->Lookup(input)) {
+    if (op_template->stretchable) {
+      return InstantiateOpTemplate(*op_template, input);
+    }
+    return PaintUncached(input, props);
+  }
+
+  bool size_dependent = HasDashedOrDottedSide(input);
+  PaintOpList ops = PaintUncached(input, props, &size_dependent);
+  // An empty box cannot tell origin-anchored coordinates from stretched
+  // ones. Complex-path miters, dash and dot layouts and constrained corner
+  // shapes depend on the side lengths, so those signatures are cached as
+  // non-stretchable. Dashes are decided from the styles, not from the ops:
+  // a box too short to dash emits a solid stroke.
+  if (!input.geometry.IsEmpty()) {
+    op_cache->Insert(input, size_dependent
+                                ? BorderOpTemplate{}
+                                : BuildOpTemplate(input, ops));
+  }
+  return ops;
+}
+
+PaintOpList BorderPainter::PaintUncached(const BorderPaintInput& input,
+                                         const BorderProperties* props,
+                                         bool* size_dependent) {
+  PaintOpList ops = PaintBorder(input, props, size_dependent);
+  if (input.dark_mode.enabled) {
+    ApplyDarkMode(ops);
+  }
+  return ops;
+}
+
+BorderOpTemplate BorderPainter::BuildOpTemplate(const BorderPaintInput& input,
+                                                const PaintOpList& painted) {
+  // Painted at an empty box, every coordinate is its offset from the anchor
+  BorderPaintInput origin_input = input;
+  origin_input.geometry = RectF{};
+  BorderOpTemplate op_template;
+  op_template.ops = PaintUncached(origin_input);
+
+  const std::vector<PaintOp>& base = op_template.ops.ops();
+  const std::vector<PaintOp>& actual = painted.ops();
+  if (base.size() != actual.size()) {
+    return op_template;
+  }
+
+  // Classify each coordinate of the real box as origin + offset or
+  // origin + size + offset; anything else means the painter branched on
+  // the box size and the signature cannot be stamped
+  const RectF& g = input.geometry;
+  std::vector<float> offsets;
+  for (size_t k = 0; k < base.size(); ++k) {
+    if (base[k].index() != actual[k].index()) {
+      return op_template;
+    }
+    offsets.clear();
+    ForEachCoordinate(base[k], [&](const float& v, int) {
+      offsets.push_back(v);
+    });
+
+    bool affine = true;
+    size_t count = 0;
+    ForEachCoordinate(actual[k], [&](const float& v, int i) {
+      ++count;
+      if (!affine || static_cast<size_t>(i) >= offsets.size()) {
+        affine = false;
+        return;
+      }
+      const bool is_y = i & 1;
+      const float origin = is_y ? g.y : g.x;
+      const float size = is_y ? g.height : g.width;
+      if (NearlyEqual(v, origin + offsets[i])) {
+        op_template.stretch.push_back(0);
+        return;
+      }
+      if (NearlyEqual(v, origin + size + offsets[i])) {
+        op_template.stretch.push_back(1);
+        return;
+      }
+      affine = false;
+    });
+    if (count != offsets.size()) {
+      affine = false;
+    }
+    for (int r = 0; r < 2; ++r) {
+      const BorderRadii* base_radii = OpRadii(base[k], r);
+      if (base_radii && *base_radii != *OpRadii(actual[k], r)) {
+        affine = false;
+      }
+    }
+    if (!affine) {
+      return op_template;
+    }
+  }
+
+  op_template.stretchable = true;
+  return op_template;
+}
+
+PaintOpList BorderPainter::InstantiateOpTemplate(
+    const BorderOpTemplate& op_template, const BorderPaintInput& input) {
+  PaintOpList ops = op_template.ops;
+  const RectF& g = input.geometry;
+  std::vector<PaintOp>& list = ops.mutable_ops();
+  const uint8_t* stretch = op_template.stretch.data();
+  for (size_t k = 0; k < list.size(); ++k) {
+    // Same association as the painter: (origin + size) + offset
+    ForEachCoordinate(list[k], [&](float& v, int i) {
+      const bool is_y = i & 1;
+      float anchor = is_y ? g.y : g.x;
+      if (*stretch++) {
+        anchor += is_y ? g.height : g.width;
+      }
+      v = anchor + v;
+    });
+    std::visit(
+        [&input](auto& o) {
+          o.transform_id = input.state_ids.transform_id;
+          o.clip_id = input.state_ids.clip_id;
+          o.effect_id = input.state_ids.effect_id;
+        },
+        list[k]);
+  }
+  return ops;
+}
+
+// Inset/outset/groove/ridge shades are derived before inversion, as in
+// Chromium where the filter runs on the final flags color
+void BorderPainter::ApplyDarkMode(PaintOpList& ops) {
+  static DarkModeFilter filter;
+  for (auto& op : ops.mutable_ops()) {
+    std::visit(
+        [](auto& o) {
+          if constexpr (HasDrawFlags<std::decay_t<decltype(o)>>::value) {
+            o.flags.color = filter.InvertColorIfNeeded(
+                o.flags.color, DarkModeFilter::ElementRole::kBorder);
+          }
+        },
+        op);
+  }
+}
+
+PaintOpList BorderPainter::PaintBorder(const BorderPaintInput& input,
+                                       const BorderProperties* analyzed,
+                                       bool* size_dependent) {
   PaintOpList ops;
 
   // Skip if not visible
@@ -115,7 +488,7 @@ PaintOpList BorderPainter::Paint(const BorderPaintInput& input) {
   }
 
   // Analyze border properties
-  BorderProperties props = AnalyzeBorder(input);
+  BorderProperties props = analyzed ? *analyzed : AnalyzeBorder(input);
 
   // No visible edges
   if (props.visible_edge_count == 0) {
@@ -156,9 +529,29 @@ PaintOpList BorderPainter::Paint(const BorderPaintInput& input) {
   // Default behavior: try fast path first
   if (input.render_hint == BorderRenderHint::kAuto ||
       input.render_hint == BorderRenderHint::kStrokedRect) {
+    if (props.is_rounded && input.corner_shapes.has_value() &&
+        !input.corner_shapes->IsRound()) {
+      PaintContouredBorder(input, props, ops);
+      if (size_dependent) {
+        *size_dependent = true;
+      }
+      return ops;
+    }
+
     if (PaintFastPath(input, props, ops)) {
       return ops;
     }
+
+    if (UsesComplexPath(props)) {
+      std::array<BorderEdge, 4> edges = {
+          GetEdge(input, BoxSide::kTop), GetEdge(input, BoxSide::kRight),
+          GetEdge(input, BoxSide::kBottom), GetEdge(input, BoxSide::kLeft)};
+      ComplexBorderPainter(input, edges, ops).Paint();
+      if (size_dependent) {
+        *size_dependent = true;
+      }
+      return ops;
+    }
   }
 
   // Fall back to per-side painting
@@ -166,6 +559,61 @@ PaintOpList BorderPainter::Paint(const BorderPaintInput& input) {
   return ops;
 }
 
+void BorderPainter::PaintContouredBorder(const BorderPaintInput& input,
+                                         const BorderProperties& props,
+                                         PaintOpList& ops) {
+  const CornerShapes& shapes = *input.corner_shapes;
+  ContourPathCache& cache = ContouredBorderGeometry::SharedPathCache();
+
+  BorderPaintInput contoured = input;
+  contoured.border_radii = ContouredBorderGeometry::ConstrainedRadii(
+      input.geometry, *input.border_radii, shapes);
+  std::vector<PointF> outer = ContouredBorderGeometry::Contour(
+      input.geometry, *contoured.border_radii, shapes,
+      input.device_scale_factor, cache);
+
+  auto [left, top, right, bottom] =
+      CalculateInnerRect(input.geometry, input.border_widths);
+  std::vector<PointF> inner;
+  if (right > left && bottom > top) {
+    inner = ContouredBorderGeometry::Contour(
+        {left, top, right - left, bottom - top},
+        AdjustRadiiForInner(*contoured.border_radii, input.border_widths),
+        shapes, input.device_scale_factor, cache);
+  }
+
+  const BorderEdge first = GetEdge(input, static_cast<BoxSide>(
+                                              props.first_visible_edge));
+  if (props.visible_edge_count == 4 && props.is_uniform_color &&
+      props.is_uniform_style && first.style == EBorderStyle::kSolid) {
+    // Nonzero winding: the reversed inner contour cuts the hole
+    DrawPathOp op;
+    op.contours.push_back(std::move(outer));
+    if (!inner.empty()) {
+      op.contours.emplace_back(inner.rbegin(), inner.rend());
+    }
+    op.flags = BuildFillFlags(first.color);
+    op.transform_id = input.state_ids.transform_id;
+    op.clip_id = input.state_ids.clip_id;
+    op.effect_id = input.state_ids.effect_id;
+    ops.AddDrawPath(std::move(op));
+    return;
+  }
+
+  std::array<BorderEdge, 4> edges = {
+      GetEdge(input, BoxSide::kTop), GetEdge(input, BoxSide::kRight),
+      GetEdge(input, BoxSide::kBottom), GetEdge(input, BoxSide::kLeft)};
+  ComplexBorderPainter painter(contoured, edges, ops);
+  painter.SetContours(std::move(outer), std::move(inner));
+  painter.Paint();
+}
+
+bool BorderPainter::UsesComplexPath(const BorderProperties& props) {
+  return props.has_transparency || props.is_rounded ||
+         props.has_dashed_or_dotted || !props.is_uniform_color ||
+         !props.is_uniform_style;
+}
+
 // Fast path for uniform borders
 // Based on BoxBorderPainter::PaintBorderFastPath()
 bool BorderPainter::PaintFastPath(const BorderPaintInput& input,
@@ -178,15 +626,77 @@ bool BorderPainter::PaintFastPath(const BorderPaintInput& input,
 
   BorderEdge first_edge = GetEdge(input, static_cast<BoxSide>(props.first_visible_edge));
 
+  // Uniform dashed / dotted rounded border => one stroked rrect, laid out
+  // around the whole centerline. The complex path would stroke the same
+  // centerline once per side under a side clip.
+  if ((first_edge.style == EBorderStyle::kDashed ||
+       first_edge.style == EBorderStyle::kDotted) &&
+      props.visible_edge_count == 4 && props.is_uniform_width &&
+      props.is_rounded) {
+    DrawRRectOp op;
+    op.rect = CalculateStrokeRect(input.geometry, first_edge.width);
+    op.radii = AdjustRadiiForStroke(*input.border_radii, first_edge.width);
+    op.flags = BuildStrokeFlags(first_edge.color, first_edge.width);
+    const RectF centerline{op.rect[0], op.rect[1], op.rect[2] - op.rect[0],
+                           op.rect[3] - op.rect[1]};
+    ApplyDashLayout(
+        ComputeDashLayout(RRectPerimeter(centerline, op.radii),
+                          static_cast<int>(std::lround(first_edge.width)),
+                          first_edge.style, /*closed_path=*/true),
+        op.flags);
+    op.transform_id = input.state_ids.transform_id;
+    op.clip_id = input.state_ids.clip_id;
+    op.effect_id = input.state_ids.effect_id;
+    ops.AddDrawRRect(std::move(op));
+    return true;
+  }
+
   // Only handle solid borders in fast path for now
   // (Chromium also handles double borders here)
   if (first_edge.style != EBorderStyle::kSolid) {
     return false;
   }
 
-  // All 4 sides must be visible for the simplest fast path
+  // Fewer than 4 sides: only worth it when it avoids the transparency layer
+  // the complex path needs for adjacent translucent sides. Solid,
+  // rectangular border => one path of side rects
   if (props.visible_edge_count != 4) {
-    return false;
+    if (first_edge.color.IsOpaque() || props.is_rounded) {
+      return false;
+    }
+
+    const RectF& g = input.geometry;
+    DrawPathOp op;
+    for (auto side : {BoxSide::kTop, BoxSide::kRight, BoxSide::kBottom,
+                      BoxSide::kLeft}) {
+      BorderEdge edge = GetEdge(input, side);
+      if (!edge.ShouldRender()) {
+        continue;
+      }
+      float l = g.x, t = g.y, r = g.Right(), b = g.Bottom();
+      switch (side) {
+        case BoxSide::kTop:
+          b = t + edge.width;
+          break;
+        case BoxSide::kRight:
+          l = r - edge.width;
+          break;
+        case BoxSide::kBottom:
+          t = b - edge.width;
+          break;
+        case BoxSide::kLeft:
+          r = l + edge.width;
+          break;
+      }
+      op.contours.push_back({PointF{l, t}, PointF{r, t}, PointF{r, b},
+                             PointF{l, b}});
+    }
+    op.flags = BuildFillFlags(first_edge.color);
+    op.transform_id = input.state_ids.transform_id;
+    op.clip_id = input.state_ids.clip_id;
+    op.effect_id = input.state_ids.effect_id;
+    ops.AddDrawPath(std::move(op));
+    return true;
   }
 
   float stroke_width = first_edge.width;
@@ -204,8 +714,10 @@ bool BorderPainter::PaintFastPath(const BorderPaintInput& input,
     return true;
   }
 
-  // Uniform width + rounded => single stroked rrect
-  if (props.is_uniform_width && props.is_rounded) {
+  // Uniform width + rounded => single stroked rrect. Under a bleed
+  // avoidance clip the DRRect below is used instead.
+  const bool bleed_clipped = BleedAvoidanceIsClipping(input.bleed_avoidance);
+  if (props.is_uniform_width && props.is_rounded && !bleed_clipped) {
     DrawRRectOp op;
     op.rect = CalculateStrokeRect(input.geometry, stroke_width);
     op.radii = AdjustRadiiForStroke(*input.border_radii, stroke_width);
@@ -218,6 +730,8 @@ bool BorderPainter::PaintFastPath(const BorderPaintInput& input,
   }
 
   // Non-uniform width => fill DRRect (outer - inner)
+  // (DrawBleedAdjustedDRRect: the bleed avoidance clip rounds the outer
+  // corners, so the outer rect stays square)
   if (props.is_rounded) {
     DrawDRRectOp op;
     op.outer_rect = {
@@ -226,7 +740,7 @@ bool BorderPainter::PaintFastPath(const BorderPaintInput& input,
         input.geometry.x + input.geometry.width,
         input.geometry.y + input.geometry.height
     };
-    op.outer_radii = *input.border_radii;
+    op.outer_radii = bleed_clipped ? BorderRadii{} : *input.border_radii;
     op.inner_rect = CalculateInnerRect(input.geometry, input.border_widths);
     op.inner_radii = AdjustRadiiForInner(*input.border_radii, input.border_widths);
     op.flags = BuildFillFlags(color);
@@ -364,7 +878,8 @@ void BorderPainter::PaintSideAsLine(const BorderPaintInput& input,
   op.y0 = y1;
   op.x1 = x2;
   op.y1 = y2;
-  op.flags = BuildStrokeFlags(color, edge.width, edge.style);
+  op.flags = BuildStrokeFlags(color, edge.width, edge.style,
+                              std::fabs((x2 - x1) + (y2 - y1)));
   op.transform_id = input.state_ids.transform_id;
   op.clip_id = input.state_ids.clip_id;
   op.effect_id = input.state_ids.effect_id;
@@ -467,7 +982,8 @@ BorderRadii BorderPainter::AdjustRadiiForInner(const BorderRadii& radii,
 
 DrawFlags BorderPainter::BuildStrokeFlags(const Color& color,
                                           float stroke_width,
-                                          EBorderStyle style) {
+                                          EBorderStyle style,
+                                          float path_length) {
   DrawFlags flags;
   flags.color = color;
   flags.style = PaintStyle::kStroke;
@@ -475,18 +991,13 @@ DrawFlags BorderPainter::BuildStrokeFlags(const Color& color,
   flags.stroke_cap = StrokeCap::kButt;
   flags.stroke_join = StrokeJoin::kMiter;
 
-  // Set up dash pattern for dotted/dashed
-  if (style == EBorderStyle::kDotted) {
-    flags.dash_pattern.has_pattern = true;
-    // Dots: square dots with gaps equal to stroke width
-    flags.dash_pattern.intervals[0] = stroke_width;
-    flags.dash_pattern.intervals[1] = stroke_width;
-    flags.stroke_cap = StrokeCap::kRound;
-  } else if (style == EBorderStyle::kDashed) {
-    flags.dash_pattern.has_pattern = true;
-    // Dashes: 3x width dash, 1x width gap
-    flags.dash_pattern.intervals[0] = stroke_width * 3;
-    flags.dash_pattern.intervals[1] = stroke_width;
+  // Dashes and dots are spaced to fit the stroked line evenly
+  if (style == EBorderStyle::kDotted || style == EBorderStyle::kDashed) {
+    ApplyDashLayout(
+        ComputeDashLayout(path_length,
+                          static_cast<int>(std::lround(stroke_width)), style,
+                          /*closed_path=*/false),
+        flags);
   }
 
   return flags;
@@ -618,7 +1129,8 @@ void BorderPainter::PaintDottedBorder(const BorderPaintInput& input,
         break;
     }
 
-    op.flags = BuildStrokeFlags(edge.color, edge.width, EBorderStyle::kDotted);
+    op.flags = BuildStrokeFlags(edge.color, edge.width, EBorderStyle::kDotted,
+                                (op.x1 - op.x0) + (op.y1 - op.y0));
     op.transform_id = input.state_ids.transform_id;
     op.clip_id = input.state_ids.clip_id;
     op.effect_id = input.state_ids.effect_id;
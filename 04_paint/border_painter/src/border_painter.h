@@ -7,11 +7,15 @@
 #include <optional>
 #include <vector>
 
+#include "cull_rect.h"
 #include "draw_commands.h"
 #include "types.h"
 
 namespace border_painter {
 
+class BorderOpCache;
+struct BorderOpTemplate;
+
 // Render hint - tells the painter which strategy Chromium used
 enum class BorderRenderHint {
   kAuto,           // Let painter decide
@@ -34,14 +38,37 @@ struct BorderPaintInput {
   DOMNodeId node_id = kInvalidDOMNodeId;
   GraphicsStateIds state_ids;
   BorderRenderHint render_hint = BorderRenderHint::kAuto;  // For verification
+  AutoDarkMode dark_mode;
+  std::optional<CornerShapes> corner_shapes;  // Default is round
+  float device_scale_factor = 1.0f;           // Corner flattening tolerance
+  // Painted by BoxDecorationPainter together with the border
+  std::optional<Color> background_color;
+  // Set by BoxDecorationPainter: with a clipping strategy the outer border
+  // clip is already applied
+  BackgroundBleedAvoidance bleed_avoidance = BackgroundBleedAvoidance::kNone;
+  // Boxes whose border box misses it paint nothing (borders are painted
+  // inside the border box, so there is no stroke outset)
+  CullRect cull_rect;
 };
 
 // Paints borders for block-level elements
 // Following Chromium's BoxBorderPainter logic
 class BorderPainter {
  public:
-  // Paint borders and return the list of paint operations
-  static PaintOpList Paint(const BorderPaintInput& input);
+  // Paint borders and return the list of paint operations. With |op_cache|,
+  // boxes sharing a border definition are stamped from one op template.
+  // A box with a background color goes through BoxDecorationPainter, as in
+  // PaintBatch.
+  static PaintOpList Paint(const BorderPaintInput& input,
+                           BorderOpCache* op_cache = nullptr);
+
+  // Paints a document's boxes in order and returns their concatenated ops.
+  // The borders are analyzed together (BorderBatch); uniform solid boxes
+  // are emitted from the batched stroke geometry, the rest are painted
+  // like Paint with the precomputed analysis. Boxes with a background
+  // color go through BoxDecorationPainter.
+  static PaintOpList PaintBatch(const std::vector<BorderPaintInput>& inputs,
+                                BorderOpCache* op_cache = nullptr);
 
  private:
   // Analyze border properties
@@ -51,17 +78,59 @@ class BorderPainter {
     bool is_uniform_style = true;
     bool is_rounded = false;
     bool has_transparency = false;
+    bool has_dashed_or_dotted = false;
     unsigned visible_edge_count = 0;
     unsigned first_visible_edge = 0;
   };
 
+  // Paint with |props| already analyzed (or nullptr)
+  static PaintOpList PaintAnalyzed(const BorderPaintInput& input,
+                                   const BorderProperties* props,
+                                   BorderOpCache* op_cache);
+
+  // Paint without the op cache: strategy selection plus dark mode.
+  // |size_dependent| reports whether the ops depend on the box size in a
+  // way a template cannot stretch (complex path miters, contoured corners).
+  static PaintOpList PaintUncached(const BorderPaintInput& input,
+                                   const BorderProperties* props = nullptr,
+                                   bool* size_dependent = nullptr);
+
+  // Strategy selection and op emission, before the dark mode pass
+  static PaintOpList PaintBorder(const BorderPaintInput& input,
+                                 const BorderProperties* props,
+                                 bool* size_dependent);
+
+  // Derives the op template for the signature of |input| from |painted|,
+  // the ops already painted for |input|
+  static BorderOpTemplate BuildOpTemplate(const BorderPaintInput& input,
+                                          const PaintOpList& painted);
+
+  // Translates and stretches |op_template| to the geometry of |input|
+  static PaintOpList InstantiateOpTemplate(const BorderOpTemplate& op_template,
+                                           const BorderPaintInput& input);
+
+  // Inverts the color of every emitted op (BorderPainter paints with
+  // DarkModeFilter::ElementRole::kBorder)
+  static void ApplyDarkMode(PaintOpList& ops);
+
   static BorderProperties AnalyzeBorder(const BorderPaintInput& input);
 
+  // Mixed colors or styles, translucency or rounded corners need the
+  // mitered, layered painting of ComplexBorderPainter
+  static bool UsesComplexPath(const BorderProperties& props);
+
   // Fast path: uniform solid border with single stroked rect/rrect
   static bool PaintFastPath(const BorderPaintInput& input,
                             const BorderProperties& props,
                             PaintOpList& ops);
 
+  // Rounded border with non-round corner shapes: one filled outer-minus-
+  // inner contour when uniform, otherwise ComplexBorderPainter clipped to
+  // the contours
+  static void PaintContouredBorder(const BorderPaintInput& input,
+                                   const BorderProperties& props,
+                                   PaintOpList& ops);
+
   // Slow path: paint individual sides
   static void PaintSides(const BorderPaintInput& input,
                          const BorderProperties& props,
@@ -126,9 +195,11 @@ class BorderPainter {
   static BorderRadii AdjustRadiiForInner(const BorderRadii& radii,
                                          const BorderWidths& widths);
 
-  // Build draw flags for border stroke
+  // Build draw flags for border stroke; dashed / dotted strokes are laid
+  // out along |path_length|
   static DrawFlags BuildStrokeFlags(const Color& color, float stroke_width,
-                                    EBorderStyle style = EBorderStyle::kSolid);
+                                    EBorderStyle style = EBorderStyle::kSolid,
+                                    float path_length = 0.0f);
 
   // Build draw flags for border fill
   static DrawFlags BuildFillFlags(const Color& color);
@@ -0,0 +1,257 @@
+// Copyright 2019 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's box_decoration_data.cc and
+// BoxFragmentPainter::PaintBoxDecorationBackgroundWithRectImpl
+// Original: third_party/blink/renderer/core/paint/box_decoration_data.cc
+//           third_party/blink/renderer/core/paint/box_fragment_painter.cc
+//
+// Changes from Chromium:
+// - See box_decoration_painter.h
+
+#include "box_decoration_painter.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "border_op_cache.h"
+#include "contoured_border_geometry.h"
+#include "dark_mode_filter.h"
+
+namespace border_painter {
+
+namespace {
+
+// Edges narrower than this (in device pixels) cannot hide the anti-aliased
+// edge of a background shrunk under them
+constexpr float kMinObscuringEdgeWidth = 2.0f;
+
+template <typename Op>
+Op WithStateIds(Op op, const BorderPaintInput& input) {
+  op.transform_id = input.state_ids.transform_id;
+  op.clip_id = input.state_ids.clip_id;
+  op.effect_id = input.state_ids.effect_id;
+  return op;
+}
+
+bool HasRadius(const BorderPaintInput& input) {
+  return input.border_radii.has_value() && !IsZeroRadii(*input.border_radii);
+}
+
+bool HasShapedCorners(const BorderPaintInput& input) {
+  return input.corner_shapes.has_value() && !input.corner_shapes->IsRound();
+}
+
+// BorderEdge::ObscuresBackgroundEdge: a present, opaque edge without gaps
+bool EdgeObscuresBackgroundEdge(const BorderEdge& edge) {
+  if (!edge.ShouldRender() || !edge.color.IsOpaque()) {
+    return false;
+  }
+  return edge.style != EBorderStyle::kDotted &&
+         edge.style != EBorderStyle::kDashed;
+}
+
+}  // namespace
+
+PaintOpList BoxDecorationPainter::Paint(const BorderPaintInput& input,
+                                        BorderOpCache* op_cache) {
+  if (input.visibility != Visibility::kVisible ||
+      !input.cull_rect.Intersects(input.geometry)) {
+    return PaintOpList();
+  }
+
+  const BackgroundBleedAvoidance bleed_avoidance =
+      DetermineBleedAvoidance(input);
+  const bool clipping = BleedAvoidanceIsClipping(bleed_avoidance);
+
+  PaintOpList ops;
+  if (clipping) {
+    ops.AddSave(WithStateIds(SaveOp{}, input));
+    ClipToBorder(input, ops);
+    if (bleed_avoidance == BackgroundBleedAvoidance::kClipLayer) {
+      ops.AddSaveLayerAlpha(WithStateIds(SaveLayerAlphaOp{}, input));
+    }
+  }
+
+  if (input.background_color.has_value()) {
+    PaintBackground(input, bleed_avoidance, ops);
+  }
+
+  BorderPaintInput border_input = input;
+  border_input.background_color.reset();
+  border_input.bleed_avoidance = bleed_avoidance;
+  PaintOpList border_ops = BorderPainter::Paint(border_input, op_cache);
+  auto& border_list = border_ops.mutable_ops();
+  ops.mutable_ops().insert(ops.mutable_ops().end(),
+                           std::make_move_iterator(border_list.begin()),
+                           std::make_move_iterator(border_list.end()));
+
+  if (clipping) {
+    if (bleed_avoidance == BackgroundBleedAvoidance::kClipLayer) {
+      ops.AddRestore(WithStateIds(RestoreOp{}, input));
+    }
+    ops.AddRestore(WithStateIds(RestoreOp{}, input));
+  }
+  return ops;
+}
+
+BackgroundBleedAvoidance BoxDecorationPainter::DetermineBleedAvoidance(
+    const BorderPaintInput& input) {
+  // Verification render hints keep their exact border ops
+  if (!input.background_color.has_value() ||
+      (input.render_hint != BorderRenderHint::kAuto &&
+       input.render_hint != BorderRenderHint::kStrokedRect)) {
+    return BackgroundBleedAvoidance::kNone;
+  }
+
+  const std::array<BorderEdge, 4> edges = Edges(input);
+  if (std::none_of(edges.begin(), edges.end(), [](const BorderEdge& edge) {
+        return edge.ShouldRender();
+      })) {
+    return BackgroundBleedAvoidance::kNone;
+  }
+
+  const bool rounded = HasRadius(input);
+  if (!(rounded && HasShapedCorners(input)) &&
+      BorderObscuresBackgroundEdge(edges, input.device_scale_factor)) {
+    return BackgroundBleedAvoidance::kShrinkBackground;
+  }
+
+  if (!rounded) {
+    return BackgroundBleedAvoidance::kNone;
+  }
+
+  if (BorderObscuresBackground(edges)) {
+    return BackgroundBleedAvoidance::kClipOnly;
+  }
+  return BackgroundBleedAvoidance::kClipLayer;
+}
+
+std::array<BorderEdge, 4> BoxDecorationPainter::Edges(
+    const BorderPaintInput& input) {
+  const BorderWidths& w = input.border_widths;
+  const BorderColors& c = input.border_colors;
+  const BorderStyles s = input.border_styles.value_or(BorderStyles{});
+  return {{{w.top, c.top, s.top},
+           {w.right, c.right, s.right},
+           {w.bottom, c.bottom, s.bottom},
+           {w.left, c.left, s.left}}};
+}
+
+bool BoxDecorationPainter::BorderObscuresBackgroundEdge(
+    const std::array<BorderEdge, 4>& edges, float device_scale_factor) {
+  for (const BorderEdge& edge : edges) {
+    if (!EdgeObscuresBackgroundEdge(edge) ||
+        edge.width * device_scale_factor < kMinObscuringEdgeWidth) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BoxDecorationPainter::BorderObscuresBackground(
+    const std::array<BorderEdge, 4>& edges) {
+  for (const BorderEdge& edge : edges) {
+    // Double borders show the background between their stripes
+    if (!EdgeObscuresBackgroundEdge(edge) ||
+        edge.style == EBorderStyle::kDouble) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// BackgroundRoundedRectAdjustedForBleedAvoidance: inset by a "safe" amount,
+// 1/2 border-width for opaque border styles, 1/6 border-width for double
+// borders
+void BoxDecorationPainter::ShrinkBackground(const BorderPaintInput& input,
+                                            std::array<float, 4>& rect,
+                                            BorderRadii& radii) {
+  const std::array<BorderEdge, 4> edges = Edges(input);
+  float insets[4];
+  for (size_t i = 0; i < 4; ++i) {
+    const float fraction =
+        edges[i].style == EBorderStyle::kDouble ? 1.0f / 6.0f : 0.5f;
+    insets[i] = edges[i].width * fraction;
+  }
+  const float top = insets[0], right = insets[1], bottom = insets[2],
+              left = insets[3];
+  rect[0] += left;
+  rect[1] += top;
+  rect[2] -= right;
+  rect[3] -= bottom;
+
+  const float radius_insets[8] = {left, top,   right, top,
+                                  right, bottom, left, bottom};
+  for (size_t i = 0; i < radii.size(); ++i) {
+    radii[i] = std::max(0.0f, radii[i] - radius_insets[i]);
+  }
+}
+
+void BoxDecorationPainter::PaintBackground(
+    const BorderPaintInput& input, BackgroundBleedAvoidance bleed_avoidance,
+    PaintOpList& ops) {
+  static DarkModeFilter filter;
+
+  DrawFlags flags;
+  flags.color = *input.background_color;
+  if (input.dark_mode.enabled) {
+    flags.color = filter.InvertColorIfNeeded(
+        flags.color, DarkModeFilter::ElementRole::kBackground);
+  }
+  flags.style = PaintStyle::kFill;
+
+  const RectF& g = input.geometry;
+  std::array<float, 4> rect = {g.x, g.y, g.Right(), g.Bottom()};
+  // Under a clipping strategy the clip rounds the corners
+  BorderRadii radii{};
+  if (HasRadius(input) && !BleedAvoidanceIsClipping(bleed_avoidance)) {
+    radii = *input.border_radii;
+  }
+  if (bleed_avoidance == BackgroundBleedAvoidance::kShrinkBackground) {
+    ShrinkBackground(input, rect, radii);
+  }
+  if (rect[2] <= rect[0] || rect[3] <= rect[1]) {
+    return;
+  }
+
+  if (IsZeroRadii(radii)) {
+    DrawRectOp op;
+    op.rect = rect;
+    op.node_id = input.node_id;
+    op.flags = flags;
+    ops.AddDrawRect(WithStateIds(std::move(op), input));
+  } else {
+    DrawRRectOp op;
+    op.rect = rect;
+    op.radii = radii;
+    op.node_id = input.node_id;
+    op.flags = flags;
+    ops.AddDrawRRect(WithStateIds(std::move(op), input));
+  }
+}
+
+void BoxDecorationPainter::ClipToBorder(const BorderPaintInput& input,
+                                        PaintOpList& ops) {
+  if (HasShapedCorners(input)) {
+    ClipPathOp op;
+    op.points = ContouredBorderGeometry::Contour(
+        input.geometry,
+        ContouredBorderGeometry::ConstrainedRadii(
+            input.geometry, *input.border_radii, *input.corner_shapes),
+        *input.corner_shapes, input.device_scale_factor,
+        ContouredBorderGeometry::SharedPathCache());
+    ops.AddClipPath(WithStateIds(std::move(op), input));
+    return;
+  }
+
+  const RectF& g = input.geometry;
+  ClipRRectOp op;
+  op.rect = {g.x, g.y, g.Right(), g.Bottom()};
+  op.radii = *input.border_radii;
+  ops.AddClipRRect(WithStateIds(std::move(op), input));
+}
+
+}  // namespace border_painter
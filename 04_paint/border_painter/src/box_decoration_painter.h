@@ -0,0 +1,85 @@
+// Copyright 2019 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's box_decoration_data.h and
+// BoxFragmentPainter::PaintBoxDecorationBackgroundWithRectImpl
+// Original: third_party/blink/renderer/core/paint/box_decoration_data.h
+//           third_party/blink/renderer/core/paint/box_fragment_painter.cc
+//
+// Changes from Chromium:
+// - Only a background color and the border; no box shadows, background
+//   images or native appearance
+// - kShrinkBackground also applies to rectangular borders (Chromium paints
+//   those with kNone): the background under an opaque border is never seen,
+//   so shrinking it only saves overdraw
+// - Shaped corners (corner_shapes) never shrink the background; the
+//   clipping strategies clip to the flattened outer contour
+// - The 2 device pixel minimum of BorderObscuresBackgroundEdge uses
+//   BorderPaintInput::device_scale_factor as the contents scale
+
+#ifndef BORDER_PAINTER_BOX_DECORATION_PAINTER_H_
+#define BORDER_PAINTER_BOX_DECORATION_PAINTER_H_
+
+#include <array>
+
+#include "border_painter.h"
+#include "draw_commands.h"
+#include "types.h"
+
+namespace border_painter {
+
+class BorderOpCache;
+
+// Paints the background color and the border of a box as one decoration,
+// so the background can avoid bleeding out of (and being overdrawn by) the
+// border. Picks the cheapest correct BackgroundBleedAvoidance:
+//
+// - kShrinkBackground: every side is an opaque, solid-looking border at
+//   least 2 device pixels wide. The background is inset by half the border
+//   widths (a sixth for double borders): no clip, no layer, and the border
+//   covers the shrunk edge.
+// - kClipOnly: the rounded border is opaque but too thin to hide a shrunk
+//   background. Background and border are clipped to the outer border.
+// - kClipLayer: anything else rounded (translucent, dashed or missing
+//   sides). The clipped decoration is also composited in a layer so the
+//   anti-aliased outer edge is blended once.
+// - kNone: no background, no border or a rectangular border that cannot
+//   cover the background edge.
+class BoxDecorationPainter {
+ public:
+  // Background (when |input| has one) followed by the border. The border
+  // ops go through |op_cache| like BorderPainter::Paint.
+  static PaintOpList Paint(const BorderPaintInput& input,
+                           BorderOpCache* op_cache = nullptr);
+
+  // BoxDecorationData::ComputeBleedAvoidance
+  static BackgroundBleedAvoidance DetermineBleedAvoidance(
+      const BorderPaintInput& input);
+
+ private:
+  static std::array<BorderEdge, 4> Edges(const BorderPaintInput& input);
+
+  // All sides opaque and wide enough to hide a background shrunk under them
+  static bool BorderObscuresBackgroundEdge(
+      const std::array<BorderEdge, 4>& edges, float device_scale_factor);
+
+  // All sides opaque and painted without gaps
+  static bool BorderObscuresBackground(const std::array<BorderEdge, 4>& edges);
+
+  // Background rect (and radii) inset for kShrinkBackground
+  static void ShrinkBackground(const BorderPaintInput& input,
+                               std::array<float, 4>& rect,
+                               BorderRadii& radii);
+
+  static void PaintBackground(const BorderPaintInput& input,
+                              BackgroundBleedAvoidance bleed_avoidance,
+                              PaintOpList& ops);
+
+  // Clip to the outer border: an rrect, or the contour of shaped corners
+  static void ClipToBorder(const BorderPaintInput& input, PaintOpList& ops);
+};
+
+}  // namespace border_painter
+
+#endif  // BORDER_PAINTER_BOX_DECORATION_PAINTER_H_
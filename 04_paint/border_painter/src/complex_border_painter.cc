@@ -0,0 +1,1604 @@
+// Copyright 2015 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's box_border_painter.cc (complex path)
+// Original: third_party/blink/renderer/core/paint/box_border_painter.cc
+//
+// Changes from Chromium:
+// - See complex_border_painter.h
+
+#include "complex_border_painter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace border_painter {
+
+namespace {
+
+enum BorderEdgeFlag {
+  kTopBorderEdge = 1 << static_cast<unsigned>(BoxSide::kTop),
+  kRightBorderEdge = 1 << static_cast<unsigned>(BoxSide::kRight),
+  kBottomBorderEdge = 1 << static_cast<unsigned>(BoxSide::kBottom),
+  kLeftBorderEdge = 1 << static_cast<unsigned>(BoxSide::kLeft),
+  kAllBorderEdges =
+      kTopBorderEdge | kBottomBorderEdge | kLeftBorderEdge | kRightBorderEdge
+};
+
+unsigned EdgeFlagForSide(BoxSide side) {
+  return 1u << static_cast<unsigned>(side);
+}
+
+bool IncludesEdge(unsigned flags, BoxSide side) {
+  return flags & EdgeFlagForSide(side);
+}
+
+bool IncludesAdjacentEdges(unsigned flags) {
+  // The set includes adjacent edges iff it contains at least one horizontal
+  // and one vertical edge
+  return (flags & (kTopBorderEdge | kBottomBorderEdge)) &&
+         (flags & (kLeftBorderEdge | kRightBorderEdge));
+}
+
+bool StyleRequiresClipPolygon(EBorderStyle style) {
+  // These are drawn with a stroke, so we have to clip to get corner miters
+  return style == EBorderStyle::kDotted || style == EBorderStyle::kDashed;
+}
+
+bool BorderStyleFillsBorderArea(EBorderStyle style) {
+  return !(style == EBorderStyle::kDotted || style == EBorderStyle::kDashed ||
+           style == EBorderStyle::kDouble);
+}
+
+bool BorderStyleHasInnerDetail(EBorderStyle style) {
+  return style == EBorderStyle::kGroove || style == EBorderStyle::kRidge ||
+         style == EBorderStyle::kDouble;
+}
+
+bool BorderStyleIsDottedOrDashed(EBorderStyle style) {
+  return style == EBorderStyle::kDotted || style == EBorderStyle::kDashed;
+}
+
+// BorderStyleOutset darkens the bottom and right (and maybe lightens the top
+// and left) BorderStyleInset darkens the top and left (and maybe lightens
+// the bottom and right)
+bool BorderStyleHasUnmatchedColorsAtCorner(EBorderStyle style,
+                                           BoxSide side,
+                                           BoxSide adjacent_side) {
+  // These styles match at the top/left and bottom/right
+  if (style == EBorderStyle::kInset || style == EBorderStyle::kGroove ||
+      style == EBorderStyle::kRidge || style == EBorderStyle::kOutset) {
+    const unsigned top_right_flags =
+        EdgeFlagForSide(BoxSide::kTop) | EdgeFlagForSide(BoxSide::kRight);
+    const unsigned bottom_left_flags =
+        EdgeFlagForSide(BoxSide::kBottom) | EdgeFlagForSide(BoxSide::kLeft);
+
+    unsigned flags = EdgeFlagForSide(side) | EdgeFlagForSide(adjacent_side);
+    return flags == top_right_flags || flags == bottom_left_flags;
+  }
+  return false;
+}
+
+bool IsZeroCorner(float width, float height) {
+  return width == 0.0f && height == 0.0f;
+}
+
+bool BorderWillArcInnerEdge(const BorderRadii& radii, int corner1,
+                            int corner2) {
+  return !IsZeroCorner(radii[2 * corner1], radii[2 * corner1 + 1]) ||
+         !IsZeroCorner(radii[2 * corner2], radii[2 * corner2 + 1]);
+}
+
+// Corner indices into BorderRadii pairs
+constexpr int kTopLeft = 0;
+constexpr int kTopRight = 1;
+constexpr int kBottomRight = 2;
+constexpr int kBottomLeft = 3;
+
+bool WillOverdraw(BoxSide side, EBorderStyle style, unsigned completed_edges) {
+  // If we're done with this side, it will obviously not overdraw any portion
+  // of the current edge
+  if (IncludesEdge(completed_edges, side)) {
+    return false;
+  }
+
+  // The side is still to be drawn. It overdraws the current edge iff it has
+  // a solid fill style
+  return BorderStyleFillsBorderArea(style);
+}
+
+bool BorderStylesRequireMiter(BoxSide side,
+                              BoxSide adjacent_side,
+                              EBorderStyle style,
+                              EBorderStyle adjacent_style) {
+  if (style == EBorderStyle::kDouble ||
+      adjacent_style == EBorderStyle::kDouble ||
+      adjacent_style == EBorderStyle::kGroove ||
+      adjacent_style == EBorderStyle::kRidge) {
+    return true;
+  }
+
+  if (BorderStyleIsDottedOrDashed(style) !=
+      BorderStyleIsDottedOrDashed(adjacent_style)) {
+    return true;
+  }
+
+  if (style != adjacent_style) {
+    return true;
+  }
+
+  return BorderStyleHasUnmatchedColorsAtCorner(style, side, adjacent_side);
+}
+
+// Style-based paint order: non-solid edges (dashed/dotted/double) are
+// painted before solid edges (inset/outset/groove/ridge/solid) to maximize
+// overdraw opportunities
+constexpr unsigned kStylePriority[] = {
+    0,  // EBorderStyle::kNone
+    0,  // EBorderStyle::kHidden
+    2,  // EBorderStyle::kInset
+    2,  // EBorderStyle::kGroove
+    2,  // EBorderStyle::kOutset
+    2,  // EBorderStyle::kRidge
+    1,  // EBorderStyle::kDotted
+    1,  // EBorderStyle::kDashed
+    3,  // EBorderStyle::kSolid
+    1,  // EBorderStyle::kDouble
+};
+
+// Given the same style, prefer drawing in non-adjacent order to minimize
+// the number of sides which require miters
+constexpr unsigned kSidePriority[] = {
+    0,  // BoxSide::kTop
+    2,  // BoxSide::kRight
+    1,  // BoxSide::kBottom
+    3,  // BoxSide::kLeft
+};
+
+// Width of a side that takes part in layout (none / hidden use 0)
+float UsedWidth(const BorderEdge& edge) {
+  if (edge.style == EBorderStyle::kNone || edge.style == EBorderStyle::kHidden) {
+    return 0.0f;
+  }
+  return edge.width;
+}
+
+int RoundedWidth(const BorderEdge& edge) {
+  return static_cast<int>(std::lround(UsedWidth(edge)));
+}
+
+bool DarkenBoxSide(BoxSide side, EBorderStyle style) {
+  return (side == BoxSide::kTop || side == BoxSide::kLeft) ==
+         (style == EBorderStyle::kInset);
+}
+
+float RelativeLuminance(const Color& color) {
+  auto linear = [](float c) {
+    return c <= 0.03928f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+  };
+  return 0.2126f * linear(color.r) + 0.7152f * linear(color.g) +
+         0.0722f * linear(color.b);
+}
+
+float ContrastRatio(const Color& a, const Color& b) {
+  float la = RelativeLuminance(a);
+  float lb = RelativeLuminance(b);
+  return (std::max(la, lb) + 0.05f) / (std::min(la, lb) + 0.05f);
+}
+
+Color CalculateInsetOutsetColor(bool is_darken, const Color& color) {
+  const Color dark_color = color.Dark();
+  // Inset, outset, ridge, and groove paint a darkened or "shadow" edge. By
+  // default, darken |color| for the darker edge and use |color| for the
+  // lighter edge.
+  if (is_darken) {
+    return dark_color;
+  }
+
+  // Skip the contrast check when the result is known to be false
+  if (color.r >= (150 / 255.0f) || color.g >= (92 / 255.0f)) {
+    return color;
+  }
+  // Not enough contrast between the darkened edge and |color|: also lighten
+  // |color| for the lighter edge
+  constexpr float kMinimumBorderEdgeContrastRatio = 1.75f;
+  return ContrastRatio(color, dark_color) < kMinimumBorderEdgeContrastRatio
+             ? color.Light()
+             : color;
+}
+
+// Stroke flags for dashed / dotted strokes |thickness| wide
+DrawFlags StyledStrokeFlags(const Color& color, float thickness,
+                            const DashLayout& layout) {
+  DrawFlags flags;
+  flags.color = color;
+  flags.style = PaintStyle::kStroke;
+  flags.stroke_width = thickness;
+  flags.stroke_cap = StrokeCap::kButt;
+  flags.stroke_join = StrokeJoin::kMiter;
+  ApplyDashLayout(layout, flags);
+  return flags;
+}
+
+DrawFlags FillFlags(const Color& color) {
+  DrawFlags flags;
+  flags.color = color;
+  flags.style = PaintStyle::kFill;
+  return flags;
+}
+
+// Intersection of the infinite lines p1-p2 and d1-d2; |intersection| is
+// left untouched for parallel lines
+void FindIntersection(const PointF& p1, const PointF& p2, const PointF& d1,
+                      const PointF& d2, PointF& intersection) {
+  const float dx = p2.x - p1.x;
+  const float dy = p2.y - p1.y;
+  const float ox = d2.x - d1.x;
+  const float oy = d2.y - d1.y;
+  const float denom = dx * oy - dy * ox;
+  if (denom == 0.0f) {
+    return;
+  }
+  const float t = ((d1.x - p1.x) * oy - (d1.y - p1.y) * ox) / denom;
+  intersection = PointF{p1.x + dx * t, p1.y + dy * t};
+}
+
+PointF Offset(const PointF& p, float dx, float dy) {
+  return PointF{p.x + dx, p.y + dy};
+}
+
+bool IsRenderable(const RectF& rect, const BorderRadii& r) {
+  return r[0] + r[2] <= rect.width && r[6] + r[4] <= rect.width &&
+         r[1] + r[7] <= rect.height && r[3] + r[5] <= rect.height;
+}
+
+}  // namespace
+
+ComplexBorderPainter::ComplexBorderPainter(
+    const BorderPaintInput& input,
+    const std::array<BorderEdge, 4>& edges,
+    PaintOpList& ops)
+    : input_(input), edges_(edges), ops_(ops) {
+  for (auto& edge : edges_) {
+    edge.style = BorderEdge::EffectiveStyle(edge.style,
+                                            static_cast<int>(edge.width));
+  }
+
+  // ComputeBorderProperties()
+  unsigned visible_edge_count = 0;
+  for (unsigned i = 0; i < 4; ++i) {
+    const BorderEdge& edge = edges_[i];
+    if (!edge.ShouldRender()) {
+      if (edge.PresentButInvisible()) {
+        is_uniform_color_ = false;
+      }
+      continue;
+    }
+
+    visible_edge_count++;
+    visible_edge_set_ |= EdgeFlagForSide(static_cast<BoxSide>(i));
+
+    if (visible_edge_count == 1) {
+      first_visible_edge_ = i;
+      continue;
+    }
+
+    is_uniform_style_ &= edge.style == edges_[first_visible_edge_].style;
+    is_uniform_color_ &= edge.SharesColorWith(edges_[first_visible_edge_]);
+  }
+
+  outer_ = input.geometry;
+  outer_radii_ = input.border_radii.value_or(BorderRadii{});
+  is_rounded_ = !IsZeroRadii(outer_radii_);
+
+  const float top = UsedWidth(Edge(BoxSide::kTop));
+  const float right = UsedWidth(Edge(BoxSide::kRight));
+  const float bottom = UsedWidth(Edge(BoxSide::kBottom));
+  const float left = UsedWidth(Edge(BoxSide::kLeft));
+  inner_ = InsetRect(top, right, bottom, left);
+  inner_radii_ = InsetRadii(top, right, bottom, left);
+  inner_renderable_ = IsRenderable(inner_, inner_radii_);
+}
+
+void ComplexBorderPainter::SetContours(std::vector<PointF> outer,
+                                       std::vector<PointF> inner) {
+  outer_contour_ = std::move(outer);
+  inner_contour_ = std::move(inner);
+}
+
+void ComplexBorderPainter::Paint() {
+  if (!visible_edge_set_ || outer_.IsEmpty()) {
+    return;
+  }
+
+  // For bleed avoidance clipping the outer border clip is already applied
+  const bool clip_to_outer_border = is_rounded_;
+  const bool outer_clipped = BleedAvoidanceIsClipping(input_.bleed_avoidance);
+  if (clip_to_outer_border) {
+    Save();
+    if (!outer_contour_.empty()) {
+      if (!outer_clipped) {
+        ClipPolygon(outer_contour_, /*antialiased=*/true);
+      }
+      if (!inner_contour_.empty()) {
+        ClipPolygon(inner_contour_, /*antialiased=*/true,
+                    /*difference=*/true);
+      }
+    } else {
+      if (!outer_clipped) {
+        ClipRRect(outer_, outer_radii_, /*difference=*/false);
+      }
+      if (inner_renderable_ && !inner_.IsEmpty()) {
+        ClipRRect(inner_, inner_radii_, /*difference=*/true);
+      }
+    }
+  }
+
+  PaintOpacityGroup(BuildOpacityGroups(), 0, 1.0f);
+
+  if (clip_to_outer_border) {
+    Restore();
+  }
+}
+
+std::vector<ComplexBorderPainter::OpacityGroup>
+ComplexBorderPainter::BuildOpacityGroups() const {
+  std::vector<BoxSide> sorted_sides;
+  sorted_sides.reserve(4);
+  for (unsigned i = first_visible_edge_; i < 4; ++i) {
+    BoxSide side = static_cast<BoxSide>(i);
+    if (IncludesEdge(visible_edge_set_, side)) {
+      sorted_sides.push_back(side);
+    }
+  }
+
+  // Paint order by three (prioritized) criteria: alpha, style, side
+  std::sort(sorted_sides.begin(), sorted_sides.end(),
+            [this](BoxSide a, BoxSide b) {
+              const BorderEdge& edge_a = Edge(a);
+              const BorderEdge& edge_b = Edge(b);
+              if (edge_a.color.a != edge_b.color.a) {
+                return edge_a.color.a < edge_b.color.a;
+              }
+              const unsigned style_priority_a =
+                  kStylePriority[static_cast<unsigned>(edge_a.style)];
+              const unsigned style_priority_b =
+                  kStylePriority[static_cast<unsigned>(edge_b.style)];
+              if (style_priority_a != style_priority_b) {
+                return style_priority_a < style_priority_b;
+              }
+              return kSidePriority[static_cast<unsigned>(a)] <
+                     kSidePriority[static_cast<unsigned>(b)];
+            });
+
+  std::vector<OpacityGroup> groups;
+  float current_alpha = 0.0f;
+  for (BoxSide side : sorted_sides) {
+    const float edge_alpha = Edge(side).color.a;
+    if (edge_alpha != current_alpha) {
+      groups.emplace_back(edge_alpha);
+      current_alpha = edge_alpha;
+    }
+    OpacityGroup& current_group = groups.back();
+    current_group.sides.push_back(side);
+    current_group.edge_flags |= EdgeFlagForSide(side);
+  }
+  return groups;
+}
+
+// Translucent sides are painted as follows, to maximize the use of overdraw
+// as a corner seam avoidance technique:
+//
+//   1) cluster sides sharing the same opacity into opacity groups
+//   2) sort groups in increasing opacity order
+//   3) reverse-iterate over groups (decreasing opacity order), pushing nested
+//      transparency layers with adjusted/relative opacity
+//   4) iterate over groups (increasing opacity order), painting the group
+//      sides and then ending their layer
+//
+// Because opacity is applied via layers, the side paint itself is opaque, so
+// later sides mask portions of the earlier ones. E.g. top 1.0, right 0.25,
+// bottom 0.5, left 0.25 paints as:
+//
+//   SaveLayerAlpha(0.5)          // bottom group
+//     right, left at 0.5         // 0.5 * 0.5 = 0.25; not adjacent, no layer
+//     bottom
+//   Restore
+//   top                          // alpha 1, no layer
+unsigned ComplexBorderPainter::PaintOpacityGroup(
+    const std::vector<OpacityGroup>& groups,
+    size_t index,
+    float effective_opacity) {
+  // For overdraw logic purposes, treat missing/transparent edges as completed
+  if (index >= groups.size()) {
+    return ~visible_edge_set_;
+  }
+
+  // Groups are sorted in increasing opacity order, but layers are created in
+  // decreasing opacity order - hence the reverse iteration
+  const OpacityGroup& group = groups[groups.size() - index - 1];
+
+  // Account for ancestor layers in case no layer is created below
+  float paint_alpha = group.alpha / effective_opacity;
+
+  // The last (bottom) group can skip the layer even when translucent iff it
+  // contains no adjacent edges (no in-group overdraw possibility)
+  const bool needs_layer =
+      group.alpha != 1.0f &&
+      (IncludesAdjacentEdges(group.edge_flags) || index + 1 < groups.size());
+
+  if (needs_layer) {
+    SaveLayerAlpha(group.alpha / effective_opacity);
+    effective_opacity = group.alpha;
+    // Group opacity is applied via the layer: paint the sides opaque
+    paint_alpha = 1.0f;
+  }
+
+  // Bounded by 4 levels, one per opacity group
+  unsigned completed_edges =
+      PaintOpacityGroup(groups, index + 1, effective_opacity);
+
+  for (BoxSide side : group.sides) {
+    PaintSide(side, paint_alpha, completed_edges);
+    completed_edges |= EdgeFlagForSide(side);
+  }
+
+  if (needs_layer) {
+    Restore();
+  }
+
+  return completed_edges;
+}
+
+void ComplexBorderPainter::PaintSide(BoxSide side,
+                                     float alpha,
+                                     unsigned completed_edges) {
+  const BorderEdge& edge = Edge(side);
+  const Color color{edge.color.r, edge.color.g, edge.color.b, alpha};
+  const bool has_inner_detail = BorderStyleHasInnerDetail(edge.style);
+
+  RectF side_rect = outer_;
+  switch (side) {
+    case BoxSide::kTop: {
+      const bool is_curved =
+          is_rounded_ &&
+          (has_inner_detail ||
+           BorderWillArcInnerEdge(inner_radii_, kTopLeft, kTopRight));
+      if (!is_curved) {
+        side_rect.height = edge.width;
+      }
+      PaintOneBorderSide(side_rect, BoxSide::kTop, BoxSide::kLeft,
+                         BoxSide::kRight, is_curved ? kCurved : kStraight,
+                         color, completed_edges);
+      break;
+    }
+    case BoxSide::kBottom: {
+      const bool is_curved =
+          is_rounded_ &&
+          (has_inner_detail ||
+           BorderWillArcInnerEdge(inner_radii_, kBottomLeft, kBottomRight));
+      if (!is_curved) {
+        side_rect.y = outer_.Bottom() - edge.width;
+        side_rect.height = edge.width;
+      }
+      PaintOneBorderSide(side_rect, BoxSide::kBottom, BoxSide::kLeft,
+                         BoxSide::kRight, is_curved ? kCurved : kStraight,
+                         color, completed_edges);
+      break;
+    }
+    case BoxSide::kLeft: {
+      const bool is_curved =
+          is_rounded_ &&
+          (has_inner_detail ||
+           BorderWillArcInnerEdge(inner_radii_, kBottomLeft, kTopLeft));
+      if (!is_curved) {
+        side_rect.width = edge.width;
+      }
+      PaintOneBorderSide(side_rect, BoxSide::kLeft, BoxSide::kTop,
+                         BoxSide::kBottom, is_curved ? kCurved : kStraight,
+                         color, completed_edges);
+      break;
+    }
+    case BoxSide::kRight: {
+      const bool is_curved =
+          is_rounded_ &&
+          (has_inner_detail ||
+           BorderWillArcInnerEdge(inner_radii_, kBottomRight, kTopRight));
+      if (!is_curved) {
+        side_rect.x = outer_.Right() - edge.width;
+        side_rect.width = edge.width;
+      }
+      PaintOneBorderSide(side_rect, BoxSide::kRight, BoxSide::kTop,
+                         BoxSide::kBottom, is_curved ? kCurved : kStraight,
+                         color, completed_edges);
+      break;
+    }
+  }
+}
+
+ComplexBorderPainter::MiterType ComplexBorderPainter::ComputeMiter(
+    BoxSide side,
+    BoxSide adjacent_side,
+    unsigned completed_edges) const {
+  const BorderEdge& adjacent_edge = Edge(adjacent_side);
+
+  // No miters for missing edges
+  if (UsedWidth(adjacent_edge) == 0.0f) {
+    return kNoMiter;
+  }
+
+  // The adjacent edge will overdraw this corner, resulting in a correct miter
+  if (WillOverdraw(adjacent_side, adjacent_edge.style, completed_edges)) {
+    return kNoMiter;
+  }
+
+  // Color transitions require miters. Use miters compatible with the AA
+  // drawing mode to avoid introducing extra clips.
+  if (!ColorsMatchAtCorner(side, adjacent_side)) {
+    return kSoftMiter;
+  }
+
+  // Non-anti-aliased miters ensure correct same-color seaming when required
+  // by style
+  if (BorderStylesRequireMiter(side, adjacent_side, Edge(side).style,
+                               adjacent_edge.style)) {
+    return kHardMiter;
+  }
+
+  // Overdraw the adjacent edge when the colors match and we have no style
+  // restrictions
+  return kNoMiter;
+}
+
+bool ComplexBorderPainter::MitersRequireClipping(MiterType miter1,
+                                                 MiterType miter2,
+                                                 EBorderStyle style) {
+  // Clipping is required if any of the present miters doesn't match the
+  // current AA mode
+  bool should_clip = miter1 == kHardMiter || miter2 == kHardMiter;
+
+  // Some styles require clipping for any type of miter
+  should_clip = should_clip || ((miter1 != kNoMiter || miter2 != kNoMiter) &&
+                                StyleRequiresClipPolygon(style));
+  return should_clip;
+}
+
+bool ComplexBorderPainter::ColorsMatchAtCorner(BoxSide side,
+                                               BoxSide adjacent_side) const {
+  if (!Edge(adjacent_side).ShouldRender()) {
+    return false;
+  }
+  if (!Edge(side).SharesColorWith(Edge(adjacent_side))) {
+    return false;
+  }
+  return !BorderStyleHasUnmatchedColorsAtCorner(Edge(side).style, side,
+                                                adjacent_side);
+}
+
+void ComplexBorderPainter::PaintOneBorderSide(const RectF& side_rect,
+                                              BoxSide side,
+                                              BoxSide adjacent_side1,
+                                              BoxSide adjacent_side2,
+                                              SideType side_type,
+                                              const Color& color,
+                                              unsigned completed_edges) {
+  const BorderEdge& edge_to_render = Edge(side);
+  const BorderEdge& adjacent_edge1 = Edge(adjacent_side1);
+  const BorderEdge& adjacent_edge2 = Edge(adjacent_side2);
+
+  if (side_type == kCurved) {
+    MiterType miter1 =
+        ColorsMatchAtCorner(side, adjacent_side1) ? kHardMiter : kSoftMiter;
+    MiterType miter2 =
+        ColorsMatchAtCorner(side, adjacent_side2) ? kHardMiter : kSoftMiter;
+
+    Save();
+    ClipBorderSidePolygon(side, miter1, miter2);
+    if (!inner_renderable_ && !inner_.IsEmpty()) {
+      ClipRRect(inner_, inner_radii_, /*difference=*/true);
+    }
+    const int stroke_thickness =
+        std::max({RoundedWidth(edge_to_render), RoundedWidth(adjacent_edge1),
+                  RoundedWidth(adjacent_edge2)});
+    DrawCurvedBoxSide(RoundedWidth(edge_to_render), stroke_thickness, side,
+                      color, edge_to_render.style);
+    Restore();
+    return;
+  }
+
+  MiterType miter1 = ComputeMiter(side, adjacent_side1, completed_edges);
+  MiterType miter2 = ComputeMiter(side, adjacent_side2, completed_edges);
+  const bool should_clip =
+      MitersRequireClipping(miter1, miter2, edge_to_render.style);
+
+  if (should_clip) {
+    Save();
+    ClipBorderSidePolygon(side, miter1, miter2);
+    // Miters are applied via clipping, no need to draw them
+    miter1 = miter2 = kNoMiter;
+  }
+
+  DrawLineForBoxSide(side_rect.x, side_rect.y, side_rect.Right(),
+                     side_rect.Bottom(), side, color, edge_to_render.style,
+                     miter1 != kNoMiter ? RoundedWidth(adjacent_edge1) : 0,
+                     miter2 != kNoMiter ? RoundedWidth(adjacent_edge2) : 0);
+
+  if (should_clip) {
+    Restore();
+  }
+}
+
+void ComplexBorderPainter::DrawCurvedBoxSide(int border_thickness,
+                                             int stroke_thickness,
+                                             BoxSide side,
+                                             Color color,
+                                             EBorderStyle border_style) {
+  if (border_thickness <= 0) {
+    return;
+  }
+
+  switch (border_style) {
+    case EBorderStyle::kDotted:
+    case EBorderStyle::kDashed:
+      DrawCurvedDashedDottedBoxSide(border_thickness, stroke_thickness, color,
+                                    border_style);
+      return;
+    case EBorderStyle::kDouble:
+      DrawCurvedDoubleBoxSide(color);
+      return;
+    case EBorderStyle::kRidge:
+    case EBorderStyle::kGroove:
+      DrawCurvedRidgeGrooveBoxSide(side, color, border_style);
+      return;
+    case EBorderStyle::kInset:
+    case EBorderStyle::kOutset:
+      color = CalculateInsetOutsetColor(DarkenBoxSide(side, border_style),
+                                        color);
+      break;
+    case EBorderStyle::kSolid:
+      break;
+    case EBorderStyle::kNone:
+    case EBorderStyle::kHidden:
+      return;
+  }
+
+  FillRect(outer_.x, outer_.y, outer_.Right(), outer_.Bottom(), color);
+}
+
+void ComplexBorderPainter::DrawCurvedDashedDottedBoxSide(
+    int border_thickness,
+    int stroke_thickness,
+    const Color& color,
+    EBorderStyle border_style) {
+  // Stroke down the middle of the dots or dashes
+  const float top = UsedWidth(Edge(BoxSide::kTop)) * 0.5f;
+  const float right = UsedWidth(Edge(BoxSide::kRight)) * 0.5f;
+  const float bottom = UsedWidth(Edge(BoxSide::kBottom)) * 0.5f;
+  const float left = UsedWidth(Edge(BoxSide::kLeft)) * 0.5f;
+  const RectF centerline = InsetRect(top, right, bottom, left);
+  const BorderRadii centerline_radii = InsetRadii(top, right, bottom, left);
+
+  float thickness = border_thickness;
+  if (StrokeIsDashed(border_thickness, border_style)) {
+    // The side clip cuts the stroke at the outer and inner edges; widen it
+    // so the clip antialiases the edges instead of the stroke
+    static constexpr float kThicknessMultiplier = 2 * 1.1f;
+    thickness = stroke_thickness * kThicknessMultiplier;
+  }
+
+  DrawRRectOp op;
+  op.rect = {centerline.x, centerline.y, centerline.Right(),
+             centerline.Bottom()};
+  op.radii = centerline_radii;
+  op.flags = StyledStrokeFlags(
+      color, thickness,
+      CurvedDashLayout(centerline, centerline_radii, border_thickness,
+                       border_style));
+  op.transform_id = input_.state_ids.transform_id;
+  op.clip_id = input_.state_ids.clip_id;
+  op.effect_id = input_.state_ids.effect_id;
+  ops_.AddDrawRRect(std::move(op));
+}
+
+const DashLayout& ComplexBorderPainter::CurvedDashLayout(
+    const RectF& centerline,
+    const BorderRadii& centerline_radii,
+    int border_thickness,
+    EBorderStyle border_style) {
+  // Every curved side strokes the same closed centerline under its own
+  // clip, so the dashes must line up around the whole perimeter
+  for (const CurvedDash& entry : curved_dashes_) {
+    if (entry.thickness == border_thickness && entry.style == border_style) {
+      return entry.layout;
+    }
+  }
+  if (centerline_length_ < 0.0f) {
+    centerline_length_ = RRectPerimeter(centerline, centerline_radii);
+  }
+  curved_dashes_.push_back(
+      {border_thickness, border_style,
+       ComputeDashLayout(centerline_length_, border_thickness, border_style,
+                         /*closed_path=*/true)});
+  return curved_dashes_.back().layout;
+}
+
+void ComplexBorderPainter::DrawCurvedDoubleBoxSide(const Color& color) {
+  // Stripe widths: outer third and two thirds, rounded per side
+  auto stripe = [this](BoxSide side, float fraction) {
+    return std::round(UsedWidth(Edge(side)) * fraction);
+  };
+
+  // Inner border line: everything inside the two-thirds inset (the inner
+  // border itself is already clipped out)
+  {
+    const float top = stripe(BoxSide::kTop, 2.0f / 3.0f);
+    const float right = stripe(BoxSide::kRight, 2.0f / 3.0f);
+    const float bottom = stripe(BoxSide::kBottom, 2.0f / 3.0f);
+    const float left = stripe(BoxSide::kLeft, 2.0f / 3.0f);
+    Save();
+    ClipRRect(InsetRect(top, right, bottom, left),
+              InsetRadii(top, right, bottom, left), /*difference=*/false);
+    FillRect(outer_.x, outer_.y, outer_.Right(), outer_.Bottom(), color);
+    Restore();
+  }
+
+  // Outer border line: everything outside the one-third inset
+  {
+    const float top = stripe(BoxSide::kTop, 1.0f / 3.0f);
+    const float right = stripe(BoxSide::kRight, 1.0f / 3.0f);
+    const float bottom = stripe(BoxSide::kBottom, 1.0f / 3.0f);
+    const float left = stripe(BoxSide::kLeft, 1.0f / 3.0f);
+    Save();
+    ClipRRect(InsetRect(top, right, bottom, left),
+              InsetRadii(top, right, bottom, left), /*difference=*/true);
+    FillRect(outer_.x, outer_.y, outer_.Right(), outer_.Bottom(), color);
+    Restore();
+  }
+}
+
+void ComplexBorderPainter::DrawCurvedRidgeGrooveBoxSide(
+    BoxSide side,
+    const Color& color,
+    EBorderStyle border_style) {
+  const EBorderStyle s1 = border_style == EBorderStyle::kGroove
+                              ? EBorderStyle::kInset
+                              : EBorderStyle::kOutset;
+  const bool darken_s1 = DarkenBoxSide(side, s1);
+
+  // Paint full border
+  FillRect(outer_.x, outer_.y, outer_.Right(), outer_.Bottom(),
+           CalculateInsetOutsetColor(darken_s1, color));
+
+  // Paint inner half only
+  const float top = RoundedWidth(Edge(BoxSide::kTop)) / 2;
+  const float right = RoundedWidth(Edge(BoxSide::kRight)) / 2;
+  const float bottom = RoundedWidth(Edge(BoxSide::kBottom)) / 2;
+  const float left = RoundedWidth(Edge(BoxSide::kLeft)) / 2;
+  Save();
+  ClipRRect(InsetRect(top, right, bottom, left),
+            InsetRadii(top, right, bottom, left), /*difference=*/false);
+  FillRect(outer_.x, outer_.y, outer_.Right(), outer_.Bottom(),
+           CalculateInsetOutsetColor(!darken_s1, color));
+  Restore();
+}
+
+void ComplexBorderPainter::DrawLineForBoxSide(float x1, float y1,
+                                              float x2, float y2,
+                                              BoxSide side,
+                                              Color color,
+                                              EBorderStyle style,
+                                              int adjacent_width1,
+                                              int adjacent_width2) {
+  float thickness;
+  float length;
+  if (side == BoxSide::kTop || side == BoxSide::kBottom) {
+    thickness = y2 - y1;
+    length = x2 - x1;
+  } else {
+    thickness = x2 - x1;
+    length = y2 - y1;
+  }
+
+  // The recursive calls for double / ridge / groove may produce empty
+  // stripes
+  if (length <= 0 || thickness <= 0) {
+    return;
+  }
+
+  const int rounded_thickness = static_cast<int>(std::lround(thickness));
+  style = BorderEdge::EffectiveStyle(style, rounded_thickness);
+
+  switch (style) {
+    case EBorderStyle::kDotted:
+    case EBorderStyle::kDashed:
+      DrawDashedOrDottedBoxSide(x1, y1, x2, y2, side, color,
+                                rounded_thickness, style);
+      break;
+    case EBorderStyle::kDouble:
+      DrawDoubleBoxSide(x1, y1, x2, y2, length, side, color, rounded_thickness,
+                        adjacent_width1, adjacent_width2);
+      break;
+    case EBorderStyle::kRidge:
+    case EBorderStyle::kGroove:
+      DrawRidgeOrGrooveBoxSide(x1, y1, x2, y2, side, color, style,
+                               adjacent_width1, adjacent_width2);
+      break;
+    case EBorderStyle::kInset:
+    case EBorderStyle::kOutset:
+      color = CalculateInsetOutsetColor(DarkenBoxSide(side, style), color);
+      [[fallthrough]];
+    case EBorderStyle::kSolid:
+      DrawSolidBoxSide(x1, y1, x2, y2, side, color, adjacent_width1,
+                       adjacent_width2);
+      break;
+    case EBorderStyle::kNone:
+    case EBorderStyle::kHidden:
+      break;
+  }
+}
+
+void ComplexBorderPainter::DrawSolidBoxSide(float x1, float y1,
+                                            float x2, float y2,
+                                            BoxSide side,
+                                            const Color& color,
+                                            int adjacent_width1,
+                                            int adjacent_width2) {
+  if (!adjacent_width1 && !adjacent_width2) {
+    FillRect(x1, y1, x2, y2, color);
+    return;
+  }
+
+  PointF quad[4];
+  switch (side) {
+    case BoxSide::kTop:
+      quad[0] = PointF{x1 + std::max(-adjacent_width1, 0), y1};
+      quad[1] = PointF{x1 + std::max(adjacent_width1, 0), y2};
+      quad[2] = PointF{x2 - std::max(adjacent_width2, 0), y2};
+      quad[3] = PointF{x2 - std::max(-adjacent_width2, 0), y1};
+      break;
+    case BoxSide::kBottom:
+      quad[0] = PointF{x1 + std::max(adjacent_width1, 0), y1};
+      quad[1] = PointF{x1 + std::max(-adjacent_width1, 0), y2};
+      quad[2] = PointF{x2 - std::max(-adjacent_width2, 0), y2};
+      quad[3] = PointF{x2 - std::max(adjacent_width2, 0), y1};
+      break;
+    case BoxSide::kLeft:
+      quad[0] = PointF{x1, y1 + std::max(-adjacent_width1, 0)};
+      quad[1] = PointF{x1, y2 - std::max(-adjacent_width2, 0)};
+      quad[2] = PointF{x2, y2 - std::max(adjacent_width2, 0)};
+      quad[3] = PointF{x2, y1 + std::max(adjacent_width1, 0)};
+      break;
+    case BoxSide::kRight:
+      quad[0] = PointF{x1, y1 + std::max(adjacent_width1, 0)};
+      quad[1] = PointF{x1, y2 - std::max(adjacent_width2, 0)};
+      quad[2] = PointF{x2, y2 - std::max(-adjacent_width2, 0)};
+      quad[3] = PointF{x2, y1 + std::max(-adjacent_width1, 0)};
+      break;
+  }
+
+  FillQuad(quad, color);
+}
+
+void ComplexBorderPainter::DrawDoubleBoxSide(float x1, float y1,
+                                             float x2, float y2,
+                                             float length,
+                                             BoxSide side,
+                                             const Color& color,
+                                             int thickness,
+                                             int adjacent_width1,
+                                             int adjacent_width2) {
+  const int third_of_thickness = (thickness + 1) / 3;
+
+  if (!adjacent_width1 && !adjacent_width2) {
+    switch (side) {
+      case BoxSide::kTop:
+      case BoxSide::kBottom:
+        FillRect(x1, y1, x1 + length, y1 + third_of_thickness, color);
+        FillRect(x1, y2 - third_of_thickness, x1 + length, y2, color);
+        break;
+      case BoxSide::kLeft:
+      case BoxSide::kRight:
+        FillRect(x1, y1, x1 + third_of_thickness, y1 + length, color);
+        FillRect(x2 - third_of_thickness, y1, x2, y1 + length, color);
+        break;
+    }
+    return;
+  }
+
+  const int adjacent1_big_third =
+      ((adjacent_width1 > 0) ? adjacent_width1 + 1 : adjacent_width1 - 1) / 3;
+  const int adjacent2_big_third =
+      ((adjacent_width2 > 0) ? adjacent_width2 + 1 : adjacent_width2 - 1) / 3;
+
+  switch (side) {
+    case BoxSide::kTop:
+      DrawLineForBoxSide(x1 + std::max((-adjacent_width1 * 2 + 1) / 3, 0), y1,
+                         x2 - std::max((-adjacent_width2 * 2 + 1) / 3, 0),
+                         y1 + third_of_thickness, side, color,
+                         EBorderStyle::kSolid, adjacent1_big_third,
+                         adjacent2_big_third);
+      DrawLineForBoxSide(x1 + std::max((adjacent_width1 * 2 + 1) / 3, 0),
+                         y2 - third_of_thickness,
+                         x2 - std::max((adjacent_width2 * 2 + 1) / 3, 0), y2,
+                         side, color, EBorderStyle::kSolid,
+                         adjacent1_big_third, adjacent2_big_third);
+      break;
+    case BoxSide::kLeft:
+      DrawLineForBoxSide(x1, y1 + std::max((-adjacent_width1 * 2 + 1) / 3, 0),
+                         x1 + third_of_thickness,
+                         y2 - std::max((-adjacent_width2 * 2 + 1) / 3, 0),
+                         side, color, EBorderStyle::kSolid,
+                         adjacent1_big_third, adjacent2_big_third);
+      DrawLineForBoxSide(x2 - third_of_thickness,
+                         y1 + std::max((adjacent_width1 * 2 + 1) / 3, 0), x2,
+                         y2 - std::max((adjacent_width2 * 2 + 1) / 3, 0),
+                         side, color, EBorderStyle::kSolid,
+                         adjacent1_big_third, adjacent2_big_third);
+      break;
+    case BoxSide::kBottom:
+      DrawLineForBoxSide(x1 + std::max((adjacent_width1 * 2 + 1) / 3, 0), y1,
+                         x2 - std::max((adjacent_width2 * 2 + 1) / 3, 0),
+                         y1 + third_of_thickness, side, color,
+                         EBorderStyle::kSolid, adjacent1_big_third,
+                         adjacent2_big_third);
+      DrawLineForBoxSide(x1 + std::max((-adjacent_width1 * 2 + 1) / 3, 0),
+                         y2 - third_of_thickness,
+                         x2 - std::max((-adjacent_width2 * 2 + 1) / 3, 0), y2,
+                         side, color, EBorderStyle::kSolid,
+                         adjacent1_big_third, adjacent2_big_third);
+      break;
+    case BoxSide::kRight:
+      DrawLineForBoxSide(x1, y1 + std::max((adjacent_width1 * 2 + 1) / 3, 0),
+                         x1 + third_of_thickness,
+                         y2 - std::max((adjacent_width2 * 2 + 1) / 3, 0),
+                         side, color, EBorderStyle::kSolid,
+                         adjacent1_big_third, adjacent2_big_third);
+      DrawLineForBoxSide(x2 - third_of_thickness,
+                         y1 + std::max((-adjacent_width1 * 2 + 1) / 3, 0), x2,
+                         y2 - std::max((-adjacent_width2 * 2 + 1) / 3, 0),
+                         side, color, EBorderStyle::kSolid,
+                         adjacent1_big_third, adjacent2_big_third);
+      break;
+  }
+}
+
+void ComplexBorderPainter::DrawRidgeOrGrooveBoxSide(float x1, float y1,
+                                                    float x2, float y2,
+                                                    BoxSide side,
+                                                    const Color& color,
+                                                    EBorderStyle style,
+                                                    int adjacent_width1,
+                                                    int adjacent_width2) {
+  EBorderStyle s1;
+  EBorderStyle s2;
+  if (style == EBorderStyle::kGroove) {
+    s1 = EBorderStyle::kInset;
+    s2 = EBorderStyle::kOutset;
+  } else {
+    s1 = EBorderStyle::kOutset;
+    s2 = EBorderStyle::kInset;
+  }
+
+  const int adjacent1_big_half =
+      ((adjacent_width1 > 0) ? adjacent_width1 + 1 : adjacent_width1 - 1) / 2;
+  const int adjacent2_big_half =
+      ((adjacent_width2 > 0) ? adjacent_width2 + 1 : adjacent_width2 - 1) / 2;
+
+  // (y1 + y2 + 1) / 2 in Chromium's integer coordinates
+  const float mid_y = y1 + static_cast<int>(std::lround(y2 - y1) + 1) / 2;
+  const float mid_x = x1 + static_cast<int>(std::lround(x2 - x1) + 1) / 2;
+
+  switch (side) {
+    case BoxSide::kTop:
+      DrawLineForBoxSide(x1 + std::max(-adjacent_width1, 0) / 2, y1,
+                         x2 - std::max(-adjacent_width2, 0) / 2, mid_y, side,
+                         color, s1, adjacent1_big_half, adjacent2_big_half);
+      DrawLineForBoxSide(x1 + std::max(adjacent_width1 + 1, 0) / 2, mid_y,
+                         x2 - std::max(adjacent_width2 + 1, 0) / 2, y2, side,
+                         color, s2, adjacent_width1 / 2, adjacent_width2 / 2);
+      break;
+    case BoxSide::kLeft:
+      DrawLineForBoxSide(x1, y1 + std::max(-adjacent_width1, 0) / 2, mid_x,
+                         y2 - std::max(-adjacent_width2, 0) / 2, side, color,
+                         s1, adjacent1_big_half, adjacent2_big_half);
+      DrawLineForBoxSide(mid_x, y1 + std::max(adjacent_width1 + 1, 0) / 2, x2,
+                         y2 - std::max(adjacent_width2 + 1, 0) / 2, side,
+                         color, s2, adjacent_width1 / 2, adjacent_width2 / 2);
+      break;
+    case BoxSide::kBottom:
+      DrawLineForBoxSide(x1 + std::max(adjacent_width1, 0) / 2, y1,
+                         x2 - std::max(adjacent_width2, 0) / 2, mid_y, side,
+                         color, s2, adjacent1_big_half, adjacent2_big_half);
+      DrawLineForBoxSide(x1 + std::max(-adjacent_width1 + 1, 0) / 2, mid_y,
+                         x2 - std::max(-adjacent_width2 + 1, 0) / 2, y2, side,
+                         color, s1, adjacent_width1 / 2, adjacent_width2 / 2);
+      break;
+    case BoxSide::kRight:
+      DrawLineForBoxSide(x1, y1 + std::max(adjacent_width1, 0) / 2, mid_x,
+                         y2 - std::max(adjacent_width2, 0) / 2, side, color,
+                         s2, adjacent1_big_half, adjacent2_big_half);
+      DrawLineForBoxSide(mid_x, y1 + std::max(-adjacent_width1 + 1, 0) / 2, x2,
+                         y2 - std::max(-adjacent_width2 + 1, 0) / 2, side,
+                         color, s1, adjacent_width1 / 2, adjacent_width2 / 2);
+      break;
+  }
+}
+
+void ComplexBorderPainter::DrawDashedOrDottedBoxSide(float x1, float y1,
+                                                     float x2, float y2,
+                                                     BoxSide side,
+                                                     const Color& color,
+                                                     int thickness,
+                                                     EBorderStyle style) {
+  switch (side) {
+    case BoxSide::kBottom:
+    case BoxSide::kTop: {
+      const float mid_y = y1 + thickness / 2;
+      DrawLineWithStyle(PointF{x1, mid_y}, PointF{x2, mid_y}, thickness, style,
+                        color);
+      break;
+    }
+    case BoxSide::kRight:
+    case BoxSide::kLeft: {
+      const float mid_x = x1 + thickness / 2;
+      DrawLineWithStyle(PointF{mid_x, y1}, PointF{mid_x, y2}, thickness, style,
+                        color);
+      break;
+    }
+  }
+}
+
+void ComplexBorderPainter::DrawLineWithStyle(PointF p1,
+                                             PointF p2,
+                                             int thickness,
+                                             EBorderStyle style,
+                                             const Color& color) {
+  const bool is_vertical_line = p1.x == p2.x;
+  const int width = thickness;
+  // Horizontal or vertical, so the length is the sum of the displacement
+  // components
+  const int length =
+      static_cast<int>(std::lround((p2.x - p1.x) + (p2.y - p1.y)));
+
+  if (style == EBorderStyle::kDotted) {
+    if (width <= 3) {
+      // Enforce full dots at both ends when the length is not an odd
+      // multiple of the width
+      EnforceDotsAtEndpoints(p1, p2, length, width, color, is_vertical_line);
+    } else {
+      // Round end caps extend beyond the endpoints, so move them in
+      if (is_vertical_line) {
+        p1.y += width / 2.f;
+        p2.y -= width / 2.f;
+      } else {
+        p1.x += width / 2.f;
+        p2.x -= width / 2.f;
+      }
+    }
+  }
+
+  // Odd widths: the midpoint came out of integer division, off by 0.5
+  if (width % 2) {
+    if (is_vertical_line) {
+      p1.x += 0.5f;
+      p2.x += 0.5f;
+    } else {
+      p1.y += 0.5f;
+      p2.y += 0.5f;
+    }
+  }
+
+  DrawLineOp op;
+  op.x0 = p1.x;
+  op.y0 = p1.y;
+  op.x1 = p2.x;
+  op.y1 = p2.y;
+  // Laid out over the full side length, as the end dots above assume
+  op.flags = StyledStrokeFlags(
+      color, width,
+      ComputeDashLayout(length, width, style, /*closed_path=*/false));
+  op.transform_id = input_.state_ids.transform_id;
+  op.clip_id = input_.state_ids.clip_id;
+  op.effect_id = input_.state_ids.effect_id;
+  ops_.AddDrawLine(std::move(op));
+}
+
+void ComplexBorderPainter::EnforceDotsAtEndpoints(PointF& p1,
+                                                  PointF& p2,
+                                                  int path_length,
+                                                  int width,
+                                                  const Color& color,
+                                                  bool is_vertical_line) {
+  // Narrow dotted lines need integral dot sizes and endpoints so that
+  // anti-aliasing does not erase the dots. The end dots are drawn as rects
+  // and the line shortened when the gaps do not come out even.
+  const int mod_4 = path_length % 4;
+  const int mod_6 = path_length % 6;
+  bool use_start_dot = false;
+  int start_dot_growth = 0;
+  int start_line_offset = 0;
+  bool use_end_dot = false;
+  int end_dot_growth = 0;
+  if ((width == 1 && path_length % 2 == 0) || (width == 3 && mod_6 == 0)) {
+    // Add one pixel to the first dot
+    use_start_dot = true;
+    start_dot_growth = 1;
+    start_line_offset = 1;
+  }
+  if ((width == 2 && (mod_4 == 0 || mod_4 == 1)) ||
+      (width == 3 && (mod_6 == 1 || mod_6 == 2))) {
+    // Drop 1 pixel from the start gap
+    use_start_dot = true;
+    start_line_offset = -1;
+  }
+  if ((width == 2 && mod_4 == 0) || (width == 3 && mod_6 == 1)) {
+    // Drop 1 pixel from the end gap
+    use_end_dot = true;
+  }
+  if ((width == 2 && mod_4 == 3) ||
+      (width == 3 && (mod_6 == 4 || mod_6 == 5))) {
+    // Add 1 pixel to the start gap
+    use_start_dot = true;
+    start_line_offset = 1;
+  }
+  if (width == 3 && mod_6 == 5) {
+    // Add 1 pixel to the end gap and leave the end dot the same size
+    use_end_dot = true;
+  } else if (width == 3 && mod_6 == 0) {
+    // Add one pixel gap and one pixel to the dot at the end
+    use_end_dot = true;
+    end_dot_growth = 1;
+  }
+
+  if (use_start_dot) {
+    if (is_vertical_line) {
+      FillRect(p1.x - width / 2, p1.y, p1.x + width - width / 2,
+               p1.y + width + start_dot_growth, color);
+      p1.y += 2 * width + start_line_offset;
+    } else {
+      FillRect(p1.x, p1.y - width / 2, p1.x + width + start_dot_growth,
+               p1.y + width - width / 2, color);
+      p1.x += 2 * width + start_line_offset;
+    }
+  }
+  if (use_end_dot) {
+    if (is_vertical_line) {
+      FillRect(p2.x - width / 2, p2.y - width - end_dot_growth,
+               p2.x + width - width / 2, p2.y, color);
+      // Stop drawing before we get to the last dot
+      p2.y -= width + end_dot_growth + 1;
+    } else {
+      FillRect(p2.x - width - end_dot_growth, p2.y - width / 2, p2.x,
+               p2.y + width - width / 2, color);
+      p2.x -= width + end_dot_growth + 1;
+    }
+  }
+}
+
+void ComplexBorderPainter::ClipBorderSidePolygon(BoxSide side,
+                                                 MiterType first_miter,
+                                                 MiterType second_miter) {
+  // The boundary of the edge for fill
+  PointF edge_quad[4];
+  std::vector<PointF> edge_pentagon;
+
+  // Points 1 and 2 of the rectilinear bounding box of edge_quad
+  PointF bound_quad1;
+  PointF bound_quad2;
+
+  // For each side, a quad that encompasses all parts of that side that may
+  // draw, including areas inside the inner border:
+  //
+  //         0----------------3
+  //       3  \              /  0
+  //       |\  1----------- 2  /|
+  //       | 2                1 |
+  //       | |                | |
+  //       | |                | |
+  //       | 1                2 |
+  //       |/  2------------1  \|
+  //       0  /              \  3
+  //         3----------------0
+  //
+  // Points 1 and 2 start at the inner rect corners and move inside when the
+  // inner corner is rounded so the quad contains the half corner. If the
+  // inner border is not renderable and line 1-2 would clip the rounded
+  // corner near the miter, a point is inserted to make a pentagon.
+  const PointF inner_points[4] = {
+      PointF{inner_.x, inner_.y},
+      PointF{inner_.Right(), inner_.y},
+      PointF{inner_.Right(), inner_.Bottom()},
+      PointF{inner_.x, inner_.Bottom()},
+  };
+  const PointF outer_points[4] = {
+      PointF{outer_.x, outer_.y},
+      PointF{outer_.Right(), outer_.y},
+      PointF{outer_.Right(), outer_.Bottom()},
+      PointF{outer_.x, outer_.Bottom()},
+  };
+  const BorderRadii& r = inner_radii_;
+  auto corner_is_zero = [&r](int corner) {
+    return IsZeroCorner(r[2 * corner], r[2 * corner + 1]);
+  };
+
+  // Offset size and direction to expand the clipping quad
+  constexpr float kExtensionLength = 1e-1f;
+  float extension_x = 0.0f;
+  float extension_y = 0.0f;
+
+  switch (side) {
+    case BoxSide::kTop:
+      edge_quad[0] = outer_points[0];
+      edge_quad[1] = inner_points[0];
+      edge_quad[2] = inner_points[1];
+      edge_quad[3] = outer_points[1];
+
+      bound_quad1 = PointF{edge_quad[0].x, edge_quad[1].y};
+      bound_quad2 = PointF{edge_quad[3].x, edge_quad[2].y};
+
+      extension_x = -kExtensionLength;
+
+      if (!corner_is_zero(kTopLeft)) {
+        FindIntersection(edge_quad[0], edge_quad[1],
+                         Offset(edge_quad[1], r[0], 0),
+                         Offset(edge_quad[1], 0, r[1]), edge_quad[1]);
+        bound_quad1.y = edge_quad[1].y;
+        bound_quad2.y = edge_quad[1].y;
+
+        if (edge_quad[1].y > inner_points[2].y) {
+          FindIntersection(edge_quad[0], edge_quad[1], inner_points[3],
+                           inner_points[2], edge_quad[1]);
+        }
+        if (edge_quad[1].x > inner_points[2].x) {
+          FindIntersection(edge_quad[0], edge_quad[1], inner_points[1],
+                           inner_points[2], edge_quad[1]);
+        }
+        if (edge_quad[2].y < edge_quad[1].y &&
+            edge_quad[2].x > edge_quad[1].x) {
+          edge_pentagon = {edge_quad[0], edge_quad[1],
+                           PointF{edge_quad[2].x, edge_quad[1].y},
+                           edge_quad[2], edge_quad[3]};
+        }
+      }
+
+      if (!corner_is_zero(kTopRight)) {
+        FindIntersection(edge_quad[3], edge_quad[2],
+                         Offset(edge_quad[2], -r[2], 0),
+                         Offset(edge_quad[2], 0, r[3]), edge_quad[2]);
+        if (bound_quad1.y < edge_quad[2].y) {
+          bound_quad1.y = edge_quad[2].y;
+          bound_quad2.y = edge_quad[2].y;
+        }
+
+        if (edge_quad[2].y > inner_points[3].y) {
+          FindIntersection(edge_quad[3], edge_quad[2], inner_points[3],
+                           inner_points[2], edge_quad[2]);
+        }
+        if (edge_quad[2].x < inner_points[3].x) {
+          FindIntersection(edge_quad[3], edge_quad[2], inner_points[0],
+                           inner_points[3], edge_quad[2]);
+        }
+        if (edge_quad[2].y > edge_quad[1].y &&
+            edge_quad[2].x > edge_quad[1].x) {
+          edge_pentagon = {edge_quad[0], edge_quad[1],
+                           PointF{edge_quad[1].x, edge_quad[2].y},
+                           edge_quad[2], edge_quad[3]};
+        }
+      }
+      break;
+
+    case BoxSide::kLeft:
+      // Swap the order of adjacent edges to allow common code
+      std::swap(first_miter, second_miter);
+      edge_quad[0] = outer_points[3];
+      edge_quad[1] = inner_points[3];
+      edge_quad[2] = inner_points[0];
+      edge_quad[3] = outer_points[0];
+
+      bound_quad1 = PointF{edge_quad[1].x, edge_quad[0].y};
+      bound_quad2 = PointF{edge_quad[2].x, edge_quad[3].y};
+
+      extension_y = kExtensionLength;
+
+      if (!corner_is_zero(kTopLeft)) {
+        FindIntersection(edge_quad[3], edge_quad[2],
+                         Offset(edge_quad[2], r[0], 0),
+                         Offset(edge_quad[2], 0, r[1]), edge_quad[2]);
+        bound_quad1.x = edge_quad[2].x;
+        bound_quad2.x = edge_quad[2].x;
+
+        if (edge_quad[2].y > inner_points[2].y) {
+          FindIntersection(edge_quad[3], edge_quad[2], inner_points[3],
+                           inner_points[2], edge_quad[2]);
+        }
+        if (edge_quad[2].x > inner_points[2].x) {
+          FindIntersection(edge_quad[3], edge_quad[2], inner_points[1],
+                           inner_points[2], edge_quad[2]);
+        }
+        if (edge_quad[2].y < edge_quad[1].y &&
+            edge_quad[2].x > edge_quad[1].x) {
+          edge_pentagon = {edge_quad[0], edge_quad[1],
+                           PointF{edge_quad[2].x, edge_quad[1].y},
+                           edge_quad[2], edge_quad[3]};
+        }
+      }
+
+      if (!corner_is_zero(kBottomLeft)) {
+        FindIntersection(edge_quad[0], edge_quad[1],
+                         Offset(edge_quad[1], r[6], 0),
+                         Offset(edge_quad[1], 0, -r[7]), edge_quad[1]);
+        if (bound_quad1.x < edge_quad[1].x) {
+          bound_quad1.x = edge_quad[1].x;
+          bound_quad2.x = edge_quad[1].x;
+        }
+
+        if (edge_quad[1].y < inner_points[1].y) {
+          FindIntersection(edge_quad[0], edge_quad[1], inner_points[0],
+                           inner_points[1], edge_quad[1]);
+        }
+        if (edge_quad[1].x > inner_points[1].x) {
+          FindIntersection(edge_quad[0], edge_quad[1], inner_points[1],
+                           inner_points[2], edge_quad[1]);
+        }
+        if (edge_quad[2].y < edge_quad[1].y &&
+            edge_quad[2].x < edge_quad[1].x) {
+          edge_pentagon = {edge_quad[0], edge_quad[1],
+                           PointF{edge_quad[1].x, edge_quad[2].y},
+                           edge_quad[2], edge_quad[3]};
+        }
+      }
+      break;
+
+    case BoxSide::kBottom:
+      // Swap the order of adjacent edges to allow common code
+      std::swap(first_miter, second_miter);
+      edge_quad[0] = outer_points[2];
+      edge_quad[1] = inner_points[2];
+      edge_quad[2] = inner_points[3];
+      edge_quad[3] = outer_points[3];
+
+      bound_quad1 = PointF{edge_quad[0].x, edge_quad[1].y};
+      bound_quad2 = PointF{edge_quad[3].x, edge_quad[2].y};
+
+      extension_x = kExtensionLength;
+
+      if (!corner_is_zero(kBottomLeft)) {
+        FindIntersection(edge_quad[3], edge_quad[2],
+                         Offset(edge_quad[2], r[6], 0),
+                         Offset(edge_quad[2], 0, -r[7]), edge_quad[2]);
+        bound_quad1.y = edge_quad[2].y;
+        bound_quad2.y = edge_quad[2].y;
+
+        if (edge_quad[2].y < inner_points[1].y) {
+          FindIntersection(edge_quad[3], edge_quad[2], inner_points[0],
+                           inner_points[1], edge_quad[2]);
+        }
+        if (edge_quad[2].x > inner_points[1].x) {
+          FindIntersection(edge_quad[3], edge_quad[2], inner_points[1],
+                           inner_points[2], edge_quad[2]);
+        }
+        if (edge_quad[2].y < edge_quad[1].y &&
+            edge_quad[2].x < edge_quad[1].x) {
+          edge_pentagon = {edge_quad[0], edge_quad[1],
+                           PointF{edge_quad[1].x, edge_quad[2].y},
+                           edge_quad[2], edge_quad[3]};
+        }
+      }
+
+      if (!corner_is_zero(kBottomRight)) {
+        FindIntersection(edge_quad[0], edge_quad[1],
+                         Offset(edge_quad[1], -r[4], 0),
+                         Offset(edge_quad[1], 0, -r[5]), edge_quad[1]);
+        if (bound_quad1.y > edge_quad[1].y) {
+          bound_quad1.y = edge_quad[1].y;
+          bound_quad2.y = edge_quad[1].y;
+        }
+
+        if (edge_quad[1].y < inner_points[0].y) {
+          FindIntersection(edge_quad[0], edge_quad[1], inner_points[0],
+                           inner_points[1], edge_quad[1]);
+        }
+        if (edge_quad[1].x < inner_points[0].x) {
+          FindIntersection(edge_quad[0], edge_quad[1], inner_points[0],
+                           inner_points[3], edge_quad[1]);
+        }
+        if (edge_quad[2].x < edge_quad[1].x &&
+            edge_quad[2].y > edge_quad[1].y) {
+          edge_pentagon = {edge_quad[0], edge_quad[1],
+                           PointF{edge_quad[2].x, edge_quad[1].y},
+                           edge_quad[2], edge_quad[3]};
+        }
+      }
+      break;
+
+    case BoxSide::kRight:
+      edge_quad[0] = outer_points[1];
+      edge_quad[1] = inner_points[1];
+      edge_quad[2] = inner_points[2];
+      edge_quad[3] = outer_points[2];
+
+      bound_quad1 = PointF{edge_quad[1].x, edge_quad[0].y};
+      bound_quad2 = PointF{edge_quad[2].x, edge_quad[3].y};
+
+      extension_y = -kExtensionLength;
+
+      if (!corner_is_zero(kTopRight)) {
+        FindIntersection(edge_quad[0], edge_quad[1],
+                         Offset(edge_quad[1], -r[2], 0),
+                         Offset(edge_quad[1], 0, r[3]), edge_quad[1]);
+        bound_quad1.x = edge_quad[1].x;
+        bound_quad2.x = edge_quad[1].x;
+
+        if (edge_quad[1].y > inner_points[3].y) {
+          FindIntersection(edge_quad[0], edge_quad[1], inner_points[3],
+                           inner_points[2], edge_quad[1]);
+        }
+        if (edge_quad[1].x < inner_points[3].x) {
+          FindIntersection(edge_quad[0], edge_quad[1], inner_points[0],
+                           inner_points[3], edge_quad[1]);
+        }
+        if (edge_quad[2].y > edge_quad[1].y &&
+            edge_quad[2].x > edge_quad[1].x) {
+          edge_pentagon = {edge_quad[0], edge_quad[1],
+                           PointF{edge_quad[1].x, edge_quad[2].y},
+                           edge_quad[2], edge_quad[3]};
+        }
+      }
+
+      if (!corner_is_zero(kBottomRight)) {
+        FindIntersection(edge_quad[3], edge_quad[2],
+                         Offset(edge_quad[2], -r[4], 0),
+                         Offset(edge_quad[2], 0, -r[5]), edge_quad[2]);
+        if (bound_quad1.x > edge_quad[2].x) {
+          bound_quad1.x = edge_quad[2].x;
+          bound_quad2.x = edge_quad[2].x;
+        }
+
+        if (edge_quad[2].y < inner_points[0].y) {
+          FindIntersection(edge_quad[3], edge_quad[2], inner_points[0],
+                           inner_points[1], edge_quad[2]);
+        }
+        if (edge_quad[2].x < inner_points[0].x) {
+          FindIntersection(edge_quad[3], edge_quad[2], inner_points[0],
+                           inner_points[3], edge_quad[2]);
+        }
+        if (edge_quad[2].x < edge_quad[1].x &&
+            edge_quad[2].y > edge_quad[1].y) {
+          edge_pentagon = {edge_quad[0], edge_quad[1],
+                           PointF{edge_quad[2].x, edge_quad[1].y},
+                           edge_quad[2], edge_quad[3]};
+        }
+      }
+      break;
+  }
+
+  if (first_miter == second_miter) {
+    if (!edge_pentagon.empty() && !inner_renderable_) {
+      ClipPolygon(std::move(edge_pentagon), first_miter == kSoftMiter);
+      return;
+    }
+    ClipPolygon({edge_quad[0], edge_quad[1], edge_quad[2], edge_quad[3]},
+                first_miter == kSoftMiter);
+    return;
+  }
+
+  // Differing anti-aliasing for the two miters needs two clips, one per
+  // miter. Each uses 3 sides of the quad's rectilinear bounding box and a
+  // 4th side along the miter, extended in the miter direction to ensure
+  // overlap as each edge is drawn.
+  if (first_miter != kNoMiter) {
+    PointF clipping_quad[4];
+    clipping_quad[0] = Offset(edge_quad[0], extension_x, extension_y);
+    FindIntersection(edge_quad[0], edge_quad[1], bound_quad1, bound_quad2,
+                     clipping_quad[1]);
+    clipping_quad[1] = Offset(clipping_quad[1], extension_x, extension_y);
+    clipping_quad[2] = bound_quad2;
+    clipping_quad[3] = edge_quad[3];
+    ClipPolygon({clipping_quad[0], clipping_quad[1], clipping_quad[2],
+                 clipping_quad[3]},
+                first_miter == kSoftMiter);
+  }
+
+  if (second_miter != kNoMiter) {
+    PointF clipping_quad[4];
+    clipping_quad[0] = edge_quad[0];
+    clipping_quad[1] = bound_quad1;
+    FindIntersection(edge_quad[2], edge_quad[3], bound_quad1, bound_quad2,
+                     clipping_quad[2]);
+    clipping_quad[2] = Offset(clipping_quad[2], -extension_x, -extension_y);
+    clipping_quad[3] = Offset(edge_quad[3], -extension_x, -extension_y);
+    ClipPolygon({clipping_quad[0], clipping_quad[1], clipping_quad[2],
+                 clipping_quad[3]},
+                second_miter == kSoftMiter);
+  }
+}
+
+RectF ComplexBorderPainter::InsetRect(float top, float right, float bottom,
+                                      float left) const {
+  return RectF{outer_.x + left, outer_.y + top,
+               outer_.width - left - right, outer_.height - top - bottom};
+}
+
+BorderRadii ComplexBorderPainter::InsetRadii(float top, float right,
+                                             float bottom, float left) const {
+  const BorderRadii& r = outer_radii_;
+  return {std::max(0.0f, r[0] - left),  std::max(0.0f, r[1] - top),
+          std::max(0.0f, r[2] - right), std::max(0.0f, r[3] - top),
+          std::max(0.0f, r[4] - right), std::max(0.0f, r[5] - bottom),
+          std::max(0.0f, r[6] - left),  std::max(0.0f, r[7] - bottom)};
+}
+
+void ComplexBorderPainter::Save() {
+  SaveOp op;
+  op.transform_id = input_.state_ids.transform_id;
+  op.clip_id = input_.state_ids.clip_id;
+  op.effect_id = input_.state_ids.effect_id;
+  ops_.AddSave(std::move(op));
+}
+
+void ComplexBorderPainter::Restore() {
+  RestoreOp op;
+  op.transform_id = input_.state_ids.transform_id;
+  op.clip_id = input_.state_ids.clip_id;
+  op.effect_id = input_.state_ids.effect_id;
+  ops_.AddRestore(std::move(op));
+}
+
+void ComplexBorderPainter::SaveLayerAlpha(float alpha) {
+  SaveLayerAlphaOp op;
+  op.alpha = alpha;
+  op.transform_id = input_.state_ids.transform_id;
+  op.clip_id = input_.state_ids.clip_id;
+  op.effect_id = input_.state_ids.effect_id;
+  ops_.AddSaveLayerAlpha(std::move(op));
+}
+
+void ComplexBorderPainter::ClipRRect(const RectF& rect,
+                                     const BorderRadii& radii,
+                                     bool difference) {
+  ClipRRectOp op;
+  op.rect = {rect.x, rect.y, rect.Right(), rect.Bottom()};
+  op.radii = radii;
+  op.difference = difference;
+  op.transform_id = input_.state_ids.transform_id;
+  op.clip_id = input_.state_ids.clip_id;
+  op.effect_id = input_.state_ids.effect_id;
+  ops_.AddClipRRect(std::move(op));
+}
+
+void ComplexBorderPainter::ClipPolygon(std::vector<PointF> points,
+                                       bool antialiased, bool difference) {
+  ClipPathOp op;
+  op.points = std::move(points);
+  op.difference = difference;
+  op.antialias = antialiased;
+  op.transform_id = input_.state_ids.transform_id;
+  op.clip_id = input_.state_ids.clip_id;
+  op.effect_id = input_.state_ids.effect_id;
+  ops_.AddClipPath(std::move(op));
+}
+
+void ComplexBorderPainter::FillRect(float left, float top, float right,
+                                    float bottom, const Color& color) {
+  DrawRectOp op;
+  op.rect = {left, top, right, bottom};
+  op.flags = FillFlags(color);
+  op.transform_id = input_.state_ids.transform_id;
+  op.clip_id = input_.state_ids.clip_id;
+  op.effect_id = input_.state_ids.effect_id;
+  ops_.AddDrawRect(std::move(op));
+}
+
+void ComplexBorderPainter::FillQuad(const PointF quad[4], const Color& color) {
+  DrawPathOp op;
+  op.contours.push_back({quad[0], quad[1], quad[2], quad[3]});
+  op.flags = FillFlags(color);
+  op.transform_id = input_.state_ids.transform_id;
+  op.clip_id = input_.state_ids.clip_id;
+  op.effect_id = input_.state_ids.effect_id;
+  ops_.AddDrawPath(std::move(op));
+}
+
+}  // namespace border_painter
@@ -0,0 +1,189 @@
+// Copyright 2015 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's box_border_painter.h (complex path)
+// Original: third_party/blink/renderer/core/paint/box_border_painter.h
+//
+// Changes from Chromium:
+// - Emits into a PaintOpList instead of drawing into a GraphicsContext
+// - Geometry stays in floats (no pixel snapping); the stripe math of double,
+//   ridge and groove sides uses widths rounded to integers
+// - Curved sides are clipped with the quad / pentagon of
+//   ClipBorderSidePolygon (ClipBorderSidePolygonCloseToEdges is not ported).
+//   Shaped corners only swap the outer / inner rrect clips for the
+//   flattened contours; double and ridge / groove stripes stay round.
+// - Bleed avoidance only skips the outer clip; double border stripes do not
+//   inflate under a clipping strategy. No edge width clamping.
+// - Dash layouts come from dash_layout.h; curved sides share one layout
+//   per distinct width and style, computed over the centerline perimeter
+
+#ifndef BORDER_PAINTER_COMPLEX_BORDER_PAINTER_H_
+#define BORDER_PAINTER_COMPLEX_BORDER_PAINTER_H_
+
+#include <array>
+#include <vector>
+
+#include "border_painter.h"
+#include "dash_layout.h"
+#include "draw_commands.h"
+#include "types.h"
+
+namespace border_painter {
+
+// Paints the borders BorderPainter's fast paths cannot: mixed colors or
+// styles, translucent sides and rounded corners. Sides are clustered into
+// opacity groups so a translucent border needs one layer per distinct alpha
+// at most, and corners between differing sides are mitered with clips.
+class ComplexBorderPainter {
+ public:
+  ComplexBorderPainter(const BorderPaintInput& input,
+                       const std::array<BorderEdge, 4>& edges,
+                       PaintOpList& ops);
+
+  // Clip to these polygons instead of the outer / inner rrects (corner
+  // shapes); |inner| may be empty
+  void SetContours(std::vector<PointF> outer, std::vector<PointF> inner);
+
+  void Paint();
+
+ private:
+  enum MiterType {
+    kNoMiter,
+    kSoftMiter,  // Anti-aliased
+    kHardMiter,  // Not anti-aliased
+  };
+
+  enum SideType { kStraight, kCurved };
+
+  // Edges sharing the same opacity
+  struct OpacityGroup {
+    explicit OpacityGroup(float alpha) : alpha(alpha) {}
+
+    std::vector<BoxSide> sides;
+    unsigned edge_flags = 0;
+    float alpha;
+  };
+
+  const BorderEdge& Edge(BoxSide side) const {
+    return edges_[static_cast<unsigned>(side)];
+  }
+
+  // Visible sides sorted by alpha, style and side, grouped by alpha
+  std::vector<OpacityGroup> BuildOpacityGroups() const;
+
+  unsigned PaintOpacityGroup(const std::vector<OpacityGroup>& groups,
+                             size_t index,
+                             float effective_opacity);
+  void PaintSide(BoxSide side, float alpha, unsigned completed_edges);
+  void PaintOneBorderSide(const RectF& side_rect,
+                          BoxSide side,
+                          BoxSide adjacent_side1,
+                          BoxSide adjacent_side2,
+                          SideType side_type,
+                          const Color& color,
+                          unsigned completed_edges);
+
+  MiterType ComputeMiter(BoxSide side,
+                         BoxSide adjacent_side,
+                         unsigned completed_edges) const;
+  static bool MitersRequireClipping(MiterType miter1,
+                                    MiterType miter2,
+                                    EBorderStyle style);
+  bool ColorsMatchAtCorner(BoxSide side, BoxSide adjacent_side) const;
+
+  void ClipBorderSidePolygon(BoxSide side,
+                             MiterType first_miter,
+                             MiterType second_miter);
+
+  // Curved sides fill the outer rect under the side clip
+  void DrawCurvedBoxSide(int border_thickness,
+                         int stroke_thickness,
+                         BoxSide side,
+                         Color color,
+                         EBorderStyle border_style);
+  void DrawCurvedDashedDottedBoxSide(int border_thickness,
+                                     int stroke_thickness,
+                                     const Color& color,
+                                     EBorderStyle border_style);
+  void DrawCurvedDoubleBoxSide(const Color& color);
+
+  // Memoized dash layout around the closed centerline rrect
+  const DashLayout& CurvedDashLayout(const RectF& centerline,
+                                     const BorderRadii& centerline_radii,
+                                     int border_thickness,
+                                     EBorderStyle border_style);
+  void DrawCurvedRidgeGrooveBoxSide(BoxSide side,
+                                    const Color& color,
+                                    EBorderStyle border_style);
+
+  // Straight sides; adjacent widths are non-zero where a miter is drawn
+  void DrawLineForBoxSide(float x1, float y1, float x2, float y2,
+                          BoxSide side, Color color, EBorderStyle style,
+                          int adjacent_width1, int adjacent_width2);
+  void DrawSolidBoxSide(float x1, float y1, float x2, float y2,
+                        BoxSide side, const Color& color,
+                        int adjacent_width1, int adjacent_width2);
+  void DrawDoubleBoxSide(float x1, float y1, float x2, float y2,
+                         float length, BoxSide side, const Color& color,
+                         int thickness, int adjacent_width1,
+                         int adjacent_width2);
+  void DrawRidgeOrGrooveBoxSide(float x1, float y1, float x2, float y2,
+                                BoxSide side, const Color& color,
+                                EBorderStyle style, int adjacent_width1,
+                                int adjacent_width2);
+  void DrawDashedOrDottedBoxSide(float x1, float y1, float x2, float y2,
+                                 BoxSide side, const Color& color,
+                                 int thickness, EBorderStyle style);
+  void DrawLineWithStyle(PointF p1, PointF p2, int thickness,
+                         EBorderStyle style, const Color& color);
+  void EnforceDotsAtEndpoints(PointF& p1, PointF& p2, int path_length,
+                              int width, const Color& color,
+                              bool is_vertical_line);
+
+  // Op emission
+  void Save();
+  void Restore();
+  void SaveLayerAlpha(float alpha);
+  void ClipRRect(const RectF& rect, const BorderRadii& radii, bool difference);
+  void ClipPolygon(std::vector<PointF> points, bool antialiased,
+                   bool difference = false);
+  void FillRect(float left, float top, float right, float bottom,
+                const Color& color);
+  void FillQuad(const PointF quad[4], const Color& color);
+
+  // Outer border inset by per-side amounts, radii shrunk to match
+  RectF InsetRect(float top, float right, float bottom, float left) const;
+  BorderRadii InsetRadii(float top, float right, float bottom,
+                         float left) const;
+
+  const BorderPaintInput& input_;
+  std::array<BorderEdge, 4> edges_;
+  PaintOpList& ops_;
+
+  RectF outer_;
+  BorderRadii outer_radii_{};
+  RectF inner_;
+  BorderRadii inner_radii_{};
+  bool is_rounded_ = false;
+  bool inner_renderable_ = true;
+  std::vector<PointF> outer_contour_;  // Set for shaped corners
+  std::vector<PointF> inner_contour_;
+
+  unsigned visible_edge_set_ = 0;
+  unsigned first_visible_edge_ = 0;
+  bool is_uniform_style_ = true;
+  bool is_uniform_color_ = true;
+
+  struct CurvedDash {
+    int thickness;
+    EBorderStyle style;
+    DashLayout layout;
+  };
+  float centerline_length_ = -1.0f;  // Computed with the first curved dash
+  std::vector<CurvedDash> curved_dashes_;
+};
+
+}  // namespace border_painter
+
+#endif  // BORDER_PAINTER_COMPLEX_BORDER_PAINTER_H_
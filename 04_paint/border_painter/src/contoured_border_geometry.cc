@@ -0,0 +1,374 @@
+// Copyright 2020 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's contoured_border_geometry.cc
+// Original: third_party/blink/renderer/core/paint/contoured_border_geometry.cc
+//
+// Changes from Chromium:
+// - See contoured_border_geometry.h
+
+#include "contoured_border_geometry.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace border_painter {
+
+namespace {
+
+constexpr uint64_t kFnvOffset = 0xcbf29ce484222325ull;
+constexpr uint64_t kFnvPrime = 0x100000001b3ull;
+
+void HashFloat(uint64_t& hash, float value) {
+  if (value == 0.0f) value = 0.0f;
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  hash ^= bits;
+  hash *= kFnvPrime;
+}
+
+// Flattening: 2 * sqrt(device radius) segments per corner, clamped
+constexpr int kMinCornerSegments = 2;
+constexpr int kMaxCornerSegments = 64;
+
+int ScaleBucket(float device_scale_factor) {
+  if (!(device_scale_factor > 1.0f)) {
+    return 0;
+  }
+  return std::min(
+      4, static_cast<int>(std::ceil(std::log2(device_scale_factor))));
+}
+
+bool IsConvexShape(float shape) {
+  return shape >= 0.0f;
+}
+
+// Offset of the superellipse point at 45 degrees from the corner center,
+// as a fraction of the radius: 2^(-1/2^K), mirrored for concave corners
+float HalfCornerFraction(float shape) {
+  if (IsConvexShape(shape)) {
+    return std::pow(2.0f, -std::pow(2.0f, -shape));
+  }
+  return 1.0f - std::pow(2.0f, -std::pow(2.0f, shape));
+}
+
+// One corner of the contoured rect, in clockwise order: the curve runs
+// from |start| to |end| around |center|, bulging toward |outer|
+struct Corner {
+  PointF start;
+  PointF outer;
+  PointF end;
+  PointF center;
+  float shape;
+
+  bool IsEmpty() const {
+    return (start.x == outer.x && start.y == outer.y) ||
+           (end.x == outer.x && end.y == outer.y);
+  }
+
+  PointF HalfCorner() const {
+    const float f = HalfCornerFraction(shape);
+    return {center.x + (outer.x - center.x) * f,
+            center.y + (outer.y - center.y) * f};
+  }
+
+  RectF BoundingBox() const {
+    const float left = std::min(outer.x, center.x);
+    const float top = std::min(outer.y, center.y);
+    return {left, top, std::max(outer.x, center.x) - left,
+            std::max(outer.y, center.y) - top};
+  }
+};
+
+using Quad = std::array<PointF, 4>;
+
+bool RectsIntersect(const RectF& a, const RectF& b) {
+  return !a.IsEmpty() && !b.IsEmpty() && a.x < b.Right() && b.x < a.Right() &&
+         a.y < b.Bottom() && b.y < a.Bottom();
+}
+
+// Intersection of the lines through p1 along d1 and through p2 along d2
+bool IntersectLines(const PointF& p1, const PointF& d1, const PointF& p2,
+                    const PointF& d2, PointF& result) {
+  const float denominator = d1.x * d2.y - d1.y * d2.x;
+  if (denominator == 0.0f) {
+    return false;
+  }
+  const float s = ((p2.x - p1.x) * d2.y - (p2.y - p1.y) * d2.x) / denominator;
+  result = {p1.x + s * d1.x, p1.y + s * d1.y};
+  return true;
+}
+
+// Separating axis test; both quads are convex
+bool QuadsIntersect(const Quad& a, const Quad& b) {
+  for (const Quad* quad : {&a, &b}) {
+    for (size_t i = 0; i < 4; ++i) {
+      const PointF& p = (*quad)[i];
+      const PointF& q = (*quad)[(i + 1) % 4];
+      const float axis_x = p.y - q.y;
+      const float axis_y = q.x - p.x;
+      if (axis_x == 0.0f && axis_y == 0.0f) {
+        continue;
+      }
+      float min_a = std::numeric_limits<float>::max();
+      float max_a = std::numeric_limits<float>::lowest();
+      float min_b = min_a;
+      float max_b = max_a;
+      for (size_t j = 0; j < 4; ++j) {
+        const float pa = a[j].x * axis_x + a[j].y * axis_y;
+        const float pb = b[j].x * axis_x + b[j].y * axis_y;
+        min_a = std::min(min_a, pa);
+        max_a = std::max(max_a, pa);
+        min_b = std::min(min_b, pb);
+        max_b = std::max(max_b, pb);
+      }
+      if (max_a <= min_b || max_b <= min_a) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+Quad ComputeHullQuad(const Corner& corner) {
+  const PointF half_corner = corner.HalfCorner();
+  // Tangent at the half corner: perpendicular to outer -> half_corner
+  const PointF tangent = {corner.outer.y - half_corner.y,
+                          half_corner.x - corner.outer.x};
+  PointF intersection_1 = corner.center;
+  PointF intersection_2 = corner.center;
+  if (tangent.x != 0.0f || tangent.y != 0.0f) {
+    if (!IntersectLines(half_corner, tangent, corner.start,
+                        {corner.center.x - corner.start.x,
+                         corner.center.y - corner.start.y},
+                        intersection_1)) {
+      intersection_1 = corner.center;
+    }
+    if (!IntersectLines(half_corner, tangent, corner.end,
+                        {corner.center.x - corner.end.x,
+                         corner.center.y - corner.end.y},
+                        intersection_2)) {
+      intersection_2 = corner.center;
+    }
+  }
+  return {corner.start, intersection_1, intersection_2, corner.end};
+}
+
+Quad ScaleQuadFromOrigin(const Quad& quad, const PointF& origin, float scale) {
+  Quad scaled;
+  for (size_t i = 0; i < 4; ++i) {
+    scaled[i] = {origin.x + (quad[i].x - origin.x) * scale,
+                 origin.y + (quad[i].y - origin.y) * scale};
+  }
+  return scaled;
+}
+
+// The "optimal" hull scale is the scale where the hulls touch but do not
+// intersect, binary-searched down to kEpsilon
+float SolveOptimalHullScale(const Quad& hull_a, const PointF& origin_a,
+                            const Quad& hull_b, const PointF& origin_b,
+                            float min_scale, float max_scale) {
+  constexpr float kEpsilon = 0.05f;
+  while (max_scale - min_scale > kEpsilon) {
+    const float check_scale = (min_scale + max_scale) / 2;
+    if (QuadsIntersect(ScaleQuadFromOrigin(hull_a, origin_a, check_scale),
+                       ScaleQuadFromOrigin(hull_b, origin_b, check_scale))) {
+      max_scale = check_scale;
+    } else {
+      min_scale = check_scale;
+    }
+  }
+  return min_scale;
+}
+
+float RadiiConstraintFactorForOppositeCorners(const Corner& a,
+                                              const Corner& b) {
+  if (a.IsEmpty() || b.IsEmpty() ||
+      !RectsIntersect(a.BoundingBox(), b.BoundingBox())) {
+    return 1.0f;
+  }
+  const Quad hull_a = ComputeHullQuad(a);
+  const Quad hull_b = ComputeHullQuad(b);
+  if (!QuadsIntersect(hull_a, hull_b)) {
+    return 1.0f;
+  }
+  return SolveOptimalHullScale(hull_a, a.outer, hull_b, b.outer, 0.0f, 1.0f);
+}
+
+// Corners of |rect| in clockwise order: top-left, top-right, bottom-right,
+// bottom-left
+std::array<Corner, 4> CornersOf(const RectF& rect, const BorderRadii& r,
+                                const CornerShapes& shapes) {
+  const float left = rect.x;
+  const float top = rect.y;
+  const float right = rect.Right();
+  const float bottom = rect.Bottom();
+  return {{
+      {{left, top + r[1]}, {left, top}, {left + r[0], top},
+       {left + r[0], top + r[1]}, shapes.top_left},
+      {{right - r[2], top}, {right, top}, {right, top + r[3]},
+       {right - r[2], top + r[3]}, shapes.top_right},
+      {{right, bottom - r[5]}, {right, bottom}, {right - r[4], bottom},
+       {right - r[4], bottom - r[5]}, shapes.bottom_right},
+      {{left + r[6], bottom}, {left, bottom}, {left, bottom - r[7]},
+       {left + r[6], bottom - r[7]}, shapes.bottom_left},
+  }};
+}
+
+}  // namespace
+
+bool ContourPathCache::Key::operator==(const Key& other) const {
+  return rx == other.rx && ry == other.ry && shape == other.shape &&
+         scale_bucket == other.scale_bucket;
+}
+
+size_t ContourPathCache::KeyHash::operator()(const Key& key) const {
+  uint64_t hash = kFnvOffset;
+  HashFloat(hash, key.rx);
+  HashFloat(hash, key.ry);
+  HashFloat(hash, key.shape);
+  hash ^= static_cast<uint32_t>(key.scale_bucket);
+  hash *= kFnvPrime;
+  return static_cast<size_t>(hash);
+}
+
+const std::vector<PointF>& ContourPathCache::CornerCurve(
+    float rx, float ry, float shape, float device_scale_factor) {
+  const Key key{rx, ry, shape, ScaleBucket(device_scale_factor)};
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    ++hits_;
+    return it->second;
+  }
+  ++misses_;
+  return entries_
+      .emplace(key, FlattenCorner(rx, ry, shape, key.scale_bucket))
+      .first->second;
+}
+
+// Superellipse |u|^e + |v|^e = 1 with e = 2^K, sampled as
+// (cos(t)^(2/e), sin(t)^(2/e)). Concave corners (K < 0) mirror the convex
+// curve of -K across the corner diagonal: (u, v) -> (1 - v, 1 - u).
+std::vector<PointF> ContourPathCache::FlattenCorner(float rx, float ry,
+                                                    float shape,
+                                                    int scale_bucket) {
+  if (std::isinf(shape)) {
+    // Square keeps the outer corner, notch cuts to the center
+    const float c = shape > 0 ? 1.0f : 0.0f;
+    return {{rx, 0.0f}, {c * rx, c * ry}, {0.0f, ry}};
+  }
+
+  const bool concave = !IsConvexShape(shape);
+  const double exponent = std::pow(2.0, std::fabs(shape));
+  int segments = 1;  // Bevel: a straight cut
+  if (shape != 0.0f) {
+    const float device_radius = std::max(rx, ry) * (1 << scale_bucket);
+    segments = std::clamp(
+        static_cast<int>(std::ceil(2.0f * std::sqrt(device_radius))),
+        kMinCornerSegments, kMaxCornerSegments);
+  }
+
+  std::vector<PointF> curve;
+  curve.reserve(segments + 1);
+  curve.push_back({rx, 0.0f});
+  for (int i = 1; i < segments; ++i) {
+    const double t = M_PI_2 * i / segments;
+    const double u = std::pow(std::max(0.0, std::cos(t)), 2.0 / exponent);
+    const double v = std::pow(std::max(0.0, std::sin(t)), 2.0 / exponent);
+    if (concave) {
+      curve.push_back({static_cast<float>((1.0 - v) * rx),
+                       static_cast<float>((1.0 - u) * ry)});
+    } else {
+      curve.push_back({static_cast<float>(u * rx), static_cast<float>(v * ry)});
+    }
+  }
+  curve.push_back({0.0f, ry});
+  return curve;
+}
+
+BorderRadii ContouredBorderGeometry::ConstrainedRadii(
+    const RectF& rect, const BorderRadii& radii, const CornerShapes& shapes) {
+  BorderRadii constrained = radii;
+
+  // FloatRoundedRect::ConstrainRadii: adjacent radii fit their side
+  float factor = 1.0f;
+  auto fit = [&factor](float length, float r1, float r2) {
+    if (r1 + r2 > length) {
+      factor = std::min(factor, length / (r1 + r2));
+    }
+  };
+  fit(rect.width, radii[0], radii[2]);
+  fit(rect.width, radii[6], radii[4]);
+  fit(rect.height, radii[1], radii[7]);
+  fit(rect.height, radii[3], radii[5]);
+
+  if (factor < 1.0f) {
+    for (float& r : constrained) r *= factor;
+  }
+  if (IsConvexShape(shapes.top_left) && IsConvexShape(shapes.top_right) &&
+      IsConvexShape(shapes.bottom_right) &&
+      IsConvexShape(shapes.bottom_left)) {
+    return constrained;
+  }
+
+  // Concave corners reach into the box: keep opposite corner hulls apart
+  const std::array<Corner, 4> corners = CornersOf(rect, constrained, shapes);
+  const float hull_factor =
+      std::min(RadiiConstraintFactorForOppositeCorners(corners[0], corners[2]),
+               RadiiConstraintFactorForOppositeCorners(corners[3], corners[1]));
+  if (hull_factor < 1.0f) {
+    for (float& r : constrained) r *= hull_factor;
+  }
+  return constrained;
+}
+
+std::vector<PointF> ContouredBorderGeometry::Contour(
+    const RectF& rect, const BorderRadii& radii, const CornerShapes& shapes,
+    float device_scale_factor, ContourPathCache& cache) {
+  // Per corner: offset signs from the center and whether the clockwise
+  // walk runs along the cached curve ((rx, 0) -> (0, ry)) or against it
+  struct Walk {
+    float sx;
+    float sy;
+    bool forward;
+  };
+  constexpr Walk kWalks[4] = {
+      {-1.0f, -1.0f, true},   // Top-left: left side -> top side
+      {1.0f, -1.0f, false},   // Top-right: top side -> right side
+      {1.0f, 1.0f, true},     // Bottom-right: right side -> bottom side
+      {-1.0f, 1.0f, false},   // Bottom-left: bottom side -> left side
+  };
+
+  const std::array<Corner, 4> corners = CornersOf(rect, radii, shapes);
+  std::vector<PointF> contour;
+  for (size_t i = 0; i < 4; ++i) {
+    const Corner& corner = corners[i];
+    const float rx = radii[i * 2];
+    const float ry = radii[i * 2 + 1];
+    if (rx <= 0.0f || ry <= 0.0f) {
+      contour.push_back(corner.outer);
+      continue;
+    }
+    const std::vector<PointF>& curve =
+        cache.CornerCurve(rx, ry, corner.shape, device_scale_factor);
+    const Walk& walk = kWalks[i];
+    for (size_t j = 0; j < curve.size(); ++j) {
+      const PointF& p = curve[walk.forward ? j : curve.size() - 1 - j];
+      contour.push_back({corner.center.x + walk.sx * p.x,
+                         corner.center.y + walk.sy * p.y});
+    }
+  }
+  return contour;
+}
+
+ContourPathCache& ContouredBorderGeometry::SharedPathCache() {
+  static ContourPathCache cache;
+  return cache;
+}
+
+}  // namespace border_painter
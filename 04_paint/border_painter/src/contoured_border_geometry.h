@@ -0,0 +1,94 @@
+// Copyright 2020 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's contoured_border_geometry.h
+// Original: third_party/blink/renderer/core/paint/contoured_border_geometry.h
+//
+// Changes from Chromium:
+// - Works on RectF + BorderRadii + CornerShapes instead of ComputedStyle and
+//   ContouredRect; no pixel snapping and no sides_to_include
+// - Corners are flattened to polygons here (Chromium builds a Skia path in
+//   ContouredRect::GetPath); the flattened corner curves are memoized in a
+//   ContourPathCache keyed on (radii, corner shape, scale bucket)
+// - The inner border uses the outer shapes on radii shrunk by the border
+//   widths, like ContouredRect::Inset
+
+#ifndef BORDER_PAINTER_CONTOURED_BORDER_GEOMETRY_H_
+#define BORDER_PAINTER_CONTOURED_BORDER_GEOMETRY_H_
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "types.h"
+
+namespace border_painter {
+
+// Flattened corner curves. A curve runs from (rx, 0) to (0, ry) as offsets
+// from the corner center toward the outer corner, so one entry serves all
+// four corners (and every box) with the same radii and shape.
+//
+// The flattening tolerance follows the device scale factor, quantized to
+// power-of-two buckets: boxes painted at 1.5x and 2x share curves, 1x and
+// 3x do not. Entries are never evicted.
+class ContourPathCache {
+ public:
+  // |shape| is the superellipse parameter of CornerShapes
+  const std::vector<PointF>& CornerCurve(float rx, float ry, float shape,
+                                         float device_scale_factor);
+
+  size_t hits() const { return hits_; }
+  size_t misses() const { return misses_; }
+  size_t size() const { return entries_.size(); }
+  double HitRate() const {
+    size_t total = hits_ + misses_;
+    return total ? static_cast<double>(hits_) / total : 0.0;
+  }
+
+ private:
+  struct Key {
+    float rx;
+    float ry;
+    float shape;
+    int scale_bucket;  // ceil(log2(device_scale_factor))
+
+    bool operator==(const Key& other) const;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  static std::vector<PointF> FlattenCorner(float rx, float ry, float shape,
+                                           int scale_bucket);
+
+  std::unordered_map<Key, std::vector<PointF>, KeyHash> entries_;
+  size_t hits_ = 0;
+  size_t misses_ = 0;
+};
+
+class ContouredBorderGeometry {
+ public:
+  // |radii| constrained like FloatRoundedRect::ConstrainRadii, then scaled
+  // down further when concave corners would make opposite corner hulls
+  // overlap (ComputeContouredBorderFromStyle)
+  static BorderRadii ConstrainedRadii(const RectF& rect,
+                                      const BorderRadii& radii,
+                                      const CornerShapes& shapes);
+
+  // Closed clockwise polygon of |rect| with shaped corners, starting at the
+  // top of the left side. |radii| must already be constrained.
+  static std::vector<PointF> Contour(const RectF& rect,
+                                     const BorderRadii& radii,
+                                     const CornerShapes& shapes,
+                                     float device_scale_factor,
+                                     ContourPathCache& cache);
+
+  // Corner curves shared by every BorderPainter::Paint call
+  static ContourPathCache& SharedPathCache();
+};
+
+}  // namespace border_painter
+
+#endif  // BORDER_PAINTER_CONTOURED_BORDER_GEOMETRY_H_
@@ -0,0 +1,177 @@
+// Copyright 2019 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's dark_mode_filter.cc,
+// dark_mode_color_classifier.cc, dark_mode_color_filter.cc and
+// lab_color_space.h
+// Original: third_party/blink/renderer/platform/graphics/
+//
+// Changes from Chromium, and how the module copies relate:
+// - See dark_mode_filter.h
+
+#include "dark_mode_filter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace border_painter {
+
+namespace {
+
+uint8_t ToByte(float c) {
+  return static_cast<uint8_t>(std::lround(std::clamp(c, 0.0f, 1.0f) * 255.0f));
+}
+
+// --- Channel access ---
+// The only block that differs between the module copies: Color channels are
+// 8-bit here and in block_painter, floats in [0, 1] in border_painter.
+uint32_t Channel8(float c) { return ToByte(c); }
+float ChannelUnit(float c) { return c; }
+float FromUnit(float c) { return c; }
+// --- End of channel access ---
+
+// DarkModeSettings defaults
+constexpr int kForegroundBrightnessThreshold = 150;
+constexpr int kBackgroundBrightnessThreshold = 205;
+
+// Based on this paper: https://www.w3.org/TR/AERT/#color-contrast
+int CalculateColorBrightness(const Color& color) {
+  return static_cast<int>((Channel8(color.r) * 299 + Channel8(color.g) * 587 +
+                           Channel8(color.b) * 114) / 1000);
+}
+
+uint32_t PackRGBA(const Color& color) {
+  return (Channel8(color.r) << 24) | (Channel8(color.g) << 16) |
+         (Channel8(color.b) << 8) | Channel8(color.a);
+}
+
+// --- LabColorSpace: sRGB <-> XYZ (D50) <-> CIELAB ---
+
+struct Vec3 {
+  float x, y, z;
+};
+
+// sRGB primaries Bradford-adapted to the D50 white point
+constexpr float kSRGBToXYZ[9] = {0.4360747f, 0.3850649f, 0.1430804f,
+                                 0.2225045f, 0.7168786f, 0.0606169f,
+                                 0.0139322f, 0.0971045f, 0.7141733f};
+constexpr float kXYZToSRGB[9] = {3.1338561f,  -1.6168667f, -0.4906146f,
+                                 -0.9787684f, 1.9161415f,  0.0334540f,
+                                 0.0719453f,  -0.2289914f, 1.4052427f};
+constexpr Vec3 kIlluminantD50 = {0.964212f, 1.0f, 0.825188f};
+
+Vec3 Mul(const float m[9], const Vec3& v) {
+  return {m[0] * v.x + m[1] * v.y + m[2] * v.z,
+          m[3] * v.x + m[4] * v.y + m[5] * v.z,
+          m[6] * v.x + m[7] * v.y + m[8] * v.z};
+}
+
+float ToLinear(float c) {
+  return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float ToGamma(float c) {
+  c = std::clamp(c, 0.0f, 1.0f);
+  return c <= 0.0031308f ? c * 12.92f
+                         : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+float LabF(float t) {
+  constexpr float kDelta = 6.0f / 29.0f;
+  return t > kDelta * kDelta * kDelta ? std::cbrt(t)
+                                      : t / (3 * kDelta * kDelta) + 4.0f / 29.0f;
+}
+
+float LabFInverse(float t) {
+  constexpr float kDelta = 6.0f / 29.0f;
+  return t > kDelta ? t * t * t : 3 * kDelta * kDelta * (t - 4.0f / 29.0f);
+}
+
+Vec3 SRGBToLab(const Vec3& rgb) {
+  Vec3 xyz = Mul(kSRGBToXYZ, {ToLinear(rgb.x), ToLinear(rgb.y), ToLinear(rgb.z)});
+  float fx = LabF(xyz.x / kIlluminantD50.x);
+  float fy = LabF(xyz.y / kIlluminantD50.y);
+  float fz = LabF(xyz.z / kIlluminantD50.z);
+  return {116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz)};
+}
+
+Vec3 LabToSRGB(const Vec3& lab) {
+  float fy = (lab.x + 16.0f) / 116.0f;
+  float fx = fy + lab.y / 500.0f;
+  float fz = fy - lab.z / 200.0f;
+  Vec3 xyz = {LabFInverse(fx) * kIlluminantD50.x,
+              LabFInverse(fy) * kIlluminantD50.y,
+              LabFInverse(fz) * kIlluminantD50.z};
+  Vec3 rgb = Mul(kXYZToSRGB, xyz);
+  return {ToGamma(rgb.x), ToGamma(rgb.y), ToGamma(rgb.z)};
+}
+
+}  // namespace
+
+bool DarkModeFilter::ShouldApplyToColor(const Color& color,
+                                        ElementRole role) const {
+  switch (role) {
+    case ElementRole::kBorder:
+    case ElementRole::kSVG:
+      return true;
+    case ElementRole::kListSymbol:
+    case ElementRole::kForeground:
+      // Dark text becomes light; text that is already light is kept
+      return CalculateColorBrightness(color) < kForegroundBrightnessThreshold;
+    case ElementRole::kBackground:
+      // Only light backgrounds are darkened
+      return CalculateColorBrightness(color) > kBackgroundBrightnessThreshold;
+  }
+  return false;
+}
+
+Color DarkModeFilter::InvertColor(const Color& color) {
+  Vec3 lab = SRGBToLab(
+      {ChannelUnit(color.r), ChannelUnit(color.g), ChannelUnit(color.b)});
+  lab.x = std::min(110.0f - lab.x, 100.0f);
+  Vec3 rgb = LabToSRGB(lab);
+  Color inverted{FromUnit(rgb.x), FromUnit(rgb.y), FromUnit(rgb.z), color.a};
+
+  // Further darken dark grays to match the primary surface color recommended
+  // by the material design guidelines:
+  //   https://material.io/design/color/dark-theme.html#properties
+  constexpr uint32_t kBrightnessThreshold = 32;
+  constexpr uint32_t kAdjustedBrightness = 18;
+  const uint32_t gray = Channel8(inverted.r);
+  if (inverted.r == inverted.g && inverted.r == inverted.b &&
+      gray < kBrightnessThreshold && gray > kAdjustedBrightness) {
+    inverted.r = inverted.g = inverted.b =
+        FromUnit(kAdjustedBrightness / 255.0f);
+  }
+  return inverted;
+}
+
+Color DarkModeFilter::GetInvertedColor(const Color& color) {
+  const uint32_t key = PackRGBA(color);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    ++cache_hits_;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->second;
+  }
+
+  ++cache_misses_;
+  Color inverted = InvertColor(color);
+  if (cache_capacity_ == 0) return inverted;
+  if (lru_.size() >= cache_capacity_) {
+    index_.erase(lru_.back().first);
+    lru_.pop_back();
+  }
+  lru_.emplace_front(key, inverted);
+  index_[key] = lru_.begin();
+  return inverted;
+}
+
+Color DarkModeFilter::InvertColorIfNeeded(const Color& color,
+                                          ElementRole role) {
+  if (color.a == 0) return color;
+  if (!ShouldApplyToColor(color, role)) return color;
+  return GetInvertedColor(color);
+}
+
+}  // namespace border_painter
@@ -0,0 +1,69 @@
+// Copyright 2019 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's dark_mode_filter.h
+// Original: third_party/blink/renderer/platform/graphics/dark_mode_filter.h
+//
+// Changes from Chromium:
+// - Only the default DarkModeSettings are supported: kInvertLightnessLAB
+//   inversion, foreground brightness threshold 150, background threshold 205
+// - DarkModeColorClassifier, DarkModeColorFilter (LAB) and LabColorSpace are
+//   folded into this class
+// - Image classification, role override and contrast adjustment are removed
+// - The inverted color cache is a plain LRU keyed by packed 8-bit RGBA
+//
+// Module copies: text_painter/src/dark_mode_filter.{h,cc} is the canonical
+// copy. block_painter and border_painter build standalone and carry their
+// own copies. Keep all three identical apart from the namespace, the include
+// guard and the channel access block in dark_mode_filter.cc, and change the
+// canonical copy first.
+
+#ifndef BORDER_PAINTER_DARK_MODE_FILTER_H_
+#define BORDER_PAINTER_DARK_MODE_FILTER_H_
+
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace border_painter {
+
+class DarkModeFilter {
+ public:
+  // Decides which classifier (if any) gates the inversion
+  enum class ElementRole { kForeground, kListSymbol, kBackground, kSVG, kBorder };
+
+  static constexpr size_t kMaxCacheSize = 1024;
+
+  explicit DarkModeFilter(size_t cache_capacity = kMaxCacheSize)
+      : cache_capacity_(cache_capacity) {}
+
+  // Returns the dark-mode color for |color| painted in |role|
+  Color InvertColorIfNeeded(const Color& color, ElementRole role);
+
+  size_t cache_hits() const { return cache_hits_; }
+  size_t cache_misses() const { return cache_misses_; }
+
+ private:
+  bool ShouldApplyToColor(const Color& color, ElementRole role) const;
+
+  // LAB lightness inversion (DarkModeColorFilter, kInvertLightnessLAB)
+  static Color InvertColor(const Color& color);
+
+  // InvertColor through the LRU cache
+  Color GetInvertedColor(const Color& color);
+
+  using CacheEntry = std::pair<uint32_t, Color>;
+  size_t cache_capacity_;
+  std::list<CacheEntry> lru_;  // Most recently used first
+  std::unordered_map<uint32_t, std::list<CacheEntry>::iterator> index_;
+  size_t cache_hits_ = 0;
+  size_t cache_misses_ = 0;
+};
+
+}  // namespace border_painter
+
+#endif  // BORDER_PAINTER_DARK_MODE_FILTER_H_
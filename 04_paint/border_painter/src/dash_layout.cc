@@ -0,0 +1,156 @@
+// Copyright 2013 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's stroke_data.cc
+// Original: third_party/blink/renderer/platform/graphics/stroke_data.cc
+//
+// Changes from Chromium:
+// - See dash_layout.h
+
+#include "dash_layout.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace border_painter {
+
+namespace {
+
+float DashLengthRatio(float thickness) {
+  return thickness >= 3 ? 2.0f : 3.0f;
+}
+
+float DashGapRatio(float thickness) {
+  return thickness >= 3 ? 1.0f : 2.0f;
+}
+
+// Ramanujan's approximation of a quarter ellipse arc
+float QuarterArcLength(float rx, float ry) {
+  if (rx <= 0.0f || ry <= 0.0f) {
+    return 0.0f;
+  }
+  const float h = 3.0f * (rx + ry) -
+                  std::sqrt((3.0f * rx + ry) * (rx + 3.0f * ry));
+  return static_cast<float>(M_PI) * 0.25f * h;
+}
+
+int DashCount(float path_length, float dash_length, float gap_length,
+              bool closed_path) {
+  const float period = dash_length + gap_length;
+  if (period <= 0.0f) {
+    return 0;
+  }
+  return static_cast<int>(std::lround(
+      (closed_path ? path_length : path_length + gap_length) / period));
+}
+
+}  // namespace
+
+float SelectBestDashGap(float stroke_length, float dash_length,
+                        float gap_length, bool closed_path) {
+  // Determine what number of dashes gives the minimum deviation from
+  // gap_length between dashes. Set the gap to that width.
+  float min_num_dashes =
+      std::floor((stroke_length + gap_length) / (dash_length + gap_length));
+  float max_num_dashes = min_num_dashes + 1;
+  float min_num_gaps = closed_path ? min_num_dashes : min_num_dashes - 1;
+  float max_num_gaps = closed_path ? max_num_dashes : max_num_dashes - 1;
+  float max_gap = (stroke_length - max_num_dashes * dash_length) / max_num_gaps;
+  if (min_num_gaps <= 0) {
+    // A single open dash has no gap to adjust
+    return max_gap > 0 ? max_gap : gap_length;
+  }
+  float min_gap = (stroke_length - min_num_dashes * dash_length) / min_num_gaps;
+  return (max_gap <= 0) ||
+                 (std::fabs(min_gap - gap_length) <
+                  std::fabs(max_gap - gap_length))
+             ? min_gap
+             : max_gap;
+}
+
+DashLayout ComputeDashLayout(float path_length, int thickness,
+                             EBorderStyle style, bool closed_path) {
+  DashLayout layout;
+  const float dash_width = static_cast<float>(std::max(thickness, 1));
+
+  if (StrokeIsDashed(thickness, style)) {
+    // Dashes, or thin dots drawn as square dashes
+    layout.dash_length = dash_width;
+    float gap_length = dash_width;
+    if (style == EBorderStyle::kDashed) {
+      layout.dash_length *= DashLengthRatio(dash_width);
+      gap_length *= DashGapRatio(dash_width);
+    }
+    if (path_length <= layout.dash_length * 2) {
+      // No space for dashes
+      layout.solid = true;
+      return layout;
+    }
+    layout.gap_length = SelectBestDashGap(path_length, layout.dash_length,
+                                          gap_length, closed_path);
+  } else if (style == EBorderStyle::kDotted) {
+    const float per_dot_length = dash_width * 2;
+    layout.round_cap = true;
+    if (path_length < per_dot_length) {
+      // Not enough space for 2 dots. Just draw 1 by giving a gap that is
+      // bigger than the length.
+      layout.gap_length = per_dot_length;
+      layout.dash_count = 1;
+      return layout;
+    }
+    // Epsilon ensures that we get a whole dot at the end of the line,
+    // even if that dot is a little inside the true endpoint. Without it
+    // we can drop the end dot due to rounding along the line.
+    static constexpr float kEpsilon = 1.0e-2f;
+    const float gap = SelectBestDashGap(path_length, dash_width, dash_width,
+                                        closed_path);
+    layout.gap_length = gap + dash_width - kEpsilon;
+    // Open paths have a dot centered on each (inset) endpoint
+    layout.dash_count =
+        closed_path
+            ? static_cast<int>(std::lround(path_length / layout.gap_length))
+            : static_cast<int>((path_length - dash_width) /
+                               layout.gap_length) + 1;
+    return layout;
+  } else {
+    layout.solid = true;
+    return layout;
+  }
+
+  layout.dash_count = DashCount(path_length, layout.dash_length,
+                                layout.gap_length, closed_path);
+  if (closed_path) {
+    // Start mid-dash: the seam where the path closes falls inside a dash
+    layout.phase = layout.dash_length * 0.5f;
+  }
+  return layout;
+}
+
+float RRectPerimeter(const RectF& rect, const BorderRadii& radii) {
+  // Straight runs between the corner arcs
+  const float top = rect.width - radii[0] - radii[2];
+  const float right = rect.height - radii[3] - radii[5];
+  const float bottom = rect.width - radii[4] - radii[6];
+  const float left = rect.height - radii[7] - radii[1];
+  float length = std::max(top, 0.0f) + std::max(right, 0.0f) +
+                 std::max(bottom, 0.0f) + std::max(left, 0.0f);
+  for (int corner = 0; corner < 4; ++corner) {
+    length += QuarterArcLength(radii[2 * corner], radii[2 * corner + 1]);
+  }
+  return length;
+}
+
+void ApplyDashLayout(const DashLayout& layout, DrawFlags& flags) {
+  if (layout.solid) {
+    flags.dash_pattern = DashPattern{};
+    return;
+  }
+  flags.dash_pattern.has_pattern = true;
+  flags.dash_pattern.intervals[0] = layout.dash_length;
+  flags.dash_pattern.intervals[1] = layout.gap_length;
+  flags.dash_pattern.phase = layout.phase;
+  flags.stroke_cap = layout.round_cap ? StrokeCap::kRound : StrokeCap::kButt;
+}
+
+}  // namespace border_painter
@@ -0,0 +1,62 @@
+// Copyright 2013 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's stroke_data.h
+// Original: third_party/blink/renderer/platform/graphics/stroke_data.h
+//
+// Changes from Chromium:
+// - The dash computation of SetupPaintDashPathEffect returns a DashLayout
+//   instead of installing a path effect on PaintFlags
+// - Closed paths start in the middle of a dash so the seam is hidden
+// - SelectBestDashGap keeps the nominal gap when a single open dash leaves
+//   nothing to divide
+// - Adds the centerline length of a rounded rect (elliptical corner arcs)
+
+#ifndef BORDER_PAINTER_DASH_LAYOUT_H_
+#define BORDER_PAINTER_DASH_LAYOUT_H_
+
+#include "draw_commands.h"
+#include "types.h"
+
+namespace border_painter {
+
+// Dashes or dots laid out along one stroked path. Computed once per side
+// (straight sides) or once per border perimeter (curved sides) and emitted
+// as the dash pattern of a single stroke op.
+struct DashLayout {
+  float dash_length = 0.0f;  // 0 with round caps draws circular dots
+  float gap_length = 0.0f;   // Adjusted so dashes fit the path evenly
+  float phase = 0.0f;
+  int dash_count = 0;
+  bool round_cap = false;
+  bool solid = false;  // No room for two dashes: stroke without a pattern
+};
+
+// Dashes are 3 (thin) or 2 (thick) widths long with 2 or 1 width gaps;
+// dots are one width apart. |closed_path| paths have as many gaps as
+// dashes. The layout depends on |path_length|, down to whether the stroke
+// is dashed at all, so BorderOpCache never stretches the ops of a dashed
+// or dotted signature (see test/input_dash_short_long.json).
+DashLayout ComputeDashLayout(float path_length, int thickness,
+                             EBorderStyle style, bool closed_path);
+
+// Gap closest to |gap_length| that fits a whole number of dashes
+float SelectBestDashGap(float stroke_length, float dash_length,
+                        float gap_length, bool closed_path);
+
+// Dotted borders up to 3px wide are drawn as square dashes
+inline bool StrokeIsDashed(int width, EBorderStyle style) {
+  return style == EBorderStyle::kDashed ||
+         (style == EBorderStyle::kDotted && width <= 3);
+}
+
+// Perimeter of the rounded rect |rect|, corner arcs included
+float RRectPerimeter(const RectF& rect, const BorderRadii& radii);
+
+// Writes |layout| into the dash pattern and cap of stroke |flags|
+void ApplyDashLayout(const DashLayout& layout, DrawFlags& flags);
+
+}  // namespace border_painter
+
+#endif  // BORDER_PAINTER_DASH_LAYOUT_H_
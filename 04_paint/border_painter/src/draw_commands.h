@@ -6,6 +6,7 @@
 
 #include <array>
 #include <memory>
+#include <string>
 #include <variant>
 #include <vector>
 
@@ -27,6 +28,7 @@ struct DrawFlags {
 struct DrawRectOp {
   std::string type = "DrawRectOp";
   std::array<float, 4> rect;  // [left, top, right, bottom]
+  DOMNodeId node_id = kInvalidDOMNodeId;  // The box it paints
   DrawFlags flags;
   int transform_id = 0;
   int clip_id = 0;
@@ -38,6 +40,7 @@ struct DrawRRectOp {
   std::string type = "DrawRRectOp";
   std::array<float, 4> rect;  // [left, top, right, bottom]
   BorderRadii radii;
+  DOMNodeId node_id = kInvalidDOMNodeId;  // The box it paints
   DrawFlags flags;
   int transform_id = 0;
   int clip_id = 0;
@@ -51,6 +54,7 @@ struct DrawLineOp {
   float y0 = 0.0f;
   float x1 = 0.0f;
   float y1 = 0.0f;
+  DOMNodeId node_id = kInvalidDOMNodeId;  // The box it paints
   DrawFlags flags;
   int transform_id = 0;
   int clip_id = 0;
@@ -65,6 +69,66 @@ struct DrawDRRectOp {
   BorderRadii outer_radii;
   std::array<float, 4> inner_rect;
   BorderRadii inner_radii;
+  DOMNodeId node_id = kInvalidDOMNodeId;  // The box it paints
+  DrawFlags flags;
+  int transform_id = 0;
+  int clip_id = 0;
+  int effect_id = 0;
+};
+
+// Save the current clip
+struct SaveOp {
+  std::string type = "SaveOp";
+  int transform_id = 0;
+  int clip_id = 0;
+  int effect_id = 0;
+};
+
+// Restore to the matching SaveOp / SaveLayerAlphaOp
+struct RestoreOp {
+  std::string type = "RestoreOp";
+  int transform_id = 0;
+  int clip_id = 0;
+  int effect_id = 0;
+};
+
+// Begin a transparency layer (one per translucent border opacity group)
+struct SaveLayerAlphaOp {
+  std::string type = "SaveLayerAlphaOp";
+  float alpha = 1.0f;
+  int transform_id = 0;
+  int clip_id = 0;
+  int effect_id = 0;
+};
+
+// Clip to (or, with difference, out of) a rounded rect
+struct ClipRRectOp {
+  std::string type = "ClipRRectOp";
+  std::array<float, 4> rect;  // [left, top, right, bottom]
+  BorderRadii radii;
+  bool difference = false;
+  bool antialias = true;
+  int transform_id = 0;
+  int clip_id = 0;
+  int effect_id = 0;
+};
+
+// Clip to a closed polygon (border side miters)
+struct ClipPathOp {
+  std::string type = "ClipPathOp";
+  std::vector<PointF> points;
+  bool difference = false;  // Clip out the polygon instead of to it
+  bool antialias = true;
+  int transform_id = 0;
+  int clip_id = 0;
+  int effect_id = 0;
+};
+
+// Fill closed polygons (mitered side quads, translucent side rects)
+struct DrawPathOp {
+  std::string type = "DrawPathOp";
+  std::vector<std::vector<PointF>> contours;
+  DOMNodeId node_id = kInvalidDOMNodeId;  // The box it paints
   DrawFlags flags;
   int transform_id = 0;
   int clip_id = 0;
@@ -72,7 +136,9 @@ struct DrawDRRectOp {
 };
 
 // Paint operation variant
-using PaintOp = std::variant<DrawRectOp, DrawRRectOp, DrawLineOp, DrawDRRectOp>;
+using PaintOp = std::variant<DrawRectOp, DrawRRectOp, DrawLineOp, DrawDRRectOp,
+                             SaveOp, RestoreOp, SaveLayerAlphaOp, ClipRRectOp,
+                             ClipPathOp, DrawPathOp>;
 
 // Container for paint operations
 class PaintOpList {
@@ -93,7 +159,32 @@ class PaintOpList {
     ops_.push_back(std::move(op));
   }
 
+  void AddSave(SaveOp op) {
+    ops_.push_back(std::move(op));
+  }
+
+  void AddRestore(RestoreOp op) {
+    ops_.push_back(std::move(op));
+  }
+
+  void AddSaveLayerAlpha(SaveLayerAlphaOp op) {
+    ops_.push_back(std::move(op));
+  }
+
+  void AddClipRRect(ClipRRectOp op) {
+    ops_.push_back(std::move(op));
+  }
+
+  void AddClipPath(ClipPathOp op) {
+    ops_.push_back(std::move(op));
+  }
+
+  void AddDrawPath(DrawPathOp op) {
+    ops_.push_back(std::move(op));
+  }
+
   const std::vector<PaintOp>& ops() const { return ops_; }
+  std::vector<PaintOp>& mutable_ops() { return ops_; }
   bool empty() const { return ops_.empty(); }
   size_t size() const { return ops_.size(); }
 
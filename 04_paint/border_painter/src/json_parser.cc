@@ -1,7 +1,13 @@
 #include "json_parser.h"
 
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace border_painter {
 namespace {
@@ -292,6 +298,93 @@ GraphicsStateIds ParseStateIds(JsonTokenizer& tok) {
   return ids;
 }
 
+AutoDarkMode ParseDarkMode(JsonTokenizer& tok) {
+  AutoDarkMode dark_mode;
+  tok.Expect('{');
+  while (tok.Peek() != '}') {
+    std::string key = tok.ReadString();
+    tok.Expect(':');
+    if (key == "enabled") {
+      dark_mode.enabled = tok.ReadBool();
+    } else {
+      tok.SkipValue();
+    }
+    if (tok.Peek() == ',') tok.Consume();
+  }
+  tok.Expect('}');
+  return dark_mode;
+}
+
+// Root-space rect with an optional "local_to_root" [a, b, c, d, e, f]
+CullRect ParseCullRect(JsonTokenizer& tok) {
+  RectF rect;
+  CullRect::Transform local_to_root = CullRect::kIdentity;
+  tok.Expect('{');
+  while (tok.Peek() != '}') {
+    std::string key = tok.ReadString();
+    tok.Expect(':');
+    if (key == "x") {
+      rect.x = static_cast<float>(tok.ReadNumber());
+    } else if (key == "y") {
+      rect.y = static_cast<float>(tok.ReadNumber());
+    } else if (key == "width") {
+      rect.width = static_cast<float>(tok.ReadNumber());
+    } else if (key == "height") {
+      rect.height = static_cast<float>(tok.ReadNumber());
+    } else if (key == "local_to_root") {
+      tok.Expect('[');
+      size_t i = 0;
+      while (tok.Peek() != ']') {
+        const float value = static_cast<float>(tok.ReadNumber());
+        if (i < local_to_root.size()) local_to_root[i++] = value;
+        if (tok.Peek() == ',') tok.Consume();
+      }
+      tok.Expect(']');
+    } else {
+      tok.SkipValue();
+    }
+    if (tok.Peek() == ',') tok.Consume();
+  }
+  tok.Expect('}');
+  return CullRect(rect, local_to_root);
+}
+
+// Superellipse parameter of a corner-shape keyword or number
+float ParseCornerShape(JsonTokenizer& tok) {
+  if (tok.Peek() != '"') {
+    return static_cast<float>(tok.ReadNumber());
+  }
+  std::string shape = tok.ReadString();
+  if (shape == "squircle") return 2.0f;
+  if (shape == "bevel") return 0.0f;
+  if (shape == "scoop") return -1.0f;
+  if (shape == "square") return std::numeric_limits<float>::infinity();
+  if (shape == "notch") return -std::numeric_limits<float>::infinity();
+  return 1.0f;  // round
+}
+
+// Either one shape for all corners or [top_left, top_right, bottom_right,
+// bottom_left]
+CornerShapes ParseCornerShapes(JsonTokenizer& tok) {
+  CornerShapes shapes;
+  if (tok.Peek() != '[') {
+    float shape = ParseCornerShape(tok);
+    shapes = {shape, shape, shape, shape};
+    return shapes;
+  }
+  float* corners[4] = {&shapes.top_left, &shapes.top_right,
+                       &shapes.bottom_right, &shapes.bottom_left};
+  tok.Expect('[');
+  size_t i = 0;
+  while (tok.Peek() != ']') {
+    float shape = ParseCornerShape(tok);
+    if (i < 4) *corners[i++] = shape;
+    if (tok.Peek() == ',') tok.Consume();
+  }
+  tok.Expect(']');
+  return shapes;
+}
+
 std::string FloatToString(float f) {
   std::ostringstream oss;
   oss.precision(10);
@@ -299,11 +392,57 @@ std::string FloatToString(float f) {
   return oss.str();
 }
 
-}  // namespace
+// Appends the dash pattern to a flags object (nothing for solid strokes)
+void SerializeDashPattern(std::ostringstream& out, const DashPattern& dash) {
+  if (!dash.has_pattern) return;
+  out << ",\n      \"dashPattern\": {\"intervals\": ["
+      << FloatToString(dash.intervals[0]) << ", "
+      << FloatToString(dash.intervals[1]) << "], \"phase\": "
+      << FloatToString(dash.phase) << "}";
+}
 
-BorderPaintInput ParseInput(const std::string& json_str) {
+// SVG path data of closed polygons: "M x y L x y ... Z"
+std::string PathToString(const std::vector<std::vector<PointF>>& contours) {
+  std::string path;
+  for (const auto& contour : contours) {
+    for (size_t i = 0; i < contour.size(); ++i) {
+      if (!path.empty()) path += ' ';
+      path += i == 0 ? "M " : "L ";
+      path += FloatToString(contour[i].x) + " " + FloatToString(contour[i].y);
+    }
+    if (!contour.empty()) path += " Z";
+  }
+  return path;
+}
+
+// [left, top, right, bottom] of the contour points, as paint.json writes
+// the bounds of a path
+std::array<float, 4> PathBounds(
+    const std::vector<std::vector<PointF>>& contours) {
+  std::array<float, 4> bounds = {0.0f, 0.0f, 0.0f, 0.0f};
+  bool first = true;
+  for (const auto& contour : contours) {
+    for (const PointF& p : contour) {
+      if (first) {
+        bounds = {p.x, p.y, p.x, p.y};
+        first = false;
+        continue;
+      }
+      bounds[0] = std::min(bounds[0], p.x);
+      bounds[1] = std::min(bounds[1], p.y);
+      bounds[2] = std::max(bounds[2], p.x);
+      bounds[3] = std::max(bounds[3], p.y);
+    }
+  }
+  return bounds;
+}
+
+// Parses one box object. When |boxes| is set, a "boxes" array of box
+// objects is parsed into it instead of being skipped.
+BorderPaintInput ParseInputObject(
+    JsonTokenizer& tok,
+    std::optional<std::vector<BorderPaintInput>>* boxes) {
   BorderPaintInput input;
-  JsonTokenizer tok(json_str);
 
   tok.Expect('{');
   while (tok.Peek() != '}') {
@@ -350,6 +489,24 @@ BorderPaintInput ParseInput(const std::string& json_str) {
       } else {
         input.render_hint = BorderRenderHint::kAuto;
       }
+    } else if (key == "dark_mode") {
+      input.dark_mode = ParseDarkMode(tok);
+    } else if (key == "corner_shapes") {
+      input.corner_shapes = ParseCornerShapes(tok);
+    } else if (key == "background_color") {
+      input.background_color = ParseColor(tok);
+    } else if (key == "device_scale_factor") {
+      input.device_scale_factor = static_cast<float>(tok.ReadNumber());
+    } else if (key == "cull_rect") {
+      input.cull_rect = ParseCullRect(tok);
+    } else if (key == "boxes" && boxes) {
+      boxes->emplace();
+      tok.Expect('[');
+      while (tok.Peek() != ']') {
+        (*boxes)->push_back(ParseInputObject(tok, nullptr));
+        if (tok.Peek() == ',') tok.Consume();
+      }
+      tok.Expect(']');
     } else {
       tok.SkipValue();
     }
@@ -361,6 +518,29 @@ BorderPaintInput ParseInput(const std::string& json_str) {
   return input;
 }
 
+}  // namespace
+
+BorderPaintInput ParseInput(const std::string& json_str) {
+  JsonTokenizer tok(json_str);
+  return ParseInputObject(tok, nullptr);
+}
+
+std::vector<BorderPaintInput> ParseDocument(const std::string& json_str) {
+  JsonTokenizer tok(json_str);
+  std::optional<std::vector<BorderPaintInput>> boxes;
+  BorderPaintInput input = ParseInputObject(tok, &boxes);
+  if (boxes) {
+    // A document-level cull rect applies to the boxes without their own
+    if (!input.cull_rect.IsInfinite()) {
+      for (BorderPaintInput& box : *boxes) {
+        if (box.cull_rect.IsInfinite()) box.cull_rect = input.cull_rect;
+      }
+    }
+    return std::move(*boxes);
+  }
+  return {std::move(input)};
+}
+
 std::string SerializeOps(const PaintOpList& ops) {
   std::ostringstream out;
   out << "[\n";
@@ -380,6 +560,7 @@ std::string SerializeOps(const PaintOpList& ops) {
             << FloatToString(arg.rect[1]) << ", "
             << FloatToString(arg.rect[2]) << ", "
             << FloatToString(arg.rect[3]) << "],\n";
+        out << "    \"nodeId\": " << arg.node_id << ",\n";
         out << "    \"flags\": {\n";
         out << "      \"r\": " << FloatToString(arg.flags.color.r) << ",\n";
         out << "      \"g\": " << FloatToString(arg.flags.color.g) << ",\n";
@@ -388,7 +569,9 @@ std::string SerializeOps(const PaintOpList& ops) {
         out << "      \"style\": " << static_cast<int>(arg.flags.style) << ",\n";
         out << "      \"strokeWidth\": " << FloatToString(arg.flags.stroke_width) << ",\n";
         out << "      \"strokeCap\": " << static_cast<int>(arg.flags.stroke_cap) << ",\n";
-        out << "      \"strokeJoin\": " << static_cast<int>(arg.flags.stroke_join) << "\n";
+        out << "      \"strokeJoin\": " << static_cast<int>(arg.flags.stroke_join);
+        SerializeDashPattern(out, arg.flags.dash_pattern);
+        out << "\n";
         out << "    },\n";
         out << "    \"transform_id\": " << arg.transform_id << ",\n";
         out << "    \"clip_id\": " << arg.clip_id << ",\n";
@@ -407,6 +590,7 @@ std::string SerializeOps(const PaintOpList& ops) {
           out << FloatToString(arg.radii[i]);
         }
         out << "],\n";
+        out << "    \"nodeId\": " << arg.node_id << ",\n";
         out << "    \"flags\": {\n";
         out << "      \"r\": " << FloatToString(arg.flags.color.r) << ",\n";
         out << "      \"g\": " << FloatToString(arg.flags.color.g) << ",\n";
@@ -415,7 +599,9 @@ std::string SerializeOps(const PaintOpList& ops) {
         out << "      \"style\": " << static_cast<int>(arg.flags.style) << ",\n";
         out << "      \"strokeWidth\": " << FloatToString(arg.flags.stroke_width) << ",\n";
         out << "      \"strokeCap\": " << static_cast<int>(arg.flags.stroke_cap) << ",\n";
-        out << "      \"strokeJoin\": " << static_cast<int>(arg.flags.stroke_join) << "\n";
+        out << "      \"strokeJoin\": " << static_cast<int>(arg.flags.stroke_join);
+        SerializeDashPattern(out, arg.flags.dash_pattern);
+        out << "\n";
         out << "    },\n";
         out << "    \"transform_id\": " << arg.transform_id << ",\n";
         out << "    \"clip_id\": " << arg.clip_id << ",\n";
@@ -428,6 +614,7 @@ std::string SerializeOps(const PaintOpList& ops) {
         out << "    \"y0\": " << FloatToString(arg.y0) << ",\n";
         out << "    \"x1\": " << FloatToString(arg.x1) << ",\n";
         out << "    \"y1\": " << FloatToString(arg.y1) << ",\n";
+        out << "    \"nodeId\": " << arg.node_id << ",\n";
         out << "    \"flags\": {\n";
         out << "      \"r\": " << FloatToString(arg.flags.color.r) << ",\n";
         out << "      \"g\": " << FloatToString(arg.flags.color.g) << ",\n";
@@ -436,7 +623,9 @@ std::string SerializeOps(const PaintOpList& ops) {
         out << "      \"style\": " << static_cast<int>(arg.flags.style) << ",\n";
         out << "      \"strokeWidth\": " << FloatToString(arg.flags.stroke_width) << ",\n";
         out << "      \"strokeCap\": " << static_cast<int>(arg.flags.stroke_cap) << ",\n";
-        out << "      \"strokeJoin\": " << static_cast<int>(arg.flags.stroke_join) << "\n";
+        out << "      \"strokeJoin\": " << static_cast<int>(arg.flags.stroke_join);
+        SerializeDashPattern(out, arg.flags.dash_pattern);
+        out << "\n";
         out << "    },\n";
         out << "    \"transform_id\": " << arg.transform_id << ",\n";
         out << "    \"clip_id\": " << arg.clip_id << ",\n";
@@ -465,6 +654,75 @@ std::string SerializeOps(const PaintOpList& ops) {
           out << FloatToString(arg.inner_radii[i]);
         }
         out << "],\n";
+        out << "    \"nodeId\": " << arg.node_id << ",\n";
+        out << "    \"flags\": {\n";
+        out << "      \"r\": " << FloatToString(arg.flags.color.r) << ",\n";
+        out << "      \"g\": " << FloatToString(arg.flags.color.g) << ",\n";
+        out << "      \"b\": " << FloatToString(arg.flags.color.b) << ",\n";
+        out << "      \"a\": " << FloatToString(arg.flags.color.a) << ",\n";
+        out << "      \"style\": " << static_cast<int>(arg.flags.style) << "\n";
+        out << "    },\n";
+        out << "    \"transform_id\": " << arg.transform_id << ",\n";
+        out << "    \"clip_id\": " << arg.clip_id << ",\n";
+        out << "    \"effect_id\": " << arg.effect_id << "\n";
+        out << "  }";
+      } else if constexpr (std::is_same_v<T, SaveOp> ||
+                           std::is_same_v<T, RestoreOp>) {
+        out << "  {\n";
+        out << "    \"type\": \"" << arg.type << "\",\n";
+        out << "    \"transform_id\": " << arg.transform_id << ",\n";
+        out << "    \"clip_id\": " << arg.clip_id << ",\n";
+        out << "    \"effect_id\": " << arg.effect_id << "\n";
+        out << "  }";
+      } else if constexpr (std::is_same_v<T, SaveLayerAlphaOp>) {
+        out << "  {\n";
+        out << "    \"type\": \"SaveLayerAlphaOp\",\n";
+        out << "    \"alpha\": " << FloatToString(arg.alpha) << ",\n";
+        out << "    \"transform_id\": " << arg.transform_id << ",\n";
+        out << "    \"clip_id\": " << arg.clip_id << ",\n";
+        out << "    \"effect_id\": " << arg.effect_id << "\n";
+        out << "  }";
+      } else if constexpr (std::is_same_v<T, ClipRRectOp>) {
+        out << "  {\n";
+        out << "    \"type\": \"ClipRRectOp\",\n";
+        out << "    \"rect\": [" << FloatToString(arg.rect[0]) << ", "
+            << FloatToString(arg.rect[1]) << ", "
+            << FloatToString(arg.rect[2]) << ", "
+            << FloatToString(arg.rect[3]) << "],\n";
+        out << "    \"radii\": [";
+        for (size_t i = 0; i < arg.radii.size(); ++i) {
+          if (i > 0) out << ", ";
+          out << FloatToString(arg.radii[i]);
+        }
+        out << "],\n";
+        // SkClipOp: 0 = difference, 1 = intersect
+        out << "    \"clipOp\": " << (arg.difference ? 0 : 1) << ",\n";
+        out << "    \"antiAlias\": " << (arg.antialias ? "true" : "false") << ",\n";
+        out << "    \"transform_id\": " << arg.transform_id << ",\n";
+        out << "    \"clip_id\": " << arg.clip_id << ",\n";
+        out << "    \"effect_id\": " << arg.effect_id << "\n";
+        out << "  }";
+      } else if constexpr (std::is_same_v<T, ClipPathOp>) {
+        out << "  {\n";
+        out << "    \"type\": \"ClipPathOp\",\n";
+        out << "    \"path\": \"" << PathToString({arg.points}) << "\",\n";
+        out << "    \"clipOp\": " << (arg.difference ? 0 : 1) << ",\n";
+        out << "    \"antiAlias\": " << (arg.antialias ? "true" : "false") << ",\n";
+        out << "    \"transform_id\": " << arg.transform_id << ",\n";
+        out << "    \"clip_id\": " << arg.clip_id << ",\n";
+        out << "    \"effect_id\": " << arg.effect_id << "\n";
+        out << "  }";
+      } else if constexpr (std::is_same_v<T, DrawPathOp>) {
+        out << "  {\n";
+        out << "    \"type\": \"DrawPathOp\",\n";
+        out << "    \"path\": \"" << PathToString(arg.contours) << "\",\n";
+        out << "    \"fillType\": 0,\n";
+        const std::array<float, 4> bounds = PathBounds(arg.contours);
+        out << "    \"bounds\": [" << FloatToString(bounds[0]) << ", "
+            << FloatToString(bounds[1]) << ", "
+            << FloatToString(bounds[2]) << ", "
+            << FloatToString(bounds[3]) << "],\n";
+        out << "    \"nodeId\": " << arg.node_id << ",\n";
         out << "    \"flags\": {\n";
         out << "      \"r\": " << FloatToString(arg.flags.color.r) << ",\n";
         out << "      \"g\": " << FloatToString(arg.flags.color.g) << ",\n";
@@ -2,6 +2,7 @@
 #define BORDER_PAINTER_JSON_PARSER_H_
 
 #include <string>
+#include <vector>
 
 #include "border_painter.h"
 #include "draw_commands.h"
@@ -11,6 +12,9 @@ namespace border_painter {
 // Parse input JSON file into BorderPaintInput
 BorderPaintInput ParseInput(const std::string& json_str);
 
+// Parse a single box, or {"boxes": [...]} painted as one document
+std::vector<BorderPaintInput> ParseDocument(const std::string& json_str);
+
 // Serialize paint operations to JSON string
 std::string SerializeOps(const PaintOpList& ops);
 
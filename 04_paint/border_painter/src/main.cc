@@ -1,9 +1,14 @@
+#include <chrono>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 
+#include "border_op_cache.h"
 #include "border_painter.h"
+#include "contoured_border_geometry.h"
 #include "json_parser.h"
 
 void PrintUsage(const char* program) {
@@ -12,11 +17,18 @@ void PrintUsage(const char* program) {
   std::cerr << "Options:\n";
   std::cerr << "  -i <file>  Input JSON file (required)\n";
   std::cerr << "  -o <file>  Output JSON file (default: stdout)\n";
+  std::cerr << "  --stats    Print op cache statistics and paint time to stderr\n";
+  std::cerr << "  --no-cache Paint every box from scratch\n";
+  std::cerr << "\n";
+  std::cerr << "Input is a single box, or {\"boxes\": [...]} painted as one"
+               " document.\n";
 }
 
 int main(int argc, char* argv[]) {
   std::string input_file;
   std::string output_file;
+  bool print_stats = false;
+  bool use_cache = true;
 
   // Parse command line arguments
   for (int i = 1; i < argc; ++i) {
@@ -25,6 +37,10 @@ int main(int argc, char* argv[]) {
       input_file = argv[++i];
     } else if (arg == "-o" && i + 1 < argc) {
       output_file = argv[++i];
+    } else if (arg == "--stats") {
+      print_stats = true;
+    } else if (arg == "--no-cache") {
+      use_cache = false;
     } else if (arg == "-h" || arg == "--help") {
       PrintUsage(argv[0]);
       return 0;
@@ -48,16 +64,44 @@ int main(int argc, char* argv[]) {
   std::string json_input = buffer.str();
 
   // Parse input
-  border_painter::BorderPaintInput input;
+  std::vector<border_painter::BorderPaintInput> inputs;
   try {
-    input = border_painter::ParseInput(json_input);
+    inputs = border_painter::ParseDocument(json_input);
   } catch (const std::exception& e) {
     std::cerr << "Error parsing input: " << e.what() << "\n";
     return 1;
   }
 
-  // Paint borders
-  auto ops = border_painter::BorderPainter::Paint(input);
+  // Paint borders for every box as one batch, sharing op templates
+  border_painter::BorderOpCache op_cache;
+  auto start = std::chrono::steady_clock::now();
+  border_painter::PaintOpList ops = border_painter::BorderPainter::PaintBatch(
+      inputs, use_cache ? &op_cache : nullptr);
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  if (print_stats) {
+    std::cerr << "boxes: " << inputs.size() << "\n";
+    if (use_cache) {
+      std::cerr << "op cache: " << op_cache.hits() << " hits, "
+                << op_cache.misses() << " misses, " << op_cache.size()
+                << " entries (" << std::fixed << std::setprecision(1)
+                << op_cache.HitRate() * 100.0 << "% hit rate)\n";
+    }
+    const auto& contour_cache =
+        border_painter::ContouredBorderGeometry::SharedPathCache();
+    if (contour_cache.hits() + contour_cache.misses() > 0) {
+      std::cerr << "contour cache: " << contour_cache.hits() << " hits, "
+                << contour_cache.misses() << " misses, "
+                << contour_cache.size() << " entries (" << std::fixed
+                << std::setprecision(1) << contour_cache.HitRate() * 100.0
+                << "% hit rate)\n";
+    }
+    std::cerr << "paint time: " << std::fixed << std::setprecision(3)
+              << elapsed.count() << " us ("
+              << (inputs.empty() ? 0.0 : elapsed.count() / inputs.size())
+              << " us/box)\n";
+  }
 
   // Serialize output
   std::string json_output = border_painter::SerializeOps(ops);
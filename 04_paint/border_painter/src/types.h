@@ -133,6 +133,11 @@ struct BorderWidths {
   bool IsZero() const {
     return top == 0.0f && right == 0.0f && bottom == 0.0f && left == 0.0f;
   }
+
+  bool operator==(const BorderWidths& other) const {
+    return top == other.top && right == other.right &&
+           bottom == other.bottom && left == other.left;
+  }
 };
 
 // Border colors for each side
@@ -145,6 +150,11 @@ struct BorderColors {
   bool IsUniform() const {
     return top == right && right == bottom && bottom == left;
   }
+
+  bool operator==(const BorderColors& other) const {
+    return top == other.top && right == other.right &&
+           bottom == other.bottom && left == other.left;
+  }
 };
 
 // Border styles for each side
@@ -162,6 +172,11 @@ struct BorderStyles {
     return top == EBorderStyle::kSolid && right == EBorderStyle::kSolid &&
            bottom == EBorderStyle::kSolid && left == EBorderStyle::kSolid;
   }
+
+  bool operator==(const BorderStyles& other) const {
+    return top == other.top && right == other.right &&
+           bottom == other.bottom && left == other.left;
+  }
 };
 
 // Border radii: [tl_x, tl_y, tr_x, tr_y, br_x, br_y, bl_x, bl_y]
@@ -175,6 +190,42 @@ inline bool IsZeroRadii(const BorderRadii& radii) {
   return true;
 }
 
+// CSS corner-shape per corner, as the superellipse() parameter K: the
+// corner curve is |x|^(2^K) + |y|^(2^K) = 1. 1 is round (the default),
+// 2 squircle, 0 bevel, -1 scoop; +inf is square and -inf notch.
+// https://drafts.csswg.org/css-borders-4/#corner-shaping
+struct CornerShapes {
+  float top_left = 1.0f;
+  float top_right = 1.0f;
+  float bottom_right = 1.0f;
+  float bottom_left = 1.0f;
+
+  bool IsRound() const {
+    return top_left == 1.0f && top_right == 1.0f && bottom_right == 1.0f &&
+           bottom_left == 1.0f;
+  }
+
+  bool operator==(const CornerShapes& other) const {
+    return top_left == other.top_left && top_right == other.top_right &&
+           bottom_right == other.bottom_right &&
+           bottom_left == other.bottom_left;
+  }
+};
+
+// How a background keeps from bleeding out of the anti-aliased outer edge
+// of a rounded border (Chromium's BackgroundBleedAvoidance)
+enum class BackgroundBleedAvoidance {
+  kNone,              // Paint normally
+  kShrinkBackground,  // Inset the background under the opaque border
+  kClipOnly,          // Clip background and border to the outer border
+  kClipLayer          // Clip to the outer border and composite in a layer
+};
+
+inline bool BleedAvoidanceIsClipping(BackgroundBleedAvoidance bleed_avoidance) {
+  return bleed_avoidance == BackgroundBleedAvoidance::kClipOnly ||
+         bleed_avoidance == BackgroundBleedAvoidance::kClipLayer;
+}
+
 // Visibility enum
 enum class Visibility {
   kVisible,
@@ -210,6 +261,11 @@ enum class StrokeJoin {
   kBevel = 2
 };
 
+// Dark mode settings
+struct AutoDarkMode {
+  bool enabled = false;
+};
+
 // Dash pattern for dashed/dotted borders
 struct DashPattern {
   float intervals[2] = {0, 0};
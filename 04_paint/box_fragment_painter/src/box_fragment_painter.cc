@@ -0,0 +1,593 @@
+// Copyright 2018 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's BoxFragmentPainter and the layer
+// order of PaintLayerPainter
+// Original: third_party/blink/renderer/core/paint/box_fragment_painter.cc
+//           third_party/blink/renderer/core/paint/paint_layer_painter.cc
+//
+// Changes from Chromium:
+// - See box_fragment_painter.h
+
+#include "box_fragment_painter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "block_painter/src/block_painter.h"
+#include "border_painter/src/border_op_cache.h"
+#include "border_painter/src/border_painter.h"
+#include "text_painter/src/text_paint_style_cache.h"
+#include "text_painter/src/text_painter.h"
+
+namespace box_fragment_painter {
+
+namespace {
+
+// The layout tree carries font sizes but no font metrics; typical Latin
+// fonts (Times, Arial) have an ascent of ~0.9em and a descent of ~0.21em
+constexpr float kAscentPerEm = 0.9f;
+constexpr float kDescentPerEm = 0.21f;
+
+enum class StepKind : uint8_t {
+  kLayer,           // PaintLayerPainter::Paint of a self-painting layer
+  kSelfBackground,  // kSelfBlockBackgroundOnly of a layer's own box
+  kPhaseRoot,       // PaintInternal of a box painting one phase
+  kDescendant,      // PaintObject of a descendant in that phase
+  kEndLayer,        // End of a layer's subsequence (with a DisplayItemCache)
+};
+
+struct PaintStep {
+  uint32_t node;
+  PaintPhase phase;
+  StepKind kind;
+};
+
+uint8_t ToByte(float normalized) {
+  return static_cast<uint8_t>(
+      std::lround(std::clamp(normalized, 0.0f, 1.0f) * 255.0f));
+}
+
+block_painter::Color ToBlockColor(const Color& color) {
+  return block_painter::Color::FromNormalized(color.r, color.g, color.b,
+                                              color.a);
+}
+
+text_painter::Color ToTextColor(const Color& color) {
+  return {ToByte(color.r), ToByte(color.g), ToByte(color.b), ToByte(color.a)};
+}
+
+class PhaseWalker {
+ public:
+  PhaseWalker(const FragmentTree& tree, const PaintOptions& options,
+              PaintStats* stats, DisplayItemCache* cache)
+      : tree_(tree), options_(options), stats_(stats), cache_(cache) {
+    if (cache_) {
+      InputHasher hasher;
+      hasher.Add(options_.dark_mode);
+      hasher.Add(options_.cull_rect.has_value());
+      if (options_.cull_rect) {
+        AddRect(hasher, *options_.cull_rect);
+      }
+      options_hash_ = hasher.Hash();
+    }
+  }
+
+  DisplayItemList Run() {
+    if (tree_.root != kNoNode) {
+      stack_.push_back({tree_.root, PaintPhase::kBlockBackground,
+                        StepKind::kLayer});
+    }
+    while (!stack_.empty()) {
+      if (stats_) {
+        stats_->max_stack_depth =
+            std::max(stats_->max_stack_depth, stack_.size());
+      }
+      const PaintStep step = stack_.back();
+      stack_.pop_back();
+      switch (step.kind) {
+        case StepKind::kLayer:
+          PushLayer(step.node);
+          break;
+        case StepKind::kPhaseRoot:
+          PaintPhaseRoot(step.node, step.phase);
+          break;
+        case StepKind::kSelfBackground:
+          Visit();
+          PaintBoxDecorationBackground(step.node, step.phase);
+          break;
+        case StepKind::kDescendant:
+          PaintDescendant(step.node, step.phase);
+          break;
+        case StepKind::kEndLayer:
+          cache_->EndSubsequence(open_subsequences_.back(), items_.size());
+          open_subsequences_.pop_back();
+          break;
+      }
+    }
+    if (stats_) {
+      stats_->layers = tree_.layers.size();
+    }
+    if (cache_) {
+      cache_->Commit(items_.items());
+    }
+    return std::move(items_);
+  }
+
+ private:
+  // Steps are popped in reverse push order, so everything is pushed last
+  // step first
+
+  // PaintLayerPainter: own block background (kSelfBlockBackgroundOnly),
+  // negative z-order children, the descendants' phases, normal flow
+  // children, positive z-order children (CSS 2.1 Appendix E)
+  void PushLayer(uint32_t node) {
+    if (cache_) {
+      // SubsequenceRecorder: a layer with nothing changed in it paints what
+      // it painted last time
+      const FragmentNode& fragment = tree_.nodes[node];
+      const int64_t id = tree_.data[node].id;
+      if (!fragment.Has(FragmentNode::kNeedsRepaint) &&
+          !fragment.Has(FragmentNode::kDescendantNeedsRepaint)) {
+        if (const DisplayItemCache::Subsequence* cached =
+                cache_->LookupSubsequence(id, options_hash_)) {
+          UseCachedSubsequence(*cached);
+          return;
+        }
+      }
+      if (stats_) {
+        ++stats_->subsequences_painted;
+      }
+      open_subsequences_.push_back(
+          cache_->BeginSubsequence(id, options_hash_, items_.size()));
+      stack_.push_back({node, PaintPhase::kBlockBackground,
+                        StepKind::kEndLayer});
+    }
+    const PaintLayerLists& lists = tree_.layers[tree_.layer_index[node]];
+    PushLayers(lists.pos_z_order);
+    PushLayers(lists.normal_flow);
+    PushAllPhases(node, /*paint_self_background=*/false);
+    PushLayers(lists.neg_z_order);
+    stack_.push_back(
+        {node, PaintPhase::kBlockBackground, StepKind::kSelfBackground});
+  }
+
+  void PushLayers(const std::vector<uint32_t>& layers) {
+    for (auto it = layers.rbegin(); it != layers.rend(); ++it) {
+      stack_.push_back({*it, PaintPhase::kBlockBackground, StepKind::kLayer});
+    }
+  }
+
+  // PaintAllPhasesAtomically. A layer has painted its own background
+  // before its negative z-order children; its kBlockBackground phase then
+  // only paints the descendants (kDescendantBlockBackgroundsOnly).
+  void PushAllPhases(uint32_t node, bool paint_self_background = true) {
+    stack_.push_back({node, PaintPhase::kForeground, StepKind::kPhaseRoot});
+    stack_.push_back({node, PaintPhase::kFloat, StepKind::kPhaseRoot});
+    if (paint_self_background) {
+      stack_.push_back(
+          {node, PaintPhase::kBlockBackground, StepKind::kPhaseRoot});
+    } else {
+      PushChildren(node, PaintPhase::kBlockBackground);
+    }
+  }
+
+  void PushChildren(uint32_t node, PaintPhase phase) {
+    const FragmentNode& fragment = tree_.nodes[node];
+    for (uint32_t i = fragment.child_count; i > 0; --i) {
+      stack_.push_back({tree_.children[fragment.first_child + i - 1], phase,
+                        StepKind::kDescendant});
+    }
+  }
+
+  // The box itself paints its decoration in the block background phase,
+  // whatever it is (a layer, a float or an atomic item)
+  void PaintPhaseRoot(uint32_t node, PaintPhase phase) {
+    Visit();
+    if (phase == PaintPhase::kBlockBackground) {
+      PaintBoxDecorationBackground(node, phase);
+    }
+    PushChildren(node, phase);
+  }
+
+  void PaintDescendant(uint32_t node, PaintPhase phase) {
+    Visit();
+    const FragmentNode& fragment = tree_.nodes[node];
+    // PaintBlockChildren / PaintLineBoxes skip self-painting layers
+    if (fragment.Has(FragmentNode::kSelfPaintingLayer)) {
+      return;
+    }
+    // Floats only paint in the float phase, all phases at once
+    if (fragment.IsFloating()) {
+      if (phase == PaintPhase::kFloat) {
+        PushAllPhases(node);
+      }
+      return;
+    }
+    // Atomic items only paint in the foreground phase, all phases at once
+    if (fragment.Has(FragmentNode::kPaintedAtomically)) {
+      if (phase == PaintPhase::kForeground) {
+        PushAllPhases(node);
+      }
+      return;
+    }
+
+    if (phase == PaintPhase::kBlockBackground) {
+      PaintBoxDecorationBackground(node, phase);
+    } else if (phase == PaintPhase::kForeground &&
+               fragment.Has(FragmentNode::kIsText)) {
+      PaintText(node, phase);
+    }
+    PushChildren(node, phase);
+  }
+
+  // Background and box shadows, then the border. A bordered box without
+  // shadows paints both as one decoration (BoxDecorationPainter), so the
+  // background can avoid bleeding under the border; outer shadows are a
+  // looper on the background fill, so a box with shadows keeps its
+  // background in BlockPainter.
+  void PaintBoxDecorationBackground(uint32_t node, PaintPhase phase) {
+    const FragmentNode& fragment = tree_.nodes[node];
+    if (!fragment.Has(FragmentNode::kHasGeometry) ||
+        !fragment.Has(FragmentNode::kVisible)) {
+      return;
+    }
+    const FragmentData& data = tree_.data[node];
+    std::optional<DisplayItemCache::Key> key;
+    if (cache_) {
+      key = DisplayItemCache::Key{data.id, phase, BoxDecorationHash(data)};
+      if (UseCachedItems(node, *key)) {
+        return;
+      }
+    }
+    const size_t first_item = items_.size();
+    const RectF& g = data.geometry;
+
+    const bool has_outer_shadow = std::any_of(
+        data.box_shadow.begin(), data.box_shadow.end(),
+        [](const BoxShadow& shadow) { return !shadow.inset; });
+    const bool has_inset_shadow = std::any_of(
+        data.box_shadow.begin(), data.box_shadow.end(),
+        [](const BoxShadow& shadow) { return shadow.inset; });
+    const bool paints_background =
+        data.background_color &&
+        (data.background_color->a > 0.0f || has_outer_shadow);
+    const bool paints_border = data.HasBorder();
+    const bool combined =
+        paints_background && paints_border && data.box_shadow.empty();
+    if (!combined && (paints_background || has_inset_shadow)) {
+      block_painter::BlockPaintInput input;
+      input.geometry = {g.x, g.y, g.width, g.height};
+      input.border_radii = data.border_radii;
+      if (paints_background) {
+        input.background_color = ToBlockColor(*data.background_color);
+      }
+      input.border_widths = data.border_widths;
+      for (const BoxShadow& shadow : data.box_shadow) {
+        block_painter::BoxShadowData box_shadow;
+        box_shadow.offset_x = shadow.offset_x;
+        box_shadow.offset_y = shadow.offset_y;
+        box_shadow.blur = shadow.blur;
+        box_shadow.spread = shadow.spread;
+        box_shadow.inset = shadow.inset;
+        box_shadow.color = ToBlockColor(shadow.color);
+        input.box_shadow.push_back(box_shadow);
+      }
+      input.node_id = data.id;
+      input.dark_mode.enabled = options_.dark_mode;
+      if (options_.cull_rect) {
+        const RectF& cull = *options_.cull_rect;
+        input.cull_rect = block_painter::CullRect(
+            {cull.x, cull.y, cull.width, cull.height});
+      }
+      Record(node, phase, DisplayItemType::kBoxDecorationBackground,
+             block_painter::BlockPainter::Paint(input));
+    }
+
+    if (paints_border) {
+      border_painter::BorderPaintInput input;
+      input.geometry = {g.x, g.y, g.width, g.height};
+      input.border_widths = {data.border_widths[0], data.border_widths[1],
+                             data.border_widths[2], data.border_widths[3]};
+      border_painter::Color colors[4];
+      border_painter::EBorderStyle styles[4];
+      for (size_t side = 0; side < 4; ++side) {
+        const Color& c = data.border_colors[side];
+        colors[side] = {c.r, c.g, c.b, c.a};
+        styles[side] =
+            static_cast<border_painter::EBorderStyle>(data.border_styles[side]);
+      }
+      input.border_colors = {colors[0], colors[1], colors[2], colors[3]};
+      input.border_styles = border_painter::BorderStyles{
+          styles[0], styles[1], styles[2], styles[3]};
+      input.border_radii = data.border_radii;
+      if (combined) {
+        const Color& c = *data.background_color;
+        input.background_color = border_painter::Color{c.r, c.g, c.b, c.a};
+      }
+      input.node_id = data.id;
+      input.dark_mode.enabled = options_.dark_mode;
+      if (options_.cull_rect) {
+        const RectF& cull = *options_.cull_rect;
+        input.cull_rect = border_painter::CullRect(
+            {cull.x, cull.y, cull.width, cull.height});
+      }
+      // BorderPainter hands a box with a background to BoxDecorationPainter
+      Record(node, phase,
+             combined ? DisplayItemType::kBoxDecorationBackground
+                      : DisplayItemType::kBorder,
+             border_painter::BorderPainter::Paint(input, &border_cache_));
+    }
+    if (key) {
+      StoreItems(*key, first_item);
+    }
+  }
+
+  // PaintLineBoxes / PaintTextItem: one TextPainter call per fragment
+  void PaintText(uint32_t node, PaintPhase phase) {
+    if (!tree_.nodes[node].Has(FragmentNode::kVisible)) {
+      return;
+    }
+    const FragmentData& data = tree_.data[node];
+    const PointF& origin = tree_.containing_block_origin[node];
+    std::optional<DisplayItemCache::Key> key;
+    if (cache_) {
+      key = DisplayItemCache::Key{data.id, phase, TextHash(data, origin)};
+      if (UseCachedItems(node, *key)) {
+        return;
+      }
+    }
+    const size_t first_item = items_.size();
+    const float ascent = data.font.size * kAscentPerEm;
+    const float descent = data.font.size * kDescentPerEm;
+    const text_painter::Color color =
+        data.color ? ToTextColor(*data.color) : text_painter::Color::Black();
+
+    for (uint32_t i = 0; i < data.text_fragment_count; ++i) {
+      const TextFragment& fragment =
+          tree_.text_fragments[data.first_text_fragment + i];
+      if (fragment.run_count == 0 || fragment.start >= fragment.end) {
+        continue;
+      }
+
+      text_painter::TextPaintInput input;
+      input.fragment.text = data.text;
+      input.fragment.from = fragment.start;
+      input.fragment.to = fragment.end;
+      text_painter::ShapeResult& shape = input.fragment.shape_result;
+      for (uint32_t r = 0; r < fragment.run_count; ++r) {
+        const TextRun& run = tree_.runs[fragment.first_run + r];
+        text_painter::GlyphRun glyph_run;
+        glyph_run.font.family = data.font.family;
+        glyph_run.font.size = data.font.size;
+        glyph_run.font.weight = data.font.weight;
+        glyph_run.font.slant = data.font.italic ? 1 : 0;
+        glyph_run.font.ascent = ascent;
+        glyph_run.font.descent = descent;
+        glyph_run.glyphs = run.glyphs;
+        glyph_run.positions = run.positions;
+        glyph_run.positioning = run.positioning;
+        shape.runs.push_back(std::move(glyph_run));
+      }
+      shape.bounds = {0.0f, -ascent, fragment.rect.width, ascent + descent};
+
+      // The line box height is split evenly above and below the font's
+      // content area (half-leading)
+      const float half_leading =
+          (fragment.rect.height - (ascent + descent)) / 2.0f;
+      input.box = {origin.x + fragment.rect.x,
+                   origin.y + fragment.rect.y + half_leading,
+                   fragment.rect.width, ascent + descent};
+      input.style.current_color = color;
+      input.style.fill_color = color;
+      input.style.stroke_color = color;
+      input.style.emphasis_mark_color = color;
+      input.node_id = data.id;
+      input.dark_mode.enabled = options_.dark_mode;
+      if (options_.cull_rect) {
+        const RectF& cull = *options_.cull_rect;
+        input.cull_rect = text_painter::CullRect(
+            {cull.x, cull.y, cull.width, cull.height});
+      }
+      Record(node, phase, DisplayItemType::kText,
+             text_painter::TextPainter::Paint(input, &style_cache_));
+    }
+    if (key) {
+      StoreItems(*key, first_item);
+    }
+  }
+
+  // Everything PaintBoxDecorationBackground reads, and the options
+  uint64_t BoxDecorationHash(const FragmentData& data) const {
+    InputHasher hasher(options_hash_);
+    AddRect(hasher, data.geometry);
+    hasher.Add(data.background_color.has_value());
+    if (data.background_color) {
+      AddColor(hasher, *data.background_color);
+    }
+    hasher.Add(static_cast<uint64_t>(data.box_shadow.size()));
+    for (const BoxShadow& shadow : data.box_shadow) {
+      hasher.Add(shadow.offset_x);
+      hasher.Add(shadow.offset_y);
+      hasher.Add(shadow.blur);
+      hasher.Add(shadow.spread);
+      hasher.Add(shadow.inset);
+      AddColor(hasher, shadow.color);
+    }
+    for (size_t side = 0; side < 4; ++side) {
+      hasher.Add(data.border_widths[side]);
+      AddColor(hasher, data.border_colors[side]);
+      hasher.Add(static_cast<uint32_t>(data.border_styles[side]));
+    }
+    hasher.Add(data.border_radii.has_value());
+    if (data.border_radii) {
+      for (float radius : *data.border_radii) {
+        hasher.Add(radius);
+      }
+    }
+    return hasher.Hash();
+  }
+
+  // Everything PaintText reads, and the options
+  uint64_t TextHash(const FragmentData& data, const PointF& origin) const {
+    InputHasher hasher(options_hash_);
+    hasher.Add(data.text);
+    hasher.Add(data.font.family);
+    hasher.Add(data.font.size);
+    hasher.Add(data.font.weight);
+    hasher.Add(data.font.italic);
+    hasher.Add(data.color.has_value());
+    if (data.color) {
+      AddColor(hasher, *data.color);
+    }
+    hasher.Add(origin.x);
+    hasher.Add(origin.y);
+    hasher.Add(data.text_fragment_count);
+    for (uint32_t i = 0; i < data.text_fragment_count; ++i) {
+      const TextFragment& fragment =
+          tree_.text_fragments[data.first_text_fragment + i];
+      AddRect(hasher, fragment.rect);
+      hasher.Add(fragment.start);
+      hasher.Add(fragment.end);
+      hasher.Add(fragment.run_count);
+      for (uint32_t r = 0; r < fragment.run_count; ++r) {
+        const TextRun& run = tree_.runs[fragment.first_run + r];
+        hasher.AddBytes(run.glyphs);
+        hasher.AddBytes(run.positions);
+        hasher.Add(run.positioning);
+      }
+    }
+    return hasher.Hash();
+  }
+
+  static void AddRect(InputHasher& hasher, const RectF& rect) {
+    hasher.Add(rect.x);
+    hasher.Add(rect.y);
+    hasher.Add(rect.width);
+    hasher.Add(rect.height);
+  }
+
+  static void AddColor(InputHasher& hasher, const Color& color) {
+    hasher.Add(color.r);
+    hasher.Add(color.g);
+    hasher.Add(color.b);
+    hasher.Add(color.a);
+  }
+
+  // Appends the cached items of |key|, now painted by |node| (its index
+  // may have moved in a new tree)
+  bool UseCachedItems(uint32_t node, const DisplayItemCache::Key& key) {
+    const DisplayItemCache::Range* cached = cache_->Lookup(key);
+    if (!cached) {
+      if (stats_) {
+        ++stats_->cache_misses;
+      }
+      return false;
+    }
+    if (stats_) {
+      ++stats_->cache_hits;
+    }
+    const size_t first_item = items_.size();
+    const std::vector<DisplayItem>& previous = cache_->previous_items();
+    for (size_t i = cached->begin; i < cached->end; ++i) {
+      DisplayItem item = previous[i];
+      item.node = node;
+      CountItem(item);
+      items_.Append(std::move(item));
+    }
+    StoreItems(key, first_item);
+    return true;
+  }
+
+  // Records the items painted since |first_item| for |key| (none is a
+  // valid entry: the node paints nothing)
+  void StoreItems(const DisplayItemCache::Key& key, size_t first_item) {
+    cache_->Store(key, {first_item, items_.size()});
+  }
+
+  void UseCachedSubsequence(const DisplayItemCache::Subsequence& cached) {
+    const size_t first_item = items_.size();
+    std::vector<DisplayItem>& items = items_.mutable_items();
+    cache_->CopySubsequence(cached, items);
+    if (stats_) {
+      ++stats_->subsequences_reused;
+    }
+    for (size_t i = first_item; i < items.size(); ++i) {
+      DisplayItem& item = items[i];
+      // Node indices move when a new tree inserts or removes nodes
+      if (item.node >= tree_.nodes.size() ||
+          tree_.data[item.node].id != item.node_id) {
+        item.node = IndexOf(item.node_id);
+      }
+      CountItem(item);
+    }
+  }
+
+  uint32_t IndexOf(int64_t id) {
+    if (index_of_.empty()) {
+      index_of_.reserve(tree_.data.size());
+      for (size_t i = 0; i < tree_.data.size(); ++i) {
+        index_of_.emplace(tree_.data[i].id, static_cast<uint32_t>(i));
+      }
+    }
+    auto it = index_of_.find(id);
+    return it == index_of_.end() ? kNoNode : it->second;
+  }
+
+  void CountItem(const DisplayItem& item) {
+    if (stats_) {
+      ++stats_->items_per_phase[static_cast<size_t>(item.phase)];
+    }
+  }
+
+  template <typename OpList>
+  void Record(uint32_t node, PaintPhase phase, DisplayItemType type,
+              OpList ops) {
+    DisplayItem item;
+    item.node = node;
+    item.node_id = tree_.data[node].id;
+    item.phase = phase;
+    item.type = type;
+    item.ops = std::move(ops);
+    if (item.OpCount() == 0) {
+      return;
+    }
+    CountItem(item);
+    items_.Append(std::move(item));
+  }
+
+  void Visit() {
+    if (stats_) {
+      ++stats_->nodes_visited;
+    }
+  }
+
+  const FragmentTree& tree_;
+  const PaintOptions& options_;
+  PaintStats* stats_;
+  DisplayItemCache* cache_;
+  uint64_t options_hash_ = 0;
+  std::vector<size_t> open_subsequences_;
+  std::unordered_map<int64_t, uint32_t> index_of_;  // Built on first use
+  std::vector<PaintStep> stack_;
+  DisplayItemList items_;
+  border_painter::BorderOpCache border_cache_;
+  text_painter::TextPaintStyleCache style_cache_;
+};
+
+}  // namespace
+
+DisplayItemList BoxFragmentPainter::Paint(const FragmentTree& tree,
+                                          const PaintOptions& options,
+                                          PaintStats* stats,
+                                          DisplayItemCache* cache) {
+  return PhaseWalker(tree, options, stats, cache).Run();
+}
+
+}  // namespace box_fragment_painter
@@ -0,0 +1,95 @@
+// Copyright 2018 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's BoxFragmentPainter and the layer
+// order of PaintLayerPainter
+// Original: third_party/blink/renderer/core/paint/box_fragment_painter.h
+//           third_party/blink/renderer/core/paint/paint_layer_painter.h
+//
+// Changes from Chromium:
+// - Paints a whole document from the shaped layout tree instead of one
+//   fragment per call; box decorations go to BlockPainter (background and
+//   box shadows) and BorderPainter, or to BoxDecorationPainter when a
+//   bordered box has a background and no shadows; text fragments go to
+//   TextPainter
+// - Phases: kBlockBackground, kFloat and kForeground (PaintPhase subset).
+//   No outlines, masks, carets, selection or overflow controls: the layout
+//   tree has no data for them
+// - The recursion of Paint / PaintObject / PaintBlockChildren /
+//   PaintAllPhasesAtomically / PaintLayerPainter::PaintChildren is an
+//   explicit stack of paint steps, so the depth of the DOM does not grow
+//   the call stack
+// - Layers paint their own block background, their negative z-order list,
+//   their descendants' content, their non-stacked (normal flow) child
+//   layers, then the positive z-order list; no property tree state, clips
+//   or effects (state ids stay 0)
+// - With a DisplayItemCache, a node whose painter input hashes the same as
+//   in the previous paint reuses its items instead of calling the painter
+//   (DrawingRecorder::UseCachedDrawingIfPossible), and a self-painting
+//   layer with no repaint marked in its subtree copies its whole previous
+//   item range without being walked
+//   (SubsequenceRecorder::UseCachedSubsequenceIfPossible)
+
+#ifndef BOX_FRAGMENT_PAINTER_BOX_FRAGMENT_PAINTER_H_
+#define BOX_FRAGMENT_PAINTER_BOX_FRAGMENT_PAINTER_H_
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+#include "display_item_cache.h"
+#include "display_item_list.h"
+#include "fragment_tree.h"
+
+namespace box_fragment_painter {
+
+struct PaintOptions {
+  bool dark_mode = false;  // AutoDarkMode for every painter
+  // Root-space cull rect (e.g. the viewport); painters skip what misses it
+  std::optional<RectF> cull_rect;
+};
+
+struct PaintStats {
+  size_t nodes_visited = 0;
+  size_t layers = 0;
+  size_t max_stack_depth = 0;
+  std::array<size_t, kPaintPhaseCount> items_per_phase = {};
+  // Painter calls served from / missing the DisplayItemCache
+  size_t cache_hits = 0;
+  size_t cache_misses = 0;
+  // Layers spliced from / painted into the DisplayItemCache
+  size_t subsequences_reused = 0;
+  size_t subsequences_painted = 0;
+};
+
+// Walks the paint phases of a fragment tree:
+//
+// - Each self-painting layer paints its own box decoration, then its
+//   negative z-order layers, then its descendants in phases, then its
+//   normal flow and positive z-order layers
+// - kBlockBackground paints the box decorations of the layer's block-level
+//   descendants in tree order
+// - kFloat paints floats (all phases at once)
+// - kForeground paints text fragments, and atomic inlines, flex items and
+//   grid items with all their phases at once
+//
+// Descendants that are self-painting layers are left to their layer.
+//
+// With a |cache|, a self-painting layer whose node and descendants are not
+// marked by FragmentTree::SetNeedsRepaint reuses its previous subsequence;
+// in the others, each box decoration and text node is looked up by its id,
+// phase and a hash of its painter input first. The cache then holds this
+// paint's items for the next one. Whoever changes the tree between paints
+// must mark what changed (see InvalidatePaint).
+class BoxFragmentPainter {
+ public:
+  static DisplayItemList Paint(const FragmentTree& tree,
+                               const PaintOptions& options = {},
+                               PaintStats* stats = nullptr,
+                               DisplayItemCache* cache = nullptr);
+};
+
+}  // namespace box_fragment_painter
+
+#endif  // BOX_FRAGMENT_PAINTER_BOX_FRAGMENT_PAINTER_H_
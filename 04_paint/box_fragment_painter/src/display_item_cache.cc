@@ -0,0 +1,133 @@
+#include "display_item_cache.h"
+
+#include <utility>
+
+namespace box_fragment_painter {
+
+void InputHasher::Add(const std::string& value) {
+  Add(static_cast<uint64_t>(value.size()));
+  AddRaw(value.data(), value.size());
+}
+
+void InputHasher::AddRaw(const void* data, size_t size) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    Add(word);
+  }
+  uint64_t tail = 0;
+  std::memcpy(&tail, bytes + i, size - i);
+  Add(tail);
+}
+
+uint64_t InputHasher::Hash() const {
+  // Final avalanche (splitmix64)
+  uint64_t h = hash_;
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ull;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebull;
+  h ^= h >> 31;
+  return h;
+}
+
+size_t DisplayItemCache::KeyHash::operator()(const Key& key) const {
+  InputHasher hasher(key.input_hash);
+  hasher.Add(key.node_id);
+  hasher.Add(static_cast<uint32_t>(key.phase));
+  return static_cast<size_t>(hasher.Hash());
+}
+
+const DisplayItemCache::Range* DisplayItemCache::Lookup(
+    const Key& key) const {
+  auto it = previous_.entry_index.find(key);
+  if (it == previous_.entry_index.end()) {
+    return nullptr;
+  }
+  return &previous_.entries[it->second].second;
+}
+
+const DisplayItemCache::Subsequence* DisplayItemCache::LookupSubsequence(
+    int64_t layer_id, uint64_t options_hash) const {
+  auto it = previous_.subsequence_index.find(layer_id);
+  if (it == previous_.subsequence_index.end()) {
+    return nullptr;
+  }
+  const Subsequence& subsequence = previous_.subsequences[it->second];
+  return subsequence.options_hash == options_hash ? &subsequence : nullptr;
+}
+
+void DisplayItemCache::Store(const Key& key, Range items) {
+  current_.entry_index.emplace(key, current_.entries.size());
+  current_.entries.emplace_back(key, items);
+}
+
+size_t DisplayItemCache::BeginSubsequence(int64_t layer_id,
+                                          uint64_t options_hash,
+                                          size_t item) {
+  const size_t index = current_.subsequences.size();
+  Subsequence subsequence;
+  subsequence.layer_id = layer_id;
+  subsequence.options_hash = options_hash;
+  subsequence.items = {item, item};
+  subsequence.entries = {current_.entries.size(), current_.entries.size()};
+  subsequence.subsequences = {index + 1, index + 1};
+  current_.subsequence_index.emplace(layer_id, index);
+  current_.subsequences.push_back(subsequence);
+  return index;
+}
+
+void DisplayItemCache::EndSubsequence(size_t subsequence, size_t item) {
+  Subsequence& ended = current_.subsequences[subsequence];
+  ended.items.end = item;
+  ended.entries.end = current_.entries.size();
+  ended.subsequences.end = current_.subsequences.size();
+}
+
+void DisplayItemCache::CopySubsequence(const Subsequence& subsequence,
+                                       std::vector<DisplayItem>& items) {
+  const std::vector<DisplayItem>& previous_items = previous_.items;
+  items.insert(items.end(),
+               previous_items.begin() + subsequence.items.begin,
+               previous_items.begin() + subsequence.items.end);
+
+  // Everything recorded inside the subsequence moves by the same offsets
+  const size_t new_item = items.size() - subsequence.items.size();
+  auto move_items = [&](Range range) {
+    return Range{range.begin - subsequence.items.begin + new_item,
+                 range.end - subsequence.items.begin + new_item};
+  };
+  const size_t new_entry = current_.entries.size();
+  const size_t new_subsequence = current_.subsequences.size();
+
+  for (size_t i = subsequence.entries.begin; i < subsequence.entries.end;
+       ++i) {
+    const auto& [key, range] = previous_.entries[i];
+    Store(key, move_items(range));
+  }
+  // The subsequence itself, then the ones nested in it
+  for (size_t i = subsequence.subsequences.begin - 1;
+       i < subsequence.subsequences.end; ++i) {
+    Subsequence moved = previous_.subsequences[i];
+    moved.items = move_items(moved.items);
+    moved.entries = {
+        moved.entries.begin - subsequence.entries.begin + new_entry,
+        moved.entries.end - subsequence.entries.begin + new_entry};
+    const size_t first = subsequence.subsequences.begin - 1;
+    moved.subsequences = {moved.subsequences.begin - first + new_subsequence,
+                          moved.subsequences.end - first + new_subsequence};
+    current_.subsequence_index.emplace(moved.layer_id,
+                                       current_.subsequences.size());
+    current_.subsequences.push_back(moved);
+  }
+}
+
+void DisplayItemCache::Commit(const std::vector<DisplayItem>& items) {
+  current_.items = items;
+  previous_ = std::move(current_);
+  current_ = Artifact();
+}
+
+}  // namespace box_fragment_painter
@@ -0,0 +1,152 @@
+// Box Fragment Painter Display Item Cache
+// The display items of the previous paint, reused for nodes whose paint
+// input has not changed (DrawingRecorder::UseCachedDrawingIfPossible)
+
+#ifndef BOX_FRAGMENT_PAINTER_DISPLAY_ITEM_CACHE_H_
+#define BOX_FRAGMENT_PAINTER_DISPLAY_ITEM_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "display_item_list.h"
+
+namespace box_fragment_painter {
+
+// 64-bit hash of a painter's input, fed field by field. Floats are hashed
+// by bit pattern, so any change to a value misses.
+class InputHasher {
+ public:
+  explicit InputHasher(uint64_t seed = 0) : hash_(seed ^ kOffset) {}
+
+  void Add(uint64_t value) {
+    hash_ ^= value + kGolden + (hash_ << 6) + (hash_ >> 2);
+    hash_ *= kPrime;
+  }
+  void Add(int64_t value) { Add(static_cast<uint64_t>(value)); }
+  void Add(uint32_t value) { Add(static_cast<uint64_t>(value)); }
+  void Add(int value) { Add(static_cast<uint64_t>(value)); }
+  void Add(bool value) { Add(static_cast<uint64_t>(value)); }
+  void Add(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    Add(bits);
+  }
+  void Add(const std::string& value);
+  template <typename T>
+  void AddBytes(const std::vector<T>& values) {
+    Add(static_cast<uint64_t>(values.size()));
+    AddRaw(values.data(), values.size() * sizeof(T));
+  }
+
+  uint64_t Hash() const;
+
+ private:
+  void AddRaw(const void* data, size_t size);
+
+  static constexpr uint64_t kOffset = 0xcbf29ce484222325ull;
+  static constexpr uint64_t kPrime = 0x100000001b3ull;
+  static constexpr uint64_t kGolden = 0x9e3779b97f4a7c15ull;
+
+  uint64_t hash_;
+};
+
+// The previous paint's display items (its artifact), with the range of
+// items each node painted, keyed by (node id, paint phase, input hash), and
+// the range each self-painting layer painted (its subsequence).
+//
+// A paint looks items up in the previous artifact and records the new one
+// as it goes; Commit makes the new artifact the previous one, so entries
+// the paint did not reach (nodes removed or changed) are gone.
+class DisplayItemCache {
+ public:
+  struct Key {
+    int64_t node_id = 0;
+    PaintPhase phase = PaintPhase::kForeground;
+    uint64_t input_hash = 0;
+
+    bool operator==(const Key& other) const {
+      return node_id == other.node_id && phase == other.phase &&
+             input_hash == other.input_hash;
+    }
+  };
+
+  // [begin, end) into an artifact's items
+  struct Range {
+    size_t begin = 0;
+    size_t end = 0;
+
+    size_t size() const { return end - begin; }
+  };
+
+  // A layer's items, with the node entries and nested subsequences recorded
+  // while it painted, as ranges of the artifact's lists
+  struct Subsequence {
+    int64_t layer_id = 0;
+    uint64_t options_hash = 0;
+    Range items;
+    Range entries;
+    Range subsequences;
+  };
+
+  const std::vector<DisplayItem>& previous_items() const {
+    return previous_.items;
+  }
+
+  // The items of the previous paint cached for |key| (possibly none: the
+  // node painted nothing), or nullptr
+  const Range* Lookup(const Key& key) const;
+
+  // The subsequence the layer |layer_id| painted with the same options in
+  // the previous paint, or nullptr
+  const Subsequence* LookupSubsequence(int64_t layer_id,
+                                       uint64_t options_hash) const;
+
+  // Records that |key| painted |items| of the new artifact
+  void Store(const Key& key, Range items);
+
+  // Bracket the steps of a layer painted into the new artifact; |item| is
+  // the size of the new item list
+  size_t BeginSubsequence(int64_t layer_id, uint64_t options_hash,
+                          size_t item);
+  void EndSubsequence(size_t subsequence, size_t item);
+
+  // Appends the items of a previous subsequence to |items| (the new
+  // artifact) with one range copy, and carries its node entries and nested
+  // subsequences over (SubsequenceRecorder::UseCachedSubsequenceIfPossible)
+  void CopySubsequence(const Subsequence& subsequence,
+                       std::vector<DisplayItem>& items);
+
+  // Ends a paint: |items| becomes the previous artifact, like
+  // PaintController::CommitNewDisplayItems
+  void Commit(const std::vector<DisplayItem>& items);
+
+  size_t size() const { return previous_.entries.size(); }
+  size_t subsequence_count() const { return previous_.subsequences.size(); }
+
+ private:
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  struct Artifact {
+    std::vector<DisplayItem> items;
+    // In paint order; a key painted twice (duplicate ids) keeps the first
+    std::vector<std::pair<Key, Range>> entries;
+    std::unordered_map<Key, size_t, KeyHash> entry_index;
+    // In pre-order, so nested subsequences follow their layer's
+    std::vector<Subsequence> subsequences;
+    std::unordered_map<int64_t, size_t> subsequence_index;
+  };
+
+  Artifact previous_;
+  Artifact current_;
+};
+
+}  // namespace box_fragment_painter
+
+#endif  // BOX_FRAGMENT_PAINTER_DISPLAY_ITEM_CACHE_H_
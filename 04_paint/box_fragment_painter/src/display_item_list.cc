@@ -0,0 +1,84 @@
+#include "display_item_list.h"
+
+#include <type_traits>
+
+#include "block_painter/src/json_parser.h"
+#include "border_painter/src/json_parser.h"
+#include "text_painter/src/json_parser.h"
+
+namespace box_fragment_painter {
+
+namespace {
+
+// The painters serialize "[\n" op ",\n" op ... "\n]"; append the ops only
+void AppendSerializedOps(const std::string& array, std::string& out) {
+  const size_t begin = array.find('\n');
+  const size_t end = array.rfind("\n]");
+  if (begin == std::string::npos || end == std::string::npos ||
+      end <= begin + 1) {
+    return;
+  }
+  if (!out.empty()) {
+    out += ",\n";
+  }
+  out.append(array, begin + 1, end - begin - 1);
+}
+
+}  // namespace
+
+const char* PaintPhaseName(PaintPhase phase) {
+  switch (phase) {
+    case PaintPhase::kBlockBackground:
+      return "block background";
+    case PaintPhase::kFloat:
+      return "float";
+    case PaintPhase::kForeground:
+      return "foreground";
+  }
+  return "";
+}
+
+size_t DisplayItem::OpCount() const {
+  return std::visit(
+      [](const auto& list) -> size_t {
+        using T = std::decay_t<decltype(list)>;
+        if constexpr (std::is_same_v<T, border_painter::PaintOpList>) {
+          return list.ops().size();
+        } else {
+          return list.ops.size();
+        }
+      },
+      ops);
+}
+
+size_t DisplayItemList::OpCount() const {
+  size_t count = 0;
+  for (const DisplayItem& item : items_) {
+    count += item.OpCount();
+  }
+  return count;
+}
+
+std::string SerializeDisplayItems(const DisplayItemList& list) {
+  std::string ops;
+  for (const DisplayItem& item : list.items()) {
+    std::visit(
+        [&ops](const auto& item_ops) {
+          using T = std::decay_t<decltype(item_ops)>;
+          if constexpr (std::is_same_v<T, block_painter::PaintOpList>) {
+            AppendSerializedOps(
+                block_painter::JsonParser::SerializeOps(item_ops), ops);
+          } else if constexpr (std::is_same_v<T,
+                                              border_painter::PaintOpList>) {
+            AppendSerializedOps(border_painter::SerializeOps(item_ops), ops);
+          } else {
+            AppendSerializedOps(
+                text_painter::JsonParser::SerializeOps(item_ops), ops);
+          }
+        },
+        item.ops);
+  }
+  return "[\n" + ops + "\n]\n";
+}
+
+}  // namespace box_fragment_painter
@@ -0,0 +1,77 @@
+// Box Fragment Painter Display Items
+// The painters' op lists, recorded per node and phase in paint order
+
+#ifndef BOX_FRAGMENT_PAINTER_DISPLAY_ITEM_LIST_H_
+#define BOX_FRAGMENT_PAINTER_DISPLAY_ITEM_LIST_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "block_painter/src/draw_commands.h"
+#include "border_painter/src/draw_commands.h"
+#include "fragment_tree.h"
+#include "text_painter/src/draw_commands.h"
+
+namespace box_fragment_painter {
+
+// Chromium's PaintPhase, reduced to the phases the layout tree has data
+// for (no outlines, masks, selection or overflow controls)
+enum class PaintPhase : uint8_t {
+  kBlockBackground,
+  kFloat,
+  kForeground,
+};
+
+constexpr size_t kPaintPhaseCount = 3;
+
+const char* PaintPhaseName(PaintPhase phase);
+
+// The painter that produced a display item
+enum class DisplayItemType : uint8_t {
+  kBoxDecorationBackground,  // BlockPainter: background and box shadows,
+                             // or BoxDecorationPainter: background and
+                             // border of a box without shadows
+  kBorder,                   // BorderPainter, after a BlockPainter item
+  kText,                     // TextPainter, one per text fragment
+};
+
+using DisplayItemOps = std::variant<block_painter::PaintOpList,
+                                    border_painter::PaintOpList,
+                                    text_painter::PaintOpList>;
+
+struct DisplayItem {
+  uint32_t node = kNoNode;  // Into FragmentTree::nodes
+  int64_t node_id = 0;
+  PaintPhase phase = PaintPhase::kForeground;
+  DisplayItemType type = DisplayItemType::kBoxDecorationBackground;
+  DisplayItemOps ops;
+
+  size_t OpCount() const;
+};
+
+// The display items of a document in paint order
+class DisplayItemList {
+ public:
+  void Append(DisplayItem item) { items_.push_back(std::move(item)); }
+
+  const std::vector<DisplayItem>& items() const { return items_; }
+  std::vector<DisplayItem>& mutable_items() { return items_; }
+  size_t size() const { return items_.size(); }
+  bool empty() const { return items_.empty(); }
+
+  size_t OpCount() const;
+
+ private:
+  std::vector<DisplayItem> items_;
+};
+
+// The ops of every item as one JSON array, each op serialized by the
+// painter that produced it
+std::string SerializeDisplayItems(const DisplayItemList& list);
+
+}  // namespace box_fragment_painter
+
+#endif  // BOX_FRAGMENT_PAINTER_DISPLAY_ITEM_LIST_H_
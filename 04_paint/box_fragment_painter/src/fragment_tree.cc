@@ -0,0 +1,162 @@
+#include "fragment_tree.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace box_fragment_painter {
+
+namespace {
+
+bool IsFlexOrGridContainer(Display display) {
+  return display == Display::kFlex || display == Display::kInlineFlex ||
+         display == Display::kGrid || display == Display::kInlineGrid;
+}
+
+// Atomic inlines, flex items and grid items paint all phases at once
+// (PhysicalFragment::IsPaintedAtomically)
+bool IsPaintedAtomically(const FragmentNode& node, const FragmentNode* parent) {
+  if (node.Has(FragmentNode::kIsText)) {
+    return false;
+  }
+  if (node.display == Display::kInlineBlock ||
+      node.display == Display::kInlineFlex ||
+      node.display == Display::kInlineGrid) {
+    return true;
+  }
+  return parent && IsFlexOrGridContainer(parent->display);
+}
+
+void SortByZIndex(const std::vector<FragmentNode>& nodes,
+                  std::vector<uint32_t>& list) {
+  std::stable_sort(list.begin(), list.end(), [&nodes](uint32_t a, uint32_t b) {
+    return nodes[a].z_index < nodes[b].z_index;
+  });
+}
+
+}  // namespace
+
+bool FragmentTree::Finalize(
+    const std::vector<std::vector<int64_t>>& child_ids) {
+  const size_t count = nodes.size();
+  std::unordered_map<int64_t, uint32_t> index_of;
+  index_of.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    index_of[data[i].id] = static_cast<uint32_t>(i);
+  }
+
+  for (FragmentNode& node : nodes) {
+    node.parent = kNoNode;
+    node.flags &= ~FragmentNode::kPaintedAtomically;
+  }
+
+  children.clear();
+  for (size_t i = 0; i < count; ++i) {
+    nodes[i].first_child = static_cast<uint32_t>(children.size());
+    for (int64_t id : child_ids[i]) {
+      auto it = index_of.find(id);
+      // Every node has at most one parent, so the walk below terminates
+      if (it == index_of.end() || nodes[it->second].parent != kNoNode) {
+        return false;
+      }
+      children.push_back(it->second);
+      nodes[it->second].parent = static_cast<uint32_t>(i);
+    }
+    nodes[i].child_count =
+        static_cast<uint32_t>(children.size()) - nodes[i].first_child;
+  }
+
+  root = kNoNode;
+  for (size_t i = 0; i < count; ++i) {
+    if (nodes[i].parent == kNoNode) {
+      root = static_cast<uint32_t>(i);
+      break;
+    }
+  }
+  if (root == kNoNode) {
+    return false;
+  }
+
+  containing_block_origin.assign(count, PointF{});
+  layer_index.assign(count, kNoNode);
+  layers.clear();
+
+  // Enclosing self-painting layer and enclosing stacking context layer of
+  // each visited node; a parent is always visited before its children
+  std::vector<uint32_t> enclosing_layer(count, kNoNode);
+  std::vector<uint32_t> enclosing_stacking_context(count, kNoNode);
+
+  std::vector<uint32_t> stack;
+  stack.push_back(root);
+  while (!stack.empty()) {
+    const uint32_t n = stack.back();
+    stack.pop_back();
+    FragmentNode& node = nodes[n];
+    const RectF& geometry = data[n].geometry;
+    const uint32_t parent = node.parent;
+
+    if (IsPaintedAtomically(node, parent == kNoNode ? nullptr
+                                                    : &nodes[parent])) {
+      node.flags |= FragmentNode::kPaintedAtomically;
+    }
+
+    if (node.Has(FragmentNode::kHasGeometry)) {
+      containing_block_origin[n] = {geometry.x, geometry.y};
+    } else if (parent != kNoNode) {
+      containing_block_origin[n] = containing_block_origin[parent];
+    }
+
+    uint32_t layer = parent == kNoNode ? kNoNode : enclosing_layer[parent];
+    uint32_t stacking_context =
+        parent == kNoNode ? kNoNode : enclosing_stacking_context[parent];
+    if (n == root || node.Has(FragmentNode::kSelfPaintingLayer)) {
+      if (n != root) {
+        // Stacked layers are ordered by their stacking context; the others
+        // paint in tree order after the content of their enclosing layer
+        if (!node.Has(FragmentNode::kStacked)) {
+          layers[layer_index[layer]].normal_flow.push_back(n);
+        } else if (node.z_index < 0) {
+          layers[layer_index[stacking_context]].neg_z_order.push_back(n);
+        } else {
+          layers[layer_index[stacking_context]].pos_z_order.push_back(n);
+        }
+      }
+      layer_index[n] = static_cast<uint32_t>(layers.size());
+      layers.emplace_back();
+      layer = n;
+      if (n == root || node.Has(FragmentNode::kStackingContext)) {
+        stacking_context = n;
+      }
+    }
+    enclosing_layer[n] = layer;
+    enclosing_stacking_context[n] = stacking_context;
+
+    for (uint32_t i = node.child_count; i > 0; --i) {
+      stack.push_back(children[node.first_child + i - 1]);
+    }
+  }
+
+  for (PaintLayerLists& lists : layers) {
+    SortByZIndex(nodes, lists.neg_z_order);
+    SortByZIndex(nodes, lists.pos_z_order);
+  }
+  return true;
+}
+
+void FragmentTree::SetNeedsRepaint(uint32_t node) {
+  nodes[node].flags |= FragmentNode::kNeedsRepaint;
+  // Ancestors above a marked one are already marked
+  for (uint32_t n = nodes[node].parent;
+       n != kNoNode && !nodes[n].Has(FragmentNode::kDescendantNeedsRepaint);
+       n = nodes[n].parent) {
+    nodes[n].flags |= FragmentNode::kDescendantNeedsRepaint;
+  }
+}
+
+void FragmentTree::ClearNeedsRepaint() {
+  for (FragmentNode& node : nodes) {
+    node.flags &= ~(FragmentNode::kNeedsRepaint |
+                    FragmentNode::kDescendantNeedsRepaint);
+  }
+}
+
+}  // namespace box_fragment_painter
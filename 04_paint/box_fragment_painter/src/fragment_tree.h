@@ -0,0 +1,196 @@
+// Box Fragment Painter Fragment Tree
+// The shaped layout tree (02_shape output) flattened for painting
+
+#ifndef BOX_FRAGMENT_PAINTER_FRAGMENT_TREE_H_
+#define BOX_FRAGMENT_PAINTER_FRAGMENT_TREE_H_
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace box_fragment_painter {
+
+// Normalized RGBA, as in the layout tree JSON
+struct Color {
+  float r = 0.0f;
+  float g = 0.0f;
+  float b = 0.0f;
+  float a = 1.0f;
+};
+
+struct RectF {
+  float x = 0.0f;
+  float y = 0.0f;
+  float width = 0.0f;
+  float height = 0.0f;
+};
+
+struct PointF {
+  float x = 0.0f;
+  float y = 0.0f;
+};
+
+struct BoxShadow {
+  float offset_x = 0.0f;
+  float offset_y = 0.0f;
+  float blur = 0.0f;
+  float spread = 0.0f;
+  bool inset = false;
+  Color color;
+};
+
+// Border style keywords, in border_painter::EBorderStyle order
+enum class BorderStyle : uint8_t {
+  kNone,
+  kHidden,
+  kInset,
+  kGroove,
+  kOutset,
+  kRidge,
+  kDotted,
+  kDashed,
+  kSolid,
+  kDouble
+};
+
+// CSS display, reduced to what decides the paint traversal
+enum class Display : uint8_t {
+  kBlock,
+  kInline,
+  kInlineBlock,
+  kFlex,
+  kInlineFlex,
+  kGrid,
+  kInlineGrid,
+  kOther
+};
+
+enum class Float : uint8_t { kNone, kLeft, kRight };
+
+// Font of a text node (computed_style, inherited)
+struct FontDescription {
+  std::string family;
+  float size = 16.0f;
+  int weight = 400;
+  bool italic = false;
+};
+
+// One shaped glyph run of a text fragment
+struct TextRun {
+  std::vector<uint16_t> glyphs;
+  std::vector<float> positions;
+  int positioning = 1;
+};
+
+// One line's fragment of a text node. |x|, |y| are relative to the
+// containing block (the nearest ancestor with geometry).
+struct TextFragment {
+  RectF rect;
+  unsigned start = 0;
+  unsigned end = 0;
+  uint32_t first_run = 0;  // Into FragmentTree::runs
+  uint32_t run_count = 0;
+};
+
+constexpr uint32_t kNoNode = 0xffffffffu;
+
+// The part of a layout object the traversal reads, kept small so the walk
+// over |FragmentTree::nodes| stays in cache. Paint data is in FragmentData.
+struct FragmentNode {
+  enum Flag : uint16_t {
+    kHasGeometry = 1 << 0,
+    kIsText = 1 << 1,
+    kVisible = 1 << 2,
+    kSelfPaintingLayer = 1 << 3,
+    kStacked = 1 << 4,
+    kStackingContext = 1 << 5,
+    kPaintedAtomically = 1 << 6,  // Computed by FragmentTree::Finalize
+    // Set by FragmentTree::SetNeedsRepaint, for the DisplayItemCache
+    kNeedsRepaint = 1 << 7,
+    kDescendantNeedsRepaint = 1 << 8,
+  };
+
+  uint32_t parent = kNoNode;
+  uint32_t first_child = 0;  // Into FragmentTree::children
+  uint32_t child_count = 0;
+  int32_t z_index = 0;
+  uint16_t flags = 0;
+  Display display = Display::kBlock;
+  Float floating = Float::kNone;
+
+  bool Has(Flag flag) const { return (flags & flag) != 0; }
+  bool IsFloating() const { return floating != Float::kNone; }
+};
+
+// What a layout object paints, only touched for nodes that paint
+struct FragmentData {
+  int64_t id = 0;
+  RectF geometry;  // Border box in root coordinates
+  std::optional<Color> background_color;
+  std::vector<BoxShadow> box_shadow;
+  std::array<float, 4> border_widths = {0, 0, 0, 0};  // top right bottom left
+  std::array<Color, 4> border_colors;
+  std::array<BorderStyle, 4> border_styles = {
+      BorderStyle::kSolid, BorderStyle::kSolid, BorderStyle::kSolid,
+      BorderStyle::kSolid};
+  std::optional<std::array<float, 8>> border_radii;
+
+  // Text nodes only
+  std::string text;
+  FontDescription font;
+  std::optional<Color> color;
+  uint32_t first_text_fragment = 0;  // Into FragmentTree::text_fragments
+  uint32_t text_fragment_count = 0;
+
+  bool HasBorder() const {
+    return border_widths[0] > 0 || border_widths[1] > 0 ||
+           border_widths[2] > 0 || border_widths[3] > 0;
+  }
+};
+
+// PaintLayerStackingNode lists of a self-painting layer: the layers it
+// paints before its own content (negative z-index), after it in tree order
+// (non-stacked layers) and on top (z-index >= 0), each in paint order
+struct PaintLayerLists {
+  std::vector<uint32_t> neg_z_order;
+  std::vector<uint32_t> normal_flow;
+  std::vector<uint32_t> pos_z_order;
+};
+
+// The layout tree as flat arrays. Nodes keep their JSON order, |data| is
+// parallel to |nodes|; children of node n are
+// children[first_child, first_child + child_count).
+struct FragmentTree {
+  std::vector<FragmentNode> nodes;
+  std::vector<FragmentData> data;
+  std::vector<uint32_t> children;
+  std::vector<TextFragment> text_fragments;
+  std::vector<TextRun> runs;
+  uint32_t root = kNoNode;
+
+  // Per node: origin of the nearest node with geometry at or above it (for
+  // a text node, its containing block), and the index into |layers| of
+  // self-painting layers (kNoNode for other nodes)
+  std::vector<PointF> containing_block_origin;
+  std::vector<uint32_t> layer_index;
+  std::vector<PaintLayerLists> layers;
+
+  // Resolves child links given as ids in |child_ids| (parallel to |nodes|),
+  // then computes painted-atomically flags, containing block origins and
+  // the layer z-order lists in one iterative depth-first pass.
+  // Returns false if the tree has no root, a child id is unknown or a node
+  // is listed as the child of two nodes.
+  bool Finalize(const std::vector<std::vector<int64_t>>& child_ids);
+
+  // Marks |node| as changed since the last paint, and its ancestors as
+  // having a changed descendant (PaintLayer::SetNeedsRepaint): their
+  // layers cannot reuse their cached subsequence.
+  void SetNeedsRepaint(uint32_t node);
+  void ClearNeedsRepaint();
+};
+
+}  // namespace box_fragment_painter
+
+#endif  // BOX_FRAGMENT_PAINTER_FRAGMENT_TREE_H_
@@ -0,0 +1,209 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "box_fragment_painter.h"
+#include "display_item_cache.h"
+#include "display_item_list.h"
+#include "fragment_tree.h"
+#include "occlusion_culling.h"
+#include "paint_invalidator.h"
+#include "tree_parser.h"
+
+void PrintUsage(const char* program) {
+  std::cerr << "Usage: " << program << " -i <layout_tree.json> [-o <output.json>]\n";
+  std::cerr << "\n";
+  std::cerr << "Options:\n";
+  std::cerr << "  -i <file>    Shaped layout tree JSON (required)\n";
+  std::cerr << "  -o <file>    Output JSON file (default: stdout)\n";
+  std::cerr << "  --dark-mode  Paint with the auto dark mode filter\n";
+  std::cerr << "  --cull-rect <x,y,width,height>\n";
+  std::cerr << "               Only paint what intersects this root-space rect\n";
+  std::cerr << "  --occlusion-culling\n";
+  std::cerr << "               Drop ops hidden under later opaque rects\n";
+  std::cerr << "  --repaint <file>\n";
+  std::cerr << "               Paint this changed tree next, reusing the display items\n";
+  std::cerr << "               of unchanged nodes; the output is the last paint\n";
+  std::cerr << "               (repeatable)\n";
+  std::cerr << "  --stats      Print traversal statistics and paint time to stderr\n";
+}
+
+namespace {
+
+bool ReadFragmentTree(const std::string& path,
+                      box_fragment_painter::FragmentTree& tree) {
+  // Read input file
+  std::ifstream ifs(path);
+  if (!ifs) {
+    std::cerr << "Error: Cannot open input file: " << path << "\n";
+    return false;
+  }
+
+  std::stringstream buffer;
+  buffer << ifs.rdbuf();
+  std::string json_input = buffer.str();
+
+  // Parse input
+  try {
+    tree = box_fragment_painter::ParseFragmentTree(json_input);
+  } catch (const std::exception& e) {
+    std::cerr << "Error parsing input: " << e.what() << "\n";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string input_file;
+  std::string output_file;
+  std::vector<std::string> repaint_files;
+  bool print_stats = false;
+  bool occlusion_culling = false;
+  box_fragment_painter::PaintOptions options;
+
+  // Parse command line arguments
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-i" && i + 1 < argc) {
+      input_file = argv[++i];
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_file = argv[++i];
+    } else if (arg == "--dark-mode") {
+      options.dark_mode = true;
+    } else if (arg == "--cull-rect" && i + 1 < argc) {
+      box_fragment_painter::RectF rect;
+      if (std::sscanf(argv[++i], "%f,%f,%f,%f", &rect.x, &rect.y, &rect.width,
+                      &rect.height) != 4) {
+        std::cerr << "Error: --cull-rect expects x,y,width,height\n";
+        return 1;
+      }
+      options.cull_rect = rect;
+    } else if (arg == "--occlusion-culling") {
+      occlusion_culling = true;
+    } else if (arg == "--repaint" && i + 1 < argc) {
+      repaint_files.push_back(argv[++i]);
+    } else if (arg == "--stats") {
+      print_stats = true;
+    } else if (arg == "-h" || arg == "--help") {
+      PrintUsage(argv[0]);
+      return 0;
+    }
+  }
+
+  if (input_file.empty()) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  box_fragment_painter::FragmentTree tree;
+  if (!ReadFragmentTree(input_file, tree)) {
+    return 1;
+  }
+
+  // Walk the paint phases of the whole tree
+  box_fragment_painter::DisplayItemCache cache;
+  box_fragment_painter::DisplayItemCache* cache_ptr =
+      repaint_files.empty() ? nullptr : &cache;
+  box_fragment_painter::PaintStats stats;
+  auto start = std::chrono::steady_clock::now();
+  box_fragment_painter::DisplayItemList items =
+      box_fragment_painter::BoxFragmentPainter::Paint(tree, options, &stats,
+                                                      cache_ptr);
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  const std::chrono::duration<double, std::micro> first_elapsed = elapsed;
+
+  // Repaint each changed tree, the stats then describing the last paint.
+  // What changed is marked first, as a DOM change would
+  size_t invalidated = 0;
+  std::chrono::duration<double, std::micro> invalidation_elapsed{0.0};
+  for (const std::string& repaint_file : repaint_files) {
+    box_fragment_painter::FragmentTree previous = std::move(tree);
+    if (!ReadFragmentTree(repaint_file, tree)) {
+      return 1;
+    }
+    auto invalidation_start = std::chrono::steady_clock::now();
+    invalidated = box_fragment_painter::InvalidatePaint(previous, tree);
+    invalidation_elapsed =
+        std::chrono::steady_clock::now() - invalidation_start;
+    stats = {};
+    start = std::chrono::steady_clock::now();
+    items = box_fragment_painter::BoxFragmentPainter::Paint(tree, options,
+                                                            &stats, &cache);
+    elapsed = std::chrono::steady_clock::now() - start;
+  }
+
+  // Drop what later opaque backgrounds cover
+  const size_t painted_items = items.size();
+  const size_t painted_ops = items.OpCount();
+  box_fragment_painter::OcclusionStats occlusion;
+  std::chrono::duration<double, std::micro> occlusion_elapsed{0.0};
+  if (occlusion_culling) {
+    auto occlusion_start = std::chrono::steady_clock::now();
+    occlusion = box_fragment_painter::CullOccludedOps(items);
+    occlusion_elapsed = std::chrono::steady_clock::now() - occlusion_start;
+  }
+
+  if (print_stats) {
+    std::cerr << "nodes: " << tree.nodes.size() << " (" << stats.nodes_visited
+              << " paint steps, max stack depth " << stats.max_stack_depth
+              << ")\n";
+    std::cerr << "layers: " << stats.layers << "\n";
+    std::cerr << "display items: " << painted_items;
+    for (size_t phase = 0; phase < box_fragment_painter::kPaintPhaseCount;
+         ++phase) {
+      std::cerr << (phase == 0 ? " (" : ", ") << stats.items_per_phase[phase]
+                << " "
+                << box_fragment_painter::PaintPhaseName(
+                       static_cast<box_fragment_painter::PaintPhase>(phase));
+    }
+    std::cerr << ")\n";
+    std::cerr << "ops: " << painted_ops << "\n";
+    std::cerr << "paint time: " << std::fixed << std::setprecision(3)
+              << elapsed.count() << " us\n";
+    if (!repaint_files.empty()) {
+      std::cerr << "first paint time: " << first_elapsed.count() << " us\n";
+      std::cerr << "invalidation: " << invalidated << " nodes changed ("
+                << invalidation_elapsed.count() << " us)\n";
+      std::cerr << "subsequences: " << stats.subsequences_reused
+                << " layers reused, " << stats.subsequences_painted
+                << " painted\n";
+      std::cerr << "display item cache: " << stats.cache_hits << " hits, "
+                << stats.cache_misses << " misses (" << cache.size()
+                << " entries)\n";
+    }
+    if (occlusion_culling) {
+      std::cerr << "occlusion: " << occlusion.ops_eliminated << " of "
+                << painted_ops << " ops, " << occlusion.items_eliminated
+                << " items, " << std::setprecision(0)
+                << occlusion.pixels_eliminated << " px eliminated ("
+                << occlusion.occluders << " occluders, "
+                << std::setprecision(3) << occlusion_elapsed.count()
+                << " us)\n";
+    }
+  }
+
+  // Serialize output
+  std::string json_output = box_fragment_painter::SerializeDisplayItems(items);
+
+  // Write output
+  if (output_file.empty()) {
+    std::cout << json_output;
+  } else {
+    std::ofstream ofs(output_file);
+    if (!ofs) {
+      std::cerr << "Error: Cannot open output file: " << output_file << "\n";
+      return 1;
+    }
+    ofs << json_output;
+  }
+
+  return 0;
+}
@@ -0,0 +1,438 @@
+#include "occlusion_culling.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "region.h"
+
+namespace box_fragment_painter {
+
+namespace {
+
+// Property tree state an op paints in; ops only occlude within one state
+struct StateKey {
+  int transform_id = 0;
+  int clip_id = 0;
+  int effect_id = 0;
+
+  bool operator<(const StateKey& other) const {
+    return std::tie(transform_id, clip_id, effect_id) <
+           std::tie(other.transform_id, other.clip_id, other.effect_id);
+  }
+};
+
+using CoveredRegions = std::map<StateKey, Region>;
+
+enum class OpKind : uint8_t {
+  kSave,     // SaveOp, SaveLayerAlphaOp
+  kRestore,
+  kClip,     // Clips without a Save still scope the rest of the item
+  kDraw,
+  kOther,    // Shadow state, transforms
+};
+
+// What one op means for occlusion
+struct OpInfo {
+  OpKind kind = OpKind::kOther;
+  StateKey state;
+  std::optional<RectF> bounds;  // Droppable draws only
+  std::array<RectF, 2> occluders;
+  int occluder_count = 0;
+};
+
+RectF FromLTRB(float left, float top, float right, float bottom) {
+  return {left, top, right - left, bottom - top};
+}
+
+RectF FromLTRB(const std::array<float, 4>& ltrb) {
+  return FromLTRB(ltrb[0], ltrb[1], ltrb[2], ltrb[3]);
+}
+
+RectF Outset(const RectF& rect, float outset) {
+  return {rect.x - outset, rect.y - outset, rect.width + 2.0f * outset,
+          rect.height + 2.0f * outset};
+}
+
+RectF Union(const RectF& a, const RectF& b) {
+  const float left = std::min(a.x, b.x);
+  const float top = std::min(a.y, b.y);
+  const float right = std::max(a.x + a.width, b.x + b.width);
+  const float bottom = std::max(a.y + a.height, b.y + b.height);
+  return FromLTRB(left, top, right, bottom);
+}
+
+// Smallest whole-pixel rect containing |rect| (gfx::ToEnclosingRect)
+RectF EnclosingRect(const RectF& rect) {
+  return FromLTRB(std::floor(rect.x), std::floor(rect.y),
+                  std::ceil(rect.x + rect.width),
+                  std::ceil(rect.y + rect.height));
+}
+
+// Largest whole-pixel rect inside |rect| (gfx::ToEnclosedRect)
+RectF EnclosedRect(const RectF& rect) {
+  const float left = std::ceil(rect.x);
+  const float top = std::ceil(rect.y);
+  const float right = std::floor(rect.x + rect.width);
+  const float bottom = std::floor(rect.y + rect.height);
+  return FromLTRB(left, top, std::max(left, right), std::max(top, bottom));
+}
+
+double Area(const RectF& rect) {
+  return static_cast<double>(rect.width) * rect.height;
+}
+
+// The opaque part of a filled rrect: the union of the rect without the
+// corner columns and the rect without the corner rows
+// Radii: [tl_x, tl_y, tr_x, tr_y, br_x, br_y, bl_x, bl_y]
+void SetRRectOccluders(const std::array<float, 4>& rect,
+                       const std::array<float, 8>& radii, OpInfo& info) {
+  const float left_radius = std::max(radii[0], radii[6]);
+  const float right_radius = std::max(radii[2], radii[4]);
+  const float top_radius = std::max(radii[1], radii[3]);
+  const float bottom_radius = std::max(radii[5], radii[7]);
+  info.occluders[0] = FromLTRB(rect[0] + left_radius, rect[1],
+                               rect[2] - right_radius, rect[3]);
+  info.occluders[1] = FromLTRB(rect[0], rect[1] + top_radius, rect[2],
+                               rect[3] - bottom_radius);
+  info.occluder_count = 2;
+}
+
+template <typename Op>
+StateKey StateOf(const Op& op) {
+  return {op.transform_id, op.clip_id, op.effect_id};
+}
+
+// Grows |bounds| by block shadows drawn along with the shape
+RectF WithShadows(const RectF& bounds,
+                  const std::vector<block_painter::ShadowFlag>& shadows) {
+  RectF result = bounds;
+  for (const block_painter::ShadowFlag& shadow : shadows) {
+    RectF shadow_bounds = Outset(bounds, 3.0f * shadow.blur_sigma);
+    shadow_bounds.x += shadow.offset_x;
+    shadow_bounds.y += shadow.offset_y;
+    result = Union(result, shadow_bounds);
+  }
+  return result;
+}
+
+bool IsOpaqueFill(const block_painter::DrawFlags& flags) {
+  return flags.a == 1.0f && flags.style == 0 && flags.shadows.empty();
+}
+
+bool IsOpaqueFill(const border_painter::DrawFlags& flags) {
+  return flags.color.IsOpaque() &&
+         flags.style == border_painter::PaintStyle::kFill;
+}
+
+float StrokeOutset(const border_painter::DrawFlags& flags) {
+  return flags.style == border_painter::PaintStyle::kFill
+             ? 0.0f
+             : flags.stroke_width / 2.0f;
+}
+
+OpInfo Classify(const block_painter::PaintOp& paint_op) {
+  return std::visit(
+      [](const auto& op) -> OpInfo {
+        using T = std::decay_t<decltype(op)>;
+        OpInfo info;
+        info.state = StateOf(op);
+        if constexpr (std::is_same_v<T, block_painter::DrawRectOp> ||
+                      std::is_same_v<T, block_painter::DrawRRectOp>) {
+          info.kind = OpKind::kDraw;
+          info.bounds = WithShadows(
+              Outset(FromLTRB(op.rect), op.flags.style == 0
+                                            ? 0.0f
+                                            : op.flags.stroke_width / 2.0f),
+              op.flags.shadows);
+          if (IsOpaqueFill(op.flags)) {
+            if constexpr (std::is_same_v<T, block_painter::DrawRectOp>) {
+              info.occluders[0] = FromLTRB(op.rect);
+              info.occluder_count = 1;
+            } else {
+              SetRRectOccluders(op.rect, op.radii, info);
+            }
+          }
+        } else if constexpr (std::is_same_v<T, block_painter::DrawDRRectOp>) {
+          info.kind = OpKind::kDraw;
+          info.bounds =
+              WithShadows(FromLTRB(op.outer_rect), op.flags.shadows);
+        } else if constexpr (std::is_same_v<T, block_painter::SaveOp>) {
+          info.kind = OpKind::kSave;
+        } else if constexpr (std::is_same_v<T, block_painter::RestoreOp>) {
+          info.kind = OpKind::kRestore;
+        } else if constexpr (std::is_same_v<T, block_painter::ClipRectOp> ||
+                             std::is_same_v<T, block_painter::ClipRRectOp>) {
+          info.kind = OpKind::kClip;
+        }
+        return info;
+      },
+      paint_op);
+}
+
+OpInfo Classify(const border_painter::PaintOp& paint_op) {
+  return std::visit(
+      [](const auto& op) -> OpInfo {
+        using T = std::decay_t<decltype(op)>;
+        OpInfo info;
+        info.state = StateOf(op);
+        if constexpr (std::is_same_v<T, border_painter::DrawRectOp> ||
+                      std::is_same_v<T, border_painter::DrawRRectOp>) {
+          info.kind = OpKind::kDraw;
+          info.bounds = Outset(FromLTRB(op.rect), StrokeOutset(op.flags));
+          if (IsOpaqueFill(op.flags)) {
+            if constexpr (std::is_same_v<T, border_painter::DrawRectOp>) {
+              info.occluders[0] = FromLTRB(op.rect);
+              info.occluder_count = 1;
+            } else {
+              SetRRectOccluders(op.rect, op.radii, info);
+            }
+          }
+        } else if constexpr (std::is_same_v<T, border_painter::DrawLineOp>) {
+          info.kind = OpKind::kDraw;
+          info.bounds = Outset(
+              FromLTRB(std::min(op.x0, op.x1), std::min(op.y0, op.y1),
+                       std::max(op.x0, op.x1), std::max(op.y0, op.y1)),
+              StrokeOutset(op.flags));
+        } else if constexpr (std::is_same_v<T, border_painter::DrawDRRectOp>) {
+          info.kind = OpKind::kDraw;
+          info.bounds = FromLTRB(op.outer_rect);
+        } else if constexpr (std::is_same_v<T, border_painter::DrawPathOp>) {
+          info.kind = OpKind::kDraw;
+          std::optional<RectF> bounds;
+          for (const auto& contour : op.contours) {
+            for (const border_painter::PointF& point : contour) {
+              const RectF point_rect = {point.x, point.y, 0.0f, 0.0f};
+              bounds = bounds ? Union(*bounds, point_rect) : point_rect;
+            }
+          }
+          info.bounds = bounds;
+        } else if constexpr (std::is_same_v<T, border_painter::SaveOp> ||
+                             std::is_same_v<T,
+                                            border_painter::SaveLayerAlphaOp>) {
+          info.kind = OpKind::kSave;
+        } else if constexpr (std::is_same_v<T, border_painter::RestoreOp>) {
+          info.kind = OpKind::kRestore;
+        } else if constexpr (std::is_same_v<T, border_painter::ClipRRectOp> ||
+                             std::is_same_v<T, border_painter::ClipPathOp>) {
+          info.kind = OpKind::kClip;
+        }
+        return info;
+      },
+      paint_op);
+}
+
+// A text item is dropped as a whole, and only if it is nothing but text
+// blobs (and their shadows) in one state, with no transforms
+std::optional<RectF> TextItemBounds(const text_painter::PaintOpList& list,
+                                    StateKey& state) {
+  std::optional<RectF> bounds;
+  std::vector<const text_painter::DrawShadowOp*> shadows;
+  bool has_state = false;
+  for (const text_painter::PaintOp& paint_op : list.ops) {
+    if (const auto* shadow = std::get_if<text_painter::DrawShadowOp>(&paint_op)) {
+      shadows.push_back(shadow);
+    } else if (std::holds_alternative<text_painter::ClearShadowOp>(paint_op)) {
+      shadows.clear();
+    } else if (const auto* blob =
+                   std::get_if<text_painter::DrawTextBlobOp>(&paint_op)) {
+      const StateKey blob_state = StateOf(*blob);
+      if (has_state && (blob_state < state || state < blob_state)) {
+        return std::nullopt;
+      }
+      state = blob_state;
+      has_state = true;
+      const RectF blob_bounds =
+          FromLTRB(blob->x + blob->bounds[0], blob->y + blob->bounds[1],
+                   blob->x + blob->bounds[2], blob->y + blob->bounds[3]);
+      RectF ink = blob_bounds;
+      for (const text_painter::DrawShadowOp* s : shadows) {
+        RectF shadow_bounds = Outset(blob_bounds, 3.0f * s->blur_sigma);
+        shadow_bounds.x += s->offset_x;
+        shadow_bounds.y += s->offset_y;
+        ink = Union(ink, shadow_bounds);
+      }
+      bounds = bounds ? Union(*bounds, ink) : ink;
+    } else if (!std::holds_alternative<text_painter::SaveOp>(paint_op) &&
+               !std::holds_alternative<text_painter::RestoreOp>(paint_op) &&
+               !std::holds_alternative<text_painter::ClipRectOp>(paint_op)) {
+      return std::nullopt;  // Decorations, marks, transforms
+    }
+  }
+  return bounds;
+}
+
+// Culls one block or border op list against |covered| and adds its
+// occluders. Returns the number of draw ops left.
+template <typename PaintOp>
+size_t CullOpList(std::vector<PaintOp>& ops, CoveredRegions& covered,
+                  OcclusionStats& stats) {
+  const size_t count = ops.size();
+  std::vector<OpInfo> infos;
+  infos.reserve(count);
+  for (const PaintOp& op : ops) {
+    infos.push_back(Classify(op));
+  }
+
+  // Ops inside a Save (or after an unscoped clip) do not paint their whole
+  // rect, so they may be dropped but cannot occlude
+  std::vector<bool> scoped(count, false);
+  int depth = 0;
+  bool clipped = false;
+  for (size_t i = 0; i < count; ++i) {
+    scoped[i] = depth > 0 || clipped;
+    switch (infos[i].kind) {
+      case OpKind::kSave:
+        ++depth;
+        break;
+      case OpKind::kRestore:
+        depth = std::max(depth - 1, 0);
+        break;
+      case OpKind::kClip:
+        clipped = clipped || depth == 0;
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Back to front: an op can only be hidden by what paints after it
+  std::vector<bool> dropped(count, false);
+  size_t dropped_count = 0;
+  size_t draw_count = 0;
+  for (size_t i = count; i-- > 0;) {
+    const OpInfo& info = infos[i];
+    if (info.kind != OpKind::kDraw) {
+      continue;
+    }
+    if (info.bounds) {
+      const RectF bounds = EnclosingRect(*info.bounds);
+      auto region = covered.find(info.state);
+      if (region != covered.end() && region->second.Contains(bounds)) {
+        dropped[i] = true;
+        ++dropped_count;
+        ++stats.ops_eliminated;
+        stats.pixels_eliminated += Area(bounds);
+        continue;
+      }
+    }
+    ++draw_count;
+    if (!scoped[i]) {
+      for (int j = 0; j < info.occluder_count; ++j) {
+        const RectF occluder = EnclosedRect(info.occluders[j]);
+        if (occluder.width > 0.0f && occluder.height > 0.0f) {
+          covered[info.state].Union(occluder);
+          ++stats.occluders;
+        }
+      }
+    }
+  }
+  if (dropped_count == 0) {
+    return draw_count;
+  }
+
+  // Save ... Restore groups left without a draw (their clips and layers
+  // applied to nothing) go too
+  std::vector<std::pair<size_t, bool>> open;  // Save index, has a draw
+  for (size_t i = 0; i < count; ++i) {
+    if (dropped[i]) {
+      continue;
+    }
+    switch (infos[i].kind) {
+      case OpKind::kSave:
+        open.push_back({i, false});
+        break;
+      case OpKind::kDraw:
+        if (!open.empty()) {
+          open.back().second = true;
+        }
+        break;
+      case OpKind::kRestore:
+        if (open.empty()) {
+          break;
+        }
+        if (open.back().second) {
+          open.pop_back();
+          if (!open.empty()) {
+            open.back().second = true;
+          }
+        } else {
+          std::fill(dropped.begin() + open.back().first,
+                    dropped.begin() + i + 1, true);
+          open.pop_back();
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (!dropped[i]) {
+      if (kept != i) {
+        ops[kept] = std::move(ops[i]);
+      }
+      ++kept;
+    }
+  }
+  ops.erase(ops.begin() + kept, ops.end());
+  return draw_count;
+}
+
+}  // namespace
+
+OcclusionStats CullOccludedOps(DisplayItemList& list) {
+  OcclusionStats stats;
+  CoveredRegions covered;
+  std::vector<DisplayItem>& items = list.mutable_items();
+  std::vector<bool> keep(items.size(), true);
+
+  for (size_t i = items.size(); i-- > 0;) {
+    DisplayItem& item = items[i];
+    if (auto* block = std::get_if<block_painter::PaintOpList>(&item.ops)) {
+      keep[i] = CullOpList(block->ops, covered, stats) > 0;
+    } else if (auto* border =
+                   std::get_if<border_painter::PaintOpList>(&item.ops)) {
+      keep[i] = CullOpList(border->mutable_ops(), covered, stats) > 0;
+    } else if (auto* text = std::get_if<text_painter::PaintOpList>(&item.ops)) {
+      StateKey state;
+      std::optional<RectF> bounds = TextItemBounds(*text, state);
+      if (!bounds) {
+        continue;
+      }
+      const RectF enclosing = EnclosingRect(*bounds);
+      auto region = covered.find(state);
+      if (region != covered.end() && region->second.Contains(enclosing)) {
+        for (const text_painter::PaintOp& op : text->ops) {
+          if (std::holds_alternative<text_painter::DrawTextBlobOp>(op)) {
+            ++stats.ops_eliminated;
+          }
+        }
+        stats.pixels_eliminated += Area(enclosing);
+        keep[i] = false;
+      }
+    }
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < items.size(); ++i) {
+    if (keep[i]) {
+      if (kept != i) {
+        items[kept] = std::move(items[i]);
+      }
+      ++kept;
+    }
+  }
+  stats.items_eliminated = items.size() - kept;
+  items.erase(items.begin() + kept, items.end());
+  return stats;
+}
+
+}  // namespace box_fragment_painter
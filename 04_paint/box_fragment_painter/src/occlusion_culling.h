@@ -0,0 +1,32 @@
+// Box Fragment Painter Occlusion Culling
+// A post-paint pass that drops ops hidden under later opaque rects
+
+#ifndef BOX_FRAGMENT_PAINTER_OCCLUSION_CULLING_H_
+#define BOX_FRAGMENT_PAINTER_OCCLUSION_CULLING_H_
+
+#include <cstddef>
+
+#include "display_item_list.h"
+
+namespace box_fragment_painter {
+
+struct OcclusionStats {
+  size_t occluders = 0;         // Opaque rects added to the covered region
+  size_t ops_eliminated = 0;    // Draw ops dropped
+  size_t items_eliminated = 0;  // Display items left with nothing to draw
+  double pixels_eliminated = 0.0;  // Area of the dropped ops' bounds
+};
+
+// Walks |list| back to front, tracking per property tree state (transform,
+// clip and effect ids) the region covered by opaque, filled, untransformed
+// DrawRectOp / DrawRRectOp. Any earlier op whose bounds (including shadow
+// and stroke outsets) lie inside the region of its state is dropped.
+//
+// Only ops outside Save / clip / layer scopes occlude, and an rrect only
+// covers the cross between its corners. Occluders are shrunk and occludees
+// grown to whole pixels, so anti-aliased edges never hide anything.
+OcclusionStats CullOccludedOps(DisplayItemList& list);
+
+}  // namespace box_fragment_painter
+
+#endif  // BOX_FRAGMENT_PAINTER_OCCLUSION_CULLING_H_
@@ -0,0 +1,121 @@
+#include "paint_invalidator.h"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+namespace box_fragment_painter {
+
+namespace {
+
+// The flags FragmentTree::SetNeedsRepaint sets are not paint input
+constexpr uint16_t kRepaintFlags =
+    FragmentNode::kNeedsRepaint | FragmentNode::kDescendantNeedsRepaint;
+
+bool SameColor(const Color& a, const Color& b) {
+  return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+bool SameColor(const std::optional<Color>& a, const std::optional<Color>& b) {
+  return a.has_value() == b.has_value() && (!a || SameColor(*a, *b));
+}
+
+bool SameRect(const RectF& a, const RectF& b) {
+  return a.x == b.x && a.y == b.y && a.width == b.width &&
+         a.height == b.height;
+}
+
+bool SameShadow(const BoxShadow& a, const BoxShadow& b) {
+  return a.offset_x == b.offset_x && a.offset_y == b.offset_y &&
+         a.blur == b.blur && a.spread == b.spread && a.inset == b.inset &&
+         SameColor(a.color, b.color);
+}
+
+bool SameNode(const FragmentTree& a, uint32_t i, const FragmentTree& b,
+              uint32_t j) {
+  const FragmentNode& na = a.nodes[i];
+  const FragmentNode& nb = b.nodes[j];
+  if ((na.flags & ~kRepaintFlags) != (nb.flags & ~kRepaintFlags) ||
+      na.display != nb.display || na.floating != nb.floating ||
+      na.z_index != nb.z_index || na.child_count != nb.child_count) {
+    return false;
+  }
+  for (uint32_t c = 0; c < na.child_count; ++c) {
+    if (a.data[a.children[na.first_child + c]].id !=
+        b.data[b.children[nb.first_child + c]].id) {
+      return false;
+    }
+  }
+
+  const PointF& oa = a.containing_block_origin[i];
+  const PointF& ob = b.containing_block_origin[j];
+  if (oa.x != ob.x || oa.y != ob.y) {
+    return false;
+  }
+
+  const FragmentData& da = a.data[i];
+  const FragmentData& db = b.data[j];
+  if (!SameRect(da.geometry, db.geometry) ||
+      !SameColor(da.background_color, db.background_color) ||
+      da.box_shadow.size() != db.box_shadow.size() ||
+      da.border_widths != db.border_widths ||
+      da.border_styles != db.border_styles ||
+      da.border_radii != db.border_radii || da.text != db.text ||
+      da.font.family != db.font.family || da.font.size != db.font.size ||
+      da.font.weight != db.font.weight || da.font.italic != db.font.italic ||
+      !SameColor(da.color, db.color) ||
+      da.text_fragment_count != db.text_fragment_count) {
+    return false;
+  }
+  for (size_t s = 0; s < da.box_shadow.size(); ++s) {
+    if (!SameShadow(da.box_shadow[s], db.box_shadow[s])) {
+      return false;
+    }
+  }
+  for (size_t side = 0; side < 4; ++side) {
+    if (!SameColor(da.border_colors[side], db.border_colors[side])) {
+      return false;
+    }
+  }
+  for (uint32_t f = 0; f < da.text_fragment_count; ++f) {
+    const TextFragment& fa = a.text_fragments[da.first_text_fragment + f];
+    const TextFragment& fb = b.text_fragments[db.first_text_fragment + f];
+    if (!SameRect(fa.rect, fb.rect) || fa.start != fb.start ||
+        fa.end != fb.end || fa.run_count != fb.run_count) {
+      return false;
+    }
+    for (uint32_t r = 0; r < fa.run_count; ++r) {
+      const TextRun& ra = a.runs[fa.first_run + r];
+      const TextRun& rb = b.runs[fb.first_run + r];
+      if (ra.glyphs != rb.glyphs || ra.positions != rb.positions ||
+          ra.positioning != rb.positioning) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+size_t InvalidatePaint(const FragmentTree& previous, FragmentTree& tree) {
+  std::unordered_map<int64_t, uint32_t> previous_index;
+  previous_index.reserve(previous.data.size());
+  for (size_t i = 0; i < previous.data.size(); ++i) {
+    previous_index.emplace(previous.data[i].id, static_cast<uint32_t>(i));
+  }
+
+  size_t marked = 0;
+  for (size_t i = 0; i < tree.nodes.size(); ++i) {
+    const uint32_t node = static_cast<uint32_t>(i);
+    auto it = previous_index.find(tree.data[i].id);
+    if (it == previous_index.end() ||
+        !SameNode(previous, it->second, tree, node)) {
+      tree.SetNeedsRepaint(node);
+      ++marked;
+    }
+  }
+  return marked;
+}
+
+}  // namespace box_fragment_painter
@@ -0,0 +1,24 @@
+// Box Fragment Painter Paint Invalidation
+// Marks the nodes of a new tree that differ from the previously painted one
+
+#ifndef BOX_FRAGMENT_PAINTER_PAINT_INVALIDATOR_H_
+#define BOX_FRAGMENT_PAINTER_PAINT_INVALIDATOR_H_
+
+#include <cstddef>
+
+#include "fragment_tree.h"
+
+namespace box_fragment_painter {
+
+// Calls tree.SetNeedsRepaint for every node of |tree| that is new or whose
+// paint input (flags, display, z-index, child ids, geometry, colors,
+// borders, text and glyph runs, containing block origin) differs from the
+// node with the same id in |previous|. A removed node changes its parent's
+// child ids. Stands in for the style and layout invalidation of a DOM
+// change, when a tree is re-parsed instead of mutated. Returns the number
+// of nodes marked.
+size_t InvalidatePaint(const FragmentTree& previous, FragmentTree& tree);
+
+}  // namespace box_fragment_painter
+
+#endif  // BOX_FRAGMENT_PAINTER_PAINT_INVALIDATOR_H_
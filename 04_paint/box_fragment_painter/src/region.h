@@ -0,0 +1,54 @@
+// Box Fragment Painter Region
+// A union of axis-aligned rects stored as y-sorted bands of x spans, like
+// SkRegion: answers "is this rect fully covered?" for occlusion culling
+
+#ifndef BOX_FRAGMENT_PAINTER_REGION_H_
+#define BOX_FRAGMENT_PAINTER_REGION_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "fragment_tree.h"
+
+namespace box_fragment_painter {
+
+class Region {
+ public:
+  bool IsEmpty() const { return bands_.empty(); }
+  size_t BandCount() const { return bands_.size(); }
+
+  // Adds |rect|; empty rects are ignored
+  void Union(const RectF& rect);
+
+  // True if every point of |rect| is covered; false for empty rects
+  bool Contains(const RectF& rect) const;
+
+  // Covered area
+  double Area() const;
+
+ private:
+  struct Span {
+    float left;
+    float right;
+    bool operator==(const Span& other) const {
+      return left == other.left && right == other.right;
+    }
+  };
+
+  // Rows [top, bottom) with sorted, disjoint, non-touching spans; bands are
+  // sorted, disjoint, and adjacent bands with equal spans are coalesced
+  struct Band {
+    float top;
+    float bottom;
+    std::vector<Span> spans;
+  };
+
+  static std::vector<Span> UnionSpans(const std::vector<Span>& spans,
+                                      const Span& span);
+
+  std::vector<Band> bands_;
+};
+
+}  // namespace box_fragment_painter
+
+#endif  // BOX_FRAGMENT_PAINTER_REGION_H_
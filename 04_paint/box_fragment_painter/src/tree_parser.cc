@@ -0,0 +1,439 @@
+#include "tree_parser.h"
+
+#include <cctype>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace box_fragment_painter {
+namespace {
+
+// Simple JSON tokenizer
+class JsonTokenizer {
+ public:
+  explicit JsonTokenizer(const std::string& json) : json_(json), pos_(0) {}
+
+  void SkipWhitespace() {
+    while (pos_ < json_.size() &&
+           (json_[pos_] == ' ' || json_[pos_] == '\n' ||
+            json_[pos_] == '\r' || json_[pos_] == '\t')) {
+      ++pos_;
+    }
+  }
+
+  char Peek() {
+    SkipWhitespace();
+    return pos_ < json_.size() ? json_[pos_] : '\0';
+  }
+
+  char Consume() {
+    SkipWhitespace();
+    return pos_ < json_.size() ? json_[pos_++] : '\0';
+  }
+
+  void Expect(char c) {
+    SkipWhitespace();
+    if (pos_ >= json_.size() || json_[pos_] != c) {
+      throw std::runtime_error(std::string("Expected '") + c + "'");
+    }
+    ++pos_;
+  }
+
+  std::string ReadString() {
+    Expect('"');
+    std::string result;
+    while (pos_ < json_.size() && json_[pos_] != '"') {
+      if (json_[pos_] == '\\' && pos_ + 1 < json_.size()) {
+        ++pos_;
+        switch (json_[pos_]) {
+          case 'n': result += '\n'; break;
+          case 't': result += '\t'; break;
+          case 'r': result += '\r'; break;
+          case '"': result += '"'; break;
+          case '\\': result += '\\'; break;
+          default: result += json_[pos_]; break;
+        }
+      } else {
+        result += json_[pos_];
+      }
+      ++pos_;
+    }
+    Expect('"');
+    return result;
+  }
+
+  double ReadNumber() {
+    SkipWhitespace();
+    size_t start = pos_;
+    if (pos_ < json_.size() && json_[pos_] == '-') ++pos_;
+    while (pos_ < json_.size() &&
+           (std::isdigit(json_[pos_]) || json_[pos_] == '.' ||
+            json_[pos_] == 'e' || json_[pos_] == 'E' ||
+            json_[pos_] == '+' || json_[pos_] == '-')) {
+      ++pos_;
+    }
+    if (start == pos_) {
+      throw std::runtime_error("Expected number");
+    }
+    return std::stod(json_.substr(start, pos_ - start));
+  }
+
+  bool ReadBool() {
+    SkipWhitespace();
+    if (json_.compare(pos_, 4, "true") == 0) {
+      pos_ += 4;
+      return true;
+    }
+    if (json_.compare(pos_, 5, "false") == 0) {
+      pos_ += 5;
+      return false;
+    }
+    throw std::runtime_error("Expected boolean");
+  }
+
+  // Consumes "null" and returns true, or returns false for any other value
+  bool ReadNull() {
+    SkipWhitespace();
+    if (json_.compare(pos_, 4, "null") == 0) {
+      pos_ += 4;
+      return true;
+    }
+    return false;
+  }
+
+  void SkipValue() {
+    SkipWhitespace();
+    char c = Peek();
+    if (c == '"') {
+      ReadString();
+    } else if (c == '{') {
+      SkipObject();
+    } else if (c == '[') {
+      SkipArray();
+    } else if (c == 't' || c == 'f') {
+      ReadBool();
+    } else if (c == 'n') {
+      ReadNull();
+    } else {
+      ReadNumber();
+    }
+  }
+
+  void SkipObject() {
+    Expect('{');
+    if (Peek() != '}') {
+      do {
+        ReadString();
+        Expect(':');
+        SkipValue();
+      } while (Peek() == ',' && (Consume(), true));
+    }
+    Expect('}');
+  }
+
+  void SkipArray() {
+    Expect('[');
+    if (Peek() != ']') {
+      do {
+        SkipValue();
+      } while (Peek() == ',' && (Consume(), true));
+    }
+    Expect(']');
+  }
+
+ private:
+  const std::string& json_;
+  size_t pos_;
+};
+
+// Calls |member(key)| for every key of an object; |member| consumes the value
+template <typename Fn>
+void ParseObject(JsonTokenizer& tok, Fn member) {
+  tok.Expect('{');
+  while (tok.Peek() != '}') {
+    std::string key = tok.ReadString();
+    tok.Expect(':');
+    member(key);
+    if (tok.Peek() == ',') tok.Consume();
+  }
+  tok.Expect('}');
+}
+
+// Calls |element()| for every element of an array
+template <typename Fn>
+void ParseArray(JsonTokenizer& tok, Fn element) {
+  tok.Expect('[');
+  while (tok.Peek() != ']') {
+    element();
+    if (tok.Peek() == ',') tok.Consume();
+  }
+  tok.Expect(']');
+}
+
+float ReadFloat(JsonTokenizer& tok) {
+  return static_cast<float>(tok.ReadNumber());
+}
+
+Color ParseColor(JsonTokenizer& tok) {
+  Color color;
+  ParseObject(tok, [&](const std::string& key) {
+    if (key == "r") {
+      color.r = ReadFloat(tok);
+    } else if (key == "g") {
+      color.g = ReadFloat(tok);
+    } else if (key == "b") {
+      color.b = ReadFloat(tok);
+    } else if (key == "a") {
+      color.a = ReadFloat(tok);
+    } else {
+      tok.SkipValue();
+    }
+  });
+  return color;
+}
+
+RectF ParseRect(JsonTokenizer& tok) {
+  RectF rect;
+  ParseObject(tok, [&](const std::string& key) {
+    if (key == "x") {
+      rect.x = ReadFloat(tok);
+    } else if (key == "y") {
+      rect.y = ReadFloat(tok);
+    } else if (key == "width") {
+      rect.width = ReadFloat(tok);
+    } else if (key == "height") {
+      rect.height = ReadFloat(tok);
+    } else {
+      tok.SkipValue();
+    }
+  });
+  return rect;
+}
+
+// {"top": v, "right": v, "bottom": v, "left": v}, indexed like BoxSide
+template <typename T, typename ParseFn>
+void ParseSides(JsonTokenizer& tok, std::array<T, 4>& sides, ParseFn parse) {
+  ParseObject(tok, [&](const std::string& key) {
+    if (key == "top") {
+      sides[0] = parse();
+    } else if (key == "right") {
+      sides[1] = parse();
+    } else if (key == "bottom") {
+      sides[2] = parse();
+    } else if (key == "left") {
+      sides[3] = parse();
+    } else {
+      tok.SkipValue();
+    }
+  });
+}
+
+BorderStyle ParseBorderStyle(const std::string& style) {
+  if (style == "none") return BorderStyle::kNone;
+  if (style == "hidden") return BorderStyle::kHidden;
+  if (style == "inset") return BorderStyle::kInset;
+  if (style == "groove") return BorderStyle::kGroove;
+  if (style == "outset") return BorderStyle::kOutset;
+  if (style == "ridge") return BorderStyle::kRidge;
+  if (style == "dotted") return BorderStyle::kDotted;
+  if (style == "dashed") return BorderStyle::kDashed;
+  if (style == "double") return BorderStyle::kDouble;
+  return BorderStyle::kSolid;
+}
+
+Display ParseDisplay(const std::string& display) {
+  if (display == "block") return Display::kBlock;
+  if (display == "inline") return Display::kInline;
+  if (display == "inline-block") return Display::kInlineBlock;
+  if (display == "flex") return Display::kFlex;
+  if (display == "inline-flex") return Display::kInlineFlex;
+  if (display == "grid") return Display::kGrid;
+  if (display == "inline-grid") return Display::kInlineGrid;
+  return Display::kOther;
+}
+
+BoxShadow ParseBoxShadow(JsonTokenizer& tok) {
+  BoxShadow shadow;
+  ParseObject(tok, [&](const std::string& key) {
+    if (key == "offset_x") {
+      shadow.offset_x = ReadFloat(tok);
+    } else if (key == "offset_y") {
+      shadow.offset_y = ReadFloat(tok);
+    } else if (key == "blur") {
+      shadow.blur = ReadFloat(tok);
+    } else if (key == "spread") {
+      shadow.spread = ReadFloat(tok);
+    } else if (key == "inset") {
+      shadow.inset = tok.ReadBool();
+    } else if (key == "color") {
+      shadow.color = ParseColor(tok);
+    } else {
+      tok.SkipValue();
+    }
+  });
+  return shadow;
+}
+
+void ParseComputedStyle(JsonTokenizer& tok, FragmentNode& node,
+                        FragmentData& data) {
+  ParseObject(tok, [&](const std::string& key) {
+    if (key == "display") {
+      node.display = ParseDisplay(tok.ReadString());
+    } else if (key == "visibility") {
+      if (tok.ReadString() != "visible") {
+        node.flags &= ~FragmentNode::kVisible;
+      }
+    } else if (key == "float") {
+      std::string value = tok.ReadString();
+      node.floating = value == "left"    ? Float::kLeft
+                      : value == "right" ? Float::kRight
+                                         : Float::kNone;
+    } else if (key == "font_family") {
+      data.font.family = tok.ReadString();
+    } else if (key == "font_size") {
+      data.font.size = ReadFloat(tok);
+    } else if (key == "font_weight") {
+      data.font.weight = static_cast<int>(tok.ReadNumber());
+    } else if (key == "font_style") {
+      data.font.italic = tok.ReadString() != "normal";
+    } else if (key == "color") {
+      data.color = ParseColor(tok);
+    } else {
+      tok.SkipValue();
+    }
+  });
+}
+
+void ParseTextFragment(JsonTokenizer& tok, FragmentTree& tree) {
+  TextFragment fragment;
+  fragment.first_run = static_cast<uint32_t>(tree.runs.size());
+  RectF& rect = fragment.rect;
+  ParseObject(tok, [&](const std::string& key) {
+    if (key == "x") {
+      rect.x = ReadFloat(tok);
+    } else if (key == "y") {
+      rect.y = ReadFloat(tok);
+    } else if (key == "width") {
+      rect.width = ReadFloat(tok);
+    } else if (key == "height") {
+      rect.height = ReadFloat(tok);
+    } else if (key == "start") {
+      fragment.start = static_cast<unsigned>(tok.ReadNumber());
+    } else if (key == "end") {
+      fragment.end = static_cast<unsigned>(tok.ReadNumber());
+    } else if (key == "runs") {
+      ParseArray(tok, [&] {
+        TextRun run;
+        ParseObject(tok, [&](const std::string& run_key) {
+          if (run_key == "glyphs") {
+            ParseArray(tok, [&] {
+              run.glyphs.push_back(static_cast<uint16_t>(tok.ReadNumber()));
+            });
+          } else if (run_key == "positions") {
+            ParseArray(tok, [&] { run.positions.push_back(ReadFloat(tok)); });
+          } else if (run_key == "positioning") {
+            run.positioning = static_cast<int>(tok.ReadNumber());
+          } else {
+            tok.SkipValue();
+          }
+        });
+        tree.runs.push_back(std::move(run));
+      });
+    } else {
+      tok.SkipValue();
+    }
+  });
+  fragment.run_count =
+      static_cast<uint32_t>(tree.runs.size()) - fragment.first_run;
+  tree.text_fragments.push_back(fragment);
+}
+
+void ParseNode(JsonTokenizer& tok, FragmentTree& tree,
+               std::vector<int64_t>& child_ids) {
+  FragmentNode node;
+  FragmentData data;
+  node.flags = FragmentNode::kVisible;
+
+  ParseObject(tok, [&](const std::string& key) {
+    if (key == "id") {
+      data.id = static_cast<int64_t>(tok.ReadNumber());
+    } else if (key == "z_index") {
+      node.z_index = static_cast<int32_t>(tok.ReadNumber());
+    } else if (key == "is_stacking_context") {
+      if (tok.ReadBool()) node.flags |= FragmentNode::kStackingContext;
+    } else if (key == "is_stacked") {
+      if (tok.ReadBool()) node.flags |= FragmentNode::kStacked;
+    } else if (key == "is_self_painting") {
+      if (tok.ReadBool()) node.flags |= FragmentNode::kSelfPaintingLayer;
+    } else if (key == "computed_style") {
+      ParseComputedStyle(tok, node, data);
+    } else if (key == "geometry") {
+      data.geometry = ParseRect(tok);
+      node.flags |= FragmentNode::kHasGeometry;
+    } else if (key == "background_color") {
+      if (!tok.ReadNull()) data.background_color = ParseColor(tok);
+    } else if (key == "border_widths") {
+      ParseSides(tok, data.border_widths, [&] { return ReadFloat(tok); });
+    } else if (key == "border_colors") {
+      ParseSides(tok, data.border_colors, [&] { return ParseColor(tok); });
+    } else if (key == "border_styles") {
+      ParseSides(tok, data.border_styles,
+                 [&] { return ParseBorderStyle(tok.ReadString()); });
+    } else if (key == "border_radii") {
+      std::array<float, 8> radii = {};
+      size_t i = 0;
+      ParseArray(tok, [&] {
+        float value = ReadFloat(tok);
+        if (i < radii.size()) radii[i++] = value;
+      });
+      data.border_radii = radii;
+    } else if (key == "box_shadow") {
+      ParseArray(tok, [&] { data.box_shadow.push_back(ParseBoxShadow(tok)); });
+    } else if (key == "text") {
+      data.text = tok.ReadString();
+      node.flags |= FragmentNode::kIsText;
+    } else if (key == "fragments") {
+      data.first_text_fragment =
+          static_cast<uint32_t>(tree.text_fragments.size());
+      ParseArray(tok, [&] { ParseTextFragment(tok, tree); });
+      data.text_fragment_count =
+          static_cast<uint32_t>(tree.text_fragments.size()) -
+          data.first_text_fragment;
+    } else if (key == "children") {
+      ParseArray(tok, [&] {
+        child_ids.push_back(static_cast<int64_t>(tok.ReadNumber()));
+      });
+    } else {
+      tok.SkipValue();
+    }
+  });
+
+  tree.nodes.push_back(node);
+  tree.data.push_back(std::move(data));
+}
+
+}  // namespace
+
+FragmentTree ParseFragmentTree(const std::string& json_str) {
+  JsonTokenizer tok(json_str);
+  FragmentTree tree;
+  std::vector<std::vector<int64_t>> child_ids;
+
+  ParseObject(tok, [&](const std::string& key) {
+    if (key == "layout_tree") {
+      ParseArray(tok, [&] {
+        child_ids.emplace_back();
+        ParseNode(tok, tree, child_ids.back());
+      });
+    } else {
+      tok.SkipValue();
+    }
+  });
+
+  if (!tree.Finalize(child_ids)) {
+    throw std::runtime_error("Invalid layout tree: broken child list");
+  }
+  return tree;
+}
+
+}  // namespace box_fragment_painter
@@ -0,0 +1,17 @@
+#ifndef BOX_FRAGMENT_PAINTER_TREE_PARSER_H_
+#define BOX_FRAGMENT_PAINTER_TREE_PARSER_H_
+
+#include <string>
+
+#include "fragment_tree.h"
+
+namespace box_fragment_painter {
+
+// Parse a shaped layout tree ({"layout_tree": [node, ...]}, as written by
+// 02_shape) into a finalized FragmentTree. Throws std::runtime_error on
+// malformed JSON or a broken child list.
+FragmentTree ParseFragmentTree(const std::string& json_str);
+
+}  // namespace box_fragment_painter
+
+#endif  // BOX_FRAGMENT_PAINTER_TREE_PARSER_H_
@@ -16,6 +16,8 @@
 #include <cmath>
 #include <algorithm>
 
+namespace text_painter {
+
 namespace {
 
 float RoundDownThickness(float stroke_thickness) {
@@ -273,3 +275,5 @@ void DecorationLinePainter::PaintWavyTextDecoration(
       state_ids_.effect_id
   });
 }
+
+}  // namespace text_painter
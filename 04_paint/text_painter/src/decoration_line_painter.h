@@ -11,6 +11,8 @@
 #include "types.h"
 #include "draw_commands.h"
 
+namespace text_painter {
+
 // Helper class for painting text decorations. Each instance paints a single
 // decoration.
 //
@@ -36,4 +38,6 @@ class DecorationLinePainter {
   const GraphicsStateIds& state_ids_;
 };
 
+}  // namespace text_painter
+
 #endif  // TEXT_PAINTER_DECORATION_LINE_PAINTER_H_
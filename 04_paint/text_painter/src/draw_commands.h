@@ -6,6 +6,8 @@
 #include <variant>
 #include <vector>
 
+namespace text_painter {
+
 // Drawing operations matching Chromium's paint op format
 
 // Font info for serialization in a run
@@ -28,10 +30,10 @@ struct RunFont {
 struct TextBlobRun {
   size_t glyph_count = 0;
   std::vector<uint16_t> glyphs;
-  int positioning = 1;  // 1 = horizontal positions only
+  int positioning = 1;  // 1 = horizontal, 2 = x/y pairs, 3 = RSXforms
   float offset_x = 0.0f;
   float offset_y = 0.0f;
-  std::vector<float> positions;
+  std::vector<float> positions;  // 1, 2 or 4 floats per glyph (see positioning)
   RunFont font;
 };
 
@@ -204,7 +206,7 @@ struct DrawEmphasisMarksOp {
   float x = 0.0f;
   float y = 0.0f;
   std::string mark;  // The emphasis mark glyph
-  std::vector<float> positions;  // X positions for each mark
+  std::vector<float> positions;  // X center of each mark, relative to x
   Color color;
   float font_size = 16.0f;
   int transform_id = 0;
@@ -392,4 +394,6 @@ struct PaintOpList {
   }
 };
 
+}  // namespace text_painter
+
 #endif  // TEXT_PAINTER_DRAW_COMMANDS_H_
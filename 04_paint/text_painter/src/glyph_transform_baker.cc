@@ -0,0 +1,164 @@
+#include "glyph_transform_baker.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace text_painter {
+
+namespace {
+
+// Rotations built from float sin/cos leave ~1e-8 residue in the zero terms
+constexpr float kBakeEpsilon = 1e-5f;
+
+bool NearlyZero(float v) { return std::fabs(v) <= kBakeEpsilon; }
+
+bool NearlyEqual(float a, float b) {
+  return std::fabs(a - b) <= kBakeEpsilon * std::max(1.0f, std::fabs(a));
+}
+
+}  // namespace
+
+GlyphBakeMode ClassifyGlyphBake(const AffineTransform& t) {
+  if (NearlyZero(t.b) && NearlyZero(t.c)) {
+    // Pure scale + translate; mirrored axes would flip glyph outlines
+    if (t.a > 0.0f && t.d > 0.0f) {
+      return GlyphBakeMode::kFullPositions;
+    }
+    return GlyphBakeMode::kNone;
+  }
+  // Similarity: [a -b; b a] (rotation + uniform scale, no reflection)
+  if (NearlyEqual(t.a, t.d) && NearlyEqual(t.b, -t.c)) {
+    return GlyphBakeMode::kRSXform;
+  }
+  return GlyphBakeMode::kNone;
+}
+
+void MapGlyphPositions(const float* xs, size_t count, float offset_x,
+                       float offset_y, const AffineTransform& t, float* out) {
+  // x' = a * (x + ox) + c * oy, y' = b * (x + ox) + d * oy
+  const float base_x = t.a * offset_x + t.c * offset_y;
+  const float base_y = t.b * offset_x + t.d * offset_y;
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  const __m128 va = _mm_set1_ps(t.a);
+  const __m128 vb = _mm_set1_ps(t.b);
+  const __m128 vbx = _mm_set1_ps(base_x);
+  const __m128 vby = _mm_set1_ps(base_y);
+  for (; i + 4 <= count; i += 4) {
+    __m128 x = _mm_loadu_ps(xs + i);
+    __m128 mx = _mm_add_ps(_mm_mul_ps(va, x), vbx);
+    __m128 my = _mm_add_ps(_mm_mul_ps(vb, x), vby);
+    // x0 y0 x1 y1 | x2 y2 x3 y3
+    _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(mx, my));
+    _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(mx, my));
+  }
+#endif
+
+  for (; i < count; ++i) {
+    out[2 * i] = t.a * xs[i] + base_x;
+    out[2 * i + 1] = t.b * xs[i] + base_y;
+  }
+}
+
+void MapGlyphRSXforms(const float* xs, size_t count, float offset_x,
+                      float offset_y, const AffineTransform& t, float* out) {
+  const float base_x = t.a * offset_x + t.c * offset_y;
+  const float base_y = t.b * offset_x + t.d * offset_y;
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  const __m128 va = _mm_set1_ps(t.a);
+  const __m128 vb = _mm_set1_ps(t.b);
+  const __m128 vbx = _mm_set1_ps(base_x);
+  const __m128 vby = _mm_set1_ps(base_y);
+  const __m128 scos_ssin = _mm_setr_ps(t.a, t.b, t.a, t.b);
+  for (; i + 4 <= count; i += 4) {
+    __m128 x = _mm_loadu_ps(xs + i);
+    __m128 mx = _mm_add_ps(_mm_mul_ps(va, x), vbx);
+    __m128 my = _mm_add_ps(_mm_mul_ps(vb, x), vby);
+    __m128 lo = _mm_unpacklo_ps(mx, my);  // x0 y0 x1 y1
+    __m128 hi = _mm_unpackhi_ps(mx, my);  // x2 y2 x3 y3
+    float* dst = out + 4 * i;
+    _mm_storeu_ps(dst, _mm_movelh_ps(scos_ssin, lo));       // a b x0 y0
+    _mm_storeu_ps(dst + 4, _mm_movehl_ps(lo, scos_ssin));   // a b x1 y1
+    _mm_storeu_ps(dst + 8, _mm_movelh_ps(scos_ssin, hi));   // a b x2 y2
+    _mm_storeu_ps(dst + 12, _mm_movehl_ps(hi, scos_ssin));  // a b x3 y3
+  }
+#endif
+
+  for (; i < count; ++i) {
+    out[4 * i] = t.a;
+    out[4 * i + 1] = t.b;
+    out[4 * i + 2] = t.a * xs[i] + base_x;
+    out[4 * i + 3] = t.b * xs[i] + base_y;
+  }
+}
+
+bool BakeGlyphTransform(const AffineTransform& transform, PointF& origin,
+                        std::array<float, 4>& bounds,
+                        std::vector<TextBlobRun>& runs) {
+  // Snap the sin/cos residue so 90 degree rotations bake to exact 0/1 terms
+  AffineTransform t = transform;
+  for (float* v : {&t.a, &t.b, &t.c, &t.d}) {
+    if (NearlyZero(*v)) *v = 0.0f;
+  }
+
+  GlyphBakeMode mode = ClassifyGlyphBake(t);
+  if (mode == GlyphBakeMode::kNone) return false;
+  for (const auto& run : runs) {
+    if (run.positioning != 1 || run.positions.size() < run.glyph_count) {
+      return false;
+    }
+  }
+
+  std::vector<float> baked;
+  for (auto& run : runs) {
+    const size_t n = run.glyph_count;
+    if (mode == GlyphBakeMode::kFullPositions) {
+      baked.resize(2 * n);
+      MapGlyphPositions(run.positions.data(), n, run.offset_x, run.offset_y,
+                        t, baked.data());
+      // Glyph outlines pick up the scale through the font instead
+      run.font.size *= t.d;
+      run.font.scale_x *= t.a / t.d;
+      run.positioning = 2;
+    } else {
+      baked.resize(4 * n);
+      MapGlyphRSXforms(run.positions.data(), n, run.offset_x, run.offset_y,
+                       t, baked.data());
+      run.positioning = 3;
+    }
+    run.positions.swap(baked);
+    run.offset_x = 0.0f;
+    run.offset_y = 0.0f;
+  }
+
+  // Bounds are origin-relative, so only the linear part applies
+  const float corners[4][2] = {{bounds[0], bounds[1]}, {bounds[2], bounds[1]},
+                               {bounds[0], bounds[3]}, {bounds[2], bounds[3]}};
+  float left = 0, top = 0, right = 0, bottom = 0;
+  for (int k = 0; k < 4; ++k) {
+    float x = t.a * corners[k][0] + t.c * corners[k][1];
+    float y = t.b * corners[k][0] + t.d * corners[k][1];
+    if (k == 0) {
+      left = right = x;
+      top = bottom = y;
+    } else {
+      left = std::min(left, x);
+      right = std::max(right, x);
+      top = std::min(top, y);
+      bottom = std::max(bottom, y);
+    }
+  }
+  bounds = {left, top, right, bottom};
+
+  origin = PointF{t.a * origin.x + t.c * origin.y + t.e,
+                  t.b * origin.x + t.d * origin.y + t.f};
+  return true;
+}
+
+}  // namespace text_painter
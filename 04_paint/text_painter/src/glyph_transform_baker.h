@@ -0,0 +1,60 @@
+#ifndef TEXT_PAINTER_GLYPH_TRANSFORM_BAKER_H_
+#define TEXT_PAINTER_GLYPH_TRANSFORM_BAKER_H_
+
+#include "types.h"
+#include "draw_commands.h"
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace text_painter {
+
+// Folds the canvas transform that TextPainter would otherwise wrap around a
+// text blob (SVG scaling factor, SVG transform, vertical writing-mode
+// rotation) into the glyph positions of each run, so the replayer can draw
+// the blob without a Save/Concat/Restore round trip.
+//
+// Skia's SkTextBlob positioning modes are used as the target encoding:
+//   - Axis-aligned positive scales become positioning=2 runs (one x/y pair
+//     per glyph) with the scale folded into font size / scale_x.
+//   - Similarity transforms (uniform scale + rotation, which covers the
+//     vertical-rl / vertical-lr rotations) become positioning=3 runs with
+//     one RSXform {scos, ssin, tx, ty} per glyph.
+//   - Anything else (skew, mirroring, non-uniform scale under rotation) can
+//     not be expressed per glyph and is left to the canvas transform.
+enum class GlyphBakeMode {
+  kNone,           // Transform must stay on the canvas
+  kFullPositions,  // positioning = 2
+  kRSXform         // positioning = 3
+};
+
+// Decide how (and whether) |transform| can be folded into glyph positions.
+GlyphBakeMode ClassifyGlyphBake(const AffineTransform& transform);
+
+// Map |count| horizontal glyph positions through the linear part of
+// |transform|. Each input glyph sits at (xs[i] + offset_x, offset_y) relative
+// to the blob origin; |out| receives 2 * |count| floats as interleaved x/y.
+void MapGlyphPositions(const float* xs, size_t count, float offset_x,
+                       float offset_y, const AffineTransform& transform,
+                       float* out);
+
+// Same as MapGlyphPositions but writes 4 * |count| floats as RSXforms
+// {scos, ssin, tx, ty} with scos = transform.a and ssin = transform.b.
+void MapGlyphRSXforms(const float* xs, size_t count, float offset_x,
+                      float offset_y, const AffineTransform& transform,
+                      float* out);
+
+// Rewrite |runs| (positioning = 1 input), the blob |origin| and the
+// origin-relative |bounds| so that drawing the result under the parent
+// transform matches drawing the originals under |transform|.
+// Returns false and leaves everything untouched if |transform| cannot be
+// baked or any run is not horizontally positioned. Only glyph geometry is
+// rewritten: callers keep stroked and shadowed blobs on the canvas
+// transform, since their flags are not scaled.
+bool BakeGlyphTransform(const AffineTransform& transform, PointF& origin,
+                        std::array<float, 4>& bounds,
+                        std::vector<TextBlobRun>& runs);
+
+}  // namespace text_painter
+
+#endif  // TEXT_PAINTER_GLYPH_TRANSFORM_BAKER_H_
@@ -1,8 +1,12 @@
 #include "json_parser.h"
+
+#include <algorithm>
 #include <cctype>
 #include <cstdlib>
 #include <sstream>
 
+namespace text_painter {
+
 namespace {
 
 // Skip whitespace
@@ -218,6 +222,20 @@ std::vector<uint16_t> JsonParser::ParseIntArray(const std::string& array_str) {
   return result;
 }
 
+std::vector<uint32_t> JsonParser::ParseUintArray(const std::string& array_str) {
+  std::vector<uint32_t> result;
+  std::istringstream iss(array_str);
+  std::string token;
+  while (std::getline(iss, token, ',')) {
+    size_t first = token.find_first_not_of(" \t\n\r[]");
+    if (first != std::string::npos) {
+      result.push_back(static_cast<uint32_t>(
+          std::strtoul(token.c_str() + first, nullptr, 10)));
+    }
+  }
+  return result;
+}
+
 std::vector<float> JsonParser::ParseFloatArray(const std::string& array_str) {
   std::vector<float> result;
   std::istringstream iss(array_str);
@@ -269,6 +287,16 @@ GlyphRun JsonParser::ParseGlyphRun(const std::string& json) {
   std::string positions_str = ExtractArray(json, "positions");
   run.positions = ParseFloatArray(positions_str);
 
+  // Parse optional cluster map (one text offset per glyph)
+  std::string clusters_str = ExtractArray(json, "clusters");
+  if (!clusters_str.empty()) {
+    run.clusters = ParseUintArray(clusters_str);
+  }
+
+  // Parse optional per-glyph ink extents (for skip-ink decorations)
+  run.ink_top = ParseFloatArray(ExtractArray(json, "inkTop"));
+  run.ink_bottom = ParseFloatArray(ExtractArray(json, "inkBottom"));
+
   run.offset_x = ExtractFloat(json, "offsetX", 0.0f);
   run.offset_y = ExtractFloat(json, "offsetY", 0.0f);
   run.positioning = ExtractInt(json, "positioning", 1);
@@ -276,6 +304,21 @@ GlyphRun JsonParser::ParseGlyphRun(const std::string& json) {
   return run;
 }
 
+CullRect JsonParser::ParseCullRect(const std::string& json) {
+  RectF rect;
+  rect.x = ExtractFloat(json, "x", 0.0f);
+  rect.y = ExtractFloat(json, "y", 0.0f);
+  rect.width = ExtractFloat(json, "width", 0.0f);
+  rect.height = ExtractFloat(json, "height", 0.0f);
+  CullRect::Transform local_to_root = CullRect::kIdentity;
+  std::vector<float> transform =
+      ParseFloatArray(ExtractArray(json, "local_to_root"));
+  if (transform.size() == 6) {
+    std::copy(transform.begin(), transform.end(), local_to_root.begin());
+  }
+  return CullRect(rect, local_to_root);
+}
+
 bool JsonParser::ParseInput(const std::string& json, TextPaintInput& output) {
   // Parse fragment
   std::string fragment = ExtractObject(json, "fragment");
@@ -420,6 +463,7 @@ bool JsonParser::ParseInput(const std::string& json, TextPaintInput& output) {
       decoration.color = Color::FromHex(ExtractString(dec_json, "color"));
       decoration.thickness = ExtractFloat(dec_json, "thickness", 1.0f);
       decoration.underline_offset = ExtractFloat(dec_json, "underline_offset", 0.0f);
+      decoration.skip_ink = ExtractString(dec_json, "skip_ink") != "none";
 
       output.decorations.push_back(decoration);
     }
@@ -495,10 +539,17 @@ bool JsonParser::ParseInput(const std::string& json, TextPaintInput& output) {
     output.dark_mode.enabled = ExtractBool(dark_mode, "enabled", false);
   }
 
+  // Parse cull_rect (root space, with the local-to-root transform)
+  std::string cull_rect = ExtractObject(json, "cull_rect");
+  if (!cull_rect.empty()) {
+    output.cull_rect = ParseCullRect(cull_rect);
+  }
+
   // Parse flags
   output.is_ellipsis = ExtractBool(json, "is_ellipsis", false);
   output.is_line_break = ExtractBool(json, "is_line_break", false);
   output.is_flow_control = ExtractBool(json, "is_flow_control", false);
+  output.bake_glyph_transforms = ExtractBool(json, "bake_glyph_transforms", false);
 
   // Parse shadows in style
   if (!style.empty()) {
@@ -523,6 +574,33 @@ bool JsonParser::ParseInput(const std::string& json, TextPaintInput& output) {
   return true;
 }
 
+bool JsonParser::ParseDocument(const std::string& json,
+                               std::vector<TextPaintInput>& outputs) {
+  std::string fragments_str = ExtractArray(json, "fragments");
+  if (fragments_str.empty()) {
+    TextPaintInput input;
+    if (!ParseInput(json, input)) return false;
+    outputs.push_back(std::move(input));
+    return true;
+  }
+
+  // A document-level cull rect applies to the fragments without their own;
+  // look for it outside the fragment list
+  std::string document = json;
+  document.erase(document.find(fragments_str), fragments_str.length());
+  std::string cull_rect = ExtractObject(document, "cull_rect");
+
+  for (const auto& fragment_json : SplitArrayElements(fragments_str)) {
+    TextPaintInput input;
+    if (!ParseInput(fragment_json, input)) return false;
+    if (input.cull_rect.IsInfinite() && !cull_rect.empty()) {
+      input.cull_rect = ParseCullRect(cull_rect);
+    }
+    outputs.push_back(std::move(input));
+  }
+  return true;
+}
+
 std::string JsonParser::SerializeOps(const PaintOpList& ops) {
   std::ostringstream oss;
   oss << "[\n";
@@ -742,13 +820,37 @@ std::string JsonParser::SerializeOps(const PaintOpList& ops) {
               oss << "],\n"
                   << "        \"positioning\": " << run.positioning << ",\n"
                   << "        \"offsetX\": " << run.offset_x << ",\n"
-                  << "        \"offsetY\": " << run.offset_y << ",\n"
-                  << "        \"positions\": [";
-              for (size_t k = 0; k < run.positions.size(); ++k) {
-                if (k > 0) oss << ", ";
-                oss << run.positions[k];
+                  << "        \"offsetY\": " << run.offset_y << ",\n";
+              if (run.positioning == 3) {
+                // RSXform positioning: {scos, ssin, tx, ty} per glyph, in
+                // place of positions
+                oss << "        \"rsxforms\": [";
+                for (size_t k = 0; k + 3 < run.positions.size(); k += 4) {
+                  if (k > 0) oss << ", ";
+                  oss << "{\"scos\": " << run.positions[k]
+                      << ", \"ssin\": " << run.positions[k + 1]
+                      << ", \"tx\": " << run.positions[k + 2]
+                      << ", \"ty\": " << run.positions[k + 3] << "}";
+                }
+                oss << "],\n";
+              } else {
+                oss << "        \"positions\": [";
+                if (run.positioning == 2) {
+                  // Full positioning: interleaved x/y pairs
+                  for (size_t k = 0; k + 1 < run.positions.size(); k += 2) {
+                    if (k > 0) oss << ", ";
+                    oss << "{\"x\": " << run.positions[k]
+                        << ", \"y\": " << run.positions[k + 1] << "}";
+                  }
+                } else {
+                  for (size_t k = 0; k < run.positions.size(); ++k) {
+                    if (k > 0) oss << ", ";
+                    oss << run.positions[k];
+                  }
+                }
+                oss << "],\n";
               }
-              oss << "],\n"
+              oss
                   << "        \"font\": {\n"
                   << "          \"size\": " << run.font.size << ",\n"
                   << "          \"scaleX\": " << run.font.scale_x << ",\n"
@@ -779,3 +881,5 @@ std::string JsonParser::SerializeOps(const PaintOpList& ops) {
   oss << "\n]";
   return oss.str();
 }
+
+}  // namespace text_painter
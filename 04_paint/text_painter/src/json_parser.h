@@ -5,6 +5,9 @@
 #include "text_painter.h"
 #include "draw_commands.h"
 #include <string>
+#include <vector>
+
+namespace text_painter {
 
 // Simple JSON parsing and serialization for text painter
 // Uses a minimal approach without external dependencies
@@ -14,6 +17,11 @@ class JsonParser {
   // Parse input JSON into TextPaintInput
   static bool ParseInput(const std::string& json, TextPaintInput& output);
 
+  // Parse a document: {"fragments": [input, ...]} yields one TextPaintInput
+  // per element, any other JSON is parsed as a single input
+  static bool ParseDocument(const std::string& json,
+                            std::vector<TextPaintInput>& outputs);
+
   // Serialize PaintOpList to JSON
   static std::string SerializeOps(const PaintOpList& ops);
 
@@ -51,8 +59,16 @@ class JsonParser {
   // Parse array of integers
   static std::vector<uint16_t> ParseIntArray(const std::string& array_str);
 
+  // Parse array of unsigned 32-bit integers
+  static std::vector<uint32_t> ParseUintArray(const std::string& array_str);
+
+  // Parse a cull rect object (root-space rect and local_to_root)
+  static CullRect ParseCullRect(const std::string& json);
+
   // Parse array of floats
   static std::vector<float> ParseFloatArray(const std::string& array_str);
 };
 
+}  // namespace text_painter
+
 #endif  // TEXT_PAINTER_JSON_PARSER_H_
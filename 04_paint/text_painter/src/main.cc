@@ -1,12 +1,15 @@
 #include "json_parser.h"
 #include "text_painter.h"
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 int main(int argc, char* argv[]) {
   std::string input_file = "input.json";
   std::string output_file = "";
+  bool print_stats = false;
 
   // Parse command line arguments
   for (int i = 1; i < argc; ++i) {
@@ -15,8 +18,14 @@ int main(int argc, char* argv[]) {
       input_file = argv[++i];
     } else if (arg == "-o" && i + 1 < argc) {
       output_file = argv[++i];
+    } else if (arg == "--stats") {
+      print_stats = true;
     } else if (arg == "-h" || arg == "--help") {
-      std::cout << "Usage: " << argv[0] << " [-i input.json] [-o output.json]\n";
+      std::cout << "Usage: " << argv[0]
+                << " [-i input.json] [-o output.json] [--stats]\n"
+                << "  Input is a single fragment, or {\"fragments\": [...]}"
+                << " painted as one document.\n"
+                << "  --stats  Print style cache statistics to stderr\n";
       return 0;
     }
   }
@@ -33,17 +42,35 @@ int main(int argc, char* argv[]) {
   std::string json_input = buffer.str();
 
   // Parse input
-  TextPaintInput input;
-  if (!JsonParser::ParseInput(json_input, input)) {
+  std::vector<text_painter::TextPaintInput> inputs;
+  if (!text_painter::JsonParser::ParseDocument(json_input, inputs)) {
     std::cerr << "Error: Failed to parse input JSON\n";
     return 1;
   }
 
-  // Run text painter
-  PaintOpList ops = TextPainter::Paint(input);
+  // Run text painter over every fragment, sharing resolved styles
+  text_painter::TextPaintStyleCache style_cache;
+  text_painter::PaintOpList ops;
+  for (const auto& input : inputs) {
+    text_painter::PaintOpList fragment_ops =
+        text_painter::TextPainter::Paint(input, &style_cache);
+    ops.ops.insert(ops.ops.end(),
+                   std::make_move_iterator(fragment_ops.ops.begin()),
+                   std::make_move_iterator(fragment_ops.ops.end()));
+  }
+  text_painter::TextPainter::MergeEmphasisMarks(ops);
+
+  if (print_stats) {
+    std::cerr << "fragments: " << inputs.size() << "\n"
+              << "style cache: " << style_cache.hits() << " hits, "
+              << style_cache.misses() << " misses, "
+              << style_cache.size() << " entries ("
+              << std::fixed << std::setprecision(1)
+              << style_cache.HitRate() * 100.0 << "% hit rate)\n";
+  }
 
   // Serialize output
-  std::string json_output = JsonParser::SerializeOps(ops);
+  std::string json_output = text_painter::JsonParser::SerializeOps(ops);
 
   // Write output
   if (output_file.empty()) {
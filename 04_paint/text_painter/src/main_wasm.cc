@@ -31,17 +31,17 @@ const char* paint_text(const char* input_json) {
   }
 
   // Parse input JSON
-  TextPaintInput input;
-  if (!JsonParser::ParseInput(input_json, input)) {
+  text_painter::TextPaintInput input;
+  if (!text_painter::JsonParser::ParseInput(input_json, input)) {
     result = R"({"error": "Failed to parse input JSON"})";
     return result.c_str();
   }
 
   // Run text painter to generate paint operations
-  PaintOpList ops = TextPainter::Paint(input);
+  text_painter::PaintOpList ops = text_painter::TextPainter::Paint(input);
 
   // Serialize paint operations to JSON
-  result = JsonParser::SerializeOps(ops);
+  result = text_painter::JsonParser::SerializeOps(ops);
   return result.c_str();
 }
 
@@ -16,6 +16,8 @@
 #include <cmath>
 #include <algorithm>
 
+namespace text_painter {
+
 namespace {
 
 // Compute decoration thickness from CSS text-decoration-thickness
@@ -249,3 +251,5 @@ Color TextDecorationInfo::LineColor() const {
 RectF TextDecorationInfo::Bounds() const {
   return DecorationLinePainter::Bounds(GetGeometry());
 }
+
+}  // namespace text_painter
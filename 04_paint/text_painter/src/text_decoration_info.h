@@ -19,6 +19,8 @@
 #include "decoration_line_painter.h"
 #include <optional>
 
+namespace text_painter {
+
 // Position of underline relative to text
 enum class ResolvedUnderlinePosition {
   kNearAlphabeticBaselineAuto,
@@ -60,6 +62,8 @@ class TextDecorationInfo {
   bool HasSpellingOrGrammarError() const {
     return HasFlag(lines_, TextDecorationLine::kSpellingError | TextDecorationLine::kGrammarError);
   }
+  // text-decoration-skip-ink of the current decoration
+  bool SkipInk() const { return decorations_[decoration_index_].skip_ink; }
 
   // Set the decoration index to use for subsequent operations
   void SetDecorationIndex(size_t index);
@@ -114,4 +118,6 @@ class TextDecorationInfo {
   DecorationGeometry line_geometry_;
 };
 
+}  // namespace text_painter
+
 #endif  // TEXT_PAINTER_TEXT_DECORATION_INFO_H_
@@ -11,8 +11,97 @@
 // - Added shadow support via PaintWithTextShadow pattern
 // - Uses PaintOpList instead of GraphicsContext
 // - Uses DecorationLinePainter directly
+// - Skip-ink is computed from per-glyph ink extents and splits the line,
+//   instead of clipping out Font::GetTextIntercepts
 
 #include "text_decoration_painter.h"
+#include <algorithm>
+
+namespace text_painter {
+
+namespace {
+
+// Same cap Chromium applies to the clip-out dilation around intercepts
+constexpr float kDecorationClipMaxDilation = 13;
+
+// Horizontal span [begin, end] of ink the decoration must skip
+struct InkSkipInterval {
+  float begin;
+  float end;
+};
+
+// Collects the glyphs whose ink crosses the stripe [upper, lower] (absolute
+// y) and merges them into sorted, disjoint intervals dilated by |dilation|.
+// A glyph spans its advance, i.e. up to the next glyph origin (or the ink
+// bounds' right edge for the final glyph). Blob glyphs arrive in visual
+// order, so each glyph is visited once and only merged against the last
+// interval: O(glyphs). Out-of-order input falls back to a sort + merge.
+std::vector<InkSkipInterval> ComputeInkSkipIntervals(const ShapeResult& shape,
+                                                     const PointF& origin,
+                                                     float upper, float lower,
+                                                     float dilation) {
+  std::vector<InkSkipInterval> intervals;
+  const float text_right = origin.x + shape.bounds.x + shape.bounds.width;
+  bool in_order = true;
+
+  auto add = [&](float begin, float end) {
+    begin -= dilation;
+    end += dilation;
+    if (!intervals.empty()) {
+      InkSkipInterval& last = intervals.back();
+      if (begin >= last.begin && begin <= last.end) {
+        last.end = std::max(last.end, end);
+        return;
+      }
+      in_order &= begin > last.end;
+    }
+    intervals.push_back({begin, end});
+  };
+
+  for (size_t r = 0; r < shape.runs.size(); ++r) {
+    const GlyphRun& run = shape.runs[r];
+    if (!run.HasInkExtents()) continue;
+
+    const float run_x = origin.x + run.offset_x;
+    const float baseline = origin.y + run.offset_y;
+    float run_end = text_right;
+    if (r + 1 < shape.runs.size() && !shape.runs[r + 1].positions.empty()) {
+      const GlyphRun& next = shape.runs[r + 1];
+      run_end = origin.x + next.offset_x + next.positions[0];
+    }
+
+    const size_t count = run.GlyphCount();
+    for (size_t i = 0; i < count; ++i) {
+      if (baseline + run.ink_bottom[i] < upper ||
+          baseline + run.ink_top[i] > lower) {
+        continue;
+      }
+      const float begin = run_x + run.positions[i];
+      const float end = i + 1 < count ? run_x + run.positions[i + 1] : run_end;
+      add(std::min(begin, end), std::max(begin, end));
+    }
+  }
+
+  if (!in_order) {
+    std::sort(intervals.begin(), intervals.end(),
+              [](const InkSkipInterval& a, const InkSkipInterval& b) {
+                return a.begin < b.begin;
+              });
+    size_t merged = 0;
+    for (size_t i = 1; i < intervals.size(); ++i) {
+      if (intervals[i].begin <= intervals[merged].end) {
+        intervals[merged].end =
+            std::max(intervals[merged].end, intervals[i].end);
+      } else {
+        intervals[++merged] = intervals[i];
+      }
+    }
+    intervals.resize(merged + 1);
+  }
+  return intervals;
+}
+
+}  // namespace
 
 TextDecorationPainter::TextDecorationPainter(
     PaintOpList& ops,
@@ -66,15 +155,13 @@ void TextDecorationPainter::PaintUnderOrOverLineDecorations(
       if (decoration_info_.HasUnderline() &&
           HasFlag(lines_to_paint, TextDecorationLine::kUnderline)) {
         decoration_info_.SetUnderlineLineData();
-        line_painter.Paint(decoration_info_.GetGeometry(),
-                           LineColorForPhase(phase));
+        PaintLineSkippingInk(line_painter, LineColorForPhase(phase));
       }
 
       if (decoration_info_.HasOverline() &&
           HasFlag(lines_to_paint, TextDecorationLine::kOverline)) {
         decoration_info_.SetOverlineLineData();
-        line_painter.Paint(decoration_info_.GetGeometry(),
-                           LineColorForPhase(phase));
+        PaintLineSkippingInk(line_painter, LineColorForPhase(phase));
       }
     }
   };
@@ -83,6 +170,51 @@ void TextDecorationPainter::PaintUnderOrOverLineDecorations(
   PaintWithTextShadow(paint_decorations, ops_, shadows_);
 }
 
+void TextDecorationPainter::PaintLineSkippingInk(
+    DecorationLinePainter& line_painter, const Color& color) {
+  const DecorationGeometry& geometry = decoration_info_.GetGeometry();
+
+  // Dotted, dashed and wavy patterns are phased from the line start, so
+  // splitting them would shift the pattern; only continuous lines skip ink.
+  const bool can_split = geometry.style == StrokeStyle::kSolidStroke ||
+                         geometry.style == StrokeStyle::kDoubleStroke;
+  if (!ink_shape_ || !can_split || !decoration_info_.SkipInk()) {
+    line_painter.Paint(geometry, color);
+    return;
+  }
+
+  // In order to ignore intersects less than 0.5px, inflate by -0.5.
+  RectF stripe = DecorationLinePainter::Bounds(geometry);
+  const float upper = stripe.y + 0.5f;
+  const float lower = stripe.y + stripe.height - 0.5f;
+  const float dilation =
+      std::min(geometry.Thickness(), kDecorationClipMaxDilation);
+
+  std::vector<InkSkipInterval> intervals = ComputeInkSkipIntervals(
+      *ink_shape_, text_origin_, upper, lower, dilation);
+  if (intervals.empty()) {
+    line_painter.Paint(geometry, color);
+    return;
+  }
+
+  // Paint the gaps between the merged intervals
+  const float line_end = geometry.line.x + geometry.line.width;
+  float x = geometry.line.x;
+  DecorationGeometry segment = geometry;
+  for (const InkSkipInterval& interval : intervals) {
+    if (interval.begin > x) {
+      segment.line.x = x;
+      segment.line.width = std::min(interval.begin, line_end) - x;
+      line_painter.Paint(segment, color);
+    }
+    x = std::max(x, interval.end);
+    if (x >= line_end) return;
+  }
+  segment.line.x = x;
+  segment.line.width = line_end - x;
+  line_painter.Paint(segment, color);
+}
+
 void TextDecorationPainter::PaintLineThroughDecorations() {
   DecorationLinePainter line_painter(ops_, state_ids_);
 
@@ -126,3 +258,5 @@ void TextDecorationPainter::PaintAll() {
   PaintExceptLineThrough();
   PaintOnlyLineThrough();
 }
+
+}  // namespace text_painter
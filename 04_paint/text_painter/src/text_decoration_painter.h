@@ -12,6 +12,8 @@
 // - Removed InlinePaintContext dependency
 // - Uses PaintOpList instead of GraphicsContext
 // - Added shadow support via PaintWithTextShadow pattern
+// - Skip-ink splits the line into the gaps between glyph ink instead of
+//   clipping out text intercepts
 
 #ifndef TEXT_PAINTER_TEXT_DECORATION_PAINTER_H_
 #define TEXT_PAINTER_TEXT_DECORATION_PAINTER_H_
@@ -23,6 +25,8 @@
 #include "text_shadow_painter.h"
 #include <optional>
 
+namespace text_painter {
+
 // TextDecorationPainter - paints text decorations (underline, overline, line-through)
 //
 // This version supports:
@@ -60,6 +64,14 @@ class TextDecorationPainter {
   // Check if there are any decorations to paint
   bool HasDecorations() const { return !decorations_.empty(); }
 
+  // Enable text-decoration-skip-ink for underlines and overlines, using the
+  // per-glyph ink extents of |shape| drawn at baseline origin |text_origin|.
+  // Runs without ink extents do not interrupt the line.
+  void SetInkSkipSource(const ShapeResult* shape, const PointF& text_origin) {
+    ink_shape_ = shape;
+    text_origin_ = text_origin;
+  }
+
   // Get the decoration info for external use
   TextDecorationInfo& GetDecorationInfo() { return decoration_info_; }
 
@@ -67,6 +79,11 @@ class TextDecorationPainter {
   void PaintUnderOrOverLineDecorations(TextDecorationLine lines_to_paint);
   void PaintLineThroughDecorations();
 
+  // Paint the current under/overline, leaving gaps where glyph ink crosses
+  // it if skip-ink applies
+  void PaintLineSkippingInk(DecorationLinePainter& line_painter,
+                            const Color& color);
+
   // Get line color based on shadow phase
   Color LineColorForPhase(TextShadowPaintPhase phase) const;
 
@@ -75,6 +92,10 @@ class TextDecorationPainter {
   std::vector<TextDecoration> decorations_;
   std::optional<std::vector<ShadowData>> shadows_;
   TextDecorationInfo decoration_info_;
+  const ShapeResult* ink_shape_ = nullptr;
+  PointF text_origin_;
 };
 
+}  // namespace text_painter
+
 #endif  // TEXT_PAINTER_TEXT_DECORATION_PAINTER_H_
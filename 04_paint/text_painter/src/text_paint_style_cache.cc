@@ -0,0 +1,48 @@
+#include "text_paint_style_cache.h"
+
+namespace text_painter {
+
+TextPaintStyleCache::Entry* TextPaintStyleCache::Find(
+    size_t hash,
+    const TextPaintStyle& style,
+    PaintPhase phase,
+    bool dark_mode) {
+  auto range = entries_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second.Matches(style, phase, dark_mode))
+      return &it->second;
+  }
+  return nullptr;
+}
+
+const ResolvedTextPaint* TextPaintStyleCache::Lookup(
+    const TextPaintStyle& style,
+    PaintPhase phase,
+    const AutoDarkMode& dark_mode) {
+  Entry* entry =
+      Find(KeyHash(style, phase, dark_mode.enabled), style, phase,
+           dark_mode.enabled);
+  if (!entry) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  return &entry->resolved;
+}
+
+const ResolvedTextPaint& TextPaintStyleCache::Insert(
+    const TextPaintStyle& style,
+    PaintPhase phase,
+    const AutoDarkMode& dark_mode,
+    ResolvedTextPaint resolved) {
+  size_t hash = KeyHash(style, phase, dark_mode.enabled);
+  if (Entry* entry = Find(hash, style, phase, dark_mode.enabled)) {
+    entry->resolved = std::move(resolved);
+    return entry->resolved;
+  }
+  auto it = entries_.emplace(
+      hash, Entry{style, phase, dark_mode.enabled, std::move(resolved)});
+  return it->second.resolved;
+}
+
+}  // namespace text_painter
@@ -0,0 +1,85 @@
+#ifndef TEXT_PAINTER_TEXT_PAINT_STYLE_CACHE_H_
+#define TEXT_PAINTER_TEXT_PAINT_STYLE_CACHE_H_
+
+#include "types.h"
+#include <cstddef>
+#include <unordered_map>
+
+namespace text_painter {
+
+// Everything TextPainter::Paint derives from the style alone: the effective
+// style after paint-phase overrides, the blob flags, and the shadow / paint
+// order decisions.
+struct ResolvedTextPaint {
+  // Effective style, with text clip overrides applied to colors, shadows
+  // and paint order
+  TextPaintStyle style;
+  PaintFlags flags;  // Flags for DrawTextBlobOp
+  bool has_shadows = false;
+};
+
+// Memo from (style, paint phase, dark mode) to ResolvedTextPaint.
+//
+// Most text on a page shares a handful of styles, so a document-level paint
+// loop keeps one cache alive across fragments and passes it to every
+// TextPainter::Paint call. Entries are never evicted; the key space is the
+// set of distinct styles in the document.
+class TextPaintStyleCache {
+ public:
+  // Returns the cached entry or nullptr (counted as a hit / miss)
+  const ResolvedTextPaint* Lookup(const TextPaintStyle& style,
+                                  PaintPhase phase,
+                                  const AutoDarkMode& dark_mode);
+
+  // Stores |resolved| for the key and returns the stored copy
+  const ResolvedTextPaint& Insert(const TextPaintStyle& style,
+                                  PaintPhase phase,
+                                  const AutoDarkMode& dark_mode,
+                                  ResolvedTextPaint resolved);
+
+  size_t hits() const { return hits_; }
+  size_t misses() const { return misses_; }
+  size_t size() const { return entries_.size(); }
+  double HitRate() const {
+    size_t total = hits_ + misses_;
+    return total ? static_cast<double>(hits_) / total : 0.0;
+  }
+
+ private:
+  // Entries are bucketed by KeyHash so Lookup can hash and compare the
+  // caller's style in place; the style is only copied on Insert. The
+  // multimap is node-based, so returned pointers survive later inserts.
+  struct Entry {
+    TextPaintStyle style;
+    PaintPhase phase;
+    bool dark_mode;
+    ResolvedTextPaint resolved;
+
+    bool Matches(const TextPaintStyle& other_style,
+                 PaintPhase other_phase,
+                 bool other_dark_mode) const {
+      return phase == other_phase && dark_mode == other_dark_mode &&
+             style.EqualsIncludingShadow(other_style);
+    }
+  };
+
+  static size_t KeyHash(const TextPaintStyle& style,
+                        PaintPhase phase,
+                        bool dark_mode) {
+    return style.Hash() ^ ((static_cast<size_t>(phase) << 1 | dark_mode) *
+                           0x9e3779b97f4a7c15ull);
+  }
+
+  Entry* Find(size_t hash,
+              const TextPaintStyle& style,
+              PaintPhase phase,
+              bool dark_mode);
+
+  std::unordered_multimap<size_t, Entry> entries_;
+  size_t hits_ = 0;
+  size_t misses_ = 0;
+};
+
+}  // namespace text_painter
+
+#endif  // TEXT_PAINTER_TEXT_PAINT_STYLE_CACHE_H_
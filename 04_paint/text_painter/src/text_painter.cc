@@ -1,7 +1,19 @@
 #include "text_painter.h"
 #include "text_decoration_painter.h"
+#include "glyph_transform_baker.h"
+#include "dark_mode_filter.h"
+#include <algorithm>
 #include <cmath>
 
+namespace text_painter {
+
+// Dark mode filter shared across Paint calls, so its inverted-color cache
+// spans every fragment of a document
+static DarkModeFilter& GetDarkModeFilter() {
+  static DarkModeFilter filter;
+  return filter;
+}
+
 // Helper to check if horizontal writing mode
 static bool IsHorizontalWritingMode(WritingMode mode) {
   return mode == WritingMode::kHorizontalTb;
@@ -54,6 +66,63 @@ PointF TextPainter::ComputeTextOrigin(const RectF& box, const ShapeResult& shape
   return PointF{left, top};
 }
 
+std::optional<RectF> TextPainter::InkOverflowRect(
+    const TextPaintInput& input) {
+  if (input.symbol_marker &&
+      input.symbol_marker->type != SymbolMarkerType::kNone) {
+    return input.symbol_marker->marker_rect;
+  }
+  if (input.svg_info) {
+    return std::nullopt;
+  }
+
+  const RectF& box = input.box;
+  const ShapeResult& shape = input.fragment.shape_result;
+  float left = box.x;
+  float top = box.y;
+  float right = box.x + box.width;
+  float bottom = box.y + box.height;
+
+  if (input.is_horizontal && !input.text_combine && !shape.IsEmpty()) {
+    // Glyph ink may overhang the box (italics, tall glyphs)
+    const PointF origin = ComputeTextOrigin(box, shape);
+    left = std::min(left, origin.x + shape.bounds.x);
+    top = std::min(top, origin.y + shape.bounds.y);
+    right = std::max(right, origin.x + shape.bounds.x + shape.bounds.width);
+    bottom = std::max(bottom, origin.y + shape.bounds.y + shape.bounds.height);
+  }
+
+  float outset = input.style.stroke_width / 2.0f;
+  if (!input.is_horizontal) {
+    // Rotated into the box; bound by its larger side
+    outset += std::max(box.width, box.height);
+  }
+  if (!input.decorations.empty() || input.emphasis_mark) {
+    // Underlines, overlines, wavy lines and emphasis marks stay within an
+    // em of the line box
+    outset += shape.runs.empty() ? box.height : shape.runs[0].font.size;
+  }
+  left -= outset;
+  top -= outset;
+  right += outset;
+  bottom += outset;
+
+  if (input.style.shadow) {
+    const float text_left = left;
+    const float text_top = top;
+    const float text_right = right;
+    const float text_bottom = bottom;
+    for (const ShadowData& shadow : *input.style.shadow) {
+      const float blur_extent = 3.0f * shadow.BlurAsSigma();
+      left = std::min(left, text_left + shadow.offset_x - blur_extent);
+      top = std::min(top, text_top + shadow.offset_y - blur_extent);
+      right = std::max(right, text_right + shadow.offset_x + blur_extent);
+      bottom = std::max(bottom, text_bottom + shadow.offset_y + blur_extent);
+    }
+  }
+  return RectF{left, top, right - left, bottom - top};
+}
+
 PaintFlags TextPainter::BuildPaintFlags(const TextPaintStyle& style) {
   PaintFlags flags;
   flags.color = style.fill_color;
@@ -160,13 +229,16 @@ void TextPainter::PaintDecorationsExceptLineThrough(
     const std::optional<std::vector<ShadowData>>& shadows,
     float scaling_factor,
     std::optional<float> font_underline_position,
-    std::optional<float> font_underline_thickness) {
+    std::optional<float> font_underline_thickness,
+    const ShapeResult* ink_shape,
+    const PointF& text_origin) {
   if (decorations.empty()) return;
 
   TextDecorationPainter painter(ops, state_ids, box.x, box.y, box.width,
                                 font_size, ascent, descent, decorations,
                                 shadows, scaling_factor,
                                 font_underline_position, font_underline_thickness);
+  painter.SetInkSkipSource(ink_shape, text_origin);
   painter.PaintExceptLineThrough();
 }
 
@@ -207,11 +279,43 @@ void TextPainter::PaintEmphasisMarks(PaintOpList& ops,
                                       const GraphicsStateIds& state_ids) {
   if (emphasis.mark.empty()) return;
 
-  // Collect positions for emphasis marks (one per character/cluster)
-  std::vector<float> positions;
+  // Collect positions for emphasis marks: one per grapheme cluster when the
+  // run carries a cluster map, otherwise one per glyph. All runs of the
+  // fragment are packed into a single op.
+  size_t mark_count = 0;
   for (const auto& run : shape.runs) {
-    for (size_t i = 0; i < run.positions.size(); ++i) {
-      positions.push_back(run.positions[i] + run.offset_x);
+    mark_count += run.positions.size();
+  }
+  std::vector<float> positions;
+  positions.reserve(mark_count);
+
+  // As Chromium's FillTextEmphasisGlyphs, each mark is centered over the
+  // advance of its cluster: from its leftmost glyph origin to the next
+  // cluster's, the next run's or the end of the text.
+  const float text_right = shape.bounds.x + shape.bounds.width;
+  for (size_t r = 0; r < shape.runs.size(); ++r) {
+    const GlyphRun& run = shape.runs[r];
+    const size_t count = std::min(run.positions.size(), run.GlyphCount());
+    float run_end = text_right - run.offset_x;
+    if (r + 1 < shape.runs.size() && !shape.runs[r + 1].positions.empty()) {
+      const GlyphRun& next = shape.runs[r + 1];
+      run_end = next.offset_x + next.positions[0] - run.offset_x;
+    }
+    // Cluster values are monotonic within a run (ascending for LTR,
+    // descending for RTL), so a cluster is a maximal span of equal values.
+    // Without a cluster map every glyph is its own cluster.
+    const bool has_clusters = run.HasClusters();
+    size_t i = 0;
+    while (i < count) {
+      float left = run.positions[i];
+      size_t j = i + 1;
+      for (; has_clusters && j < count && run.clusters[j] == run.clusters[i];
+           ++j) {
+        left = std::min(left, run.positions[j]);
+      }
+      const float right = j < count ? run.positions[j] : run_end;
+      positions.push_back((left + std::max(left, right)) / 2 + run.offset_x);
+      i = j;
     }
   }
 
@@ -221,7 +325,97 @@ void TextPainter::PaintEmphasisMarks(PaintOpList& ops,
                         state_ids.transform_id, state_ids.clip_id, state_ids.effect_id);
 }
 
-PaintOpList TextPainter::Paint(const TextPaintInput& input) {
+void TextPainter::MergeEmphasisMarks(PaintOpList& ops) {
+  std::vector<PaintOp>& list = ops.ops;
+  // The marks op the next one may merge into; a canvas state change in
+  // between ends the line
+  size_t pending = list.size();
+  std::vector<bool> merged(list.size(), false);
+  for (size_t i = 0; i < list.size(); ++i) {
+    const PaintOp& op = list[i];
+    if (std::holds_alternative<SaveOp>(op) ||
+        std::holds_alternative<RestoreOp>(op) ||
+        std::holds_alternative<ClipRectOp>(op) ||
+        std::holds_alternative<TranslateOp>(op) ||
+        std::holds_alternative<ScaleOp>(op) ||
+        std::holds_alternative<ConcatOp>(op) ||
+        std::holds_alternative<SetMatrixOp>(op) ||
+        std::holds_alternative<SaveLayerAlphaOp>(op)) {
+      pending = list.size();
+      continue;
+    }
+    auto* marks = std::get_if<DrawEmphasisMarksOp>(&list[i]);
+    if (!marks) {
+      continue;
+    }
+    if (pending != list.size()) {
+      const auto& previous = std::get<DrawEmphasisMarksOp>(list[pending]);
+      if (previous.y == marks->y && previous.mark == marks->mark &&
+          previous.color == marks->color &&
+          previous.font_size == marks->font_size &&
+          previous.transform_id == marks->transform_id &&
+          previous.clip_id == marks->clip_id &&
+          previous.effect_id == marks->effect_id) {
+        // Positions are relative to the op's x, which becomes the line's
+        // first
+        std::vector<float> positions = previous.positions;
+        positions.reserve(previous.positions.size() + marks->positions.size());
+        for (float position : marks->positions) {
+          positions.push_back(position + marks->x - previous.x);
+        }
+        marks->x = previous.x;
+        marks->positions.swap(positions);
+        merged[pending] = true;
+      }
+    }
+    pending = i;
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < list.size(); ++i) {
+    if (!merged[i]) {
+      if (kept != i) {
+        list[kept] = std::move(list[i]);
+      }
+      ++kept;
+    }
+  }
+  list.resize(kept);
+}
+
+ResolvedTextPaint TextPainter::ResolveStyle(const TextPaintStyle& style,
+                                            PaintPhase paint_phase,
+                                            const AutoDarkMode& dark_mode) {
+  ResolvedTextPaint resolved;
+  resolved.style = style;
+  if (dark_mode.enabled && paint_phase != PaintPhase::kTextClip) {
+    DarkModeFilter& filter = GetDarkModeFilter();
+    const auto role = DarkModeFilter::ElementRole::kForeground;
+    resolved.style.current_color =
+        filter.InvertColorIfNeeded(style.current_color, role);
+    resolved.style.fill_color = filter.InvertColorIfNeeded(style.fill_color, role);
+    resolved.style.stroke_color =
+        filter.InvertColorIfNeeded(style.stroke_color, role);
+    resolved.style.emphasis_mark_color =
+        filter.InvertColorIfNeeded(style.emphasis_mark_color, role);
+  }
+  if (paint_phase == PaintPhase::kTextClip) {
+    // When we use the text as a clip, we only care about the alpha
+    resolved.style.current_color = Color::Black();
+    resolved.style.fill_color = Color::Black();
+    resolved.style.stroke_color = Color::Black();
+    resolved.style.emphasis_mark_color = Color::Black();
+    resolved.style.shadow = std::nullopt;
+    resolved.style.paint_order = EPaintOrder::kPaintOrderNormal;
+  }
+  resolved.flags = BuildPaintFlags(resolved.style);
+  resolved.has_shadows =
+      resolved.style.shadow && !resolved.style.shadow->empty();
+  return resolved;
+}
+
+PaintOpList TextPainter::Paint(const TextPaintInput& input,
+                               TextPaintStyleCache* style_cache) {
   PaintOpList ops;
 
   // === Early exit checks (following Chromium's TextFragmentPainter::Paint) ===
@@ -231,40 +425,62 @@ PaintOpList TextPainter::Paint(const TextPaintInput& input) {
     return ops;
   }
 
-  // 2. Paint symbol markers first (if present) - check before text checks
+  // 2. Skip fragments outside the cull rect
+  if (!input.cull_rect.IsInfinite()) {
+    const std::optional<RectF> ink_overflow = InkOverflowRect(input);
+    if (ink_overflow && !input.cull_rect.Intersects(*ink_overflow)) {
+      return ops;
+    }
+  }
+
+  // 3. Paint symbol markers first (if present) - check before text checks
   // because symbol markers are special items that don't have text
   if (input.symbol_marker && input.symbol_marker->type != SymbolMarkerType::kNone) {
+    if (input.dark_mode.enabled) {
+      SymbolMarkerInfo marker = *input.symbol_marker;
+      marker.color = GetDarkModeFilter().InvertColorIfNeeded(
+          marker.color, DarkModeFilter::ElementRole::kListSymbol);
+      PaintSymbolMarker(ops, marker, input.state_ids);
+      return ops;
+    }
     PaintSymbolMarker(ops, *input.symbol_marker, input.state_ids);
     return ops;  // Symbol markers don't have text
   }
 
-  // 3. Check if we have text to paint
+  // 4. Check if we have text to paint
   if (input.fragment.from >= input.fragment.to) {
     return ops;
   }
 
-  // 4. Check if we have shape result (and it's not just a line break)
+  // 5. Check if we have shape result (and it's not just a line break)
   if (!input.fragment.HasShapeResult() && !input.is_line_break) {
     return ops;
   }
 
-  // 5. Flow controls (line break, tab, <wbr>) need only selection painting
+  // 6. Flow controls (line break, tab, <wbr>) need only selection painting
   // which we're excluding, so skip them
   if (input.is_flow_control) {
     return ops;
   }
 
-  // === Build effective style (handle text clip phase) ===
-  TextPaintStyle effective_style = input.style;
-  if (input.paint_phase == PaintPhase::kTextClip) {
-    // When we use the text as a clip, we only care about the alpha
-    effective_style.current_color = Color::Black();
-    effective_style.fill_color = Color::Black();
-    effective_style.stroke_color = Color::Black();
-    effective_style.emphasis_mark_color = Color::Black();
-    effective_style.shadow = std::nullopt;
-    effective_style.paint_order = EPaintOrder::kPaintOrderNormal;
+  // === Resolve effective style (handle text clip phase) ===
+  const ResolvedTextPaint* resolved = nullptr;
+  ResolvedTextPaint uncached;
+  if (style_cache) {
+    resolved = style_cache->Lookup(input.style, input.paint_phase,
+                                   input.dark_mode);
+    if (!resolved) {
+      resolved = &style_cache->Insert(input.style, input.paint_phase,
+                                      input.dark_mode,
+                                      ResolveStyle(input.style,
+                                                   input.paint_phase,
+                                                   input.dark_mode));
+    }
+  } else {
+    uncached = ResolveStyle(input.style, input.paint_phase, input.dark_mode);
+    resolved = &uncached;
   }
+  const TextPaintStyle& effective_style = resolved->style;
 
   // === Handle SVG text scaling ===
   float scaling_factor = 1.0f;
@@ -293,9 +509,68 @@ PaintOpList TextPainter::Paint(const TextPaintInput& input) {
                                         : nullptr;
   PointF origin = ComputeTextOrigin(input.box, shape, scaling_factor, text_combine);
 
+  // === Check for shadows and decorations ===
+  bool has_shadows = resolved->has_shadows;
+  bool has_decorations = !input.decorations.empty();
+  const std::vector<TextDecoration>* decorations = &input.decorations;
+  std::vector<TextDecoration> dark_decorations;
+  if (has_decorations && input.dark_mode.enabled) {
+    dark_decorations = input.decorations;
+    for (auto& decoration : dark_decorations) {
+      decoration.color = GetDarkModeFilter().InvertColorIfNeeded(
+          decoration.color, DarkModeFilter::ElementRole::kForeground);
+    }
+    decorations = &dark_decorations;
+  }
+  bool has_emphasis_marks = input.emphasis_mark &&
+                            !input.emphasis_mark->mark.empty() &&
+                            !input.is_ellipsis;
+  // Note: Shadows for decorations are now handled by TextDecorationPainter internally
+  // via PaintWithTextShadow pattern, so we don't need to paint shadows separately here
+
   // === Apply transforms if needed ===
+  bool needs_transform = scaling_factor != 1.0f || has_svg_transform || needs_rotation;
+  AffineTransform text_transform;
+  if (needs_transform) {
+    if (scaling_factor != 1.0f) {
+      text_transform = AffineTransform::MakeScale(1.0f / scaling_factor,
+                                                  1.0f / scaling_factor);
+    }
+    if (has_svg_transform) {
+      text_transform = text_transform.Concat(svg_transform);
+    }
+    if (needs_rotation) {
+      text_transform = text_transform.Concat(rotation);
+    }
+  }
+
+  // Convert glyph runs
+  std::vector<TextBlobRun> blob_runs;
+  for (const auto& run : shape.runs) {
+    blob_runs.push_back(ConvertRun(run));
+  }
+
+  // Bounds are relative to the text blob origin
+  std::array<float, 4> bounds = {
+      shape.bounds.x,
+      shape.bounds.y,
+      shape.bounds.x + shape.bounds.width,
+      shape.bounds.y + shape.bounds.height
+  };
+
+  // Decorations and emphasis marks are geometry in the transformed space,
+  // so only a bare text blob can have the transform baked into its glyphs.
+  // Baking scales the font, not the flags: a stroke width or shadow offset
+  // and blur would lose the transform's scale, so those stay on the canvas.
+  bool bake_transform = input.bake_glyph_transforms && needs_transform &&
+                        !has_decorations && !has_emphasis_marks &&
+                        !has_shadows &&
+                        resolved->flags.style == PaintStyle::kFill &&
+                        BakeGlyphTransform(text_transform, origin, bounds,
+                                           blob_runs);
+
   bool state_saved = false;
-  if (scaling_factor != 1.0f || has_svg_transform || needs_rotation) {
+  if (needs_transform && !bake_transform) {
     ops.Save();
     state_saved = true;
 
@@ -310,12 +585,6 @@ PaintOpList TextPainter::Paint(const TextPaintInput& input) {
     }
   }
 
-  // === Check for shadows and decorations ===
-  bool has_shadows = effective_style.shadow && !effective_style.shadow->empty();
-  bool has_decorations = !input.decorations.empty();
-  // Note: Shadows for decorations are now handled by TextDecorationPainter internally
-  // via PaintWithTextShadow pattern, so we don't need to paint shadows separately here
-
   // === Get font metrics for decorations ===
   float font_size = 16.0f;
   float ascent = 14.0f;
@@ -332,29 +601,17 @@ PaintOpList TextPainter::Paint(const TextPaintInput& input) {
 
   // === Paint decorations (except line-through) ===
   if (has_decorations) {
-    PaintDecorationsExceptLineThrough(ops, input.decorations, input.box,
+    PaintDecorationsExceptLineThrough(ops, *decorations, input.box,
                                       font_size, ascent, descent,
                                       input.state_ids, effective_style.shadow,
                                       scaling_factor,
-                                      font_underline_position, font_underline_thickness);
+                                      font_underline_position, font_underline_thickness,
+                                      &shape, origin);
   }
 
   // === Paint text ===
-  PaintFlags flags = BuildPaintFlags(effective_style);
+  const PaintFlags& flags = resolved->flags;
 
-  // Convert glyph runs
-  std::vector<TextBlobRun> blob_runs;
-  for (const auto& run : shape.runs) {
-    blob_runs.push_back(ConvertRun(run));
-  }
-
-  // Bounds are relative to the text blob origin
-  std::array<float, 4> bounds = {
-      shape.bounds.x,
-      shape.bounds.y,
-      shape.bounds.x + shape.bounds.width,
-      shape.bounds.y + shape.bounds.height
-  };
 
   // Emit DrawTextBlobOp (with or without shadows depending on whether we painted shadows earlier)
   if (has_shadows && !has_decorations) {
@@ -368,7 +625,7 @@ PaintOpList TextPainter::Paint(const TextPaintInput& input) {
 
   // === Paint line-through decoration ===
   if (has_decorations) {
-    PaintDecorationsLineThrough(ops, input.decorations, input.box,
+    PaintDecorationsLineThrough(ops, *decorations, input.box,
                                 font_size, ascent, descent,
                                 input.state_ids, effective_style.shadow,
                                 scaling_factor,
@@ -376,7 +633,7 @@ PaintOpList TextPainter::Paint(const TextPaintInput& input) {
   }
 
   // === Paint emphasis marks ===
-  if (input.emphasis_mark && !input.emphasis_mark->mark.empty() && !input.is_ellipsis) {
+  if (has_emphasis_marks) {
     PaintEmphasisMarks(ops, *input.emphasis_mark, shape, origin,
                        effective_style.emphasis_mark_color, input.state_ids);
   }
@@ -388,3 +645,5 @@ PaintOpList TextPainter::Paint(const TextPaintInput& input) {
 
   return ops;
 }
+
+}  // namespace text_painter
@@ -2,7 +2,11 @@
 #define TEXT_PAINTER_TEXT_PAINTER_H_
 
 #include "types.h"
+#include "cull_rect.h"
 #include "draw_commands.h"
+#include "text_paint_style_cache.h"
+
+namespace text_painter {
 
 // Input context for text painting - all data needed to paint text
 // This mirrors the data that TextFragmentPainter::Paint receives from Chromium
@@ -40,10 +44,20 @@ struct TextPaintInput {
   // === Dark mode ===
   AutoDarkMode dark_mode;
 
+  // === Culling ===
+  // Fragments whose ink overflow misses it paint nothing
+  CullRect cull_rect;
+
   // === Flags ===
   bool is_ellipsis = false;
   bool is_line_break = false;
   bool is_flow_control = false;
+
+  // === Replay options ===
+  // Fold the scaling / SVG / writing-mode transform into glyph positions
+  // instead of wrapping the blob in Save/Concat/Restore.
+  // See glyph_transform_baker.h for which transforms qualify.
+  bool bake_glyph_transforms = false;
 };
 
 // Pure functional text painter
@@ -52,9 +66,29 @@ struct TextPaintInput {
 class TextPainter {
  public:
   // Main entry point - produces paint ops from input
-  static PaintOpList Paint(const TextPaintInput& input);
+  // |style_cache| (optional) memoizes style resolution across fragments.
+  static PaintOpList Paint(const TextPaintInput& input,
+                           TextPaintStyleCache* style_cache = nullptr);
+
+  // Merges the DrawEmphasisMarksOps of consecutive fragments on one line
+  // (same baseline, mark, color, size and state ids, and no canvas state
+  // change in between) into one op per line. The merged op takes the place
+  // of the line's last one, after all of the line's text. For documents
+  // painted fragment by fragment.
+  static void MergeEmphasisMarks(PaintOpList& ops);
 
  private:
+  // Resolve the effective style, flags and shadow / paint-order data
+  // (dark mode applies DarkModeFilter's foreground role to text colors)
+  static ResolvedTextPaint ResolveStyle(const TextPaintStyle& style,
+                                        PaintPhase paint_phase,
+                                        const AutoDarkMode& dark_mode);
+
+  // Conservative ink overflow of the fragment: glyph bounds, decorations,
+  // emphasis marks, stroke and shadows. nullopt when it cannot be bounded
+  // cheaply (SVG text)
+  static std::optional<RectF> InkOverflowRect(const TextPaintInput& input);
+
   // Convert GlyphRun to TextBlobRun
   static TextBlobRun ConvertRun(const GlyphRun& run);
 
@@ -75,6 +109,7 @@ class TextPainter {
                                 const GraphicsStateIds& state_ids);
 
   // Paint text decorations (underline, overline) - uses TextDecorationPainter
+  // |ink_shape| / |text_origin| supply glyph ink extents for skip-ink.
   static void PaintDecorationsExceptLineThrough(
       PaintOpList& ops,
       const std::vector<TextDecoration>& decorations,
@@ -86,7 +121,9 @@ class TextPainter {
       const std::optional<std::vector<ShadowData>>& shadows = std::nullopt,
       float scaling_factor = 1.0f,
       std::optional<float> font_underline_position = std::nullopt,
-      std::optional<float> font_underline_thickness = std::nullopt);
+      std::optional<float> font_underline_thickness = std::nullopt,
+      const ShapeResult* ink_shape = nullptr,
+      const PointF& text_origin = PointF{});
 
   // Paint line-through decorations - uses TextDecorationPainter
   static void PaintDecorationsLineThrough(
@@ -119,4 +156,6 @@ class TextPainter {
                                                       const RectF& rect);
 };
 
+}  // namespace text_painter
+
 #endif  // TEXT_PAINTER_TEXT_PAINTER_H_
@@ -15,6 +15,8 @@
 #include "types.h"
 #include "draw_commands.h"
 
+namespace text_painter {
+
 // Phase of shadow painting - mirrors Chromium's TextShadowPaintPhase
 enum class TextShadowPaintPhase {
   kShadow,      // Painting the shadow layer
@@ -58,4 +60,6 @@ inline bool HasTextShadow(const std::optional<std::vector<ShadowData>>& shadows)
   return shadows && !shadows->empty();
 }
 
+}  // namespace text_painter
+
 #endif  // TEXT_PAINTER_TEXT_SHADOW_PAINTER_H_
@@ -5,10 +5,13 @@
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <optional>
 #include <string>
 #include <vector>
 
+namespace text_painter {
+
 // Stubbed types that mirror Chromium's blink types
 
 struct Color {
@@ -83,6 +86,11 @@ struct ShadowData {
     // Chromium uses blur / 2.0 for sigma approximation
     return blur / 2.0f;
   }
+
+  bool operator==(const ShadowData& other) const {
+    return offset_x == other.offset_x && offset_y == other.offset_y &&
+           blur == other.blur && color == other.color;
+  }
 };
 
 enum class ColorScheme { kLight, kDark };
@@ -231,6 +239,7 @@ struct TextDecoration {
   Color color;
   float thickness = 1.0f;
   float underline_offset = 0.0f;  // For underline position
+  bool skip_ink = true;           // text-decoration-skip-ink: auto
 
   // Get the stroke style for painting
   StrokeStyle GetStrokeStyle() const {
@@ -372,8 +381,21 @@ struct GlyphRun {
   float offset_x = 0.0f;               // Run offset X
   float offset_y = 0.0f;               // Run offset Y
   int positioning = 1;                 // 1 = horizontal, 2 = full positioning
+  // Optional cluster map: text offset of the cluster each glyph belongs to
+  // (HarfBuzz cluster values). Glyphs sharing a value form one cluster.
+  std::vector<uint32_t> clusters;
+  // Optional per-glyph vertical ink extents relative to the run baseline
+  // (y down, so ascenders are negative). Used for skip-ink decorations.
+  std::vector<float> ink_top;
+  std::vector<float> ink_bottom;
 
   size_t GlyphCount() const { return glyphs.size(); }
+  bool HasClusters() const { return clusters.size() == glyphs.size(); }
+  bool HasInkExtents() const {
+    return ink_top.size() == glyphs.size() &&
+           ink_bottom.size() == glyphs.size() &&
+           positions.size() >= glyphs.size();
+  }
 };
 
 // Shape result from HarfBuzz - pre-computed during layout
@@ -415,6 +437,48 @@ struct TextPaintStyle {
            color_scheme == other.color_scheme &&
            paint_order == other.paint_order;
   }
+
+  // operator== ignores shadows; memo keys need them too
+  bool EqualsIncludingShadow(const TextPaintStyle& other) const {
+    return *this == other && shadow == other.shadow;
+  }
+
+  // Hash over every field, shadows included (consistent with
+  // EqualsIncludingShadow)
+  size_t Hash() const {
+    auto color_bits = [](const Color& c) -> uint32_t {
+      return (uint32_t(c.a) << 24) | (uint32_t(c.r) << 16) |
+             (uint32_t(c.g) << 8) | uint32_t(c.b);
+    };
+    auto float_bits = [](float f) -> uint32_t {
+      if (f == 0.0f) return 0;  // +0 and -0 compare equal
+      uint32_t bits;
+      std::memcpy(&bits, &f, sizeof(bits));
+      return bits;
+    };
+    uint64_t h = 0xcbf29ce484222325ull;  // FNV-1a over 32-bit words
+    auto mix = [&h](uint32_t v) {
+      h ^= v;
+      h *= 0x100000001b3ull;
+    };
+    mix(color_bits(current_color));
+    mix(color_bits(fill_color));
+    mix(color_bits(stroke_color));
+    mix(color_bits(emphasis_mark_color));
+    mix(float_bits(stroke_width));
+    mix((static_cast<uint32_t>(color_scheme) << 8) |
+        static_cast<uint32_t>(paint_order));
+    if (shadow) {
+      mix(static_cast<uint32_t>(shadow->size()) + 1);
+      for (const auto& s : *shadow) {
+        mix(float_bits(s.offset_x));
+        mix(float_bits(s.offset_y));
+        mix(float_bits(s.blur));
+        mix(color_bits(s.color));
+      }
+    }
+    return static_cast<size_t>(h);
+  }
 };
 
 // Dark mode settings
@@ -449,4 +513,6 @@ struct PaintFlags {
   float A() const { return color.A(); }
 };
 
+}  // namespace text_painter
+
 #endif  // TEXT_PAINTER_TYPES_H_
@@ -0,0 +1,110 @@
+// Copyright 2017 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Adapted from ui/gfx/geometry/axis_transform2d.h.
+//
+// Changes from Chromium:
+// - Double precision (Chromium stores floats), so accumulating translations
+//   matches the full-matrix path bit for bit
+// - Only construction, concatenation and inversion; no rect/point mapping,
+//   decomposition or ToString
+
+#ifndef PAINT_PREPROCESSOR_AXIS_TRANSFORM2D_H_
+#define PAINT_PREPROCESSOR_AXIS_TRANSFORM2D_H_
+
+#include <cmath>
+
+namespace paint_preprocessor {
+
+// This class implements the subset of 2D linear transforms that only
+// translation and axis-aligned scaling are allowed.
+// Internally this is stored as a vector for pre-scale, and another vector
+// for post-translation. The class constructor and member accessor follows
+// the same convention.
+class AxisTransform2d {
+ public:
+  constexpr AxisTransform2d() = default;
+
+  static constexpr AxisTransform2d FromScaleAndTranslation(double scale_x,
+                                                           double scale_y,
+                                                           double tx,
+                                                           double ty) {
+    AxisTransform2d result;
+    result.scale_x_ = scale_x;
+    result.scale_y_ = scale_y;
+    result.translation_x_ = tx;
+    result.translation_y_ = ty;
+    return result;
+  }
+
+  bool operator==(const AxisTransform2d& other) const {
+    return scale_x_ == other.scale_x_ && scale_y_ == other.scale_y_ &&
+           translation_x_ == other.translation_x_ &&
+           translation_y_ == other.translation_y_;
+  }
+
+  // this = this * scale
+  void PreScale(double x, double y) {
+    scale_x_ *= x;
+    scale_y_ *= y;
+  }
+  // this = scale * this
+  void PostScale(double x, double y) {
+    scale_x_ *= x;
+    scale_y_ *= y;
+    translation_x_ *= x;
+    translation_y_ *= y;
+  }
+  // this = this * translation
+  void PreTranslate(double x, double y) {
+    translation_x_ += scale_x_ * x;
+    translation_y_ += scale_y_ * y;
+  }
+  // this = translation * this
+  void PostTranslate(double x, double y) {
+    translation_x_ += x;
+    translation_y_ += y;
+  }
+
+  // this = this * post
+  void PreConcat(const AxisTransform2d& post) {
+    PreTranslate(post.translation_x_, post.translation_y_);
+    PreScale(post.scale_x_, post.scale_y_);
+  }
+  // this = pre * this
+  void PostConcat(const AxisTransform2d& pre) {
+    PostScale(pre.scale_x_, pre.scale_y_);
+    PostTranslate(pre.translation_x_, pre.translation_y_);
+  }
+
+  double Determinant() const { return scale_x_ * scale_y_; }
+  bool IsInvertible() const {
+    // Check finiteness of the determinant instead of the scales, so a
+    // product that overflows is not invertible
+    return std::isnormal(Determinant());
+  }
+  void Invert() {
+    scale_x_ = 1.0 / scale_x_;
+    scale_y_ = 1.0 / scale_y_;
+    translation_x_ = -translation_x_ * scale_x_;
+    translation_y_ = -translation_y_ * scale_y_;
+  }
+
+  double scale_x() const { return scale_x_; }
+  double scale_y() const { return scale_y_; }
+  double translation_x() const { return translation_x_; }
+  double translation_y() const { return translation_y_; }
+
+ private:
+  // Scale is applied before translation, i.e.
+  // this->Transform(p) == scale_ * p + translation_
+  double scale_x_ = 1.0;
+  double scale_y_ = 1.0;
+  double translation_x_ = 0.0;
+  double translation_y_ = 0.0;
+};
+
+}  // namespace paint_preprocessor
+
+#endif  // PAINT_PREPROCESSOR_AXIS_TRANSFORM2D_H_
@@ -0,0 +1,55 @@
+// Paint Preprocessor Geometry
+// The points and rects transforms map, in double precision
+
+#ifndef PAINT_PREPROCESSOR_GEOMETRY_H_
+#define PAINT_PREPROCESSOR_GEOMETRY_H_
+
+#include <algorithm>
+
+namespace paint_preprocessor {
+
+// Min and max as SSE2's minpd / maxpd: the second operand unless the first
+// is smaller (larger). Mapped bounds use them, so the scalar and SIMD
+// versions agree on -0 against +0.
+inline double BoundsMin(double a, double b) {
+  return a < b ? a : b;
+}
+inline double BoundsMax(double a, double b) {
+  return a > b ? a : b;
+}
+
+struct PointF {
+  double x = 0.0;
+  double y = 0.0;
+};
+
+// Left/top/right/bottom
+struct RectF {
+  double left = 0.0;
+  double top = 0.0;
+  double right = 0.0;
+  double bottom = 0.0;
+
+  static RectF FromXYWH(double x, double y, double width, double height) {
+    return {x, y, x + width, y + height};
+  }
+  // Larger than any clip_rect of a paint artifact (the root clip is
+  // +-2^23)
+  static RectF Infinite() { return {-1e9, -1e9, 1e9, 1e9}; }
+
+  double width() const { return right - left; }
+  double height() const { return bottom - top; }
+  bool IsEmpty() const { return right <= left || bottom <= top; }
+
+  // Empty intersections collapse to a zero-size rect at the overlap
+  void Intersect(const RectF& other) {
+    left = std::max(left, other.left);
+    top = std::max(top, other.top);
+    right = std::max(left, std::min(right, other.right));
+    bottom = std::max(top, std::min(bottom, other.bottom));
+  }
+};
+
+}  // namespace paint_preprocessor
+
+#endif  // PAINT_PREPROCESSOR_GEOMETRY_H_
@@ -0,0 +1,822 @@
+#include "json_parser.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace paint_preprocessor {
+namespace {
+
+// Simple JSON tokenizer
+class JsonTokenizer {
+ public:
+  explicit JsonTokenizer(const std::string& json) : json_(json), pos_(0) {}
+
+  void SkipWhitespace() {
+    while (pos_ < json_.size() &&
+           (json_[pos_] == ' ' || json_[pos_] == '\n' ||
+            json_[pos_] == '\r' || json_[pos_] == '\t')) {
+      ++pos_;
+    }
+  }
+
+  char Peek() {
+    SkipWhitespace();
+    return pos_ < json_.size() ? json_[pos_] : '\0';
+  }
+
+  char Consume() {
+    SkipWhitespace();
+    return pos_ < json_.size() ? json_[pos_++] : '\0';
+  }
+
+  void Expect(char c) {
+    SkipWhitespace();
+    if (pos_ >= json_.size() || json_[pos_] != c) {
+      throw std::runtime_error(std::string("Expected '") + c + "' at offset " +
+                               std::to_string(pos_));
+    }
+    ++pos_;
+  }
+
+  // Decodes escapes, including \uXXXX (and surrogate pairs) to UTF-8, so
+  // the serializer can escape the string again the way JSON.stringify does
+  std::string ReadString() {
+    Expect('"');
+    std::string result;
+    while (pos_ < json_.size() && json_[pos_] != '"') {
+      if (json_[pos_] != '\\') {
+        result += json_[pos_++];
+        continue;
+      }
+      ++pos_;
+      if (pos_ >= json_.size()) {
+        break;
+      }
+      switch (json_[pos_++]) {
+        case 'n': result += '\n'; break;
+        case 't': result += '\t'; break;
+        case 'r': result += '\r'; break;
+        case 'b': result += '\b'; break;
+        case 'f': result += '\f'; break;
+        case 'u': AppendUtf8(ReadCodePoint(), result); break;
+        default: result += json_[pos_ - 1]; break;
+      }
+    }
+    Expect('"');
+    return result;
+  }
+
+  double ReadNumber() {
+    SkipWhitespace();
+    const char* start = json_.c_str() + pos_;
+    char* end = nullptr;
+    const double value = std::strtod(start, &end);
+    if (end == start) {
+      throw std::runtime_error("Expected number at offset " +
+                               std::to_string(pos_));
+    }
+    pos_ += end - start;
+    return value;
+  }
+
+  bool ReadBool() {
+    SkipWhitespace();
+    if (json_.compare(pos_, 4, "true") == 0) {
+      pos_ += 4;
+      return true;
+    }
+    if (json_.compare(pos_, 5, "false") == 0) {
+      pos_ += 5;
+      return false;
+    }
+    throw std::runtime_error("Expected boolean at offset " +
+                             std::to_string(pos_));
+  }
+
+  // Consumes "null" and returns true, or returns false for any other value
+  bool ReadNull() {
+    SkipWhitespace();
+    if (json_.compare(pos_, 4, "null") == 0) {
+      pos_ += 4;
+      return true;
+    }
+    return false;
+  }
+
+  // Skips any value without building strings or numbers; the paint ops and
+  // most node fields are only copied through
+  void SkipValue() {
+    const char c = Peek();
+    if (c == '"') {
+      SkipString();
+    } else if (c == '{' || c == '[') {
+      SkipContainer();
+    } else if (c == 't' || c == 'f') {
+      ReadBool();
+    } else if (c == 'n') {
+      if (!ReadNull()) {
+        throw std::runtime_error("Expected null at offset " +
+                                 std::to_string(pos_));
+      }
+    } else {
+      ReadNumber();
+    }
+  }
+
+  size_t pos() const { return pos_; }
+
+  // The source text of [begin, end)
+  std::string Source(size_t begin, size_t end) const {
+    return json_.substr(begin, end - begin);
+  }
+
+ private:
+  void SkipString() {
+    ++pos_;  // Opening quote
+    while (pos_ < json_.size() && json_[pos_] != '"') {
+      pos_ += json_[pos_] == '\\' ? 2 : 1;
+    }
+    Expect('"');
+  }
+
+  // Skips a whole object or array by bracket depth
+  void SkipContainer() {
+    int depth = 0;
+    do {
+      const char c = json_[pos_];
+      if (c == '"') {
+        SkipString();
+        continue;
+      }
+      if (c == '{' || c == '[') {
+        ++depth;
+      } else if (c == '}' || c == ']') {
+        --depth;
+      }
+      ++pos_;
+    } while (depth > 0 && pos_ < json_.size());
+    if (depth > 0) {
+      throw std::runtime_error("Unterminated object or array");
+    }
+  }
+
+  uint32_t ReadHex4() {
+    if (pos_ + 4 > json_.size()) {
+      throw std::runtime_error("Truncated \\u escape");
+    }
+    const std::string hex = json_.substr(pos_, 4);
+    pos_ += 4;
+    return static_cast<uint32_t>(std::strtoul(hex.c_str(), nullptr, 16));
+  }
+
+  uint32_t ReadCodePoint() {
+    const uint32_t unit = ReadHex4();
+    if (unit >= 0xD800 && unit < 0xDC00 &&
+        json_.compare(pos_, 2, "\\u") == 0) {
+      const size_t saved = pos_;
+      pos_ += 2;
+      const uint32_t low = ReadHex4();
+      if (low >= 0xDC00 && low < 0xE000) {
+        return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+      }
+      pos_ = saved;
+    }
+    return unit;
+  }
+
+  static void AppendUtf8(uint32_t code_point, std::string& out) {
+    if (code_point < 0x80) {
+      out += static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+      out += static_cast<char>(0xC0 | (code_point >> 6));
+      out += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+      out += static_cast<char>(0xE0 | (code_point >> 12));
+      out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else {
+      out += static_cast<char>(0xF0 | (code_point >> 18));
+      out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+  }
+
+  const std::string& json_;
+  size_t pos_;
+};
+
+// Calls |member(key, begin)| for every key of an object, |begin| being the
+// offset of the key; |member| consumes the value
+template <typename Fn>
+void ParseObject(JsonTokenizer& tok, Fn member) {
+  tok.Expect('{');
+  while (tok.Peek() != '}') {
+    const size_t begin = tok.pos();
+    std::string key = tok.ReadString();
+    tok.Expect(':');
+    member(key, begin);
+    if (tok.Peek() == ',') tok.Consume();
+  }
+  tok.Expect('}');
+}
+
+// Calls |element()| for every element of an array
+template <typename Fn>
+void ParseArray(JsonTokenizer& tok, Fn element) {
+  tok.Expect('[');
+  while (tok.Peek() != ']') {
+    element();
+    if (tok.Peek() == ',') tok.Consume();
+  }
+  tok.Expect(']');
+}
+
+// A number array; null elements read as 0
+std::vector<double> ReadNumbers(JsonTokenizer& tok) {
+  std::vector<double> values;
+  if (tok.ReadNull()) {
+    return values;
+  }
+  ParseArray(tok, [&]() {
+    values.push_back(tok.ReadNull() ? 0.0 : tok.ReadNumber());
+  });
+  return values;
+}
+
+int64_t ReadId(JsonTokenizer& tok) {
+  return tok.ReadNull() ? kInvalidNodeId
+                        : static_cast<int64_t>(tok.ReadNumber());
+}
+
+// Fields SerializeReplayArtifact writes, dropped on input so a replay
+// artifact can be preprocessed again. "opacity_folded" is kept: it tells
+// that the op colors already have the opacity.
+bool IsResolvedField(const std::string& key) {
+  return key == "screen_matrix" || key == "screen_inverse" ||
+         key == "creates_3d" || key == "cull_backface" || key == "order" ||
+         key == "descendants" || key == "clip_bounds" || key == "clip_cmds" ||
+         key == "render_surface_reason";
+}
+
+// Reads a node object, calling |read_field(key)| for every field and
+// keeping the source text of the fields
+template <typename ReadField>
+void ReadNode(JsonTokenizer& tok, std::vector<PaintArtifact::Field>& fields,
+              ReadField read_field) {
+  ParseObject(tok, [&](const std::string& key, size_t begin) {
+    if (IsResolvedField(key)) {
+      tok.SkipValue();
+      return;
+    }
+    read_field(key);
+    fields.push_back({key, tok.Source(begin, tok.pos())});
+  });
+}
+
+// Reads {"nodes": [...]}, calling |read_node()| for every node
+template <typename ReadNodeFn>
+void ReadTree(JsonTokenizer& tok, ReadNodeFn read_node) {
+  ParseObject(tok, [&](const std::string& key, size_t) {
+    if (key != "nodes") {
+      tok.SkipValue();
+      return;
+    }
+    ParseArray(tok, read_node);
+  });
+}
+
+void ReadTransformNode(JsonTokenizer& tok, TransformNode& node,
+                       std::vector<PaintArtifact::Field>& fields) {
+  std::vector<double> matrix, local, origin, translation;
+  ReadNode(tok, fields, [&](const std::string& key) {
+    if (key == "id") {
+      node.id = ReadId(tok);
+    } else if (key == "parent_id") {
+      node.parent_id = ReadId(tok);
+    } else if (key == "matrix") {
+      matrix = ReadNumbers(tok);
+    } else if (key == "local") {
+      local = ReadNumbers(tok);
+    } else if (key == "origin") {
+      origin = ReadNumbers(tok);
+    } else if (key == "translation2d") {
+      translation = ReadNumbers(tok);
+    } else if (key == "backface_hidden") {
+      node.backface_hidden = !tok.ReadNull() && tok.ReadBool();
+    } else {
+      tok.SkipValue();
+    }
+  });
+
+  // As draw.html's getTransformMatrix: "matrix", else "local", around
+  // "origin"; else "translation2d". A 2d scale and/or translation stays an
+  // AxisTransform2d.
+  const std::vector<double>& values = matrix.size() == 16 ? matrix : local;
+  if (values.size() == 16) {
+    std::array<double, 16> row_major;
+    std::copy(values.begin(), values.end(), row_major.begin());
+    node.local = Transform::RowMajorOrAxis2d(row_major);
+    if (origin.size() >= 2) {
+      node.local.ApplyTransformOrigin(origin[0], origin[1],
+                                      origin.size() > 2 ? origin[2] : 0.0);
+    }
+  } else if (translation.size() == 2) {
+    node.local = Transform::MakeTranslation(translation[0], translation[1]);
+  }
+}
+
+void ReadTransformTree(JsonTokenizer& tok, PaintArtifact& artifact) {
+  ReadTree(tok, [&]() {
+    artifact.transform_nodes.emplace_back();
+    artifact.transform_fields.emplace_back();
+    ReadTransformNode(tok, artifact.transform_nodes.back(),
+                      artifact.transform_fields.back());
+  });
+}
+
+void ReadClipTree(JsonTokenizer& tok, PaintArtifact& artifact) {
+  ReadTree(tok, [&]() {
+    artifact.clip_nodes.emplace_back();
+    artifact.clip_fields.emplace_back();
+    ClipNode& node = artifact.clip_nodes.back();
+    ReadNode(tok, artifact.clip_fields.back(), [&](const std::string& key) {
+      if (key == "id") {
+        node.id = ReadId(tok);
+      } else if (key == "parent_id") {
+        node.parent_id = ReadId(tok);
+      } else if (key == "clip_rect") {
+        const std::vector<double> rect = ReadNumbers(tok);
+        if (rect.size() == 4) {
+          node.has_clip_rect = true;
+          node.clip_rect = RectF::FromXYWH(rect[0], rect[1], rect[2], rect[3]);
+        }
+      } else if (key == "clip_path") {
+        node.clip_path = tok.ReadNull() ? std::string() : tok.ReadString();
+      } else {
+        tok.SkipValue();
+      }
+    });
+  });
+}
+
+// Reads "filter": [{"type": "blur", "amount": 4}, ...], keeping the first
+// blur with an amount > 0, as draw.html
+void ReadBlur(JsonTokenizer& tok, EffectNode& node) {
+  if (tok.ReadNull()) {
+    return;
+  }
+  ParseArray(tok, [&]() {
+    std::string type;
+    double amount = 0.0;
+    ParseObject(tok, [&](const std::string& key, size_t) {
+      if (key == "type" && tok.Peek() == '"') {
+        type = tok.ReadString();
+      } else if (key == "amount" && tok.Peek() != 'n') {
+        amount = tok.ReadNumber();
+      } else {
+        tok.SkipValue();
+      }
+    });
+    if (type == "blur" && amount > 0.0 && node.blur == 0.0) {
+      node.blur = amount;
+    }
+  });
+}
+
+void ReadEffectTree(JsonTokenizer& tok, PaintArtifact& artifact) {
+  ReadTree(tok, [&]() {
+    artifact.effect_nodes.emplace_back();
+    artifact.effect_fields.emplace_back();
+    EffectNode& node = artifact.effect_nodes.back();
+    ReadNode(tok, artifact.effect_fields.back(), [&](const std::string& key) {
+      if (key == "id") {
+        node.id = ReadId(tok);
+      } else if (key == "parent_id") {
+        node.parent_id = ReadId(tok);
+      } else if (key == "opacity") {
+        node.opacity = tok.ReadNull() ? 1.0 : tok.ReadNumber();
+      } else if (key == "blend_mode") {
+        // As draw.html: a missing or empty blend mode is SrcOver
+        node.blend_mode = tok.ReadNull() ? std::string() : tok.ReadString();
+        if (node.blend_mode.empty()) {
+          node.blend_mode = "SrcOver";
+        }
+      } else if (key == "filter") {
+        ReadBlur(tok, node);
+      } else if (key == "opacity_folded") {
+        node.opacity_folded = !tok.ReadNull() && tok.ReadBool();
+      } else {
+        tok.SkipValue();
+      }
+    });
+  });
+}
+
+// The local bounds of a draw op, as its renderer reads its geometry
+bool DrawBounds(const PaintOp& op, const std::vector<double>& rect,
+                const std::vector<double>& bounds, const PointF& origin,
+                const std::array<double, 4>& line, RectF& out) {
+  if (op.type == "DrawRectOp" || op.type == "DrawRRectOp" ||
+      op.type == "DrawOvalOp" || op.type == "DrawDRRectOp") {
+    if (rect.size() != 4) {
+      return false;
+    }
+    out = {rect[0], rect[1], rect[2], rect[3]};
+  } else if (op.type == "DrawPathOp") {
+    if (bounds.size() != 4) {
+      return false;
+    }
+    out = {bounds[0], bounds[1], bounds[2], bounds[3]};
+  } else if (op.type == "DrawLineOp") {
+    out = {std::min(line[0], line[2]), std::min(line[1], line[3]),
+           std::max(line[0], line[2]), std::max(line[1], line[3])};
+  } else if (op.type == "DrawTextBlobOp") {
+    // "bounds" are relative to the blob's origin
+    if (bounds.size() != 4) {
+      return false;
+    }
+    out = {origin.x + bounds[0], origin.y + bounds[1], origin.x + bounds[2],
+           origin.y + bounds[3]};
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Reads what DecideRenderSurfaces needs of every op. Alpha offsets are
+// made relative to |text_begin|, where the source text of "paint_ops"
+// starts.
+void ReadPaintOps(JsonTokenizer& tok, size_t text_begin,
+                  std::vector<PaintOp>& ops) {
+  ParseArray(tok, [&]() {
+    ops.emplace_back();
+    PaintOp& op = ops.back();
+    std::vector<double> rect, bounds;
+    // DrawTextBlobOp's x, y
+    PointF origin;
+    // DrawLineOp's x0, y0, x1, y1
+    std::array<double, 4> line = {0.0, 0.0, 0.0, 0.0};
+    bool has_alpha = false;
+    bool has_paint_extras = false;
+    bool stroke = false;
+    double stroke_width = 0.0;
+    size_t runs = 0;
+    ParseObject(tok, [&](const std::string& key, size_t) {
+      if (key == "type") {
+        op.type = tok.ReadString();
+      } else if (key == "transform_id") {
+        op.transform_id = ReadId(tok);
+      } else if (key == "effect_id") {
+        op.effect_id = ReadId(tok);
+      } else if (key == "rect" || key == "oval" || key == "outer_rect") {
+        rect = ReadNumbers(tok);
+      } else if (key == "bounds") {
+        bounds = ReadNumbers(tok);
+      } else if (key == "x" || key == "y") {
+        (key == "x" ? origin.x : origin.y) =
+            tok.ReadNull() ? 0.0 : tok.ReadNumber();
+      } else if (key == "x0" || key == "y0" || key == "x1" || key == "y1") {
+        line[(key[0] == 'y') + 2 * (key[1] == '1')] =
+            tok.ReadNull() ? 0.0 : tok.ReadNumber();
+      } else if (key == "runs" && tok.Peek() == '[') {
+        ParseArray(tok, [&]() {
+          tok.SkipValue();
+          ++runs;
+        });
+      } else if (key == "flags" && tok.Peek() == '{') {
+        ParseObject(tok, [&](const std::string& flag, size_t) {
+          if (tok.ReadNull()) {
+            return;
+          }
+          if (flag == "a") {
+            tok.Peek();
+            op.alpha_begin = tok.pos() - text_begin;
+            op.alpha = tok.ReadNumber();
+            op.alpha_end = tok.pos() - text_begin;
+            has_alpha = std::isfinite(op.alpha);
+          } else if (flag == "style") {
+            stroke = tok.ReadNumber() == 1.0;
+          } else if (flag == "strokeWidth") {
+            stroke_width = tok.ReadNumber();
+          } else if (flag == "shadows" && tok.Peek() == '[') {
+            ParseArray(tok, [&]() {
+              tok.SkipValue();
+              has_paint_extras = true;
+            });
+          } else {
+            // Shaders and blend modes do not take the alpha as a color
+            has_paint_extras |= flag == "shaderType" || flag == "hasShader" ||
+                                flag == "tileRecord" || flag == "blendMode";
+            tok.SkipValue();
+          }
+        });
+      } else {
+        tok.SkipValue();
+      }
+    });
+
+    // A multi-run blob is drawn a blob per run, which may overlap
+    op.has_bounds =
+        runs <= 1 && DrawBounds(op, rect, bounds, origin, line, op.bounds);
+    if (!op.has_bounds) {
+      op.bounds = RectF();
+    } else if (stroke) {
+      // Miter joins reach up to 4 half widths (the miter limit) out; a
+      // hairline is a pixel wide
+      const double outset = 2.0 * std::max(stroke_width, 1.0);
+      op.bounds = {op.bounds.left - outset, op.bounds.top - outset,
+                   op.bounds.right + outset, op.bounds.bottom + outset};
+    }
+    op.solid_color = has_alpha && !has_paint_extras;
+  });
+}
+
+// JavaScript's Number to String: the fewest digits that round-trip, in
+// fixed notation for exponents in [-7, 21), else as d.ddde+n
+void AppendNumber(double value, std::string& out) {
+  if (!std::isfinite(value)) {
+    out += "null";
+    return;
+  }
+  if (value == 0.0) {
+    out += "0";
+    return;
+  }
+  char buffer[32];
+  for (int precision = 1; precision <= 17; ++precision) {
+    std::snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, value);
+    if (std::strtod(buffer, nullptr) == value) {
+      break;
+    }
+  }
+  // buffer is [-]d[.ddd]e[+-]xx
+  std::string text = buffer;
+  if (text[0] == '-') {
+    out += '-';
+    text.erase(0, 1);
+  }
+  const size_t e = text.find('e');
+  std::string digits = text.substr(0, e);
+  digits.erase(std::remove(digits.begin(), digits.end(), '.'), digits.end());
+  const int k = static_cast<int>(digits.size());
+  const int n = std::atoi(text.c_str() + e + 1) + 1;
+  if (k <= n && n <= 21) {
+    out += digits;
+    out.append(n - k, '0');
+  } else if (0 < n && n <= 21) {
+    out += digits.substr(0, n);
+    out += '.';
+    out += digits.substr(n);
+  } else if (-6 < n && n <= 0) {
+    out += "0.";
+    out.append(-n, '0');
+    out += digits;
+  } else {
+    out += digits[0];
+    if (k > 1) {
+      out += '.';
+      out += digits.substr(1);
+    }
+    out += n - 1 < 0 ? "e-" : "e+";
+    out += std::to_string(std::abs(n - 1));
+  }
+}
+
+template <typename Container>
+void AppendNumbers(const Container& values, std::string& out) {
+  out += '[';
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (i > 0) {
+      out += ", ";
+    }
+    AppendNumber(values[i], out);
+  }
+  out += ']';
+}
+
+void AppendMatrix(const Transform& transform, std::string& out) {
+  std::array<double, 16> values;
+  transform.GetRowMajor(values);
+  AppendNumbers(values, out);
+}
+
+void AppendBool(bool value, std::string& out) {
+  out += value ? "true" : "false";
+}
+
+// Writes {"nodes": [...]}, one node per line, each as its source fields
+// followed by what |append_resolved(index, out)| adds
+template <typename AppendResolved>
+void AppendTree(const std::vector<std::vector<PaintArtifact::Field>>& fields,
+                AppendResolved append_resolved, std::string& out) {
+  out += "{\"nodes\": [";
+  for (size_t i = 0; i < fields.size(); ++i) {
+    out += i > 0 ? ",\n  " : "\n  ";
+    out += '{';
+    for (const PaintArtifact::Field& field : fields[i]) {
+      out += field.text;
+      out += ", ";
+    }
+    append_resolved(i, out);
+    out += '}';
+  }
+  out += fields.empty() ? "]}" : "\n]}";
+}
+
+}  // namespace
+
+PaintArtifact ParsePaintArtifact(const std::string& json_str) {
+  JsonTokenizer tok(json_str);
+  PaintArtifact artifact;
+  ParseObject(tok, [&](const std::string& key, size_t begin) {
+    // The key as written, up to the colon
+    PaintArtifact::Member member;
+    member.key = tok.Source(begin, tok.pos());
+    member.key.erase(member.key.find_last_not_of(" \t\r\n:") + 1);
+
+    const size_t value_begin = tok.pos();
+    if (key == "transform_tree") {
+      ReadTransformTree(tok, artifact);
+    } else if (key == "clip_tree") {
+      ReadClipTree(tok, artifact);
+    } else if (key == "effect_tree") {
+      ReadEffectTree(tok, artifact);
+    } else if (key == "paint_ops") {
+      // Copied, with the ops read on the way
+      tok.Peek();
+      const size_t text_begin = tok.pos();
+      if (!tok.ReadNull()) {
+        ReadPaintOps(tok, text_begin, artifact.paint_ops);
+      }
+      member.value = tok.Source(text_begin, tok.pos());
+    } else {
+      tok.SkipValue();
+      // Copied, not parsed
+      tok.Peek();
+      member.value = tok.Source(value_begin, tok.pos());
+      member.value.erase(0, member.value.find_first_not_of(" \t\r\n"));
+      member.value.erase(member.value.find_last_not_of(" \t\r\n") + 1);
+    }
+    artifact.members.push_back(std::move(member));
+  });
+  return artifact;
+}
+
+std::vector<uint32_t> ApplyTransformChanges(const std::string& json_str,
+                                            PaintArtifact& artifact) {
+  // The last node with an id wins, as in the tree walk
+  std::unordered_map<int64_t, uint32_t> index_of;
+  for (uint32_t i = 0; i < artifact.transform_nodes.size(); ++i) {
+    index_of[artifact.transform_nodes[i].id] = i;
+  }
+
+  JsonTokenizer tok(json_str);
+  std::vector<uint32_t> changed;
+  ParseObject(tok, [&](const std::string& key, size_t) {
+    if (key != "changes") {
+      tok.SkipValue();
+      return;
+    }
+    ParseArray(tok, [&]() {
+      TransformNode change;
+      change.id = kInvalidNodeId;
+      std::vector<PaintArtifact::Field> fields;
+      ReadTransformNode(tok, change, fields);
+      auto it = index_of.find(change.id);
+      if (it == index_of.end()) {
+        throw std::runtime_error("Unknown transform node id " +
+                                 std::to_string(change.id));
+      }
+      const uint32_t index = it->second;
+
+      // Merge the fields, then read the node again from them
+      std::vector<PaintArtifact::Field>& node_fields =
+          artifact.transform_fields[index];
+      for (PaintArtifact::Field& field : fields) {
+        if (field.key == "id") {
+          continue;
+        }
+        if (field.key == "parent_id" &&
+            change.parent_id != artifact.transform_nodes[index].parent_id) {
+          throw std::runtime_error("Changing the parent_id of transform node " +
+                                   std::to_string(change.id) +
+                                   " is not supported");
+        }
+        auto existing = std::find_if(
+            node_fields.begin(), node_fields.end(),
+            [&](const PaintArtifact::Field& f) { return f.key == field.key; });
+        if (existing != node_fields.end()) {
+          *existing = std::move(field);
+        } else {
+          node_fields.push_back(std::move(field));
+        }
+      }
+      std::string node_json = "{";
+      for (size_t i = 0; i < node_fields.size(); ++i) {
+        node_json += i > 0 ? ", " : "";
+        node_json += node_fields[i].text;
+      }
+      node_json += '}';
+      JsonTokenizer node_tok(node_json);
+      TransformNode node;
+      std::vector<PaintArtifact::Field> reread;
+      ReadTransformNode(node_tok, node, reread);
+      artifact.transform_nodes[index] = node;
+      changed.push_back(index);
+    });
+  });
+  return changed;
+}
+
+std::string SerializeReplayArtifact(
+    const PaintArtifact& artifact,
+    const std::vector<ResolvedTransform>& transforms,
+    const std::vector<ResolvedClip>& clips, const RenderSurfaces& surfaces) {
+  std::string out = "{";
+  for (size_t i = 0; i < artifact.members.size(); ++i) {
+    const PaintArtifact::Member& member = artifact.members[i];
+    out += i > 0 ? ",\n" : "";
+    out += member.key;
+    out += ": ";
+    if (member.key == "\"transform_tree\"") {
+      AppendTree(
+          artifact.transform_fields,
+          [&](size_t index, std::string& node) {
+            const ResolvedTransform& transform = transforms[index];
+            node += "\"screen_matrix\": ";
+            AppendMatrix(transform.screen, node);
+            node += ", \"screen_inverse\": ";
+            if (transform.invertible) {
+              AppendMatrix(transform.inverse, node);
+            } else {
+              node += "null";
+            }
+            node += ", \"creates_3d\": ";
+            AppendBool(transform.creates_3d, node);
+            node += ", \"cull_backface\": ";
+            AppendBool(transform.cull_backface, node);
+            node += ", \"order\": " + std::to_string(transform.order);
+            node +=
+                ", \"descendants\": " + std::to_string(transform.descendants);
+          },
+          out);
+    } else if (member.key == "\"clip_tree\"") {
+      AppendTree(
+          artifact.clip_fields,
+          [&](size_t index, std::string& node) {
+            const ResolvedClip& clip = clips[index];
+            const std::array<double, 4> bounds = {
+                clip.bounds.left, clip.bounds.top, clip.bounds.width(),
+                clip.bounds.height()};
+            node += "\"clip_bounds\": ";
+            AppendNumbers(bounds, node);
+            if (!clip.path_cmds.empty()) {
+              node += ", \"clip_cmds\": ";
+              AppendNumbers(clip.path_cmds, node);
+            }
+          },
+          out);
+    } else if (member.key == "\"effect_tree\"") {
+      AppendTree(
+          artifact.effect_fields,
+          [&](size_t index, std::string& node) {
+            const EffectSurface& surface = surfaces.effects[index];
+            // Before the reason, where a second run finds it among the
+            // source fields
+            if (surface.fold_opacity &&
+                !artifact.effect_nodes[index].opacity_folded) {
+              node += "\"opacity_folded\": true, ";
+            }
+            node += "\"render_surface_reason\": \"";
+            node += RenderSurfaceReasonToString(surface.reason);
+            node += '"';
+          },
+          out);
+    } else if (member.key == "\"paint_ops\"" &&
+               !surfaces.folded_ops.empty()) {
+      // The source text with the folded alphas spliced in
+      size_t copied = 0;
+      for (const RenderSurfaces::FoldedOp& folded : surfaces.folded_ops) {
+        const PaintOp& op = artifact.paint_ops[folded.op];
+        out.append(member.value, copied, op.alpha_begin - copied);
+        AppendNumber(op.alpha * artifact.effect_nodes[folded.effect].opacity,
+                     out);
+        copied = op.alpha_end;
+      }
+      out.append(member.value, copied, std::string::npos);
+    } else {
+      out += member.value;
+    }
+  }
+  out += "}\n";
+  return out;
+}
+
+}  // namespace paint_preprocessor
@@ -0,0 +1,71 @@
+#ifndef PAINT_PREPROCESSOR_JSON_PARSER_H_
+#define PAINT_PREPROCESSOR_JSON_PARSER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "property_trees.h"
+#include "render_surfaces.h"
+
+namespace paint_preprocessor {
+
+// A paint artifact as read: the transform, clip and effect tree nodes,
+// what the render surface pass needs of the paint ops, and the source text
+// of everything else, which passes through unchanged
+struct PaintArtifact {
+  // Top-level members in source order, as their key and value text
+  struct Member {
+    std::string key;
+    std::string value;
+  };
+  std::vector<Member> members;
+
+  // A node field: its key, and its "key": value text
+  struct Field {
+    std::string key;
+    std::string text;
+  };
+
+  std::vector<TransformNode> transform_nodes;
+  std::vector<ClipNode> clip_nodes;
+  std::vector<EffectNode> effect_nodes;
+  // The fields of each node, without the ones SerializeReplayArtifact adds
+  std::vector<std::vector<Field>> transform_fields;
+  std::vector<std::vector<Field>> clip_fields;
+  std::vector<std::vector<Field>> effect_fields;
+
+  // "paint_ops" is also kept as its source text, in |members|
+  std::vector<PaintOp> paint_ops;
+};
+
+// Parse a paint artifact ({"paint_ops", "transform_tree": {"nodes"},
+// "clip_tree": {"nodes"}, "effect_tree": {"nodes"}}, as
+// 04_paint/reference/paint.json).
+// Throws std::runtime_error on malformed JSON.
+PaintArtifact ParsePaintArtifact(const std::string& json_str);
+
+// Apply {"changes": [{"id": 3, "translation2d": [0, 5]}, ...]} to the
+// transform nodes: each change replaces or adds fields of the node with its
+// id, which is read again from its merged fields. Returns the indices of the
+// changed nodes. Throws std::runtime_error on malformed JSON, an unknown id
+// or a changed parent_id, which would change the tree's structure.
+std::vector<uint32_t> ApplyTransformChanges(const std::string& json_str,
+                                            PaintArtifact& artifact);
+
+// Serialize the artifact with the resolved fields added to its nodes: a
+// transform node gains "screen_matrix", "screen_inverse" (row-major, null
+// when not invertible), "creates_3d", "cull_backface", "order" and
+// "descendants"; a clip node "clip_bounds" ([x, y, width, height]) and,
+// for a clip_path, "clip_cmds"; an effect node "render_surface_reason"
+// and, when its opacity is folded, "opacity_folded": true. The ops of
+// |surfaces.folded_ops| have their "a" multiplied by the opacity.
+// Everything else is written as read.
+std::string SerializeReplayArtifact(
+    const PaintArtifact& artifact,
+    const std::vector<ResolvedTransform>& transforms,
+    const std::vector<ResolvedClip>& clips, const RenderSurfaces& surfaces);
+
+}  // namespace paint_preprocessor
+
+#endif  // PAINT_PREPROCESSOR_JSON_PARSER_H_
@@ -0,0 +1,224 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "json_parser.h"
+#include "property_trees.h"
+#include "render_surfaces.h"
+
+void PrintUsage(const char* program) {
+  std::cerr << "Usage: " << program << " -i <paint.json> [-o <output.json>]\n";
+  std::cerr << "\n";
+  std::cerr << "Options:\n";
+  std::cerr << "  -i <file>        Paint artifact JSON (required)\n";
+  std::cerr << "  -o <file>        Output JSON file (default: stdout)\n";
+  std::cerr << "  --changes <file> Apply transform node changes after resolving,\n";
+  std::cerr << "                   and resolve again through the cache\n";
+  std::cerr << "  --full-matrix    Keep every transform as a full 4x4 matrix\n";
+  std::cerr << "                   (no AxisTransform2d), for comparison\n";
+  std::cerr << "  --stats          Print node counts, render surfaces and\n";
+  std::cerr << "                   parse/resolve/serialize times to stderr\n";
+}
+
+bool ReadFile(const std::string& path, std::string& contents) {
+  std::ifstream ifs(path);
+  if (!ifs) {
+    std::cerr << "Error: Cannot open input file: " << path << "\n";
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << ifs.rdbuf();
+  contents = buffer.str();
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  std::string input_file;
+  std::string output_file;
+  std::string changes_file;
+  bool full_matrix = false;
+  bool print_stats = false;
+
+  // Parse command line arguments
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-i" && i + 1 < argc) {
+      input_file = argv[++i];
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_file = argv[++i];
+    } else if (arg == "--changes" && i + 1 < argc) {
+      changes_file = argv[++i];
+    } else if (arg == "--full-matrix") {
+      full_matrix = true;
+    } else if (arg == "--stats") {
+      print_stats = true;
+    } else if (arg == "-h" || arg == "--help") {
+      PrintUsage(argv[0]);
+      return 0;
+    }
+  }
+
+  if (input_file.empty()) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  // Read input files
+  std::string json_input;
+  std::string changes_input;
+  if (!ReadFile(input_file, json_input) ||
+      (!changes_file.empty() && !ReadFile(changes_file, changes_input))) {
+    return 1;
+  }
+
+  // Parse input
+  using Clock = std::chrono::steady_clock;
+  auto parse_start = Clock::now();
+  paint_preprocessor::PaintArtifact artifact;
+  try {
+    artifact = paint_preprocessor::ParsePaintArtifact(json_input);
+  } catch (const std::exception& e) {
+    std::cerr << "Error parsing input: " << e.what() << "\n";
+    return 1;
+  }
+  if (full_matrix) {
+    for (paint_preprocessor::TransformNode& node : artifact.transform_nodes) {
+      node.local.EnsureFullMatrix();
+    }
+  }
+
+  // Resolve both trees. The screen transforms are accumulated through the
+  // cache first, so --stats can time the products on their own.
+  auto resolve_start = Clock::now();
+  paint_preprocessor::PreprocessStats stats;
+  paint_preprocessor::TransformCache cache(artifact.transform_nodes);
+  auto accumulate = [&cache]() {
+    const auto start = Clock::now();
+    for (const uint32_t index : cache.pre_order()) {
+      cache.ScreenTransform(index);
+    }
+    return Clock::now() - start;
+  };
+  const Clock::duration accumulate_time = accumulate();
+  std::vector<paint_preprocessor::ResolvedTransform> transforms;
+  paint_preprocessor::ResolveTransformTree(artifact.transform_nodes, cache,
+                                           transforms, &stats);
+  std::vector<paint_preprocessor::ResolvedClip> clips =
+      paint_preprocessor::ResolveClipTree(artifact.clip_nodes, &stats);
+
+  // Apply the changes and resolve the transform tree again; the cache only
+  // multiplies out the changed subtrees
+  auto update_start = Clock::now();
+  size_t changed_nodes = 0;
+  const size_t computed = cache.computed();
+  const size_t reused = cache.reused();
+  Clock::duration update_accumulate_time{};
+  paint_preprocessor::PreprocessStats update_stats;
+  if (!changes_file.empty()) {
+    try {
+      for (const uint32_t index : paint_preprocessor::ApplyTransformChanges(
+               changes_input, artifact)) {
+        if (full_matrix) {
+          artifact.transform_nodes[index].local.EnsureFullMatrix();
+        }
+        cache.SetNeedsUpdate(index);
+        ++changed_nodes;
+      }
+    } catch (const std::exception& e) {
+      std::cerr << "Error applying changes: " << e.what() << "\n";
+      return 1;
+    }
+    update_accumulate_time = accumulate();
+    paint_preprocessor::ResolveTransformTree(artifact.transform_nodes, cache,
+                                             transforms, &update_stats);
+  }
+
+  // Decide which effects need a surface, against the final transforms
+  auto surfaces_start = Clock::now();
+  const paint_preprocessor::RenderSurfaces surfaces =
+      paint_preprocessor::DecideRenderSurfaces(
+          artifact.effect_nodes, artifact.paint_ops, artifact.transform_nodes,
+          transforms);
+
+  // Serialize output
+  auto serialize_start = Clock::now();
+  std::string json_output = paint_preprocessor::SerializeReplayArtifact(
+      artifact, transforms, clips, surfaces);
+  auto serialize_end = Clock::now();
+
+  if (print_stats) {
+    using Ms = std::chrono::duration<double, std::milli>;
+    const paint_preprocessor::PreprocessStats& transform_stats =
+        changes_file.empty() ? stats : update_stats;
+    std::cerr << "transform nodes: " << transforms.size() << " ("
+              << transform_stats.transforms_axis_2d << " 2d axis-aligned, "
+              << transform_stats.transforms_3d << " 3d, "
+              << transform_stats.non_invertible << " not invertible, "
+              << transform_stats.backface_culled << " backface culled)\n";
+    std::cerr << "clip nodes: " << clips.size() << " (" << stats.clip_paths
+              << " clip paths, " << stats.clip_paths_unresolved
+              << " left to the renderer)\n";
+    using Reason = paint_preprocessor::RenderSurfaceReason;
+    size_t folded_effects = 0;
+    auto surfaces_for = [&surfaces](Reason reason) {
+      size_t count = 0;
+      for (const paint_preprocessor::EffectSurface& surface :
+           surfaces.effects) {
+        count += surface.reason == reason;
+      }
+      return count;
+    };
+    for (const paint_preprocessor::EffectSurface& surface : surfaces.effects) {
+      folded_effects += surface.fold_opacity;
+    }
+    std::cerr << "effect nodes: " << surfaces.effects.size() << " ("
+              << surfaces.effects.size() - surfaces_for(Reason::kNone)
+              << " render surfaces: " << surfaces_for(Reason::kOpacity)
+              << " opacity, "
+              << surfaces_for(Reason::kBlendMode) +
+                     surfaces_for(Reason::kBlendModeDstIn)
+              << " blend mode, " << surfaces_for(Reason::kFilter)
+              << " filter; " << folded_effects << " opacities folded into "
+              << surfaces.folded_ops.size() << " ops)\n";
+    if (!changes_file.empty()) {
+      std::cerr << "changes: " << changed_nodes << " nodes, "
+                << cache.computed() - computed
+                << " screen transforms recomputed, "
+                << cache.reused() - reused << " reused\n";
+    }
+    std::cerr << std::fixed << std::setprecision(3)
+              << "parse time: " << Ms(resolve_start - parse_start).count()
+              << " ms\n"
+              << "resolve time: "
+              << Ms(update_start - resolve_start).count() << " ms ("
+              << Ms(accumulate_time).count() << " ms accumulating)\n";
+    if (!changes_file.empty()) {
+      std::cerr << "update time: "
+                << Ms(surfaces_start - update_start).count() << " ms ("
+                << Ms(update_accumulate_time).count()
+                << " ms accumulating)\n";
+    }
+    std::cerr << "render surfaces time: "
+              << Ms(serialize_start - surfaces_start).count() << " ms\n";
+    std::cerr << "serialize time: "
+              << Ms(serialize_end - serialize_start).count() << " ms\n";
+  }
+
+  // Write output
+  if (output_file.empty()) {
+    std::cout << json_output;
+  } else {
+    std::ofstream ofs(output_file);
+    if (!ofs) {
+      std::cerr << "Error: Cannot open output file: " << output_file << "\n";
+      return 1;
+    }
+    ofs << json_output;
+  }
+
+  return 0;
+}
@@ -0,0 +1,404 @@
+// Paint Preprocessor Batched Mapping Implementation
+
+#include "map_batch.h"
+
+#include <cfloat>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace paint_preprocessor {
+
+namespace {
+
+// One lane: the tail of every loop, and the whole loop without SSE2
+struct Scalar {
+  static constexpr size_t kLanes = 1;
+
+  static Scalar Load(const double* p) { return {*p}; }
+  static Scalar Set(double value) { return {value}; }
+  void Store(double* p) const { *p = v; }
+
+  friend Scalar operator+(Scalar a, Scalar b) { return {a.v + b.v}; }
+  friend Scalar operator*(Scalar a, Scalar b) { return {a.v * b.v}; }
+  friend Scalar operator/(Scalar a, Scalar b) { return {a.v / b.v}; }
+  friend Scalar Min(Scalar a, Scalar b) { return {BoundsMin(a.v, b.v)}; }
+  friend Scalar Max(Scalar a, Scalar b) { return {BoundsMax(a.v, b.v)}; }
+
+  friend bool AllInFront(Scalar w) { return w.v > 0; }
+  // Transform::MapPoint's divide by w
+  friend void Project(Scalar& x, Scalar& y, Scalar w) {
+    if (w.v != 1 && std::isnormal(w.v)) {
+      const double w_inverse = 1 / w.v;
+      x.v *= w_inverse;
+      y.v *= w_inverse;
+    }
+  }
+
+  double v;
+};
+
+#if defined(__AVX2__)
+struct Lanes {
+  static constexpr size_t kLanes = 4;
+
+  static Lanes Load(const double* p) { return {_mm256_loadu_pd(p)}; }
+  static Lanes Set(double value) { return {_mm256_set1_pd(value)}; }
+  void Store(double* p) const { _mm256_storeu_pd(p, v); }
+
+  friend Lanes operator+(Lanes a, Lanes b) {
+    return {_mm256_add_pd(a.v, b.v)};
+  }
+  friend Lanes operator*(Lanes a, Lanes b) {
+    return {_mm256_mul_pd(a.v, b.v)};
+  }
+  friend Lanes operator/(Lanes a, Lanes b) {
+    return {_mm256_div_pd(a.v, b.v)};
+  }
+  friend Lanes Min(Lanes a, Lanes b) { return {_mm256_min_pd(a.v, b.v)}; }
+  friend Lanes Max(Lanes a, Lanes b) { return {_mm256_max_pd(a.v, b.v)}; }
+
+  friend bool AllInFront(Lanes w) {
+    const __m256d in_front =
+        _mm256_cmp_pd(w.v, _mm256_setzero_pd(), _CMP_GT_OQ);
+    return _mm256_movemask_pd(in_front) == 0xF;
+  }
+  friend void Project(Lanes& x, Lanes& y, Lanes w) {
+    // |w| in [DBL_MIN, DBL_MAX] is std::isnormal; NaN compares false
+    const __m256d magnitude = _mm256_andnot_pd(_mm256_set1_pd(-0.0), w.v);
+    const __m256d divide = _mm256_and_pd(
+        _mm256_and_pd(
+            _mm256_cmp_pd(magnitude, _mm256_set1_pd(DBL_MIN), _CMP_GE_OQ),
+            _mm256_cmp_pd(magnitude, _mm256_set1_pd(DBL_MAX), _CMP_LE_OQ)),
+        _mm256_cmp_pd(w.v, _mm256_set1_pd(1.0), _CMP_NEQ_OQ));
+    const __m256d w_inverse = _mm256_div_pd(_mm256_set1_pd(1.0), w.v);
+    x.v = _mm256_blendv_pd(x.v, _mm256_mul_pd(x.v, w_inverse), divide);
+    y.v = _mm256_blendv_pd(y.v, _mm256_mul_pd(y.v, w_inverse), divide);
+  }
+
+  __m256d v;
+};
+#elif defined(__SSE2__)
+struct Lanes {
+  static constexpr size_t kLanes = 2;
+
+  static Lanes Load(const double* p) { return {_mm_loadu_pd(p)}; }
+  static Lanes Set(double value) { return {_mm_set1_pd(value)}; }
+  void Store(double* p) const { _mm_storeu_pd(p, v); }
+
+  friend Lanes operator+(Lanes a, Lanes b) { return {_mm_add_pd(a.v, b.v)}; }
+  friend Lanes operator*(Lanes a, Lanes b) { return {_mm_mul_pd(a.v, b.v)}; }
+  friend Lanes operator/(Lanes a, Lanes b) { return {_mm_div_pd(a.v, b.v)}; }
+  friend Lanes Min(Lanes a, Lanes b) { return {_mm_min_pd(a.v, b.v)}; }
+  friend Lanes Max(Lanes a, Lanes b) { return {_mm_max_pd(a.v, b.v)}; }
+
+  friend bool AllInFront(Lanes w) {
+    return _mm_movemask_pd(_mm_cmpgt_pd(w.v, _mm_setzero_pd())) == 0x3;
+  }
+  friend void Project(Lanes& x, Lanes& y, Lanes w) {
+    // |w| in [DBL_MIN, DBL_MAX] is std::isnormal; NaN compares false
+    const __m128d magnitude = _mm_andnot_pd(_mm_set1_pd(-0.0), w.v);
+    const __m128d divide = _mm_and_pd(
+        _mm_and_pd(_mm_cmpge_pd(magnitude, _mm_set1_pd(DBL_MIN)),
+                   _mm_cmple_pd(magnitude, _mm_set1_pd(DBL_MAX))),
+        _mm_cmpneq_pd(w.v, _mm_set1_pd(1.0)));
+    const __m128d w_inverse = _mm_div_pd(_mm_set1_pd(1.0), w.v);
+    x.v = _mm_or_pd(_mm_and_pd(divide, _mm_mul_pd(x.v, w_inverse)),
+                    _mm_andnot_pd(divide, x.v));
+    y.v = _mm_or_pd(_mm_and_pd(divide, _mm_mul_pd(y.v, w_inverse)),
+                    _mm_andnot_pd(divide, y.v));
+  }
+
+  __m128d v;
+};
+#endif
+
+// Runs kernel.Map<V>(i) over [0, count), a vector of lanes at a time
+template <typename Kernel>
+void Run(const Kernel& kernel, size_t count) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + Lanes::kLanes <= count; i += Lanes::kLanes) {
+    kernel.template Map<Lanes>(i);
+  }
+#endif
+  for (; i < count; ++i) {
+    kernel.template Map<Scalar>(i);
+  }
+}
+
+// x' = a * x + c * y + e, y' = b * x + d * y + f, w = p * x + q * y + r,
+// the rows of the transform that act on a point in the z = 0 plane
+struct Coefficients {
+  explicit Coefficients(const Transform& t)
+      : a(t.rc(0, 0)),
+        b(t.rc(1, 0)),
+        c(t.rc(0, 1)),
+        d(t.rc(1, 1)),
+        e(t.rc(0, 3)),
+        f(t.rc(1, 3)),
+        p(t.rc(3, 0)),
+        q(t.rc(3, 1)),
+        r(t.rc(3, 3)) {}
+
+  double a, b, c, d, e, f, p, q, r;
+};
+
+struct PointArrays {
+  const double* x;
+  const double* y;
+  double* out_x;
+  double* out_y;
+};
+
+// The kernels mirror Transform::MapPoint / MapRect operation for operation
+
+struct TranslatePoints {
+  template <typename V>
+  void Map(size_t i) const {
+    (V::Load(p.x + i) + V::Set(m.e)).Store(p.out_x + i);
+    (V::Load(p.y + i) + V::Set(m.f)).Store(p.out_y + i);
+  }
+
+  const Coefficients& m;
+  PointArrays p;
+};
+
+struct ScaleTranslatePoints {
+  template <typename V>
+  void Map(size_t i) const {
+    (V::Set(m.a) * V::Load(p.x + i) + V::Set(m.e)).Store(p.out_x + i);
+    (V::Set(m.d) * V::Load(p.y + i) + V::Set(m.f)).Store(p.out_y + i);
+  }
+
+  const Coefficients& m;
+  PointArrays p;
+};
+
+struct AffinePoints {
+  template <typename V>
+  void Map(size_t i) const {
+    const V x = V::Load(p.x + i);
+    const V y = V::Load(p.y + i);
+    (V::Set(m.a) * x + V::Set(m.c) * y + V::Set(m.e)).Store(p.out_x + i);
+    (V::Set(m.b) * x + V::Set(m.d) * y + V::Set(m.f)).Store(p.out_y + i);
+  }
+
+  const Coefficients& m;
+  PointArrays p;
+};
+
+struct PerspectivePoints {
+  template <typename V>
+  void Map(size_t i) const {
+    const V x = V::Load(p.x + i);
+    const V y = V::Load(p.y + i);
+    V mapped_x = V::Set(m.a) * x + V::Set(m.c) * y + V::Set(m.e);
+    V mapped_y = V::Set(m.b) * x + V::Set(m.d) * y + V::Set(m.f);
+    const V w = V::Set(m.p) * x + V::Set(m.q) * y + V::Set(m.r);
+    Project(mapped_x, mapped_y, w);
+    mapped_x.Store(p.out_x + i);
+    mapped_y.Store(p.out_y + i);
+  }
+
+  const Coefficients& m;
+  PointArrays p;
+};
+
+void MapPointArrays(Transform::MapKind kind, const Coefficients& m,
+                    const PointArrays& arrays, size_t count) {
+  switch (kind) {
+    case Transform::MapKind::kTranslate:
+      Run(TranslatePoints{m, arrays}, count);
+      break;
+    case Transform::MapKind::kScaleTranslate:
+      Run(ScaleTranslatePoints{m, arrays}, count);
+      break;
+    case Transform::MapKind::kAffine:
+      Run(AffinePoints{m, arrays}, count);
+      break;
+    case Transform::MapKind::kPerspective:
+      Run(PerspectivePoints{m, arrays}, count);
+      break;
+  }
+}
+
+struct RectArrays {
+  RectArrays(const RectBatch& rects, RectBatch& out)
+      : left(rects.left.data()),
+        top(rects.top.data()),
+        right(rects.right.data()),
+        bottom(rects.bottom.data()),
+        out_left(out.left.data()),
+        out_top(out.top.data()),
+        out_right(out.right.data()),
+        out_bottom(out.bottom.data()) {}
+
+  const double* left;
+  const double* top;
+  const double* right;
+  const double* bottom;
+  double* out_left;
+  double* out_top;
+  double* out_right;
+  double* out_bottom;
+};
+
+struct TranslateRects {
+  template <typename V>
+  void Map(size_t i) const {
+    (V::Load(r.left + i) + V::Set(m.e)).Store(r.out_left + i);
+    (V::Load(r.top + i) + V::Set(m.f)).Store(r.out_top + i);
+    (V::Load(r.right + i) + V::Set(m.e)).Store(r.out_right + i);
+    (V::Load(r.bottom + i) + V::Set(m.f)).Store(r.out_bottom + i);
+  }
+
+  const Coefficients& m;
+  RectArrays r;
+};
+
+struct ScaleTranslateRects {
+  template <typename V>
+  void Map(size_t i) const {
+    const V x0 = V::Set(m.a) * V::Load(r.left + i) + V::Set(m.e);
+    const V y0 = V::Set(m.d) * V::Load(r.top + i) + V::Set(m.f);
+    const V x1 = V::Set(m.a) * V::Load(r.right + i) + V::Set(m.e);
+    const V y1 = V::Set(m.d) * V::Load(r.bottom + i) + V::Set(m.f);
+    Min(x0, x1).Store(r.out_left + i);
+    Min(y0, y1).Store(r.out_top + i);
+    Max(x0, x1).Store(r.out_right + i);
+    Max(y0, y1).Store(r.out_bottom + i);
+  }
+
+  const Coefficients& m;
+  RectArrays r;
+};
+
+// The bounds of 4 mapped corners, in MapRect's order
+template <typename V>
+void StoreBounds(const V (&x)[4], const V (&y)[4], const RectArrays& r,
+                 size_t i) {
+  Min(Min(Min(x[0], x[1]), x[2]), x[3]).Store(r.out_left + i);
+  Min(Min(Min(y[0], y[1]), y[2]), y[3]).Store(r.out_top + i);
+  Max(Max(Max(x[0], x[1]), x[2]), x[3]).Store(r.out_right + i);
+  Max(Max(Max(y[0], y[1]), y[2]), y[3]).Store(r.out_bottom + i);
+}
+
+struct AffineRects {
+  template <typename V>
+  void Map(size_t i) const {
+    const V left = V::Load(r.left + i);
+    const V top = V::Load(r.top + i);
+    const V right = V::Load(r.right + i);
+    const V bottom = V::Load(r.bottom + i);
+    const V corner_x[4] = {left, right, right, left};
+    const V corner_y[4] = {top, top, bottom, bottom};
+    V x[4], y[4];
+    for (int k = 0; k < 4; ++k) {
+      x[k] = V::Set(m.a) * corner_x[k] + V::Set(m.c) * corner_y[k] +
+             V::Set(m.e);
+      y[k] = V::Set(m.b) * corner_x[k] + V::Set(m.d) * corner_y[k] +
+             V::Set(m.f);
+    }
+    StoreBounds(x, y, r, i);
+  }
+
+  const Coefficients& m;
+  RectArrays r;
+};
+
+struct PerspectiveRects {
+  template <typename V>
+  void Map(size_t i) const {
+    const V left = V::Load(r.left + i);
+    const V top = V::Load(r.top + i);
+    const V right = V::Load(r.right + i);
+    const V bottom = V::Load(r.bottom + i);
+    const V corner_x[4] = {left, right, right, left};
+    const V corner_y[4] = {top, top, bottom, bottom};
+    V x[4], y[4], w[4];
+    for (int k = 0; k < 4; ++k) {
+      x[k] = V::Set(m.a) * corner_x[k] + V::Set(m.c) * corner_y[k] +
+             V::Set(m.e);
+      y[k] = V::Set(m.b) * corner_x[k] + V::Set(m.d) * corner_y[k] +
+             V::Set(m.f);
+      w[k] = V::Set(m.p) * corner_x[k] + V::Set(m.q) * corner_y[k] +
+             V::Set(m.r);
+    }
+    if (!AllInFront(w[0]) || !AllInFront(w[1]) || !AllInFront(w[2]) ||
+        !AllInFront(w[3])) {
+      // Some lane needs clipping
+      for (size_t lane = i; lane < i + V::kLanes; ++lane) {
+        const RectF mapped = transform.MapRect(
+            {r.left[lane], r.top[lane], r.right[lane], r.bottom[lane]});
+        r.out_left[lane] = mapped.left;
+        r.out_top[lane] = mapped.top;
+        r.out_right[lane] = mapped.right;
+        r.out_bottom[lane] = mapped.bottom;
+      }
+      return;
+    }
+    for (int k = 0; k < 4; ++k) {
+      const V w_inverse = V::Set(1.0) / w[k];
+      x[k] = x[k] * w_inverse;
+      y[k] = y[k] * w_inverse;
+    }
+    StoreBounds(x, y, r, i);
+  }
+
+  const Transform& transform;
+  const Coefficients& m;
+  RectArrays r;
+};
+
+}  // namespace
+
+void MapPoints(const Transform& transform, const PointBatch& points,
+               PointBatch& out) {
+  out.Resize(points.size());
+  const Coefficients m(transform);
+  MapPointArrays(transform.GetMapKind(), m,
+                 {points.x.data(), points.y.data(), out.x.data(),
+                  out.y.data()},
+                 points.size());
+}
+
+void MapRects(const Transform& transform, const RectBatch& rects,
+              RectBatch& out) {
+  out.Resize(rects.size());
+  const Coefficients m(transform);
+  const RectArrays arrays(rects, out);
+  switch (transform.GetMapKind()) {
+    case Transform::MapKind::kTranslate:
+      Run(TranslateRects{m, arrays}, rects.size());
+      break;
+    case Transform::MapKind::kScaleTranslate:
+      Run(ScaleTranslateRects{m, arrays}, rects.size());
+      break;
+    case Transform::MapKind::kAffine:
+      Run(AffineRects{m, arrays}, rects.size());
+      break;
+    case Transform::MapKind::kPerspective:
+      Run(PerspectiveRects{transform, m, arrays}, rects.size());
+      break;
+  }
+}
+
+void MapQuads(const Transform& transform, const QuadBatch& quads,
+              QuadBatch& out) {
+  out.Resize(quads.size());
+  const Coefficients m(transform);
+  const Transform::MapKind kind = transform.GetMapKind();
+  for (int k = 0; k < 4; ++k) {
+    MapPointArrays(kind, m,
+                   {quads.x[k].data(), quads.y[k].data(), out.x[k].data(),
+                    out.y[k].data()},
+                   quads.size());
+  }
+}
+
+}  // namespace paint_preprocessor
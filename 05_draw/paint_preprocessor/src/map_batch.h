@@ -0,0 +1,77 @@
+// Paint Preprocessor Batched Mapping
+// Maps arrays of points, rects and quads through one transform at once
+
+#ifndef PAINT_PREPROCESSOR_MAP_BATCH_H_
+#define PAINT_PREPROCESSOR_MAP_BATCH_H_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "transform.h"
+
+namespace paint_preprocessor {
+
+// Batches are structures of arrays, one lane per element, so a SIMD op maps
+// the same coordinate of 4 (AVX2) or 2 (SSE2) elements.
+struct PointBatch {
+  size_t size() const { return x.size(); }
+  void Resize(size_t size) {
+    x.resize(size);
+    y.resize(size);
+  }
+
+  std::vector<double> x;
+  std::vector<double> y;
+};
+
+struct RectBatch {
+  size_t size() const { return left.size(); }
+  void Resize(size_t size) {
+    left.resize(size);
+    top.resize(size);
+    right.resize(size);
+    bottom.resize(size);
+  }
+
+  std::vector<double> left;
+  std::vector<double> top;
+  std::vector<double> right;
+  std::vector<double> bottom;
+};
+
+// Quads by their 4 vertices, clockwise from the top left for a quad made
+// from a rect
+struct QuadBatch {
+  size_t size() const { return x[0].size(); }
+  void Resize(size_t size) {
+    for (int i = 0; i < 4; ++i) {
+      x[i].resize(size);
+      y[i].resize(size);
+    }
+  }
+
+  std::array<std::vector<double>, 4> x;
+  std::array<std::vector<double>, 4> y;
+};
+
+// Transform::MapPoint, MapRect and MapPoint of each vertex, over a whole
+// batch. The loop is picked once per batch by Transform::GetMapKind instead
+// of once per element, and runs as AVX2 (make SIMD_FLAGS=-mavx2) or SSE2
+// code with a scalar tail. Results are the same as mapping one element at a
+// time, bit for bit (with -ffp-contract=off, as matrix_kernels.h).
+//
+// |out| is resized to the input's size, and may be the input itself.
+void MapPoints(const Transform& transform, const PointBatch& points,
+               PointBatch& out);
+// With perspective, vectors of rects that are entirely in front of the eye
+// are mapped together; a vector with a corner behind it (w <= 0) falls back
+// to Transform::MapRect lane by lane, which clips it.
+void MapRects(const Transform& transform, const RectBatch& rects,
+              RectBatch& out);
+void MapQuads(const Transform& transform, const QuadBatch& quads,
+              QuadBatch& out);
+
+}  // namespace paint_preprocessor
+
+#endif  // PAINT_PREPROCESSOR_MAP_BATCH_H_
@@ -0,0 +1,342 @@
+// Paint Preprocessor Matrix Kernels Implementation
+
+#include "matrix_kernels.h"
+
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace paint_preprocessor {
+
+namespace {
+
+// The 2x2 minors b00..b11: b00..b05 of the first two columns, for the row
+// pairs (0,1) (0,2) (0,3) (1,2) (1,3) (2,3), and b06..b11 of the last two
+void MinorsScalar(const double m[4][4], double b[12]) {
+  b[0] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+  b[1] = m[0][0] * m[1][2] - m[0][2] * m[1][0];
+  b[2] = m[0][0] * m[1][3] - m[0][3] * m[1][0];
+  b[3] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+  b[4] = m[0][1] * m[1][3] - m[0][3] * m[1][1];
+  b[5] = m[0][2] * m[1][3] - m[0][3] * m[1][2];
+  b[6] = m[2][0] * m[3][1] - m[2][1] * m[3][0];
+  b[7] = m[2][0] * m[3][2] - m[2][2] * m[3][0];
+  b[8] = m[2][0] * m[3][3] - m[2][3] * m[3][0];
+  b[9] = m[2][1] * m[3][2] - m[2][2] * m[3][1];
+  b[10] = m[2][1] * m[3][3] - m[2][3] * m[3][1];
+  b[11] = m[2][2] * m[3][3] - m[2][3] * m[3][2];
+}
+
+double DeterminantFromMinors(const double b[12]) {
+  return b[0] * b[11] - b[1] * b[10] + b[2] * b[9] + b[3] * b[8] -
+         b[4] * b[7] + b[5] * b[6];
+}
+
+// The terms of the adjugate. Entry [col][row] is
+//   m[x][y1] * b[z1] - m[x][y2] * b[z2] +/- m[x][y3] * b[z3]
+// where x is the column m is read from (1, 0, 3, 2 for rows 0..3) and the
+// minors are b06..b11 for rows 0 and 1, b00..b05 for rows 2 and 3, offset
+// by z. Rows 0 and 2 share y and z, as do rows 1 and 3.
+struct AdjugateColumn {
+  int y1[2], y2[2], y3;
+  int z1[2], z2[2], z3;
+  // Whether the third term is added in rows 0 and 2 (and subtracted in 1
+  // and 3), or the other way around
+  bool add_even;
+};
+
+constexpr AdjugateColumn kAdjugate[4] = {
+    {{1, 2}, {2, 1}, 3, {5, 4}, {4, 5}, 3, true},
+    {{2, 0}, {0, 2}, 3, {2, 5}, {5, 2}, 1, false},
+    {{0, 1}, {1, 0}, 3, {4, 2}, {2, 4}, 0, true},
+    {{1, 0}, {0, 1}, 2, {1, 3}, {3, 1}, 0, false}};
+
+constexpr int kAdjugateSource[4] = {1, 0, 3, 2};
+
+#if defined(__AVX2__)
+
+// Minors of rows (0,1) (0,2) (0,3) (1,2) of columns x and y
+__m256d Minors4(__m256d x, __m256d y) {
+  const __m256d x_i = _mm256_permute4x64_pd(x, 0x40);  // 0 0 0 1
+  const __m256d y_j = _mm256_permute4x64_pd(y, 0xB9);  // 1 2 3 2
+  const __m256d x_j = _mm256_permute4x64_pd(x, 0xB9);
+  const __m256d y_i = _mm256_permute4x64_pd(y, 0x40);
+  return _mm256_sub_pd(_mm256_mul_pd(x_i, y_j), _mm256_mul_pd(x_j, y_i));
+}
+
+void Minors(const double m[4][4], double b[12]) {
+  const __m256d c0 = _mm256_loadu_pd(m[0]);
+  const __m256d c1 = _mm256_loadu_pd(m[1]);
+  const __m256d c2 = _mm256_loadu_pd(m[2]);
+  const __m256d c3 = _mm256_loadu_pd(m[3]);
+  // Rows (1,3) (2,3) of columns 0, 1 and of columns 2, 3
+  const __m256d x_i = _mm256_blend_pd(_mm256_permute4x64_pd(c0, 0x99),
+                                      _mm256_permute4x64_pd(c2, 0x99), 0xC);
+  const __m256d y_j = _mm256_blend_pd(_mm256_permute4x64_pd(c1, 0xFF),
+                                      _mm256_permute4x64_pd(c3, 0xFF), 0xC);
+  const __m256d x_j = _mm256_blend_pd(_mm256_permute4x64_pd(c0, 0xFF),
+                                      _mm256_permute4x64_pd(c2, 0xFF), 0xC);
+  const __m256d y_i = _mm256_blend_pd(_mm256_permute4x64_pd(c1, 0x99),
+                                      _mm256_permute4x64_pd(c3, 0x99), 0xC);
+  const __m256d last =
+      _mm256_sub_pd(_mm256_mul_pd(x_i, y_j), _mm256_mul_pd(x_j, y_i));
+
+  _mm256_storeu_pd(b, Minors4(c0, c1));
+  _mm_storeu_pd(b + 4, _mm256_castpd256_pd128(last));
+  _mm256_storeu_pd(b + 6, Minors4(c2, c3));
+  _mm_storeu_pd(b + 10, _mm256_extractf128_pd(last, 1));
+}
+
+#elif defined(__SSE2__)
+
+// Minors of columns x and y, each as its rows (0,1) and (2,3)
+void Minors6(__m128d x_lo, __m128d x_hi, __m128d y_lo, __m128d y_hi,
+             double b[6]) {
+  // (0,1) (0,2)
+  __m128d x_i = _mm_unpacklo_pd(x_lo, x_lo);
+  __m128d y_j = _mm_shuffle_pd(y_lo, y_hi, 1);
+  __m128d x_j = _mm_shuffle_pd(x_lo, x_hi, 1);
+  __m128d y_i = _mm_unpacklo_pd(y_lo, y_lo);
+  _mm_storeu_pd(b, _mm_sub_pd(_mm_mul_pd(x_i, y_j), _mm_mul_pd(x_j, y_i)));
+  // (0,3) (1,2)
+  x_i = x_lo;
+  y_j = _mm_shuffle_pd(y_hi, y_hi, 1);
+  x_j = _mm_shuffle_pd(x_hi, x_hi, 1);
+  y_i = y_lo;
+  _mm_storeu_pd(b + 2,
+                _mm_sub_pd(_mm_mul_pd(x_i, y_j), _mm_mul_pd(x_j, y_i)));
+  // (1,3) (2,3)
+  x_i = _mm_shuffle_pd(x_lo, x_hi, 1);
+  y_j = _mm_unpackhi_pd(y_hi, y_hi);
+  x_j = _mm_unpackhi_pd(x_hi, x_hi);
+  y_i = _mm_shuffle_pd(y_lo, y_hi, 1);
+  _mm_storeu_pd(b + 4,
+                _mm_sub_pd(_mm_mul_pd(x_i, y_j), _mm_mul_pd(x_j, y_i)));
+}
+
+void Minors(const double m[4][4], double b[12]) {
+  Minors6(_mm_loadu_pd(m[0]), _mm_loadu_pd(m[0] + 2), _mm_loadu_pd(m[1]),
+          _mm_loadu_pd(m[1] + 2), b);
+  Minors6(_mm_loadu_pd(m[2]), _mm_loadu_pd(m[2] + 2), _mm_loadu_pd(m[3]),
+          _mm_loadu_pd(m[3] + 2), b + 6);
+}
+
+#else
+
+void Minors(const double m[4][4], double b[12]) { MinorsScalar(m, b); }
+
+#endif
+
+}  // namespace
+
+const char* MatrixKernelName() {
+#if defined(__AVX2__)
+  return "AVX2";
+#elif defined(__SSE2__)
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
+
+void ConcatMatricesScalar(const double a[4][4], const double b[4][4],
+                          double out[4][4]) {
+  for (int col = 0; col < 4; ++col) {
+    for (int row = 0; row < 4; ++row) {
+      out[col][row] = a[0][row] * b[col][0] + a[1][row] * b[col][1] +
+                      a[2][row] * b[col][2] + a[3][row] * b[col][3];
+    }
+  }
+}
+
+void ConcatMatrices(const double a[4][4], const double b[4][4],
+                    double out[4][4]) {
+#if defined(__AVX2__)
+  // Each column of |out| is the columns of |a| weighted by a column of |b|,
+  // summed in the scalar order
+  const __m256d a0 = _mm256_loadu_pd(a[0]);
+  const __m256d a1 = _mm256_loadu_pd(a[1]);
+  const __m256d a2 = _mm256_loadu_pd(a[2]);
+  const __m256d a3 = _mm256_loadu_pd(a[3]);
+  for (int col = 0; col < 4; ++col) {
+    const double* weights = b[col];
+    __m256d sum = _mm256_mul_pd(a0, _mm256_broadcast_sd(&weights[0]));
+    sum = _mm256_add_pd(sum,
+                        _mm256_mul_pd(a1, _mm256_broadcast_sd(&weights[1])));
+    sum = _mm256_add_pd(sum,
+                        _mm256_mul_pd(a2, _mm256_broadcast_sd(&weights[2])));
+    sum = _mm256_add_pd(sum,
+                        _mm256_mul_pd(a3, _mm256_broadcast_sd(&weights[3])));
+    _mm256_storeu_pd(out[col], sum);
+  }
+#elif defined(__SSE2__)
+  // As the AVX2 kernel, rows (0,1) and (2,3) apart
+  for (int half = 0; half < 4; half += 2) {
+    const __m128d a0 = _mm_loadu_pd(a[0] + half);
+    const __m128d a1 = _mm_loadu_pd(a[1] + half);
+    const __m128d a2 = _mm_loadu_pd(a[2] + half);
+    const __m128d a3 = _mm_loadu_pd(a[3] + half);
+    for (int col = 0; col < 4; ++col) {
+      __m128d sum = _mm_mul_pd(a0, _mm_set1_pd(b[col][0]));
+      sum = _mm_add_pd(sum, _mm_mul_pd(a1, _mm_set1_pd(b[col][1])));
+      sum = _mm_add_pd(sum, _mm_mul_pd(a2, _mm_set1_pd(b[col][2])));
+      sum = _mm_add_pd(sum, _mm_mul_pd(a3, _mm_set1_pd(b[col][3])));
+      _mm_storeu_pd(out[col] + half, sum);
+    }
+  }
+#else
+  ConcatMatricesScalar(a, b, out);
+#endif
+}
+
+double MatrixDeterminantScalar(const double m[4][4]) {
+  double b[12];
+  MinorsScalar(m, b);
+  return DeterminantFromMinors(b);
+}
+
+double MatrixDeterminant(const double m[4][4]) {
+  double b[12];
+  Minors(m, b);
+  return DeterminantFromMinors(b);
+}
+
+bool InvertMatrixScalar(const double m[4][4], double out[4][4]) {
+  double b[12];
+  MinorsScalar(m, b);
+  const double inv_det = 1.0 / DeterminantFromMinors(b);
+  // Also rejects a zero determinant (inv_det is infinite)
+  if (!std::isfinite(inv_det)) {
+    return false;
+  }
+
+  for (int col = 0; col < 4; ++col) {
+    const AdjugateColumn& terms = kAdjugate[col];
+    for (int row = 0; row < 4; ++row) {
+      const double* x = m[kAdjugateSource[row]];
+      const double* minors = row < 2 ? b + 6 : b;
+      const int k = row % 2;
+      const double term = x[terms.y1[k]] * minors[terms.z1[k]] -
+                          x[terms.y2[k]] * minors[terms.z2[k]];
+      const double third = x[terms.y3] * minors[terms.z3];
+      out[col][row] =
+          ((k == 0) == terms.add_even ? term + third : term - third) *
+          inv_det;
+    }
+  }
+  return true;
+}
+
+bool InvertMatrix(const double m[4][4], double out[4][4]) {
+#if defined(__AVX2__)
+  double b[12];
+  Minors(m, b);
+  const double inv_det = 1.0 / DeterminantFromMinors(b);
+  if (!std::isfinite(inv_det)) {
+    return false;
+  }
+
+  // rows[y] = m[1][y], m[0][y], m[3][y], m[2][y]: the source of each row
+  const __m256d c0 = _mm256_loadu_pd(m[0]);
+  const __m256d c1 = _mm256_loadu_pd(m[1]);
+  const __m256d c2 = _mm256_loadu_pd(m[2]);
+  const __m256d c3 = _mm256_loadu_pd(m[3]);
+  const __m256d t0 = _mm256_unpacklo_pd(c1, c0);
+  const __m256d t1 = _mm256_unpackhi_pd(c1, c0);
+  const __m256d t2 = _mm256_unpacklo_pd(c3, c2);
+  const __m256d t3 = _mm256_unpackhi_pd(c3, c2);
+  const __m256d rows[4] = {_mm256_permute2f128_pd(t0, t2, 0x20),
+                           _mm256_permute2f128_pd(t1, t3, 0x20),
+                           _mm256_permute2f128_pd(t0, t2, 0x31),
+                           _mm256_permute2f128_pd(t1, t3, 0x31)};
+  const double* hi = b + 6;
+  const __m256d scale = _mm256_set1_pd(inv_det);
+  const __m256d even = _mm256_setr_pd(1, -1, 1, -1);
+
+  for (int col = 0; col < 4; ++col) {
+    const AdjugateColumn& terms = kAdjugate[col];
+    // Rows 0 and 2 from one source row, 1 and 3 from the other
+    const __m256d x1 =
+        _mm256_blend_pd(rows[terms.y1[0]], rows[terms.y1[1]], 0xA);
+    const __m256d x2 =
+        _mm256_blend_pd(rows[terms.y2[0]], rows[terms.y2[1]], 0xA);
+    const __m256d x3 = rows[terms.y3];
+    const __m256d z1 = _mm256_setr_pd(hi[terms.z1[0]], hi[terms.z1[1]],
+                                      b[terms.z1[0]], b[terms.z1[1]]);
+    const __m256d z2 = _mm256_setr_pd(hi[terms.z2[0]], hi[terms.z2[1]],
+                                      b[terms.z2[0]], b[terms.z2[1]]);
+    // Negating is exact, so adding the negated product rounds as the
+    // scalar subtraction
+    const __m256d sign =
+        terms.add_even ? even : _mm256_sub_pd(_mm256_setzero_pd(), even);
+    const __m256d third = _mm256_mul_pd(
+        _mm256_mul_pd(sign, x3),
+        _mm256_setr_pd(hi[terms.z3], hi[terms.z3], b[terms.z3], b[terms.z3]));
+    const __m256d term =
+        _mm256_sub_pd(_mm256_mul_pd(x1, z1), _mm256_mul_pd(x2, z2));
+    _mm256_storeu_pd(out[col],
+                     _mm256_mul_pd(_mm256_add_pd(term, third), scale));
+  }
+  return true;
+#elif defined(__SSE2__)
+  double b[12];
+  Minors(m, b);
+  const double inv_det = 1.0 / DeterminantFromMinors(b);
+  if (!std::isfinite(inv_det)) {
+    return false;
+  }
+
+  // As the AVX2 kernel, rows (0,1) from columns 1, 0 and minors b06..b11,
+  // rows (2,3) from columns 3, 2 and minors b00..b05
+  const __m128d scale = _mm_set1_pd(inv_det);
+  for (int half = 0; half < 2; ++half) {
+    const __m128d x_lo = _mm_loadu_pd(m[kAdjugateSource[2 * half]]);
+    const __m128d x_hi = _mm_loadu_pd(m[kAdjugateSource[2 * half]] + 2);
+    const __m128d y_lo = _mm_loadu_pd(m[kAdjugateSource[2 * half + 1]]);
+    const __m128d y_hi = _mm_loadu_pd(m[kAdjugateSource[2 * half + 1]] + 2);
+    const __m128d rows[4] = {
+        _mm_unpacklo_pd(x_lo, y_lo), _mm_unpackhi_pd(x_lo, y_lo),
+        _mm_unpacklo_pd(x_hi, y_hi), _mm_unpackhi_pd(x_hi, y_hi)};
+    const double* minors = half == 0 ? b + 6 : b;
+
+    for (int col = 0; col < 4; ++col) {
+      const AdjugateColumn& terms = kAdjugate[col];
+      const __m128d x1 = _mm_move_sd(rows[terms.y1[1]], rows[terms.y1[0]]);
+      const __m128d x2 = _mm_move_sd(rows[terms.y2[1]], rows[terms.y2[0]]);
+      const __m128d x3 = rows[terms.y3];
+      const __m128d z1 =
+          _mm_setr_pd(minors[terms.z1[0]], minors[terms.z1[1]]);
+      const __m128d z2 =
+          _mm_setr_pd(minors[terms.z2[0]], minors[terms.z2[1]]);
+      const __m128d sign =
+          terms.add_even ? _mm_setr_pd(1, -1) : _mm_setr_pd(-1, 1);
+      const __m128d third = _mm_mul_pd(_mm_mul_pd(sign, x3),
+                                       _mm_set1_pd(minors[terms.z3]));
+      const __m128d term = _mm_sub_pd(_mm_mul_pd(x1, z1), _mm_mul_pd(x2, z2));
+      _mm_storeu_pd(out[col] + 2 * half,
+                    _mm_mul_pd(_mm_add_pd(term, third), scale));
+    }
+  }
+  return true;
+#else
+  return InvertMatrixScalar(m, out);
+#endif
+}
+
+double MatrixCofactor33(const double m[4][4]) {
+  // m[col][row]: the minor of rows and columns 0, 1 and 3
+  double cofactor_part_1 = m[0][0] * m[1][1] * m[3][3];
+  double cofactor_part_2 = m[1][0] * m[3][1] * m[0][3];
+  double cofactor_part_3 = m[3][0] * m[0][1] * m[1][3];
+  double cofactor_part_4 = m[0][0] * m[3][1] * m[1][3];
+  double cofactor_part_5 = m[1][0] * m[0][1] * m[3][3];
+  double cofactor_part_6 = m[3][0] * m[1][1] * m[0][3];
+  return cofactor_part_1 + cofactor_part_2 + cofactor_part_3 -
+         cofactor_part_4 - cofactor_part_5 - cofactor_part_6;
+}
+
+}  // namespace paint_preprocessor
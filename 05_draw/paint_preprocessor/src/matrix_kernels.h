@@ -0,0 +1,46 @@
+// Paint Preprocessor Matrix Kernels
+// The 4x4 double matrix math behind Transform's full matrices, as AVX2 or
+// SSE2 kernels with the scalar versions they match bit for bit
+
+#ifndef PAINT_PREPROCESSOR_MATRIX_KERNELS_H_
+#define PAINT_PREPROCESSOR_MATRIX_KERNELS_H_
+
+namespace paint_preprocessor {
+
+// Matrices are column-major, m[col][row], like Transform's matrix_.
+//
+// The kernels are chosen at compile time: AVX2 when built with -mavx2
+// (make SIMD_FLAGS=-mavx2), else SSE2 (any x86-64 build), else the scalar
+// versions. Each kernel rounds every product and sum the way its scalar
+// version does, so results are identical as long as the compiler does not
+// contract a * b + c into fused multiply-adds (-ffp-contract=off).
+
+// "AVX2", "SSE2" or "scalar"
+const char* MatrixKernelName();
+
+// out = a * b; |out| may alias neither input
+void ConcatMatrices(const double a[4][4], const double b[4][4],
+                    double out[4][4]);
+void ConcatMatricesScalar(const double a[4][4], const double b[4][4],
+                          double out[4][4]);
+
+// Laplace expansion by the 2x2 minors of the first two columns and their
+// complementary minors in the last two
+double MatrixDeterminant(const double m[4][4]);
+double MatrixDeterminantScalar(const double m[4][4]);
+
+// The adjugate over the determinant, from the same 2x2 minors. Returns
+// false, leaving |out| unchanged, when 1 / determinant is not finite.
+// |out| may not alias |m|.
+bool InvertMatrix(const double m[4][4], double out[4][4]);
+bool InvertMatrixScalar(const double m[4][4], double out[4][4]);
+
+// The cofactor of the 3rd row, 3rd column, whose sign against the
+// determinant's tells whether the back face is visible. Scalar only: its
+// six triple products gather 18 scattered elements, and SSE2 / AVX2
+// versions ran at half the scalar speed.
+double MatrixCofactor33(const double m[4][4]);
+
+}  // namespace paint_preprocessor
+
+#endif  // PAINT_PREPROCESSOR_MATRIX_KERNELS_H_
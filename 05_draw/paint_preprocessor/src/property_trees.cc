@@ -0,0 +1,386 @@
+#include "property_trees.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <unordered_map>
+#include <utility>
+
+namespace paint_preprocessor {
+
+namespace {
+
+// CanvasKit's path verbs (CanvasKit.MOVE_VERB, ...)
+constexpr double kMoveVerb = 0;
+constexpr double kLineVerb = 1;
+constexpr double kQuadVerb = 2;
+constexpr double kCubicVerb = 4;
+constexpr double kCloseVerb = 5;
+
+// A tree's nodes in pre-order, with each node's parent in the walk (-1 for
+// a root)
+struct PreOrder {
+  std::vector<uint32_t> nodes;
+  std::vector<int64_t> parent;
+};
+
+template <typename Node>
+PreOrder WalkPreOrder(const std::vector<Node>& nodes) {
+  const uint32_t count = static_cast<uint32_t>(nodes.size());
+  // The last node with an id wins, as in draw.html's Map of nodes
+  std::unordered_map<int64_t, uint32_t> index_of;
+  index_of.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    index_of[nodes[i].id] = i;
+  }
+
+  // Children of each node, in list order, as one flat array
+  std::vector<int64_t> parent(count, -1);
+  std::vector<uint32_t> first_child(count + 1, 0);
+  for (uint32_t i = 0; i < count; ++i) {
+    auto it = index_of.find(nodes[i].parent_id);
+    if (it != index_of.end() && it->second != i) {
+      parent[i] = it->second;
+      ++first_child[it->second + 1];
+    }
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    first_child[i + 1] += first_child[i];
+  }
+  std::vector<uint32_t> children(first_child[count]);
+  std::vector<uint32_t> next_child(first_child.begin(), first_child.end() - 1);
+  for (uint32_t i = 0; i < count; ++i) {
+    if (parent[i] >= 0) {
+      children[next_child[parent[i]]++] = i;
+    }
+  }
+
+  PreOrder walk;
+  walk.nodes.reserve(count);
+  walk.parent.assign(count, -1);
+  std::vector<bool> visited(count, false);
+  std::vector<uint32_t> stack;
+  auto walk_from = [&](uint32_t root) {
+    visited[root] = true;
+    stack.push_back(root);
+    while (!stack.empty()) {
+      const uint32_t node = stack.back();
+      stack.pop_back();
+      walk.nodes.push_back(node);
+      // Reversed, so children are popped in list order
+      for (uint32_t k = first_child[node + 1]; k > first_child[node]; --k) {
+        const uint32_t child = children[k - 1];
+        if (!visited[child]) {
+          visited[child] = true;
+          walk.parent[child] = node;
+          stack.push_back(child);
+        }
+      }
+    }
+  };
+  for (uint32_t i = 0; i < count; ++i) {
+    if (parent[i] < 0) {
+      walk_from(i);
+    }
+  }
+  // What is left hangs off a cycle; its first node becomes a root
+  for (uint32_t i = 0; i < count; ++i) {
+    if (!visited[i]) {
+      walk_from(i);
+    }
+  }
+  return walk;
+}
+
+// Reads the SVG path grammar's numbers and command letters
+class SvgPathReader {
+ public:
+  explicit SvgPathReader(const std::string& path) : path_(path) {}
+
+  void SkipSeparators() {
+    while (pos_ < path_.size() &&
+           (std::isspace(static_cast<unsigned char>(path_[pos_])) ||
+            path_[pos_] == ',')) {
+      ++pos_;
+    }
+  }
+
+  bool AtEnd() {
+    SkipSeparators();
+    return pos_ >= path_.size();
+  }
+
+  // Whether a number (rather than a command) comes next
+  bool AtNumber() {
+    SkipSeparators();
+    if (pos_ >= path_.size()) {
+      return false;
+    }
+    const char c = path_[pos_];
+    return std::isdigit(static_cast<unsigned char>(c)) || c == '-' ||
+           c == '+' || c == '.';
+  }
+
+  char ReadCommand() { return AtEnd() ? '\0' : path_[pos_++]; }
+
+  bool ReadNumber(double& value) {
+    if (!AtNumber()) {
+      return false;
+    }
+    const char* start = path_.c_str() + pos_;
+    char* end = nullptr;
+    value = std::strtod(start, &end);
+    if (end == start) {
+      return false;
+    }
+    pos_ += end - start;
+    return true;
+  }
+
+ private:
+  const std::string& path_;
+  size_t pos_ = 0;
+};
+
+}  // namespace
+
+TransformCache::TransformCache(const std::vector<TransformNode>& nodes)
+    : nodes_(nodes), entries_(nodes.size()), inverses_(nodes.size()) {
+  PreOrder walk = WalkPreOrder(nodes);
+  pre_order_ = std::move(walk.nodes);
+  parent_ = std::move(walk.parent);
+}
+
+void TransformCache::Validate(uint32_t index) {
+  if (entries_[index].validated_epoch == epoch_) {
+    return;
+  }
+
+  // Climb to the nearest node validated since the last change; above it
+  // everything is current
+  stale_chain_.clear();
+  for (int64_t i = index; i >= 0 && entries_[i].validated_epoch != epoch_;
+       i = parent_[i]) {
+    stale_chain_.push_back(static_cast<uint32_t>(i));
+  }
+
+  // Then down again, recomputing a node only if its local or its parent's
+  // screen transform changed since it was computed
+  for (size_t k = stale_chain_.size(); k-- > 0;) {
+    const uint32_t i = stale_chain_[k];
+    Entry& entry = entries_[i];
+    const int64_t parent = parent_[i];
+    const uint64_t parent_generation =
+        parent >= 0 ? entries_[parent].generation : 0;
+    if (entry.screen_local_generation != entry.local_generation ||
+        entry.screen_parent_generation != parent_generation) {
+      entry.screen = parent >= 0 ? entries_[parent].screen * nodes_[i].local
+                                 : nodes_[i].local;
+      entry.screen_local_generation = entry.local_generation;
+      entry.screen_parent_generation = parent_generation;
+      ++entry.generation;
+      ++computed_;
+    } else {
+      ++reused_;
+    }
+    entry.validated_epoch = epoch_;
+  }
+}
+
+const Transform& TransformCache::ScreenTransform(uint32_t index) {
+  Validate(index);
+  return entries_[index].screen;
+}
+
+bool TransformCache::ScreenInverse(uint32_t index,
+                                   const Transform** inverse) {
+  Validate(index);
+  const Entry& entry = entries_[index];
+  InverseEntry& inverse_entry = inverses_[index];
+  if (inverse_entry.generation != entry.generation) {
+    inverse_entry.invertible = entry.screen.GetInverse(&inverse_entry.inverse);
+    inverse_entry.generation = entry.generation;
+  }
+  *inverse = &inverse_entry.inverse;
+  return inverse_entry.invertible;
+}
+
+void TransformCache::SetNeedsUpdate(uint32_t index) {
+  ++entries_[index].local_generation;
+  ++epoch_;
+}
+
+std::vector<ResolvedTransform> ResolveTransformTree(
+    const std::vector<TransformNode>& nodes, PreprocessStats* stats) {
+  TransformCache cache(nodes);
+  std::vector<ResolvedTransform> resolved;
+  ResolveTransformTree(nodes, cache, resolved, stats);
+  return resolved;
+}
+
+void ResolveTransformTree(const std::vector<TransformNode>& nodes,
+                          TransformCache& cache,
+                          std::vector<ResolvedTransform>& resolved,
+                          PreprocessStats* stats) {
+  const std::vector<uint32_t>& pre_order = cache.pre_order();
+  resolved.resize(nodes.size());
+  std::vector<bool> backface_hidden(nodes.size(), false);
+
+  for (uint32_t order = 0; order < pre_order.size(); ++order) {
+    const uint32_t index = pre_order[order];
+    ResolvedTransform& transform = resolved[index];
+    const int64_t parent = cache.parent(index);
+    backface_hidden[index] = nodes[index].backface_hidden ||
+                             (parent >= 0 && backface_hidden[parent]);
+
+    // Parents come first, so each lookup revalidates at most the node
+    // itself
+    transform.screen = cache.ScreenTransform(index);
+    const Transform* inverse = nullptr;
+    transform.invertible = cache.ScreenInverse(index, &inverse);
+    transform.inverse = *inverse;
+    transform.creates_3d = transform.screen.Creates3d();
+    transform.cull_backface =
+        backface_hidden[index] && transform.screen.IsBackFaceVisible();
+    transform.order = order;
+    transform.descendants = 0;
+    if (stats) {
+      stats->transforms_axis_2d += !transform.screen.IsFullMatrix();
+      stats->transforms_3d += transform.creates_3d;
+      stats->non_invertible += !transform.invertible;
+      stats->backface_culled += transform.cull_backface;
+    }
+  }
+
+  // Children come after their parent, so one reverse pass sums subtrees
+  for (size_t k = pre_order.size(); k-- > 0;) {
+    const uint32_t index = pre_order[k];
+    if (cache.parent(index) >= 0) {
+      resolved[cache.parent(index)].descendants +=
+          resolved[index].descendants + 1;
+    }
+  }
+}
+
+std::vector<ResolvedClip> ResolveClipTree(const std::vector<ClipNode>& nodes,
+                                          PreprocessStats* stats) {
+  const PreOrder walk = WalkPreOrder(nodes);
+  std::vector<ResolvedClip> resolved(nodes.size());
+
+  for (const uint32_t index : walk.nodes) {
+    const ClipNode& node = nodes[index];
+    ResolvedClip& clip = resolved[index];
+    const int64_t parent = walk.parent[index];
+    clip.bounds = parent >= 0 ? resolved[parent].bounds : RectF::Infinite();
+    if (node.has_clip_rect) {
+      clip.bounds.Intersect(node.clip_rect);
+    }
+
+    if (!node.clip_path.empty()) {
+      clip.path_unresolved = !FlattenSvgPath(node.clip_path, clip.path_cmds);
+      if (stats) {
+        ++stats->clip_paths;
+        stats->clip_paths_unresolved += clip.path_unresolved;
+      }
+    }
+  }
+  return resolved;
+}
+
+bool FlattenSvgPath(const std::string& path, std::vector<double>& cmds) {
+  SvgPathReader reader(path);
+  std::vector<double> result;
+  double x = 0, y = 0;              // Current point
+  double start_x = 0, start_y = 0;  // Start of the subpath
+  char command = '\0';
+
+  while (!reader.AtEnd()) {
+    // Numbers after a command's arguments repeat the command (a lineto
+    // after a moveto)
+    if (!reader.AtNumber()) {
+      command = reader.ReadCommand();
+    } else if (command == 'M') {
+      command = 'L';
+    } else if (command == 'm') {
+      command = 'l';
+    } else if (command == '\0' || command == 'Z' || command == 'z') {
+      return false;
+    }
+
+    const bool relative = std::islower(static_cast<unsigned char>(command));
+    const double origin_x = relative ? x : 0;
+    const double origin_y = relative ? y : 0;
+    double v[6];
+    auto read = [&](int count) {
+      for (int i = 0; i < count; ++i) {
+        if (!reader.ReadNumber(v[i])) {
+          return false;
+        }
+        v[i] += i % 2 == 0 ? origin_x : origin_y;
+      }
+      return true;
+    };
+
+    switch (std::toupper(static_cast<unsigned char>(command))) {
+      case 'M':
+        if (!read(2)) {
+          return false;
+        }
+        result.insert(result.end(), {kMoveVerb, v[0], v[1]});
+        x = start_x = v[0];
+        y = start_y = v[1];
+        break;
+      case 'L':
+        if (!read(2)) {
+          return false;
+        }
+        result.insert(result.end(), {kLineVerb, v[0], v[1]});
+        x = v[0];
+        y = v[1];
+        break;
+      case 'H':
+        if (!reader.ReadNumber(v[0])) {
+          return false;
+        }
+        x = v[0] + origin_x;
+        result.insert(result.end(), {kLineVerb, x, y});
+        break;
+      case 'V':
+        if (!reader.ReadNumber(v[0])) {
+          return false;
+        }
+        y = v[0] + origin_y;
+        result.insert(result.end(), {kLineVerb, x, y});
+        break;
+      case 'Q':
+        if (!read(4)) {
+          return false;
+        }
+        result.insert(result.end(), {kQuadVerb, v[0], v[1], v[2], v[3]});
+        x = v[2];
+        y = v[3];
+        break;
+      case 'C':
+        if (!read(6)) {
+          return false;
+        }
+        result.insert(result.end(),
+                      {kCubicVerb, v[0], v[1], v[2], v[3], v[4], v[5]});
+        x = v[4];
+        y = v[5];
+        break;
+      case 'Z':
+        result.push_back(kCloseVerb);
+        x = start_x;
+        y = start_y;
+        break;
+      default:
+        return false;
+    }
+  }
+
+  cmds.insert(cmds.end(), result.begin(), result.end());
+  return true;
+}
+
+}  // namespace paint_preprocessor
@@ -0,0 +1,167 @@
+// Paint Preprocessor Property Trees
+// Resolves the transform and clip trees of a paint artifact once, so the
+// renderer replays ops without walking either tree
+
+#ifndef PAINT_PREPROCESSOR_PROPERTY_TREES_H_
+#define PAINT_PREPROCESSOR_PROPERTY_TREES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "geometry.h"
+#include "transform.h"
+
+namespace paint_preprocessor {
+
+constexpr int64_t kInvalidNodeId = -1;
+
+// A transform tree node: its local transform (the "matrix" or "local"
+// matrix around "origin", or "translation2d"), relative to its parent
+struct TransformNode {
+  int64_t id = 0;
+  int64_t parent_id = kInvalidNodeId;
+  Transform local;
+  bool backface_hidden = false;
+};
+
+// A clip tree node: its root-space "clip_rect" and SVG "clip_path"
+struct ClipNode {
+  int64_t id = 0;
+  int64_t parent_id = kInvalidNodeId;
+  bool has_clip_rect = false;
+  RectF clip_rect;
+  std::string clip_path;
+};
+
+// A transform node resolved against its ancestors
+struct ResolvedTransform {
+  // Root -> node product of the local transforms, as draw.html's
+  // getTransformMatrix builds it
+  Transform screen;
+  // Identity when not invertible
+  Transform inverse;
+  bool invertible = true;
+  bool creates_3d = false;
+  // backface-visibility: hidden on the node or an ancestor, and the back
+  // face of |screen| faces the viewer: the node's ops are not drawn
+  bool cull_backface = false;
+  // Pre-order index and descendant count in the transform tree: a is an
+  // ancestor of b iff order(a) < order(b) <= order(a) + descendants(a)
+  uint32_t order = 0;
+  uint32_t descendants = 0;
+};
+
+// A clip node resolved against its ancestors
+struct ResolvedClip {
+  // Intersection of the clip_rects of the node and its ancestors
+  RectF bounds;
+  // clip_path as CanvasKit path commands (Path.MakeFromCmds): verbs
+  // followed by their points, absolute
+  std::vector<double> path_cmds;
+  // clip_path was set but uses commands the flattener does not handle; the
+  // renderer parses the SVG string
+  bool path_unresolved = false;
+};
+
+struct PreprocessStats {
+  // Screen transforms kept as AxisTransform2d, a 2d scale and/or
+  // translation
+  size_t transforms_axis_2d = 0;
+  size_t transforms_3d = 0;
+  size_t non_invertible = 0;
+  size_t backface_culled = 0;
+  size_t clip_paths = 0;
+  size_t clip_paths_unresolved = 0;
+};
+
+// Memoized screen transforms of a transform tree, as Chromium's
+// TransformTree keeps to_screen per node. Every node records the
+// generation of its local transform and of its parent's screen transform
+// it was computed from; a node is multiplied out again only if either
+// changed. Inverses are memoized against the node's own generation.
+//
+// The cache reads the locals from |nodes|, which must outlive it and keep
+// its tree structure: after changing nodes[i].local, call SetNeedsUpdate(i).
+class TransformCache {
+ public:
+  explicit TransformCache(const std::vector<TransformNode>& nodes);
+
+  // The nodes in pre-order, and each node's parent index (-1 for a root),
+  // as ResolveTransformTree walks them
+  const std::vector<uint32_t>& pre_order() const { return pre_order_; }
+  int64_t parent(uint32_t index) const { return parent_[index]; }
+
+  // Root -> node product of the locals. Revalidates the stale ancestors
+  // first, from the nearest one already validated since the last change.
+  const Transform& ScreenTransform(uint32_t index);
+  // The inverse of ScreenTransform(index), or identity; returns whether
+  // it is invertible
+  bool ScreenInverse(uint32_t index, const Transform** inverse);
+
+  void SetNeedsUpdate(uint32_t index);
+
+  // Products computed and cached products revalidated, since construction
+  size_t computed() const { return computed_; }
+  size_t reused() const { return reused_; }
+
+ private:
+  struct Entry {
+    Transform screen;
+    uint64_t local_generation = 1;
+    // What |screen| was computed from
+    uint64_t screen_local_generation = 0;
+    uint64_t screen_parent_generation = 0;
+    // Bumped when |screen| is recomputed
+    uint64_t generation = 0;
+    // |epoch_| when the node was last revalidated
+    uint64_t validated_epoch = 0;
+  };
+  // Apart from the entries, which revalidation walks
+  struct InverseEntry {
+    Transform inverse;
+    bool invertible = true;
+    // The screen generation |inverse| was computed from
+    uint64_t generation = 0;
+  };
+
+  void Validate(uint32_t index);
+
+  const std::vector<TransformNode>& nodes_;
+  std::vector<uint32_t> pre_order_;
+  std::vector<int64_t> parent_;
+  std::vector<Entry> entries_;
+  std::vector<InverseEntry> inverses_;
+  // Bumped by every SetNeedsUpdate, so revalidation stops at ancestors
+  // validated since
+  uint64_t epoch_ = 1;
+  std::vector<uint32_t> stale_chain_;
+  size_t computed_ = 0;
+  size_t reused_ = 0;
+};
+
+// Resolves every node in one pre-order walk per tree, parents before
+// children. Nodes are indexed like |nodes|. A node whose parent is missing
+// is a root, and a cycle is broken at the first node listed in it.
+std::vector<ResolvedTransform> ResolveTransformTree(
+    const std::vector<TransformNode>& nodes, PreprocessStats* stats = nullptr);
+// The same, taking the screen transforms and inverses from |cache|, built
+// on |nodes|: after SetNeedsUpdate, only the changed subtrees are
+// multiplied out again. |resolved| is overwritten in place, so resolving
+// again does not allocate.
+void ResolveTransformTree(const std::vector<TransformNode>& nodes,
+                          TransformCache& cache,
+                          std::vector<ResolvedTransform>& resolved,
+                          PreprocessStats* stats = nullptr);
+std::vector<ResolvedClip> ResolveClipTree(const std::vector<ClipNode>& nodes,
+                                          PreprocessStats* stats = nullptr);
+
+// Appends the CanvasKit path commands of an SVG path string (M, L, H, V, C,
+// Q, Z and their relative forms) to |cmds|. Returns false, leaving |cmds|
+// unchanged, for anything else (arcs, smooth curves, malformed data).
+bool FlattenSvgPath(const std::string& path, std::vector<double>& cmds);
+
+}  // namespace paint_preprocessor
+
+#endif  // PAINT_PREPROCESSOR_PROPERTY_TREES_H_
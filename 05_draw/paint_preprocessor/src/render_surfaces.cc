@@ -0,0 +1,175 @@
+#include "render_surfaces.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+
+#include "map_batch.h"
+
+namespace paint_preprocessor {
+namespace {
+
+// Ops that draw nothing themselves; an effect's Save/Restore pairs and
+// clips leave the opacity to its draws
+bool IsStateOp(const std::string& type) {
+  return type == "SaveOp" || type == "RestoreOp" || type == "ClipRectOp" ||
+         type == "ClipRRectOp" || type == "ClipPathOp" || type == "NoopOp";
+}
+
+// Screen bounds are outset by a pixel of antialiasing, so draws that only
+// touch each other still count as overlapping
+constexpr double kAntiAliasOutset = 1.0;
+
+bool Overlaps(const RectF& a, const RectF& b) {
+  return a.left < b.right && b.left < a.right && a.top < b.bottom &&
+         b.top < a.bottom;
+}
+
+// Whether any two of |rects| overlap. Sorted by left edge, a rect is only
+// compared with the ones that start before its right edge.
+bool AnyOverlap(std::vector<RectF>& rects) {
+  std::sort(rects.begin(), rects.end(), [](const RectF& a, const RectF& b) {
+    return a.left < b.left;
+  });
+  for (size_t i = 0; i < rects.size(); ++i) {
+    for (size_t j = i + 1; j < rects.size() && rects[j].left < rects[i].right;
+         ++j) {
+      if (Overlaps(rects[i], rects[j])) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+const char* RenderSurfaceReasonToString(RenderSurfaceReason reason) {
+  switch (reason) {
+    case RenderSurfaceReason::kNone: return "none";
+    case RenderSurfaceReason::kBlendMode: return "blend mode";
+    case RenderSurfaceReason::kBlendModeDstIn: return "blend mode kDstIn";
+    case RenderSurfaceReason::kOpacity: return "opacity";
+    case RenderSurfaceReason::kFilter: return "filter";
+  }
+  return "";
+}
+
+RenderSurfaces DecideRenderSurfaces(
+    const std::vector<EffectNode>& effects, const std::vector<PaintOp>& ops,
+    const std::vector<TransformNode>& transform_nodes,
+    const std::vector<ResolvedTransform>& transforms) {
+  RenderSurfaces surfaces;
+  surfaces.effects.resize(effects.size());
+
+  // The last node with an id wins, as draw.html's Maps
+  std::unordered_map<int64_t, uint32_t> effect_index;
+  for (uint32_t i = 0; i < effects.size(); ++i) {
+    effect_index[effects[i].id] = i;
+  }
+  std::unordered_map<int64_t, uint32_t> transform_index;
+  for (uint32_t i = 0; i < transform_nodes.size(); ++i) {
+    transform_index[transform_nodes[i].id] = i;
+  }
+
+  // Blend modes and blurs need a surface whatever the ops; opacity alone
+  // may be folded
+  std::vector<bool> foldable(effects.size(), false);
+  for (size_t i = 0; i < effects.size(); ++i) {
+    const EffectNode& effect = effects[i];
+    RenderSurfaceReason& reason = surfaces.effects[i].reason;
+    if (effect.blend_mode != "SrcOver") {
+      reason = effect.blend_mode == "DstIn"
+                   ? RenderSurfaceReason::kBlendModeDstIn
+                   : RenderSurfaceReason::kBlendMode;
+    } else if (effect.blur > 0.0) {
+      reason = RenderSurfaceReason::kFilter;
+    } else if (effect.opacity < 1.0) {
+      // A node folded by an earlier run stays folded: its ops already
+      // have the opacity
+      surfaces.effects[i].fold_opacity = effect.opacity_folded;
+      foldable[i] = !effect.opacity_folded;
+    }
+  }
+
+  // The draws of the foldable nodes: one that cannot take the alpha, or
+  // whose transform is unknown, rules its node out. The others are grouped
+  // by transform node, to be mapped to the screen a batch per transform.
+  constexpr uint32_t kNoEffect = UINT32_MAX;
+  std::vector<uint32_t> op_effect(ops.size(), kNoEffect);
+  std::vector<std::vector<uint32_t>> draws(transform_nodes.size());
+  for (uint32_t i = 0; i < ops.size(); ++i) {
+    const PaintOp& op = ops[i];
+    auto effect = effect_index.find(op.effect_id);
+    if (effect == effect_index.end() || !foldable[effect->second] ||
+        IsStateOp(op.type)) {
+      continue;
+    }
+    op_effect[i] = effect->second;
+    auto transform = transform_index.find(op.transform_id);
+    if (transform == transform_index.end() || !op.has_bounds ||
+        !op.solid_color) {
+      foldable[effect->second] = false;
+      continue;
+    }
+    // Culled ops are not drawn
+    if (!transforms[transform->second].cull_backface) {
+      draws[transform->second].push_back(i);
+    }
+  }
+
+  std::vector<std::vector<RectF>> screen_bounds(effects.size());
+  RectBatch batch;
+  for (size_t t = 0; t < draws.size(); ++t) {
+    std::vector<uint32_t>& indices = draws[t];
+    indices.erase(std::remove_if(indices.begin(), indices.end(),
+                                 [&](uint32_t i) {
+                                   return !foldable[op_effect[i]];
+                                 }),
+                  indices.end());
+    if (indices.empty()) {
+      continue;
+    }
+    batch.Resize(indices.size());
+    for (size_t k = 0; k < indices.size(); ++k) {
+      const RectF& bounds = ops[indices[k]].bounds;
+      batch.left[k] = bounds.left;
+      batch.top[k] = bounds.top;
+      batch.right[k] = bounds.right;
+      batch.bottom[k] = bounds.bottom;
+    }
+    MapRects(transforms[t].screen, batch, batch);
+    for (size_t k = 0; k < indices.size(); ++k) {
+      screen_bounds[op_effect[indices[k]]].push_back(
+          {batch.left[k] - kAntiAliasOutset, batch.top[k] - kAntiAliasOutset,
+           batch.right[k] + kAntiAliasOutset,
+           batch.bottom[k] + kAntiAliasOutset});
+    }
+  }
+
+  for (size_t i = 0; i < effects.size(); ++i) {
+    EffectSurface& surface = surfaces.effects[i];
+    if (surface.reason != RenderSurfaceReason::kNone ||
+        surface.fold_opacity || effects[i].opacity >= 1.0) {
+      continue;
+    }
+    if (foldable[i] && AnyOverlap(screen_bounds[i])) {
+      foldable[i] = false;
+    }
+    if (foldable[i]) {
+      surface.fold_opacity = true;
+    } else {
+      surface.reason = RenderSurfaceReason::kOpacity;
+    }
+  }
+
+  for (uint32_t i = 0; i < ops.size(); ++i) {
+    const uint32_t effect = op_effect[i];
+    if (effect != kNoEffect && foldable[effect]) {
+      surfaces.folded_ops.push_back({i, effect});
+    }
+  }
+  return surfaces;
+}
+
+}  // namespace paint_preprocessor
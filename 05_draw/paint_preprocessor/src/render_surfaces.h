@@ -0,0 +1,103 @@
+// Paint Preprocessor Render Surfaces
+// Decides which effect nodes need an offscreen surface during replay, and
+// folds the opacity of the others into the colors of their ops
+
+#ifndef PAINT_PREPROCESSOR_RENDER_SURFACES_H_
+#define PAINT_PREPROCESSOR_RENDER_SURFACES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "geometry.h"
+#include "property_trees.h"
+
+namespace paint_preprocessor {
+
+// Why an effect needs a surface: the subset of cc's RenderSurfaceReason
+// (05_draw/chromium/effect_node.h) that draw.html's replay can produce
+enum class RenderSurfaceReason {
+  kNone,
+  kBlendMode,
+  kBlendModeDstIn,
+  kOpacity,
+  kFilter,
+};
+
+// "none", "blend mode", "blend mode kDstIn", "opacity" and "filter", as
+// cc's RenderSurfaceReasonToString
+const char* RenderSurfaceReasonToString(RenderSurfaceReason reason);
+
+// An effect tree node: what draw.html opens a saveLayer for
+struct EffectNode {
+  int64_t id = 0;
+  int64_t parent_id = kInvalidNodeId;
+  double opacity = 1.0;
+  std::string blend_mode = "SrcOver";
+  // The amount of the first "blur" filter with an amount > 0
+  double blur = 0.0;
+  // "opacity_folded": the opacity is already in the op colors, from an
+  // earlier run over the same artifact. The node stays folded.
+  bool opacity_folded = false;
+};
+
+// What the pass needs of a paint op
+struct PaintOp {
+  std::string type;
+  int64_t transform_id = kInvalidNodeId;
+  int64_t effect_id = kInvalidNodeId;
+  // Local bounds of what a draw op covers, stroke included
+  bool has_bounds = false;
+  RectF bounds;
+  // A solid color with an explicit "a", no shadows and no shader: an
+  // opacity can be multiplied into |alpha|
+  bool solid_color = false;
+  double alpha = 1.0;
+  // The offsets of the "a" value in the source text of "paint_ops"
+  size_t alpha_begin = 0;
+  size_t alpha_end = 0;
+};
+
+// The decision for an effect node
+struct EffectSurface {
+  RenderSurfaceReason reason = RenderSurfaceReason::kNone;
+  // The node's opacity is < 1 but needs no surface: it is multiplied into
+  // the alpha of its ops instead
+  bool fold_opacity = false;
+};
+
+struct RenderSurfaces {
+  // Indexed like the effect nodes
+  std::vector<EffectSurface> effects;
+  // The ops whose alpha takes the opacity of their effect node, in op
+  // order. The ops of a node folded by an earlier run are not listed.
+  struct FoldedOp {
+    uint32_t op;
+    uint32_t effect;
+  };
+  std::vector<FoldedOp> folded_ops;
+};
+
+// Decides, for every node of |effects| (indexed alike), whether replaying
+// its ops needs a surface, as cc's ComputeRenderSurfaceReason does for
+// what draw.html supports: a blend mode other than SrcOver or a blur
+// always does. Opacity < 1 does unless every op of the node is a Save,
+// Restore or Clip op or a solid color draw, and the draws do not overlap
+// each other on screen (|transforms| are |transform_nodes| resolved):
+// then each pixel is drawn at most once, and multiplying the opacity into
+// the op colors gives the same result without the layer. This extends
+// Chromium's fold of a SaveLayerAlpha around a single draw
+// (PaintOpBuffer's SaveLayerAlpha/Draw/Restore optimization) to draws that
+// do not overlap.
+//
+// Effects are flat in draw.html: a node's saveLayer is closed before the
+// next node's opens, so only the ops with the node's own effect_id count.
+RenderSurfaces DecideRenderSurfaces(
+    const std::vector<EffectNode>& effects, const std::vector<PaintOp>& ops,
+    const std::vector<TransformNode>& transform_nodes,
+    const std::vector<ResolvedTransform>& transforms);
+
+}  // namespace paint_preprocessor
+
+#endif  // PAINT_PREPROCESSOR_RENDER_SURFACES_H_
@@ -0,0 +1,468 @@
+// Copyright 2012 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Adapted from ui/gfx/geometry/transform.cc and matrix44.cc. See
+// transform.h for the changes from Chromium.
+
+#include "transform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "matrix_kernels.h"
+
+namespace paint_preprocessor {
+
+namespace {
+
+const double kEpsilon = std::numeric_limits<float>::epsilon();
+
+// The w that MapRect clips quads to, in front of the eye, as cc's
+// MathUtil::ComputeClippedPointForEdge
+const double kClippedW = 0.00001;
+
+// A point in homogeneous coordinates, before the divide by w
+struct HomogeneousPoint {
+  double x;
+  double y;
+  double w;
+
+  bool ShouldBeClipped() const { return w <= 0; }
+};
+
+// Where the edge from |a| to |b|, one of them behind the eye, crosses
+// w = kClippedW
+PointF ClippedPointForEdge(const HomogeneousPoint& a,
+                           const HomogeneousPoint& b) {
+  const double t = (kClippedW - a.w) / (b.w - a.w);
+  const double x = (1 - t) * a.x + t * b.x;
+  const double y = (1 - t) * a.y + t * b.y;
+  return {x / kClippedW, y / kClippedW};
+}
+
+}  // namespace
+
+Transform Transform::RowMajor(const std::array<double, 16>& a) {
+  Transform result;
+  result.full_matrix_ = true;
+  for (int row = 0; row < 4; ++row) {
+    for (int col = 0; col < 4; ++col) {
+      result.matrix_[col][row] = a[row * 4 + col];
+    }
+  }
+  return result;
+}
+
+Transform Transform::RowMajorOrAxis2d(const std::array<double, 16>& a) {
+  // [sx 0 0 tx]
+  // [0 sy 0 ty]
+  // [0  0 1  0]
+  // [0  0 0  1]
+  for (int i = 0; i < 16; ++i) {
+    const bool free = i == 0 || i == 3 || i == 5 || i == 7;
+    if (!free && a[i] != (i % 5 == 0 ? 1 : 0)) {
+      return RowMajor(a);
+    }
+  }
+  return Transform(
+      AxisTransform2d::FromScaleAndTranslation(a[0], a[5], a[3], a[7]));
+}
+
+double Transform::rc(int row, int col) const {
+  if (!full_matrix_) {
+    const double m[4][4] = {
+        {axis_2d_.scale_x(), 0, 0, axis_2d_.translation_x()},
+        {0, axis_2d_.scale_y(), 0, axis_2d_.translation_y()},
+        {0, 0, 1, 0},
+        {0, 0, 0, 1}};
+    return m[row][col];
+  }
+  return matrix_[col][row];
+}
+
+void Transform::GetRowMajor(std::array<double, 16>& a) const {
+  for (int row = 0; row < 4; ++row) {
+    for (int col = 0; col < 4; ++col) {
+      a[row * 4 + col] = rc(row, col);
+    }
+  }
+}
+
+void Transform::GetFullMatrix(double matrix[4][4]) const {
+  if (full_matrix_) {
+    std::copy(&matrix_[0][0], &matrix_[0][0] + 16, &matrix[0][0]);
+    return;
+  }
+  for (int col = 0; col < 4; ++col) {
+    for (int row = 0; row < 4; ++row) {
+      matrix[col][row] = rc(row, col);
+    }
+  }
+}
+
+void Transform::EnsureFullMatrix() {
+  if (!full_matrix_) {
+    // matrix_ overlays axis_2d_
+    double matrix[4][4];
+    GetFullMatrix(matrix);
+    std::copy(&matrix[0][0], &matrix[0][0] + 16, &matrix_[0][0]);
+    full_matrix_ = true;
+  }
+}
+
+void Transform::PreConcat(const Transform& transform) {
+  if (!transform.full_matrix_) {
+    PreConcat(transform.axis_2d_);
+  } else if (!full_matrix_) {
+    AxisTransform2d self = axis_2d_;
+    *this = transform;
+    PostConcat(self);
+  } else {
+    double result[4][4];
+    ConcatMatrices(matrix_, transform.matrix_, result);
+    std::copy(&result[0][0], &result[0][0] + 16, &matrix_[0][0]);
+  }
+}
+
+void Transform::PostConcat(const Transform& transform) {
+  if (!transform.full_matrix_) {
+    PostConcat(transform.axis_2d_);
+  } else if (!full_matrix_) {
+    AxisTransform2d self = axis_2d_;
+    *this = transform;
+    PreConcat(self);
+  } else {
+    double result[4][4];
+    ConcatMatrices(transform.matrix_, matrix_, result);
+    std::copy(&result[0][0], &result[0][0] + 16, &matrix_[0][0]);
+  }
+}
+
+Transform Transform::operator*(const Transform& other) const {
+  if (!full_matrix_ && !other.full_matrix_) {
+    AxisTransform2d result = axis_2d_;
+    result.PreConcat(other.axis_2d_);
+    return Transform(result);
+  }
+  if (!other.full_matrix_) {
+    Transform result = *this;
+    result.PreConcat(other.axis_2d_);
+    return result;
+  }
+  if (!full_matrix_) {
+    Transform result = other;
+    result.PostConcat(axis_2d_);
+    return result;
+  }
+  Transform result;
+  result.full_matrix_ = true;
+  ConcatMatrices(matrix_, other.matrix_, result.matrix_);
+  return result;
+}
+
+void Transform::PreConcat(const AxisTransform2d& transform) {
+  Translate3d(transform.translation_x(), transform.translation_y(), 0);
+  Scale(transform.scale_x(), transform.scale_y());
+}
+
+void Transform::PostConcat(const AxisTransform2d& transform) {
+  PostScale(transform.scale_x(), transform.scale_y());
+  PostTranslate3d(transform.translation_x(), transform.translation_y(), 0);
+}
+
+void Transform::Scale(double x, double y) {
+  if (!full_matrix_) {
+    axis_2d_.PreScale(x, y);
+    return;
+  }
+  for (int row = 0; row < 4; ++row) {
+    matrix_[0][row] *= x;
+    matrix_[1][row] *= y;
+  }
+}
+
+void Transform::PostScale(double x, double y) {
+  if (!full_matrix_) {
+    axis_2d_.PostScale(x, y);
+    return;
+  }
+  for (int col = 0; col < 4; ++col) {
+    matrix_[col][0] *= x;
+    matrix_[col][1] *= y;
+  }
+}
+
+void Transform::Translate3d(double x, double y, double z) {
+  if (!full_matrix_ && z == 0) {
+    axis_2d_.PreTranslate(x, y);
+    return;
+  }
+  EnsureFullMatrix();
+  // The last column gains the first three columns scaled by x, y, z
+  for (int row = 0; row < 4; ++row) {
+    matrix_[3][row] +=
+        matrix_[0][row] * x + matrix_[1][row] * y + matrix_[2][row] * z;
+  }
+}
+
+void Transform::PostTranslate3d(double x, double y, double z) {
+  if (!full_matrix_ && z == 0) {
+    axis_2d_.PostTranslate(x, y);
+    return;
+  }
+  EnsureFullMatrix();
+  // Each column gains the translation scaled by its bottom row
+  for (int col = 0; col < 4; ++col) {
+    matrix_[col][0] += x * matrix_[col][3];
+    matrix_[col][1] += y * matrix_[col][3];
+    matrix_[col][2] += z * matrix_[col][3];
+  }
+}
+
+void Transform::ApplyTransformOrigin(double x, double y, double z) {
+  PostTranslate3d(x, y, z);
+  Translate3d(-x, -y, -z);
+}
+
+bool Transform::IsIdentity() const {
+  if (!full_matrix_) {
+    return axis_2d_ == AxisTransform2d();
+  }
+  return *this == Transform();
+}
+
+bool Transform::IsIdentityOrTranslation() const {
+  if (!full_matrix_) {
+    return axis_2d_.scale_x() == 1 && axis_2d_.scale_y() == 1;
+  }
+  for (int col = 0; col < 3; ++col) {
+    for (int row = 0; row < 4; ++row) {
+      if (matrix_[col][row] != (row == col ? 1 : 0)) {
+        return false;
+      }
+    }
+  }
+  return matrix_[3][3] == 1;
+}
+
+bool Transform::Creates3d() const {
+  if (!full_matrix_) {
+    return false;
+  }
+  return rc(2, 0) != 0 || rc(2, 1) != 0 || rc(2, 3) != 0;
+}
+
+bool Transform::IsBackFaceVisible() const {
+  if (!full_matrix_) {
+    return false;
+  }
+
+  // Compute whether a layer with a forward-facing normal of (0, 0, 1, 0)
+  // would have its back face visible after applying the transform.
+  // This is done by transforming the normal and seeing if the resulting z
+  // value is positive or negative. However, note that transforming a normal
+  // actually requires using the inverse-transpose of the original transform.
+  //
+  // We can avoid inverting and transposing the matrix since we know we want
+  // to transform only the specific normal vector (0, 0, 1, 0). In this case,
+  // we only need the 3rd row, 3rd column of the inverse-transpose. We can
+  // calculate only the 3rd row 3rd column element of the inverse, skipping
+  // everything else.
+  double determinant = Determinant();
+
+  // If matrix was not invertible, then just assume back face is not visible.
+  if (determinant == 0)
+    return false;
+
+  // Compute the cofactor of the 3rd row, 3rd column.
+  double cofactor33 = MatrixCofactor33(matrix_);
+
+  // Technically the transformed z component is cofactor33 / determinant.  But
+  // we can avoid the costly division because we only care about the resulting
+  // +/- sign; we can check this equivalently by multiplication.
+  return cofactor33 * determinant < -kEpsilon;
+}
+
+double Transform::Determinant() const {
+  if (!full_matrix_) {
+    return axis_2d_.Determinant();
+  }
+  return MatrixDeterminant(matrix_);
+}
+
+bool Transform::GetInverse(Transform* transform) const {
+  if (!full_matrix_) {
+    transform->full_matrix_ = false;
+    if (axis_2d_.IsInvertible()) {
+      transform->axis_2d_ = axis_2d_;
+      transform->axis_2d_.Invert();
+      return true;
+    }
+    transform->axis_2d_ = AxisTransform2d();
+    return false;
+  }
+
+  if (IsIdentityOrTranslation()) {
+    *transform = *this;
+    transform->matrix_[3][0] = -matrix_[3][0];
+    transform->matrix_[3][1] = -matrix_[3][1];
+    transform->matrix_[3][2] = -matrix_[3][2];
+    return true;
+  }
+
+  double inverse[4][4];
+  if (!InvertMatrix(matrix_, inverse)) {
+    *transform = Transform();
+    return false;
+  }
+  transform->full_matrix_ = true;
+  std::copy(&inverse[0][0], &inverse[0][0] + 16, &transform->matrix_[0][0]);
+  return true;
+}
+
+Transform::MapKind Transform::GetMapKind() const {
+  if (!full_matrix_) {
+    return axis_2d_.scale_x() == 1 && axis_2d_.scale_y() == 1
+               ? MapKind::kTranslate
+               : MapKind::kScaleTranslate;
+  }
+  // The third row and column only act on z
+  if (matrix_[0][3] != 0 || matrix_[1][3] != 0 || matrix_[3][3] != 1) {
+    return MapKind::kPerspective;
+  }
+  if (matrix_[1][0] != 0 || matrix_[0][1] != 0) {
+    return MapKind::kAffine;
+  }
+  return matrix_[0][0] == 1 && matrix_[1][1] == 1 ? MapKind::kTranslate
+                                                  : MapKind::kScaleTranslate;
+}
+
+PointF Transform::MapPoint(const PointF& point) const {
+  const double x = point.x;
+  const double y = point.y;
+  if (!full_matrix_) {
+    return {axis_2d_.scale_x() * x + axis_2d_.translation_x(),
+            axis_2d_.scale_y() * y + axis_2d_.translation_y()};
+  }
+  switch (GetMapKind()) {
+    case MapKind::kTranslate:
+      return {x + matrix_[3][0], y + matrix_[3][1]};
+    case MapKind::kScaleTranslate:
+      return {matrix_[0][0] * x + matrix_[3][0],
+              matrix_[1][1] * y + matrix_[3][1]};
+    case MapKind::kAffine:
+      return {matrix_[0][0] * x + matrix_[1][0] * y + matrix_[3][0],
+              matrix_[0][1] * x + matrix_[1][1] * y + matrix_[3][1]};
+    case MapKind::kPerspective:
+      break;
+  }
+  const double mapped_x = matrix_[0][0] * x + matrix_[1][0] * y + matrix_[3][0];
+  const double mapped_y = matrix_[0][1] * x + matrix_[1][1] * y + matrix_[3][1];
+  const double w = matrix_[0][3] * x + matrix_[1][3] * y + matrix_[3][3];
+  if (w != 1 && std::isnormal(w)) {
+    const double w_inverse = 1 / w;
+    return {mapped_x * w_inverse, mapped_y * w_inverse};
+  }
+  return {mapped_x, mapped_y};
+}
+
+RectF Transform::MapRect(const RectF& rect) const {
+  const MapKind kind = GetMapKind();
+  if (kind == MapKind::kTranslate || kind == MapKind::kScaleTranslate) {
+    const PointF a = MapPoint({rect.left, rect.top});
+    const PointF b = MapPoint({rect.right, rect.bottom});
+    if (kind == MapKind::kTranslate) {
+      return {a.x, a.y, b.x, b.y};
+    }
+    // A negative scale swaps the sides
+    return {BoundsMin(a.x, b.x), BoundsMin(a.y, b.y), BoundsMax(a.x, b.x),
+            BoundsMax(a.y, b.y)};
+  }
+
+  // The corners clockwise from the top left, as a quad
+  const PointF corners[4] = {{rect.left, rect.top},
+                             {rect.right, rect.top},
+                             {rect.right, rect.bottom},
+                             {rect.left, rect.bottom}};
+  PointF mapped[4];
+  if (kind == MapKind::kAffine) {
+    for (int i = 0; i < 4; ++i) {
+      mapped[i] = MapPoint(corners[i]);
+    }
+  } else {
+    HomogeneousPoint h[4];
+    bool clipped = false;
+    for (int i = 0; i < 4; ++i) {
+      const double x = corners[i].x;
+      const double y = corners[i].y;
+      h[i] = {matrix_[0][0] * x + matrix_[1][0] * y + matrix_[3][0],
+              matrix_[0][1] * x + matrix_[1][1] * y + matrix_[3][1],
+              matrix_[0][3] * x + matrix_[1][3] * y + matrix_[3][3]};
+      clipped = clipped || h[i].ShouldBeClipped();
+    }
+    if (clipped) {
+      // Bound the corners in front of the eye and the points where the
+      // edges cross to behind it
+      bool empty = true;
+      RectF bounds;
+      auto add = [&empty, &bounds](const PointF& p) {
+        if (empty) {
+          bounds = {p.x, p.y, p.x, p.y};
+          empty = false;
+          return;
+        }
+        bounds = {BoundsMin(bounds.left, p.x), BoundsMin(bounds.top, p.y),
+                  BoundsMax(bounds.right, p.x), BoundsMax(bounds.bottom, p.y)};
+      };
+      for (int i = 0; i < 4; ++i) {
+        const HomogeneousPoint& next = h[(i + 1) % 4];
+        if (!h[i].ShouldBeClipped()) {
+          const double w_inverse = 1 / h[i].w;
+          add({h[i].x * w_inverse, h[i].y * w_inverse});
+        }
+        if (h[i].ShouldBeClipped() != next.ShouldBeClipped()) {
+          add(ClippedPointForEdge(h[i], next));
+        }
+      }
+      return bounds;
+    }
+    for (int i = 0; i < 4; ++i) {
+      const double w_inverse = 1 / h[i].w;
+      mapped[i] = {h[i].x * w_inverse, h[i].y * w_inverse};
+    }
+  }
+  return {BoundsMin(BoundsMin(BoundsMin(mapped[0].x, mapped[1].x),
+                              mapped[2].x),
+                    mapped[3].x),
+          BoundsMin(BoundsMin(BoundsMin(mapped[0].y, mapped[1].y),
+                              mapped[2].y),
+                    mapped[3].y),
+          BoundsMax(BoundsMax(BoundsMax(mapped[0].x, mapped[1].x),
+                              mapped[2].x),
+                    mapped[3].x),
+          BoundsMax(BoundsMax(BoundsMax(mapped[0].y, mapped[1].y),
+                              mapped[2].y),
+                    mapped[3].y)};
+}
+
+bool Transform::operator==(const Transform& other) const {
+  if (!full_matrix_ && !other.full_matrix_) {
+    return axis_2d_ == other.axis_2d_;
+  }
+  double matrix[4][4];
+  double other_matrix[4][4];
+  GetFullMatrix(matrix);
+  other.GetFullMatrix(other_matrix);
+  for (int col = 0; col < 4; ++col) {
+    for (int row = 0; row < 4; ++row) {
+      if (matrix[col][row] != other_matrix[col][row]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace paint_preprocessor
@@ -0,0 +1,158 @@
+// Copyright 2012 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Adapted from ui/gfx/geometry/transform.h (05_draw/chromium/transform.h).
+//
+// Changes from Chromium:
+// - Matrix44 folded in as a column-major double[4][4], in a union with the
+//   AxisTransform2d (double precision here)
+// - Full matrices are multiplied and inverted by the SSE2 / AVX2 kernels of
+//   matrix_kernels.h instead of Matrix44's Double4 code
+// - Only what resolving property trees and mapping op rects needs:
+//   construction, concatenation, transform origin, inversion, the 3d /
+//   backface queries, and MapPoint / MapRect in the z = 0 plane
+// - No base/ dependencies, DCHECKs or mojo traits
+
+#ifndef PAINT_PREPROCESSOR_TRANSFORM_H_
+#define PAINT_PREPROCESSOR_TRANSFORM_H_
+
+#include <array>
+
+#include "axis_transform2d.h"
+#include "geometry.h"
+
+namespace paint_preprocessor {
+
+// 4x4 Transformation matrix. Depending on the complexity of the matrix, it
+// is stored as an AxisTransform2d (a 2d scale and/or translation) or a full
+// 4x4 matrix, as gfx::Transform:
+// - Construction from a translation or scale, and the identity, use
+//   AxisTransform2d; RowMajor() always creates a full matrix
+// - Mutation keeps AxisTransform2d while the result can still be 2d scale
+//   and/or translation
+// - Concatenating two AxisTransform2d costs 4 multiplies instead of a 4x4
+//   matrix product
+class Transform {
+ public:
+  Transform() = default;
+
+  explicit Transform(const AxisTransform2d& axis_2d) : axis_2d_(axis_2d) {}
+
+  // Creates a transform from 16 matrix elements in row-major order, the
+  // order of the "matrix" arrays of paint.json and of CanvasKit's M44.
+  // Always creates a full 4x4 matrix.
+  static Transform RowMajor(const std::array<double, 16>& a);
+
+  // Creates an AxisTransform2d if the row-major elements are a 2d scale
+  // and/or translation, otherwise a full matrix (like ColMajorF())
+  static Transform RowMajorOrAxis2d(const std::array<double, 16>& a);
+
+  // Creates a transform as a 2d translation.
+  static Transform MakeTranslation(double tx, double ty) {
+    return Transform(
+        AxisTransform2d::FromScaleAndTranslation(1.0, 1.0, tx, ty));
+  }
+
+  // Creates a transform as a 2d scale.
+  static Transform MakeScale(double sx, double sy) {
+    return Transform(AxisTransform2d::FromScaleAndTranslation(sx, sy, 0, 0));
+  }
+
+  // Gets a value at |row|, |col| from the matrix.
+  double rc(int row, int col) const;
+
+  // Sets a value in the matrix at |row|, |col|. It forces a full 4x4
+  // matrix.
+  void set_rc(int row, int col, double v) {
+    EnsureFullMatrix();
+    matrix_[col][row] = v;
+  }
+
+  // Gets row-major data.
+  void GetRowMajor(std::array<double, 16>& a) const;
+
+  // this = this * transform
+  void PreConcat(const Transform& transform);
+  // this = transform * this
+  void PostConcat(const Transform& transform);
+  // Returns |this| * |other|.
+  Transform operator*(const Transform& other) const;
+
+  // this = this * scaling
+  void Scale(double x, double y);
+  // this = scaling * this
+  void PostScale(double x, double y);
+  // this = this * translation
+  void Translate3d(double x, double y, double z);
+  // this = translation * this
+  void PostTranslate3d(double x, double y, double z);
+
+  // Changes the transform to apply as if the origin were at (x, y, z).
+  void ApplyTransformOrigin(double x, double y, double z);
+
+  bool IsIdentity() const;
+  bool IsIdentityOrTranslation() const;
+
+  // Returns whether this matrix can transform a z=0 plane to something
+  // containing points where z != 0.
+  bool Creates3d() const;
+
+  // Returns true if a layer with a forward-facing normal of (0, 0, 1) would
+  // have its back side facing frontwards after applying the transform.
+  bool IsBackFaceVisible() const;
+
+  double Determinant() const;
+
+  // If |this| is invertible, inverts |this| and stores the result in
+  // |*transform|, and returns true. Otherwise sets |*transform| to identity
+  // and returns false.
+  [[nodiscard]] bool GetInverse(Transform* transform) const;
+
+  // How a point in the z = 0 plane maps, the cheapest case first. The
+  // batched MapPoints / MapRects of map_batch.h pick their loop by it.
+  enum class MapKind {
+    kTranslate,       // x + tx
+    kScaleTranslate,  // sx * x + tx
+    kAffine,          // a * x + c * y + tx
+    kPerspective,     // Divided by w
+  };
+  MapKind GetMapKind() const;
+
+  // Maps a point in the z = 0 plane. With perspective, x and y are divided
+  // by w unless w is 1 or not normal, as gfx::Transform::MapPoint.
+  PointF MapPoint(const PointF& point) const;
+
+  // Returns the bounding box of the mapped rect. With perspective, the part
+  // of the rect behind the eye (w <= 0) is clipped off first, as cc's
+  // MathUtil::MapClippedRect; a rect entirely behind it maps to an empty
+  // rect at the origin.
+  RectF MapRect(const RectF& rect) const;
+
+  bool operator==(const Transform& other) const;
+
+  // Switches to the full 4x4 representation, which gives the same values;
+  // paint_preprocessor --full-matrix uses it to measure the AxisTransform2d
+  // path
+  void EnsureFullMatrix();
+  bool IsFullMatrix() const { return full_matrix_; }
+
+ private:
+  // Mutations that keep an AxisTransform2d
+  void PreConcat(const AxisTransform2d& transform);
+  void PostConcat(const AxisTransform2d& transform);
+
+  void GetFullMatrix(double matrix[4][4]) const;
+
+  // axis_2d_ is used if full_matrix_ is false, otherwise matrix_ is used.
+  bool full_matrix_ = false;
+  union {
+    AxisTransform2d axis_2d_{};
+    // matrix_[col][row]
+    double matrix_[4][4];
+  };
+};
+
+}  // namespace paint_preprocessor
+
+#endif  // PAINT_PREPROCESSOR_TRANSFORM_H_
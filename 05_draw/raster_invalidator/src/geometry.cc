@@ -0,0 +1,97 @@
+#include "geometry.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace raster_invalidator {
+
+RectF RectF::Infinite() {
+  // The root clip node of a paint.json clip tree is
+  // [-8388608, -8388608, 16777215, 16777215]
+  constexpr double kLarge = 1e9;
+  return {-kLarge, -kLarge, kLarge, kLarge};
+}
+
+RectF RectF::Intersect(const RectF& other) const {
+  RectF result = {std::max(left, other.left), std::max(top, other.top),
+                  std::min(right, other.right),
+                  std::min(bottom, other.bottom)};
+  return result.IsEmpty() ? RectF() : result;
+}
+
+RectF RectF::Union(const RectF& other) const {
+  if (IsEmpty()) {
+    return other;
+  }
+  if (other.IsEmpty()) {
+    return *this;
+  }
+  return {std::min(left, other.left), std::min(top, other.top),
+          std::max(right, other.right), std::max(bottom, other.bottom)};
+}
+
+RectF RectF::Offset(double dx, double dy) const {
+  return {left + dx, top + dy, right + dx, bottom + dy};
+}
+
+RectF RectF::Outset(double outset) const {
+  return {left - outset, top - outset, right + outset, bottom + outset};
+}
+
+RectF RectF::Enclosing() const {
+  return {std::floor(left), std::floor(top), std::ceil(right),
+          std::ceil(bottom)};
+}
+
+Matrix44 Matrix44::Translate(double dx, double dy, double dz) {
+  return Matrix44({1, 0, 0, dx, 0, 1, 0, dy, 0, 0, 1, dz, 0, 0, 0, 1});
+}
+
+Matrix44 Matrix44::Scale(double sx, double sy) {
+  return Matrix44({sx, 0, 0, 0, 0, sy, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1});
+}
+
+Matrix44 Matrix44::Rotate(double degrees) {
+  const double radians = degrees * M_PI / 180.0;
+  const double c = std::cos(radians);
+  const double s = std::sin(radians);
+  return Matrix44({c, -s, 0, 0, s, c, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1});
+}
+
+Matrix44 Matrix44::Concat(const Matrix44& other) const {
+  std::array<double, 16> result;
+  for (int row = 0; row < 4; ++row) {
+    for (int col = 0; col < 4; ++col) {
+      double sum = 0.0;
+      for (int k = 0; k < 4; ++k) {
+        sum += rc(row, k) * other.rc(k, col);
+      }
+      result[row * 4 + col] = sum;
+    }
+  }
+  return Matrix44(result);
+}
+
+bool Matrix44::MapRect(const RectF& rect, RectF& mapped) const {
+  const double xs[4] = {rect.left, rect.right, rect.right, rect.left};
+  const double ys[4] = {rect.top, rect.top, rect.bottom, rect.bottom};
+  for (int i = 0; i < 4; ++i) {
+    const double w = rc(3, 0) * xs[i] + rc(3, 1) * ys[i] + rc(3, 3);
+    if (!(w > 0.0)) {
+      return false;
+    }
+    const double x = (rc(0, 0) * xs[i] + rc(0, 1) * ys[i] + rc(0, 3)) / w;
+    const double y = (rc(1, 0) * xs[i] + rc(1, 1) * ys[i] + rc(1, 3)) / w;
+    if (i == 0) {
+      mapped = {x, y, x, y};
+    } else {
+      mapped.left = std::min(mapped.left, x);
+      mapped.top = std::min(mapped.top, y);
+      mapped.right = std::max(mapped.right, x);
+      mapped.bottom = std::max(mapped.bottom, y);
+    }
+  }
+  return true;
+}
+
+}  // namespace raster_invalidator
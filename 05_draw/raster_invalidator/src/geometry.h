@@ -0,0 +1,72 @@
+// Raster Invalidator Geometry
+// Rects and 4x4 matrices for mapping paint op bounds to root space
+
+#ifndef RASTER_INVALIDATOR_GEOMETRY_H_
+#define RASTER_INVALIDATOR_GEOMETRY_H_
+
+#include <array>
+
+namespace raster_invalidator {
+
+// Left, top, right, bottom, as paint ops store rects
+struct RectF {
+  double left = 0.0;
+  double top = 0.0;
+  double right = 0.0;
+  double bottom = 0.0;
+
+  static RectF FromXYWH(double x, double y, double width, double height) {
+    return {x, y, x + width, y + height};
+  }
+  // Larger than any clip of the paint.json property trees
+  static RectF Infinite();
+
+  double width() const { return right - left; }
+  double height() const { return bottom - top; }
+  bool IsEmpty() const { return !(left < right && top < bottom); }
+  double Area() const { return IsEmpty() ? 0.0 : width() * height(); }
+
+  RectF Intersect(const RectF& other) const;
+  // Empty rects are ignored
+  RectF Union(const RectF& other) const;
+  RectF Offset(double dx, double dy) const;
+  RectF Outset(double outset) const;
+  // The smallest rect with integer edges containing this one
+  RectF Enclosing() const;
+
+  bool operator==(const RectF& other) const {
+    return left == other.left && top == other.top && right == other.right &&
+           bottom == other.bottom;
+  }
+};
+
+// Row-major 4x4 matrix, as the paint.json transform tree and ConcatOp store
+// it; points are columns, so a child's matrix is post-multiplied
+class Matrix44 {
+ public:
+  Matrix44() : m_{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1} {}
+  explicit Matrix44(const std::array<double, 16>& row_major)
+      : m_(row_major) {}
+
+  static Matrix44 Translate(double dx, double dy, double dz = 0.0);
+  static Matrix44 Scale(double sx, double sy);
+  static Matrix44 Rotate(double degrees);
+
+  double rc(int row, int col) const { return m_[row * 4 + col]; }
+  const std::array<double, 16>& values() const { return m_; }
+
+  // this * other
+  Matrix44 Concat(const Matrix44& other) const;
+
+  // The bounds of |rect| (in the plane z = 0) mapped by this matrix. False
+  // if a corner maps behind the viewer (w <= 0), where the bounds are
+  // unknown.
+  bool MapRect(const RectF& rect, RectF& mapped) const;
+
+ private:
+  std::array<double, 16> m_;
+};
+
+}  // namespace raster_invalidator
+
+#endif  // RASTER_INVALIDATOR_GEOMETRY_H_
@@ -0,0 +1,728 @@
+#include "json_parser.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+
+namespace raster_invalidator {
+namespace {
+
+// Simple JSON tokenizer
+class JsonTokenizer {
+ public:
+  explicit JsonTokenizer(const std::string& json) : json_(json), pos_(0) {}
+
+  void SkipWhitespace() {
+    while (pos_ < json_.size() &&
+           (json_[pos_] == ' ' || json_[pos_] == '\n' ||
+            json_[pos_] == '\r' || json_[pos_] == '\t')) {
+      ++pos_;
+    }
+  }
+
+  char Peek() {
+    SkipWhitespace();
+    return pos_ < json_.size() ? json_[pos_] : '\0';
+  }
+
+  char Consume() {
+    SkipWhitespace();
+    return pos_ < json_.size() ? json_[pos_++] : '\0';
+  }
+
+  void Expect(char c) {
+    SkipWhitespace();
+    if (pos_ >= json_.size() || json_[pos_] != c) {
+      throw std::runtime_error(std::string("Expected '") + c + "' at offset " +
+                               std::to_string(pos_));
+    }
+    ++pos_;
+  }
+
+  // Decodes escapes, including \uXXXX (and surrogate pairs) to UTF-8, so
+  // the serializer can escape the string again the way JSON.stringify does
+  std::string ReadString() {
+    Expect('"');
+    std::string result;
+    while (pos_ < json_.size() && json_[pos_] != '"') {
+      if (json_[pos_] != '\\') {
+        result += json_[pos_++];
+        continue;
+      }
+      ++pos_;
+      if (pos_ >= json_.size()) {
+        break;
+      }
+      switch (json_[pos_++]) {
+        case 'n': result += '\n'; break;
+        case 't': result += '\t'; break;
+        case 'r': result += '\r'; break;
+        case 'b': result += '\b'; break;
+        case 'f': result += '\f'; break;
+        case 'u': AppendUtf8(ReadCodePoint(), result); break;
+        default: result += json_[pos_ - 1]; break;
+      }
+    }
+    Expect('"');
+    return result;
+  }
+
+  double ReadNumber() {
+    SkipWhitespace();
+    const char* start = json_.c_str() + pos_;
+    char* end = nullptr;
+    const double value = std::strtod(start, &end);
+    if (end == start) {
+      throw std::runtime_error("Expected number at offset " +
+                               std::to_string(pos_));
+    }
+    pos_ += end - start;
+    return value;
+  }
+
+  bool ReadBool() {
+    SkipWhitespace();
+    if (json_.compare(pos_, 4, "true") == 0) {
+      pos_ += 4;
+      return true;
+    }
+    if (json_.compare(pos_, 5, "false") == 0) {
+      pos_ += 5;
+      return false;
+    }
+    throw std::runtime_error("Expected boolean at offset " +
+                             std::to_string(pos_));
+  }
+
+  // Consumes "null" and returns true, or returns false for any other value
+  bool ReadNull() {
+    SkipWhitespace();
+    if (json_.compare(pos_, 4, "null") == 0) {
+      pos_ += 4;
+      return true;
+    }
+    return false;
+  }
+
+  size_t pos() const { return pos_; }
+  void set_pos(size_t pos) { pos_ = pos; }
+
+ private:
+  uint32_t ReadHex4() {
+    if (pos_ + 4 > json_.size()) {
+      throw std::runtime_error("Truncated \\u escape");
+    }
+    const std::string hex = json_.substr(pos_, 4);
+    pos_ += 4;
+    return static_cast<uint32_t>(std::strtoul(hex.c_str(), nullptr, 16));
+  }
+
+  uint32_t ReadCodePoint() {
+    const uint32_t unit = ReadHex4();
+    if (unit >= 0xD800 && unit < 0xDC00 &&
+        json_.compare(pos_, 2, "\\u") == 0) {
+      const size_t saved = pos_;
+      pos_ += 2;
+      const uint32_t low = ReadHex4();
+      if (low >= 0xDC00 && low < 0xE000) {
+        return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+      }
+      pos_ = saved;
+    }
+    return unit;
+  }
+
+  static void AppendUtf8(uint32_t code_point, std::string& out) {
+    if (code_point < 0x80) {
+      out += static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+      out += static_cast<char>(0xC0 | (code_point >> 6));
+      out += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+      out += static_cast<char>(0xE0 | (code_point >> 12));
+      out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else {
+      out += static_cast<char>(0xF0 | (code_point >> 18));
+      out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+  }
+
+  const std::string& json_;
+  size_t pos_;
+};
+
+constexpr uint64_t kSeed = 0xcbf29ce484222325ull;
+
+uint64_t HashBytes(const std::string& bytes) {
+  uint64_t hash = kSeed;
+  for (unsigned char c : bytes) {
+    hash = (hash ^ c) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+uint64_t HashNumber(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+// Reads any value and returns a hash of its structure and contents, so the
+// same value hashes the same whatever its formatting
+uint64_t ReadHashedValue(JsonTokenizer& tok) {
+  const char c = tok.Peek();
+  if (c == '"') {
+    return HashCombine(1, HashBytes(tok.ReadString()));
+  }
+  if (c == '{') {
+    tok.Consume();
+    uint64_t hash = 2;
+    if (tok.Peek() == '}') {
+      tok.Consume();
+      return hash;
+    }
+    while (true) {
+      hash = HashCombine(hash, HashBytes(tok.ReadString()));
+      tok.Expect(':');
+      hash = HashCombine(hash, ReadHashedValue(tok));
+      if (tok.Peek() == ',') {
+        tok.Consume();
+      } else {
+        break;
+      }
+    }
+    tok.Expect('}');
+    return hash;
+  }
+  if (c == '[') {
+    tok.Consume();
+    uint64_t hash = 3;
+    if (tok.Peek() == ']') {
+      tok.Consume();
+      return hash;
+    }
+    while (true) {
+      hash = HashCombine(hash, ReadHashedValue(tok));
+      if (tok.Peek() == ',') {
+        tok.Consume();
+      } else {
+        break;
+      }
+    }
+    tok.Expect(']');
+    return hash;
+  }
+  if (c == 't' || c == 'f') {
+    return tok.ReadBool() ? 4 : 5;
+  }
+  if (c == 'n') {
+    if (!tok.ReadNull()) {
+      throw std::runtime_error("Expected null at offset " +
+                               std::to_string(tok.pos()));
+    }
+    return 6;
+  }
+  return HashCombine(7, HashNumber(tok.ReadNumber()));
+}
+
+// Calls |read_field| for each key of an object; it reads the value of the
+// keys it knows and returns false for the others, which are skipped. With
+// |hashed|, the returned hash covers every key and value.
+template <typename ReadField>
+uint64_t ReadHashedObject(JsonTokenizer& tok, ReadField read_field,
+                          bool hashed = true) {
+  tok.Expect('{');
+  uint64_t hash = 2;
+  if (tok.Peek() == '}') {
+    tok.Consume();
+    return hash;
+  }
+  while (true) {
+    const std::string key = tok.ReadString();
+    tok.Expect(':');
+    const size_t value_start = tok.pos();
+    const bool known = read_field(key);
+    if (hashed && known) {
+      // Read again for the hash
+      tok.set_pos(value_start);
+    }
+    if (hashed || !known) {
+      const uint64_t value_hash = ReadHashedValue(tok);
+      hash = HashCombine(HashCombine(hash, HashBytes(key)), value_hash);
+    }
+    if (tok.Peek() == ',') {
+      tok.Consume();
+    } else {
+      break;
+    }
+  }
+  tok.Expect('}');
+  return hash;
+}
+
+// A number, or |fallback| for null
+double ReadNumberOr(JsonTokenizer& tok, double fallback) {
+  return tok.ReadNull() ? fallback : tok.ReadNumber();
+}
+
+std::vector<double> ReadNumberArray(JsonTokenizer& tok, bool& has_null) {
+  std::vector<double> values;
+  has_null = false;
+  tok.Expect('[');
+  if (tok.Peek() == ']') {
+    tok.Consume();
+    return values;
+  }
+  while (true) {
+    if (tok.ReadNull()) {
+      has_null = true;
+      values.push_back(0.0);
+    } else {
+      values.push_back(tok.ReadNumber());
+    }
+    if (tok.Peek() == ',') {
+      tok.Consume();
+    } else {
+      break;
+    }
+  }
+  tok.Expect(']');
+  return values;
+}
+
+// [left, top, right, bottom], or nullopt for a missing (null) rect such as
+// the bounds of an unbounded SaveLayerOp
+std::optional<RectF> ReadLTRB(JsonTokenizer& tok) {
+  if (tok.ReadNull()) {
+    return std::nullopt;
+  }
+  bool has_null;
+  const std::vector<double> v = ReadNumberArray(tok, has_null);
+  if (has_null || v.size() != 4) {
+    return std::nullopt;
+  }
+  return RectF{v[0], v[1], v[2], v[3]};
+}
+
+// The bounds of the points of SVG path data ("M1479 735L1487 743", or
+// "M 24 128 L 24 208 Z" as border_painter writes it). Curve control points
+// are included, which can only make the bounds larger. Nullopt for arcs and
+// anything unparsable.
+std::optional<RectF> PathBounds(const std::string& path) {
+  std::optional<RectF> bounds;
+  double x = 0.0;  // Current point
+  double y = 0.0;
+  double start_x = 0.0;  // Start of the current contour
+  double start_y = 0.0;
+  char command = 0;
+  const char* p = path.c_str();
+  const auto add = [&](double px, double py) {
+    const RectF point = {px, py, px, py};
+    bounds = bounds ? RectF{std::min(bounds->left, px),
+                            std::min(bounds->top, py),
+                            std::max(bounds->right, px),
+                            std::max(bounds->bottom, py)}
+                    : point;
+  };
+  while (true) {
+    while (*p == ' ' || *p == ',' || *p == '\n' || *p == '\t') {
+      ++p;
+    }
+    if (*p == '\0') {
+      return bounds;
+    }
+    if (std::isalpha(static_cast<unsigned char>(*p))) {
+      command = *p++;
+      if (command == 'Z' || command == 'z') {
+        x = start_x;
+        y = start_y;
+        continue;
+      }
+    }
+    const bool relative = std::islower(static_cast<unsigned char>(command));
+    size_t count;
+    switch (std::toupper(static_cast<unsigned char>(command))) {
+      case 'M': case 'L': case 'T': count = 2; break;
+      case 'H': case 'V': count = 1; break;
+      case 'Q': case 'S': count = 4; break;
+      case 'C': count = 6; break;
+      default: return std::nullopt;
+    }
+    double values[6];
+    for (size_t i = 0; i < count; ++i) {
+      while (*p == ' ' || *p == ',') {
+        ++p;
+      }
+      char* end = nullptr;
+      values[i] = std::strtod(p, &end);
+      if (end == p) {
+        return std::nullopt;
+      }
+      p = end;
+    }
+    const double base_x = relative ? x : 0.0;
+    const double base_y = relative ? y : 0.0;
+    if (count == 1) {
+      if (std::toupper(static_cast<unsigned char>(command)) == 'H') {
+        x = base_x + values[0];
+      } else {
+        y = base_y + values[0];
+      }
+      add(x, y);
+      continue;
+    }
+    for (size_t i = 0; i < count; i += 2) {
+      add(base_x + values[i], base_y + values[i + 1]);
+    }
+    x = base_x + values[count - 2];
+    y = base_y + values[count - 1];
+    if (command == 'M' || command == 'm') {
+      start_x = x;
+      start_y = y;
+      // Further pairs are lines
+      command = relative ? 'l' : 'L';
+    }
+  }
+}
+
+std::optional<Matrix44> ReadMatrix(JsonTokenizer& tok) {
+  bool has_null;
+  const std::vector<double> v = ReadNumberArray(tok, has_null);
+  if (has_null || v.size() != 16) {
+    return std::nullopt;
+  }
+  std::array<double, 16> values;
+  std::copy(v.begin(), v.end(), values.begin());
+  return Matrix44(values);
+}
+
+template <typename ReadElement>
+void ReadArray(JsonTokenizer& tok, ReadElement read_element) {
+  tok.Expect('[');
+  if (tok.Peek() == ']') {
+    tok.Consume();
+    return;
+  }
+  while (true) {
+    read_element();
+    if (tok.Peek() == ',') {
+      tok.Consume();
+    } else {
+      break;
+    }
+  }
+  tok.Expect(']');
+}
+
+void ReadFlags(JsonTokenizer& tok, PaintOp& op) {
+  ReadHashedObject(tok, [&](const std::string& key) {
+    if (key == "style") {
+      op.style = static_cast<int>(tok.ReadNumber());
+    } else if (key == "strokeWidth") {
+      op.stroke_width = tok.ReadNumber();
+    } else if (key == "shadows") {
+      ReadArray(tok, [&] {
+        Shadow shadow;
+        ReadHashedObject(tok, [&](const std::string& shadow_key) {
+          if (shadow_key == "offsetX") {
+            shadow.offset_x = tok.ReadNumber();
+          } else if (shadow_key == "offsetY") {
+            shadow.offset_y = tok.ReadNumber();
+          } else if (shadow_key == "blurSigma") {
+            shadow.blur_sigma = tok.ReadNumber();
+          } else {
+            return false;
+          }
+          return true;
+        });
+        op.shadows.push_back(shadow);
+      });
+    } else {
+      return false;
+    }
+    return true;
+  });
+}
+
+std::vector<PaintOp> ReadOps(JsonTokenizer& tok);
+
+PaintOp ReadOp(JsonTokenizer& tok) {
+  PaintOp op;
+  std::optional<RectF> path_bounds;
+  op.hash = ReadHashedObject(tok, [&](const std::string& key) {
+    if (key == "type") {
+      op.type = tok.ReadString();
+    } else if (key == "nodeId" || key == "node_id") {
+      op.node_id = static_cast<int64_t>(ReadNumberOr(tok, kNoNodeId));
+    } else if (key == "transform_id") {
+      op.transform_id = static_cast<int>(tok.ReadNumber());
+    } else if (key == "clip_id") {
+      op.clip_id = static_cast<int>(tok.ReadNumber());
+    } else if (key == "effect_id") {
+      op.effect_id = static_cast<int>(tok.ReadNumber());
+    } else if (key == "rect" || key == "outer_rect" || key == "oval" ||
+               key == "dst") {
+      op.rect = ReadLTRB(tok);
+    } else if (key == "bounds") {
+      op.bounds = ReadLTRB(tok);
+    } else if (key == "path") {
+      path_bounds = PathBounds(tok.ReadString());
+    } else if (key == "x") {
+      op.x = tok.ReadNumber();
+    } else if (key == "y") {
+      op.y = tok.ReadNumber();
+    } else if (key == "x0") {
+      op.x0 = tok.ReadNumber();
+    } else if (key == "y0") {
+      op.y0 = tok.ReadNumber();
+    } else if (key == "x1") {
+      op.x1 = tok.ReadNumber();
+    } else if (key == "y1") {
+      op.y1 = tok.ReadNumber();
+    } else if (key == "dx") {
+      op.dx = tok.ReadNumber();
+    } else if (key == "dy") {
+      op.dy = tok.ReadNumber();
+    } else if (key == "sx") {
+      op.sx = tok.ReadNumber();
+    } else if (key == "sy") {
+      op.sy = tok.ReadNumber();
+    } else if (key == "degrees") {
+      op.degrees = tok.ReadNumber();
+    } else if (key == "matrix") {
+      op.matrix = ReadMatrix(tok);
+    } else if (key == "clipOp") {
+      op.clip_op = static_cast<int>(tok.ReadNumber());
+    } else if (key == "flags") {
+      ReadFlags(tok, op);
+    } else if (key == "record") {
+      op.record = ReadOps(tok);
+    } else {
+      return false;
+    }
+    return true;
+  });
+  // Paths written without their bounds are bounded by their points
+  if (!op.bounds) {
+    op.bounds = path_bounds;
+  }
+  return op;
+}
+
+std::vector<PaintOp> ReadOps(JsonTokenizer& tok) {
+  std::vector<PaintOp> ops;
+  ReadArray(tok, [&] { ops.push_back(ReadOp(tok)); });
+  return ops;
+}
+
+// Calls |read_node| for each node of {"nodes": [...]}
+template <typename ReadNode>
+void ReadTree(JsonTokenizer& tok, ReadNode read_node) {
+  ReadHashedObject(tok, [&](const std::string& key) {
+    if (key != "nodes") {
+      return false;
+    }
+    ReadArray(tok, read_node);
+    return true;
+  }, /*hashed=*/false);
+}
+
+TransformNode ReadTransformNode(JsonTokenizer& tok) {
+  TransformNode node;
+  std::optional<Matrix44> matrix;
+  std::optional<std::array<double, 3>> origin;
+  std::optional<std::array<double, 2>> translation;
+  node.hash = ReadHashedObject(tok, [&](const std::string& key) {
+    bool has_null;
+    if (key == "id") {
+      node.id = static_cast<int>(tok.ReadNumber());
+    } else if (key == "parent_id") {
+      node.parent_id = static_cast<int>(ReadNumberOr(tok, -1));
+    } else if (key == "matrix" || key == "local") {
+      matrix = ReadMatrix(tok);
+    } else if (key == "origin") {
+      const std::vector<double> v = ReadNumberArray(tok, has_null);
+      if (!has_null && v.size() >= 2) {
+        origin = {v[0], v[1], v.size() > 2 ? v[2] : 0.0};
+      }
+    } else if (key == "translation2d") {
+      const std::vector<double> v = ReadNumberArray(tok, has_null);
+      if (!has_null && v.size() == 2) {
+        translation = {v[0], v[1]};
+      }
+    } else {
+      return false;
+    }
+    return true;
+  });
+  // As draw.html's PropertyTrees::getTransformMatrix
+  if (matrix) {
+    node.local = *matrix;
+    if (origin) {
+      const std::array<double, 3>& o = *origin;
+      node.local = Matrix44::Translate(o[0], o[1], o[2])
+                       .Concat(*matrix)
+                       .Concat(Matrix44::Translate(-o[0], -o[1], -o[2]));
+    }
+  } else if (translation) {
+    node.local = Matrix44::Translate((*translation)[0], (*translation)[1]);
+  }
+  return node;
+}
+
+ClipNode ReadClipNode(JsonTokenizer& tok) {
+  ClipNode node;
+  node.hash = ReadHashedObject(tok, [&](const std::string& key) {
+    if (key == "id") {
+      node.id = static_cast<int>(tok.ReadNumber());
+    } else if (key == "parent_id") {
+      node.parent_id = static_cast<int>(ReadNumberOr(tok, -1));
+    } else if (key == "clip_rect") {
+      bool has_null;
+      const std::vector<double> v = ReadNumberArray(tok, has_null);
+      if (!has_null && v.size() == 4) {
+        node.clip_rect = RectF::FromXYWH(v[0], v[1], v[2], v[3]);
+      }
+    } else {
+      return false;
+    }
+    return true;
+  });
+  return node;
+}
+
+EffectNode ReadEffectNode(JsonTokenizer& tok) {
+  EffectNode node;
+  node.hash = ReadHashedObject(tok, [&](const std::string& key) {
+    if (key == "id") {
+      node.id = static_cast<int>(tok.ReadNumber());
+    } else if (key == "parent_id") {
+      node.parent_id = static_cast<int>(ReadNumberOr(tok, -1));
+    } else if (key == "filter") {
+      // A blur spreads its input three sigmas; other filters stay in place
+      ReadArray(tok, [&] {
+        std::string type;
+        double amount = 0.0;
+        ReadHashedObject(tok, [&](const std::string& filter_key) {
+          if (filter_key == "type") {
+            type = tok.ReadString();
+          } else if (filter_key == "amount") {
+            amount = tok.ReadNumber();
+          } else {
+            return false;
+          }
+          return true;
+        });
+        if (type == "blur") {
+          node.outset += 3.0 * amount;
+        }
+      });
+    } else {
+      return false;
+    }
+    return true;
+  });
+  return node;
+}
+
+void AppendNumber(std::string& out, double value) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.0f", value);
+  out += buffer;
+}
+
+void AppendRect(std::string& out, const RectF& rect) {
+  out += '[';
+  AppendNumber(out, rect.left);
+  out += ", ";
+  AppendNumber(out, rect.top);
+  out += ", ";
+  AppendNumber(out, rect.width());
+  out += ", ";
+  AppendNumber(out, rect.height());
+  out += ']';
+}
+
+void AppendEscaped(std::string& out, const std::string& value) {
+  out += '"';
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+    }
+    out += c;
+  }
+  out += '"';
+}
+
+}  // namespace
+
+PaintArtifact ParsePaintArtifact(const std::string& json_str) {
+  JsonTokenizer tok(json_str);
+  PaintArtifact artifact;
+  if (tok.Peek() == '[') {
+    artifact.ops = ReadOps(tok);
+    return artifact;
+  }
+  ReadHashedObject(tok, [&](const std::string& key) {
+    if (key == "paint_ops") {
+      artifact.ops = ReadOps(tok);
+    } else if (key == "transform_tree") {
+      ReadTree(tok, [&] {
+        artifact.transform_tree.push_back(ReadTransformNode(tok));
+      });
+    } else if (key == "clip_tree") {
+      ReadTree(tok, [&] { artifact.clip_tree.push_back(ReadClipNode(tok)); });
+    } else if (key == "effect_tree") {
+      ReadTree(tok,
+               [&] { artifact.effect_tree.push_back(ReadEffectNode(tok)); });
+    } else {
+      return false;
+    }
+    return true;
+  }, /*hashed=*/false);
+  return artifact;
+}
+
+std::string SerializeRasterInvalidations(const RasterInvalidationResult& result,
+                                         bool items) {
+  std::string out = "{\n  \"raster_invalidations\": [";
+  for (size_t i = 0; i < result.rects.size(); ++i) {
+    out += i == 0 ? "\n    " : ",\n    ";
+    AppendRect(out, result.rects[i]);
+  }
+  out += result.rects.empty() ? "]" : "\n  ]";
+  if (items) {
+    out += ",\n  \"items\": [";
+    for (size_t i = 0; i < result.invalidations.size(); ++i) {
+      const RasterInvalidation& invalidation = result.invalidations[i];
+      out += i == 0 ? "\n    " : ",\n    ";
+      out += "{\"node_id\": ";
+      if (invalidation.id.node_id == kNoNodeId) {
+        out += "null";
+      } else {
+        out += std::to_string(invalidation.id.node_id);
+      }
+      out += ", \"type\": ";
+      AppendEscaped(out, invalidation.id.type);
+      out += ", \"ordinal\": " + std::to_string(invalidation.id.ordinal);
+      out += ", \"reason\": \"";
+      out += InvalidationReasonName(invalidation.reason);
+      out += "\", \"rect\": ";
+      AppendRect(out, invalidation.rect);
+      out += '}';
+    }
+    out += result.invalidations.empty() ? "]" : "\n  ]";
+  }
+  out += "\n}\n";
+  return out;
+}
+
+}  // namespace raster_invalidator
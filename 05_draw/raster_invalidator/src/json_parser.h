@@ -0,0 +1,26 @@
+#ifndef RASTER_INVALIDATOR_JSON_PARSER_H_
+#define RASTER_INVALIDATOR_JSON_PARSER_H_
+
+#include <string>
+
+#include "paint_artifact.h"
+#include "raster_invalidator.h"
+
+namespace raster_invalidator {
+
+// Parse a paint artifact: an object with "paint_ops" and the
+// "transform_tree", "clip_tree" and "effect_tree" (as in paint.json), or a
+// bare array of ops (as box_fragment_painter writes it), which has no
+// property trees. Every op and tree node is hashed as it is read.
+// Throws std::runtime_error on malformed JSON.
+PaintArtifact ParsePaintArtifact(const std::string& json_str);
+
+// Serialize to {"raster_invalidations": [[x, y, width, height], ...]}, and
+// with |items| the invalidation of each display item ("items": [{"node_id",
+// "type", "ordinal", "reason", "rect"}, ...])
+std::string SerializeRasterInvalidations(const RasterInvalidationResult& result,
+                                         bool items);
+
+}  // namespace raster_invalidator
+
+#endif  // RASTER_INVALIDATOR_JSON_PARSER_H_
@@ -0,0 +1,127 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "json_parser.h"
+#include "paint_artifact.h"
+#include "raster_invalidator.h"
+
+void PrintUsage(const char* program) {
+  std::cerr << "Usage: " << program << " --old <paint.json> --new <paint.json> [-o <output.json>]\n";
+  std::cerr << "\n";
+  std::cerr << "Options:\n";
+  std::cerr << "  --old <file>  Paint artifact of the previous paint (required)\n";
+  std::cerr << "  --new <file>  Paint artifact of the new paint (required)\n";
+  std::cerr << "  -o <file>     Output JSON file (default: stdout)\n";
+  std::cerr << "  --items       Also write the invalidation of each display item\n";
+  std::cerr << "  --stats       Print item counts, invalidated area and time to stderr\n";
+}
+
+namespace {
+
+bool ReadArtifact(const std::string& path,
+                  raster_invalidator::PaintArtifact& artifact) {
+  std::ifstream ifs(path);
+  if (!ifs) {
+    std::cerr << "Error: Cannot open input file: " << path << "\n";
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << ifs.rdbuf();
+  try {
+    artifact = raster_invalidator::ParsePaintArtifact(buffer.str());
+  } catch (const std::exception& e) {
+    std::cerr << "Error parsing " << path << ": " << e.what() << "\n";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string old_file;
+  std::string new_file;
+  std::string output_file;
+  bool write_items = false;
+  bool print_stats = false;
+
+  // Parse command line arguments
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--old" && i + 1 < argc) {
+      old_file = argv[++i];
+    } else if (arg == "--new" && i + 1 < argc) {
+      new_file = argv[++i];
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_file = argv[++i];
+    } else if (arg == "--items") {
+      write_items = true;
+    } else if (arg == "--stats") {
+      print_stats = true;
+    } else if (arg == "-h" || arg == "--help") {
+      PrintUsage(argv[0]);
+      return 0;
+    }
+  }
+
+  if (old_file.empty() || new_file.empty()) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  raster_invalidator::PaintArtifact old_artifact;
+  raster_invalidator::PaintArtifact new_artifact;
+  if (!ReadArtifact(old_file, old_artifact) ||
+      !ReadArtifact(new_file, new_artifact)) {
+    return 1;
+  }
+
+  // Diff the two paints
+  auto start = std::chrono::steady_clock::now();
+  raster_invalidator::RasterInvalidationResult result =
+      raster_invalidator::GenerateRasterInvalidations(old_artifact,
+                                                      new_artifact);
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  if (print_stats) {
+    const raster_invalidator::RasterInvalidationStats& stats = result.stats;
+    double area = 0.0;
+    for (const raster_invalidator::RectF& rect : result.rects) {
+      area += rect.Area();
+    }
+    std::cerr << "display items: " << stats.old_items << " old, "
+              << stats.new_items << " new (" << stats.unchanged
+              << " unchanged, " << stats.changed << " changed, "
+              << stats.appeared << " appeared, " << stats.disappeared
+              << " disappeared, " << stats.reordered << " reordered)\n";
+    std::cerr << "invalidations: " << result.invalidations.size() << " ("
+              << stats.culled << " clipped out)\n";
+    std::cerr << "rects: " << result.rects.size() << ", " << std::fixed
+              << std::setprecision(0) << area << " px\n";
+    std::cerr << "time: " << std::setprecision(3) << elapsed.count()
+              << " us\n";
+  }
+
+  // Serialize output
+  std::string json_output =
+      raster_invalidator::SerializeRasterInvalidations(result, write_items);
+
+  // Write output
+  if (output_file.empty()) {
+    std::cout << json_output;
+  } else {
+    std::ofstream ofs(output_file);
+    if (!ofs) {
+      std::cerr << "Error: Cannot open output file: " << output_file << "\n";
+      return 1;
+    }
+    ofs << json_output;
+  }
+
+  return 0;
+}
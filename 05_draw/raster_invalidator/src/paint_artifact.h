@@ -0,0 +1,98 @@
+// Raster Invalidator Paint Artifact
+// The merged op stream of one paint and its property trees, as written to
+// paint.json (04_paint/reference/paint.json)
+
+#ifndef RASTER_INVALIDATOR_PAINT_ARTIFACT_H_
+#define RASTER_INVALIDATOR_PAINT_ARTIFACT_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "geometry.h"
+
+namespace raster_invalidator {
+
+constexpr int64_t kNoNodeId = -1;
+
+inline uint64_t HashCombine(uint64_t seed, uint64_t value) {
+  seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+  return seed * 0x100000001b3ull;
+}
+
+struct Shadow {
+  double offset_x = 0.0;
+  double offset_y = 0.0;
+  double blur_sigma = 0.0;
+};
+
+// One paint op with the fields that place it; which are set depends on the
+// type. |hash| covers every field of the op, including nested records.
+struct PaintOp {
+  std::string type;
+  int64_t node_id = kNoNodeId;  // nodeId / node_id of the painted box
+  int transform_id = 0;
+  int clip_id = 0;
+  int effect_id = 0;
+  uint64_t hash = 0;
+
+  std::optional<RectF> rect;    // rect, outer_rect, oval or dst
+  // bounds (else the points of a path); relative to (x, y) for text blobs
+  std::optional<RectF> bounds;
+  double x = 0.0;
+  double y = 0.0;
+  double x0 = 0.0;  // DrawLineOp
+  double y0 = 0.0;
+  double x1 = 0.0;
+  double y1 = 0.0;
+  double dx = 0.0;  // TranslateOp
+  double dy = 0.0;
+  double sx = 1.0;  // ScaleOp
+  double sy = 1.0;
+  double degrees = 0.0;  // RotateOp
+  std::optional<Matrix44> matrix;  // ConcatOp, SetMatrixOp
+  int clip_op = 1;                 // SkClipOp: 0 difference, 1 intersect
+
+  // flags
+  int style = 0;  // 0 fill, 1 stroke, 2 stroke and fill
+  double stroke_width = 0.0;
+  std::vector<Shadow> shadows;
+
+  std::vector<PaintOp> record;  // DrawRecordOp
+};
+
+// Property tree nodes; |hash| covers every field of the node
+struct TransformNode {
+  int id = 0;
+  int parent_id = -1;
+  // translate(origin) * matrix * translate(-origin), or translation2d
+  Matrix44 local;
+  uint64_t hash = 0;
+};
+
+struct ClipNode {
+  int id = 0;
+  int parent_id = -1;
+  RectF clip_rect = RectF::Infinite();  // Root space
+  uint64_t hash = 0;
+};
+
+struct EffectNode {
+  int id = 0;
+  int parent_id = -1;
+  // How far the node's filters (blur, drop shadow) spread its content
+  double outset = 0.0;
+  uint64_t hash = 0;
+};
+
+struct PaintArtifact {
+  std::vector<PaintOp> ops;
+  std::vector<TransformNode> transform_tree;
+  std::vector<ClipNode> clip_tree;
+  std::vector<EffectNode> effect_tree;
+};
+
+}  // namespace raster_invalidator
+
+#endif  // RASTER_INVALIDATOR_PAINT_ARTIFACT_H_
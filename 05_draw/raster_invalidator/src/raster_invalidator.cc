@@ -0,0 +1,553 @@
+// Copyright 2017 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's RasterInvalidator
+// Original: third_party/blink/renderer/platform/graphics/compositing/
+//           raster_invalidator.cc
+//
+// Changes from Chromium:
+// - See raster_invalidator.h
+
+#include "raster_invalidator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+
+#include "region.h"
+
+namespace raster_invalidator {
+
+namespace {
+
+// A top-level draw op of an artifact, as RasterInvalidator sees a display
+// item: its id, everything that decides its pixels, and where they go
+struct DrawItem {
+  DisplayItemId id;
+  uint64_t hash = 0;
+  RectF visual_rect;  // Root space, whole pixels, clipped; may be empty
+};
+
+struct DisplayItemIdHash {
+  size_t operator()(const DisplayItemId& id) const {
+    return static_cast<size_t>(HashCombine(
+        HashCombine(std::hash<int64_t>()(id.node_id),
+                    std::hash<std::string>()(id.type)),
+        id.ordinal));
+  }
+};
+
+bool IsDrawOp(const std::string& type) {
+  return type.compare(0, 4, "Draw") == 0;
+}
+
+// The property trees of an artifact, with each node's root-space matrix,
+// clip and chain hash computed once
+class PropertyTreeState {
+ public:
+  explicit PropertyTreeState(const PaintArtifact& artifact) {
+    for (size_t i = 0; i < artifact.transform_tree.size(); ++i) {
+      transform_index_[artifact.transform_tree[i].id] = i;
+    }
+    for (size_t i = 0; i < artifact.clip_tree.size(); ++i) {
+      clip_index_[artifact.clip_tree[i].id] = i;
+    }
+    for (size_t i = 0; i < artifact.effect_tree.size(); ++i) {
+      effect_index_[artifact.effect_tree[i].id] = i;
+    }
+    // Parents may come after their children, so each chain is resolved on
+    // first use, root first
+    transforms_.resize(artifact.transform_tree.size());
+    clips_.resize(artifact.clip_tree.size());
+    effects_.resize(artifact.effect_tree.size());
+    for (size_t i = 0; i < transforms_.size(); ++i) {
+      ResolveTransform(artifact, i);
+    }
+    for (size_t i = 0; i < clips_.size(); ++i) {
+      ResolveClip(artifact, i);
+    }
+    for (size_t i = 0; i < effects_.size(); ++i) {
+      ResolveEffect(artifact, i);
+    }
+  }
+
+  // Missing nodes (a bare op array has no trees) are the identity, no clip
+  // and no effect
+  const Matrix44& ScreenTransform(int id) const {
+    auto it = transform_index_.find(id);
+    return it == transform_index_.end() ? identity_
+                                        : transforms_[it->second].matrix;
+  }
+  uint64_t TransformHash(int id) const {
+    auto it = transform_index_.find(id);
+    return it == transform_index_.end() ? 0 : transforms_[it->second].hash;
+  }
+  RectF ClipRect(int id) const {
+    auto it = clip_index_.find(id);
+    return it == clip_index_.end() ? RectF::Infinite()
+                                   : clips_[it->second].rect;
+  }
+  uint64_t ClipHash(int id) const {
+    auto it = clip_index_.find(id);
+    return it == clip_index_.end() ? 0 : clips_[it->second].hash;
+  }
+  double EffectOutset(int id) const {
+    auto it = effect_index_.find(id);
+    return it == effect_index_.end() ? 0.0 : effects_[it->second].outset;
+  }
+  uint64_t EffectHash(int id) const {
+    auto it = effect_index_.find(id);
+    return it == effect_index_.end() ? 0 : effects_[it->second].hash;
+  }
+
+ private:
+  struct ResolvedTransform {
+    bool resolved = false;
+    Matrix44 matrix;
+    uint64_t hash = 0;
+  };
+  struct ResolvedClip {
+    bool resolved = false;
+    RectF rect = RectF::Infinite();
+    uint64_t hash = 0;
+  };
+  struct ResolvedEffect {
+    bool resolved = false;
+    double outset = 0.0;
+    uint64_t hash = 0;
+  };
+
+  // Each walks up to the first resolved ancestor, then back down
+  void ResolveTransform(const PaintArtifact& artifact, size_t index) {
+    std::vector<size_t> chain;
+    for (size_t i = index; !transforms_[i].resolved;) {
+      transforms_[i].resolved = true;  // Guards against cycles
+      chain.push_back(i);
+      auto parent = transform_index_.find(artifact.transform_tree[i].parent_id);
+      if (parent == transform_index_.end()) {
+        break;
+      }
+      i = parent->second;
+    }
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+      const TransformNode& node = artifact.transform_tree[*it];
+      auto parent = transform_index_.find(node.parent_id);
+      const ResolvedTransform* resolved_parent =
+          parent == transform_index_.end() || parent->second == *it
+              ? nullptr
+              : &transforms_[parent->second];
+      transforms_[*it].matrix =
+          resolved_parent ? resolved_parent->matrix.Concat(node.local)
+                          : node.local;
+      transforms_[*it].hash = HashCombine(
+          resolved_parent ? resolved_parent->hash : 0, node.hash);
+    }
+  }
+
+  void ResolveClip(const PaintArtifact& artifact, size_t index) {
+    std::vector<size_t> chain;
+    for (size_t i = index; !clips_[i].resolved;) {
+      clips_[i].resolved = true;
+      chain.push_back(i);
+      auto parent = clip_index_.find(artifact.clip_tree[i].parent_id);
+      if (parent == clip_index_.end()) {
+        break;
+      }
+      i = parent->second;
+    }
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+      const ClipNode& node = artifact.clip_tree[*it];
+      auto parent = clip_index_.find(node.parent_id);
+      const ResolvedClip* resolved_parent =
+          parent == clip_index_.end() || parent->second == *it
+              ? nullptr
+              : &clips_[parent->second];
+      clips_[*it].rect = resolved_parent
+                             ? resolved_parent->rect.Intersect(node.clip_rect)
+                             : node.clip_rect;
+      clips_[*it].hash =
+          HashCombine(resolved_parent ? resolved_parent->hash : 0, node.hash);
+    }
+  }
+
+  void ResolveEffect(const PaintArtifact& artifact, size_t index) {
+    std::vector<size_t> chain;
+    for (size_t i = index; !effects_[i].resolved;) {
+      effects_[i].resolved = true;
+      chain.push_back(i);
+      auto parent = effect_index_.find(artifact.effect_tree[i].parent_id);
+      if (parent == effect_index_.end()) {
+        break;
+      }
+      i = parent->second;
+    }
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+      const EffectNode& node = artifact.effect_tree[*it];
+      auto parent = effect_index_.find(node.parent_id);
+      const ResolvedEffect* resolved_parent =
+          parent == effect_index_.end() || parent->second == *it
+              ? nullptr
+              : &effects_[parent->second];
+      effects_[*it].outset =
+          (resolved_parent ? resolved_parent->outset : 0.0) + node.outset;
+      effects_[*it].hash =
+          HashCombine(resolved_parent ? resolved_parent->hash : 0, node.hash);
+    }
+  }
+
+  Matrix44 identity_;
+  std::unordered_map<int, size_t> transform_index_;
+  std::unordered_map<int, size_t> clip_index_;
+  std::unordered_map<int, size_t> effect_index_;
+  std::vector<ResolvedTransform> transforms_;
+  std::vector<ResolvedClip> clips_;
+  std::vector<ResolvedEffect> effects_;
+};
+
+// The canvas state the ops of a stream build up with save / restore
+struct CanvasState {
+  Matrix44 matrix;                   // Local to root space
+  RectF clip = RectF::Infinite();    // Root space
+  uint64_t hash = 0;                 // State ops applied so far
+};
+
+// The local bounds of a draw op, or nullopt if it has none (it may cover
+// its whole clip)
+std::optional<RectF> DrawBounds(const PaintOp& op) {
+  std::optional<RectF> bounds;
+  if (op.type == "DrawTextBlobOp") {
+    if (op.bounds) {
+      bounds = op.bounds->Offset(op.x, op.y);
+    }
+  } else if (op.type == "DrawLineOp") {
+    bounds = RectF{std::min(op.x0, op.x1), std::min(op.y0, op.y1),
+                   std::max(op.x0, op.x1), std::max(op.y0, op.y1)};
+  } else if (op.rect) {
+    bounds = op.rect;
+  } else if (op.bounds) {
+    bounds = op.bounds;
+  }
+  if (!bounds) {
+    return bounds;
+  }
+  if (op.style != 0) {
+    bounds = bounds->Outset(op.stroke_width / 2.0);
+  }
+  RectF with_shadows = *bounds;
+  for (const Shadow& shadow : op.shadows) {
+    // Skia blurs reach three sigmas
+    with_shadows = with_shadows.Union(
+        bounds->Offset(shadow.offset_x, shadow.offset_y)
+            .Outset(3.0 * shadow.blur_sigma));
+  }
+  return with_shadows;
+}
+
+class ItemCollector {
+ public:
+  explicit ItemCollector(const PaintArtifact& artifact)
+      : artifact_(artifact), trees_(artifact) {}
+
+  std::vector<DrawItem> Collect() {
+    std::vector<DrawItem> items;
+    std::unordered_map<DisplayItemId, uint32_t, DisplayItemIdHash> ordinals;
+    // The stream's canvas state, relative to the property tree state of
+    // each op
+    std::vector<CanvasState> stack(1);
+    for (const PaintOp& op : artifact_.ops) {
+      if (!IsDrawOp(op.type)) {
+        ApplyStateOp(op, stack);
+        continue;
+      }
+      DrawItem item;
+      item.id.node_id = op.node_id;
+      item.id.type = op.type;
+      item.id.ordinal = ordinals[item.id]++;
+
+      const Matrix44 to_root =
+          trees_.ScreenTransform(op.transform_id).Concat(stack.back().matrix);
+      // The in-stream clip is kept in root space, so it does not move with
+      // the property tree transform of later ops
+      const RectF clip =
+          trees_.ClipRect(op.clip_id).Intersect(stack.back().clip);
+      RectF bounds;
+      DrawOpBounds(op, to_root, clip, bounds);
+      item.visual_rect = bounds.Outset(trees_.EffectOutset(op.effect_id))
+                             .Intersect(trees_.ClipRect(op.clip_id))
+                             .Enclosing();
+
+      uint64_t hash = HashCombine(op.hash, stack.back().hash);
+      hash = HashCombine(hash, trees_.TransformHash(op.transform_id));
+      hash = HashCombine(hash, trees_.ClipHash(op.clip_id));
+      item.hash = HashCombine(hash, trees_.EffectHash(op.effect_id));
+      items.push_back(std::move(item));
+    }
+    return items;
+  }
+
+ private:
+  void ApplyStateOp(const PaintOp& op, std::vector<CanvasState>& stack,
+                    const Matrix44* base = nullptr) {
+    CanvasState& state = stack.back();
+    const Matrix44 to_root =
+        base ? base->Concat(state.matrix)
+             : trees_.ScreenTransform(op.transform_id).Concat(state.matrix);
+    if (op.type == "SaveOp" || op.type == "SaveLayerOp" ||
+        op.type == "SaveLayerAlphaOp") {
+      CanvasState saved = state;
+      saved.hash = HashCombine(saved.hash, op.hash);
+      stack.push_back(saved);
+      return;
+    }
+    if (op.type == "RestoreOp") {
+      if (stack.size() > 1) {
+        stack.pop_back();
+      }
+      return;
+    }
+    state.hash = HashCombine(state.hash, op.hash);
+    if (op.type == "TranslateOp") {
+      state.matrix = state.matrix.Concat(Matrix44::Translate(op.dx, op.dy));
+    } else if (op.type == "ScaleOp") {
+      state.matrix = state.matrix.Concat(Matrix44::Scale(op.sx, op.sy));
+    } else if (op.type == "RotateOp") {
+      state.matrix = state.matrix.Concat(Matrix44::Rotate(op.degrees));
+    } else if ((op.type == "ConcatOp" || op.type == "SetMatrixOp") &&
+               op.matrix) {
+      // Like draw.html, SetMatrixOp is applied as a concat
+      state.matrix = state.matrix.Concat(*op.matrix);
+    } else if (op.type.compare(0, 4, "Clip") == 0 && op.clip_op == 1) {
+      // Only intersecting clips shrink what an op can touch
+      const std::optional<RectF>& local = op.rect ? op.rect : op.bounds;
+      RectF mapped;
+      if (local && to_root.MapRect(*local, mapped)) {
+        state.clip = state.clip.Intersect(mapped);
+      }
+    }
+  }
+
+  // The root-space bounds of a draw op inside |clip|; a DrawRecordOp plays
+  // its record back with its own save / restore and folds its nested ops'
+  // bounds in
+  void DrawOpBounds(const PaintOp& op, const Matrix44& to_root,
+                    const RectF& clip, RectF& bounds) {
+    if (op.type == "DrawRecordOp") {
+      std::vector<CanvasState> stack(1);
+      stack.back().clip = clip;
+      for (const PaintOp& nested : op.record) {
+        if (!IsDrawOp(nested.type)) {
+          ApplyStateOp(nested, stack, &to_root);
+          continue;
+        }
+        DrawOpBounds(nested, to_root.Concat(stack.back().matrix),
+                     stack.back().clip, bounds);
+      }
+      return;
+    }
+    const std::optional<RectF> local = DrawBounds(op);
+    RectF mapped;
+    if (!local || !to_root.MapRect(*local, mapped)) {
+      mapped = clip;  // Unknown extent: all it may touch
+    }
+    bounds = bounds.Union(mapped.Intersect(clip));
+  }
+
+  const PaintArtifact& artifact_;
+  PropertyTreeState trees_;
+};
+
+// Ops without a node id all share kNoNodeId, so their ordinals would shift
+// with every such op added or removed before them. They are aligned by
+// sequence instead, and the new items take the ordinal of the old item they
+// align with (or a fresh one, to appear):
+//
+// - Items with the same hash (op, state and trees), in order, are anchors
+// - Between two anchors, the remaining items of a type pair up in order,
+//   as changed versions of each other
+void AlignUnidentifiedItems(const std::vector<DrawItem>& old_items,
+                            std::vector<DrawItem>& new_items) {
+  std::vector<size_t> old_anon;
+  std::vector<size_t> new_anon;
+  for (size_t i = 0; i < old_items.size(); ++i) {
+    if (old_items[i].id.node_id == kNoNodeId) {
+      old_anon.push_back(i);
+    }
+  }
+  for (size_t i = 0; i < new_items.size(); ++i) {
+    if (new_items[i].id.node_id == kNoNodeId) {
+      new_anon.push_back(i);
+    }
+  }
+  if (new_anon.empty()) {
+    return;
+  }
+
+  // The old positions (into old_anon) of each hash, and how many of them
+  // are already behind the last anchor
+  struct Positions {
+    std::vector<size_t> positions;
+    size_t next = 0;
+  };
+  std::unordered_map<uint64_t, Positions> by_hash;
+  for (size_t k = 0; k < old_anon.size(); ++k) {
+    by_hash[old_items[old_anon[k]].hash].positions.push_back(k);
+  }
+  constexpr size_t kUnmatched = SIZE_MAX;
+  std::vector<size_t> match(new_anon.size(), kUnmatched);
+  // Anchors as (new position, old position), in increasing order of both
+  std::vector<std::pair<size_t, size_t>> anchors;
+  size_t next_old = 0;
+  for (size_t j = 0; j < new_anon.size(); ++j) {
+    const DrawItem& item = new_items[new_anon[j]];
+    auto it = by_hash.find(item.hash);
+    if (it == by_hash.end()) {
+      continue;
+    }
+    Positions& candidates = it->second;
+    while (candidates.next < candidates.positions.size() &&
+           candidates.positions[candidates.next] < next_old) {
+      ++candidates.next;
+    }
+    if (candidates.next == candidates.positions.size()) {
+      continue;
+    }
+    const size_t k = candidates.positions[candidates.next++];
+    if (old_items[old_anon[k]].id.type != item.id.type) {
+      continue;
+    }
+    match[j] = k;
+    anchors.push_back({j, k});
+    next_old = k + 1;
+  }
+
+  // The gaps before, between and after the anchors
+  anchors.push_back({new_anon.size(), old_anon.size()});
+  size_t gap_new = 0;
+  size_t gap_old = 0;
+  std::unordered_map<std::string, std::vector<size_t>> gap_by_type;
+  for (const auto& [anchor_new, anchor_old] : anchors) {
+    if (gap_new < anchor_new && gap_old < anchor_old) {
+      gap_by_type.clear();
+      // Reversed, so each type's next old item is at the back
+      for (size_t k = anchor_old; k > gap_old; --k) {
+        gap_by_type[old_items[old_anon[k - 1]].id.type].push_back(k - 1);
+      }
+      for (size_t j = gap_new; j < anchor_new; ++j) {
+        auto it = gap_by_type.find(new_items[new_anon[j]].id.type);
+        if (it != gap_by_type.end() && !it->second.empty()) {
+          match[j] = it->second.back();
+          it->second.pop_back();
+        }
+      }
+    }
+    gap_new = anchor_new + 1;
+    gap_old = anchor_old + 1;
+  }
+
+  // Old ordinals of a type count from 0, so none reaches old_anon.size()
+  uint32_t fresh_ordinal = static_cast<uint32_t>(old_anon.size());
+  for (size_t j = 0; j < new_anon.size(); ++j) {
+    new_items[new_anon[j]].id.ordinal =
+        match[j] == kUnmatched ? fresh_ordinal++
+                               : old_items[old_anon[match[j]]].id.ordinal;
+  }
+}
+
+void Invalidate(const DrawItem& item, InvalidationReason reason,
+                RasterInvalidationResult& result) {
+  if (item.visual_rect.IsEmpty()) {
+    ++result.stats.culled;
+    return;
+  }
+  result.invalidations.push_back({item.id, reason, item.visual_rect});
+}
+
+}  // namespace
+
+const char* InvalidationReasonName(InvalidationReason reason) {
+  switch (reason) {
+    case InvalidationReason::kAppeared:
+      return "appeared";
+    case InvalidationReason::kDisappeared:
+      return "disappeared";
+    case InvalidationReason::kChanged:
+      return "changed";
+    case InvalidationReason::kReordered:
+      return "reordered";
+  }
+  return "unknown";
+}
+
+RasterInvalidationResult GenerateRasterInvalidations(
+    const PaintArtifact& old_artifact, const PaintArtifact& new_artifact) {
+  const std::vector<DrawItem> old_items =
+      ItemCollector(old_artifact).Collect();
+  std::vector<DrawItem> new_items = ItemCollector(new_artifact).Collect();
+  AlignUnidentifiedItems(old_items, new_items);
+
+  RasterInvalidationResult result;
+  result.stats.old_items = old_items.size();
+  result.stats.new_items = new_items.size();
+
+  std::unordered_map<DisplayItemId, size_t, DisplayItemIdHash> old_index;
+  old_index.reserve(old_items.size());
+  for (size_t i = 0; i < old_items.size(); ++i) {
+    old_index.emplace(old_items[i].id, i);
+  }
+  std::vector<bool> matched(old_items.size(), false);
+
+  // Like GenerateRasterInvalidations over paint chunks: a matched item
+  // painted before one it used to follow is out of order
+  size_t max_matched_old = 0;
+  bool any_matched = false;
+  for (const DrawItem& item : new_items) {
+    auto it = old_index.find(item.id);
+    if (it == old_index.end()) {
+      ++result.stats.appeared;
+      Invalidate(item, InvalidationReason::kAppeared, result);
+      continue;
+    }
+    const DrawItem& old_item = old_items[it->second];
+    matched[it->second] = true;
+    const bool reordered = any_matched && it->second < max_matched_old;
+    if (!reordered) {
+      max_matched_old = it->second;
+      any_matched = true;
+    }
+
+    if (old_item.hash != item.hash ||
+        !(old_item.visual_rect == item.visual_rect)) {
+      ++result.stats.changed;
+      Invalidate(old_item, InvalidationReason::kChanged, result);
+      if (!(old_item.visual_rect == item.visual_rect)) {
+        Invalidate(item, InvalidationReason::kChanged, result);
+      }
+    } else if (reordered) {
+      ++result.stats.reordered;
+      Invalidate(item, InvalidationReason::kReordered, result);
+    } else {
+      ++result.stats.unchanged;
+    }
+  }
+  for (size_t i = 0; i < old_items.size(); ++i) {
+    if (!matched[i]) {
+      ++result.stats.disappeared;
+      Invalidate(old_items[i], InvalidationReason::kDisappeared, result);
+    }
+  }
+
+  Region region;
+  for (const RasterInvalidation& invalidation : result.invalidations) {
+    region.Union(invalidation.rect);
+  }
+  result.rects = region.Rects();
+  if (result.rects.size() > kMaxInvalidationRects) {
+    result.rects = {region.Bounds()};
+  }
+  return result;
+}
+
+}  // namespace raster_invalidator
@@ -0,0 +1,96 @@
+// Copyright 2017 The Chromium Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This file is adapted from Chromium's RasterInvalidator
+// Original: third_party/blink/renderer/platform/graphics/compositing/
+//           raster_invalidator.h
+//
+// Changes from Chromium:
+// - Compares two merged paint artifacts (paint.json op streams) instead of
+//   the paint chunks of one composited layer, and invalidates root space
+//   instead of layer space
+// - Display items are the top-level draw ops, identified by node id, op
+//   type and ordinal (the n-th op of that type for that node); state ops
+//   (save, restore, clips, canvas transforms, layers) have no id and are
+//   folded into the hash and visual rect of the draws they affect. Draw ops
+//   without a node id get their ordinals from a sequence alignment with
+//   the old ones, not from their position.
+// - An item is unchanged when its hash (op, canvas state and property tree
+//   nodes) and its visual rect are; there is no partial (incremental)
+//   invalidation of a resized item
+// - The rects are merged into a region and simplified to their bounds past
+//   kMaxInvalidationRects, as cc::InvalidationRegion does
+
+#ifndef RASTER_INVALIDATOR_RASTER_INVALIDATOR_H_
+#define RASTER_INVALIDATOR_RASTER_INVALIDATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "geometry.h"
+#include "paint_artifact.h"
+
+namespace raster_invalidator {
+
+// cc::InvalidationRegion::kMaxInvalidationRectCount
+constexpr size_t kMaxInvalidationRects = 256;
+
+// PaintInvalidationReason, reduced to what an op diff can tell
+enum class InvalidationReason : uint8_t {
+  kAppeared,     // New id
+  kDisappeared,  // Id gone
+  kChanged,      // Same id, different op, state or visual rect
+  kReordered,    // Same id and content, painted out of order
+};
+
+const char* InvalidationReasonName(InvalidationReason reason);
+
+struct DisplayItemId {
+  int64_t node_id = kNoNodeId;
+  std::string type;
+  uint32_t ordinal = 0;
+
+  bool operator==(const DisplayItemId& other) const {
+    return node_id == other.node_id && ordinal == other.ordinal &&
+           type == other.type;
+  }
+};
+
+struct RasterInvalidation {
+  DisplayItemId id;
+  InvalidationReason reason = InvalidationReason::kChanged;
+  RectF rect;  // Root space, whole pixels, clipped; never empty
+};
+
+struct RasterInvalidationStats {
+  size_t old_items = 0;
+  size_t new_items = 0;
+  size_t unchanged = 0;
+  size_t changed = 0;
+  size_t appeared = 0;
+  size_t disappeared = 0;
+  size_t reordered = 0;
+  size_t culled = 0;  // Invalidations entirely clipped out
+};
+
+struct RasterInvalidationResult {
+  // One per invalidated rect of an item: a changed item that moved
+  // invalidates its old and new rects
+  std::vector<RasterInvalidation> invalidations;
+  // Their union as disjoint rects (or their bounds past
+  // kMaxInvalidationRects)
+  std::vector<RectF> rects;
+  RasterInvalidationStats stats;
+};
+
+// What must be re-rastered, in root space, to turn |old_artifact|'s pixels
+// into |new_artifact|'s
+RasterInvalidationResult GenerateRasterInvalidations(
+    const PaintArtifact& old_artifact, const PaintArtifact& new_artifact);
+
+}  // namespace raster_invalidator
+
+#endif  // RASTER_INVALIDATOR_RASTER_INVALIDATOR_H_
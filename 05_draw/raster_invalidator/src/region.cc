@@ -0,0 +1,122 @@
+#include "region.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace raster_invalidator {
+
+std::vector<Region::Span> Region::UnionSpans(const std::vector<Span>& spans,
+                                             const Span& span) {
+  std::vector<Span> result;
+  result.reserve(spans.size() + 1);
+  Span merged = span;
+  bool inserted = false;
+  for (const Span& s : spans) {
+    if (s.right < merged.left) {
+      result.push_back(s);
+    } else if (s.left > merged.right) {
+      if (!inserted) {
+        result.push_back(merged);
+        inserted = true;
+      }
+      result.push_back(s);
+    } else {
+      // Overlapping or touching: absorb
+      merged.left = std::min(merged.left, s.left);
+      merged.right = std::max(merged.right, s.right);
+    }
+  }
+  if (!inserted) {
+    result.push_back(merged);
+  }
+  return result;
+}
+
+void Region::Union(const RectF& rect) {
+  if (rect.IsEmpty()) {
+    return;
+  }
+  const double top = rect.top;
+  const double bottom = rect.bottom;
+  const Span span = {rect.left, rect.right};
+
+  std::vector<Band> bands;
+  bands.reserve(bands_.size() + 3);
+  double y = top;  // Start of the part of |rect| not emitted yet
+  for (Band& band : bands_) {
+    if (band.bottom <= top) {
+      bands.push_back(std::move(band));
+      continue;
+    }
+    if (band.top >= bottom) {
+      if (y < bottom) {
+        bands.push_back({y, bottom, {span}});
+        y = bottom;
+      }
+      bands.push_back(std::move(band));
+      continue;
+    }
+    // |band| overlaps the rows of |rect|: split it at top / bottom
+    if (band.top < top) {
+      bands.push_back({band.top, top, band.spans});
+    }
+    const double overlap_top = std::max(band.top, top);
+    const double overlap_bottom = std::min(band.bottom, bottom);
+    if (y < overlap_top) {
+      bands.push_back({y, overlap_top, {span}});
+    }
+    bands.push_back({overlap_top, overlap_bottom, UnionSpans(band.spans, span)});
+    y = overlap_bottom;
+    if (band.bottom > bottom) {
+      bands.push_back({bottom, band.bottom, std::move(band.spans)});
+    }
+  }
+  if (y < bottom) {
+    bands.push_back({y, bottom, {span}});
+  }
+
+  // Coalesce adjacent bands with the same spans
+  bands_.clear();
+  for (Band& band : bands) {
+    if (!bands_.empty() && bands_.back().bottom == band.top &&
+        bands_.back().spans == band.spans) {
+      bands_.back().bottom = band.bottom;
+    } else {
+      bands_.push_back(std::move(band));
+    }
+  }
+}
+
+std::vector<RectF> Region::Rects() const {
+  std::vector<RectF> rects;
+  for (const Band& band : bands_) {
+    for (const Span& s : band.spans) {
+      rects.push_back({s.left, band.top, s.right, band.bottom});
+    }
+  }
+  return rects;
+}
+
+RectF Region::Bounds() const {
+  RectF bounds;
+  for (const Band& band : bands_) {
+    bounds = bounds.Union(
+        {band.spans.front().left, band.top, band.spans.back().right,
+         band.bottom});
+  }
+  return bounds;
+}
+
+double Region::Area() const {
+  double area = 0.0;
+  for (const Band& band : bands_) {
+    double width = 0.0;
+    for (const Span& s : band.spans) {
+      width += s.right - s.left;
+    }
+    area += width * (band.bottom - band.top);
+  }
+  return area;
+}
+
+}  // namespace raster_invalidator
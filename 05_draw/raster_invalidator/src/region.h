@@ -0,0 +1,53 @@
+// Raster Invalidator Region
+// A union of axis-aligned rects stored as y-sorted bands of x spans, like
+// SkRegion: merges invalidation rects into disjoint ones
+
+#ifndef RASTER_INVALIDATOR_REGION_H_
+#define RASTER_INVALIDATOR_REGION_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "geometry.h"
+
+namespace raster_invalidator {
+
+class Region {
+ public:
+  bool IsEmpty() const { return bands_.empty(); }
+
+  // Adds |rect|; empty rects are ignored
+  void Union(const RectF& rect);
+
+  // The covered area as disjoint rects, one per span of each band, top to
+  // bottom and left to right
+  std::vector<RectF> Rects() const;
+  RectF Bounds() const;
+  double Area() const;
+
+ private:
+  struct Span {
+    double left;
+    double right;
+    bool operator==(const Span& other) const {
+      return left == other.left && right == other.right;
+    }
+  };
+
+  // Rows [top, bottom) with sorted, disjoint, non-touching spans; bands are
+  // sorted, disjoint, and adjacent bands with equal spans are coalesced
+  struct Band {
+    double top;
+    double bottom;
+    std::vector<Span> spans;
+  };
+
+  static std::vector<Span> UnionSpans(const std::vector<Span>& spans,
+                                      const Span& span);
+
+  std::vector<Band> bands_;
+};
+
+}  // namespace raster_invalidator
+
+#endif  // RASTER_INVALIDATOR_REGION_H_